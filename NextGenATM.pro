@@ -0,0 +1,11 @@
+TEMPLATE = subdirs
+
+SUBDIRS = core QtApp bench tools
+
+core.file = core/atm_core.pro
+QtApp.file = QtApp/ATMSim.pro
+QtApp.depends = core
+bench.file = bench/atm_bench.pro
+bench.depends = core
+tools.file = tools/atmtool.pro
+tools.depends = core
@@ -2,14 +2,22 @@ QT += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++17
+CONFIG += c++17 ltcg
 
 TARGET = NextGenATM
 TEMPLATE = app
 
 DESTDIR = ./app
 
-SOURCES += atm_qt_app.cpp qrcodegen.cpp
+SOURCES += atm_qt_app.cpp
 RESOURCES += assets.qrc
 
-HEADERS += nfcworker.h qrcodegen.hpp
+HEADERS += nfcworker.h
+
+# --- Shared core library (built by ../core/atm_core.pro) ---
+INCLUDEPATH += ../core
+DEPENDPATH += ../core
+LIBS += -L$$OUT_PWD/../core/lib -latm_core
+
+win32-msvc*: PRE_TARGETDEPS += $$OUT_PWD/../core/lib/atm_core.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/../core/lib/libatm_core.a
@@ -16,6 +16,12 @@
 #include <QByteArray>
 #include <QFrame>
 #include <QGraphicsDropShadowEffect>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QDateTime>
 
 // --- Qt Network Includes (Cross-Platform) ---
 #include <QTcpServer>
@@ -28,9 +34,23 @@
 #include <cstring>
 #include <climits>
 #include <algorithm>
+#include <memory>
 #include <stdexcept>
+#include <memory_resource>
 
 #include "nfcworker.h"
+#include "account.h"
+#include "account_file.h"
+#include "account_import.h"
+#include "account_store.h"
+#include "card_number.h"
+#include "journal.h"
+#include "pin_block.h"
+#include "pin_verifier.h"
+#include "session_arena.h"
+#include "sharded_account_store.h"
+#include "snapshot.h"
+#include "nfc_request.h"
 #include "qrcodegen.hpp"
 
 using std::uint8_t;
@@ -39,43 +59,15 @@ using qrcodegen::QrSegment;
 using namespace std;
 
 // ==========================================
-// 1. Logic Layer (The Account Class)
+// 1. Logic Layer (atm_core: Account, NFC request parsing, QR engine)
 // ==========================================
-class Account {
-private:
-    int accountNumber;
-    QString accountHolderName;
-    double balance;
-    int pin;
-    long long cardNumber;
-
-public:
-    Account(int accNum = 0, QString accHolder = "", double bal = 0.0, int pinCode = 0, long long cardNum = 0)
-        : accountNumber(accNum), accountHolderName(accHolder), balance(bal), pin(pinCode), cardNumber(cardNum) {
-    }
-
-    int getAccountNumber() const { return accountNumber; }
-    long long getCardNumber() const { return cardNumber; }
-    bool validatePin(int enteredPin) const { return pin == enteredPin; }
-    QString getName() const { return accountHolderName; }
-    double getBalance() const { return balance; }
-
-    bool deposit(int amount) {
-        if (amount > 0 && amount % 100 == 0) {
-            balance += amount;
-            return true;
-        }
-        return false;
-    }
-
-    bool withdraw(int amount) {
-        if (amount > 0 && amount <= balance && amount % 100 == 0) {
-            balance -= amount;
-            return true;
-        }
-        return false;
-    }
-};
+using atm::Account;
+using atm::AccountFile;
+using atm::AccountHandle;
+using atm::Journal;
+using atm::ShardedAccountStore;
+using atm::Snapshotter;
+using atm::TxnStatus;
 
 // ==========================================
 // 2. NFC Worker Thread (Cross-Platform Qt Network)
@@ -117,7 +109,7 @@ void NfcWorker::run() {
 
     if (socket->waitForReadyRead(3000)) {
         QByteArray requestData = socket->readAll();
-        string rawRequest = requestData.toStdString();
+        std::string_view rawRequest(requestData.constData(), static_cast<size_t>(requestData.size()));
 
         QString httpResponse = "HTTP/1.1 200 OK\r\n"
                                "Content-Type: text/plain\r\n"
@@ -127,23 +119,20 @@ void NfcWorker::run() {
         socket->waitForBytesWritten(1000);
         socket->disconnectFromHost();
 
-        string jsonBody = "";
-        size_t bodyPos = rawRequest.find("\r\n\r\n");
-        if (bodyPos != string::npos) {
-            jsonBody = rawRequest.substr(bodyPos + 4);
-        } else {
-            jsonBody = rawRequest;
-        }
-
-        string cardNumStr = parseJsonValue(jsonBody, "cardNum");
+        // The tap is parsed on this thread, so it gets its own small arena
+        // rather than the GUI thread's session arena.
+        alignas(std::max_align_t) unsigned char scratch[512];
+        std::pmr::monotonic_buffer_resource tapMemory(scratch, sizeof(scratch));
+        std::string_view jsonBody = atm::httpRequestBody(rawRequest);
+        std::pmr::string cardNumStr = atm::parseJsonValue(jsonBody, "cardNum", &tapMemory);
 
         if (!cardNumStr.empty()) {
-            try {
-                long long cardNum = stoll(cardNumStr);
-                emit cardDetected(cardNum);
-            } catch (...) {
-                emit errorOccurred("Invalid number format");
-            }
+            // Length and check digit are verified here, so handleNfcSuccess
+            // only ever looks up well-formed card numbers.
+            long long cardNum = 0;
+            atm::CardCheck check = atm::checkCardNumber(cardNumStr, &cardNum);
+            if (check == atm::CardCheck::Ok) emit cardDetected(cardNum);
+            else emit errorOccurred(QString("Invalid card number (%1)").arg(atm::cardCheckName(check)));
         } else {
             emit errorOccurred("No cardNum found in request");
         }
@@ -154,36 +143,37 @@ void NfcWorker::run() {
     server.close();
 }
 
-std::string NfcWorker::parseJsonValue(std::string body, std::string key) {
-    string searchKey = "\"" + key + "\"";
-    size_t keyPos = body.find(searchKey);
-    if (keyPos == string::npos) return "";
-
-    size_t colonPos = body.find(":", keyPos);
-    if (colonPos == string::npos) return "";
-
-    size_t valueStart = colonPos + 1;
-    size_t valueEnd = body.find_first_of(",}", valueStart);
-    if (valueEnd == string::npos) valueEnd = body.length();
-
-    string value = body.substr(valueStart, valueEnd - valueStart);
-    value.erase(remove(value.begin(), value.end(), '\"'), value.end());
-    value.erase(remove(value.begin(), value.end(), ' '), value.end());
-    value.erase(remove(value.begin(), value.end(), '\n'), value.end());
-    value.erase(remove(value.begin(), value.end(), '\r'), value.end());
-
-    return value;
-}
-
 // ==========================================
 // 3. GUI Layer (The Main Window)
 // ==========================================
 class ATMWindow : public QWidget {
 private:
-    // Data
-    Account accounts[3];
-    Account* currentSession = nullptr;
-    Account* pendingAccount = nullptr;
+    static constexpr std::uint32_t kTerminalId = 2;
+    static constexpr std::uint64_t kHistoryReplayRecords = 100000;   // journal records read into mini-statements at startup
+    static constexpr std::size_t kMiniStatementLines = 10;
+
+    // Data (mapped from accounts.dat in the app data folder)
+    std::unique_ptr<ShardedAccountStore> accounts;
+    QString accountFilePath;
+    QString accountImportPath;
+    QDateTime accountImportModified;
+    QString binTablePath;
+    QDateTime binTableModified;
+    QFileSystemWatcher dataFileWatcher;   // bins.txt, accounts.csv and their folder
+    std::unique_ptr<Journal> journal;   // journal.log next to accounts.dat
+    std::unique_ptr<Journal> dispenseLog;   // dispense.log: cash handed out, keyed by the debit's LSN
+    std::unique_ptr<Snapshotter> snapshotter;   // keeps accounts.snap behind the journal
+    AccountHandle currentSession;
+    AccountHandle pendingAccount;
+    // Session temporaries on the GUI thread; released on "Eject Card".
+    atm::SessionArena sessionArena;
+    // The PIN pad stand-in enciphers PINs into ISO 9564 format-4 blocks
+    // under this key; hashing and deciphering run on the verifier's
+    // workers, never on the GUI thread. Declared after the session state
+    // so the workers are joined before that state goes away.
+    const atm::Aes128 pinPadKey = atm::Aes128::generate();
+    atm::PinVerifier pinVerifier{pinVerifierOptions(&pinPadKey)};
+    std::uint64_t pinCheckId = 0;   // bumped per check; stale results are dropped
 
     // NFC Thread
     NfcWorker* nfcThread;
@@ -225,9 +215,7 @@ public:
     ATMWindow() {
         this->setObjectName("ATMWindow");
         // Initialize Data
-        accounts[0] = Account(1001, "Tanmay Ravindra Padale", 1800.00, 1234, 8825);
-        accounts[1] = Account(1002, "Swayam Bagul", 1500.50, 5678, 7787);
-        accounts[2] = Account(1003, "Yash Pratap Gautam", 2000.00, 1111, 5887);
+        openAccountFile();
 
         upiTimer = new QTimer(this);
         connect(upiTimer, &QTimer::timeout, this, &ATMWindow::updateTimer);
@@ -251,9 +239,126 @@ public:
             nfcThread->quit();
             nfcThread->wait();
         }
+        // Nothing changes balances any more: once the journal is on disk the
+        // account file is marked clean, and the next start opens it in place.
+        snapshotter.reset();
+        if (journal && accounts) {
+            try {
+                journal->flush();
+                if (dispenseLog) dispenseLog->flush();
+                accounts->closeCleanly(journal->durableLsn());
+            } catch (const std::exception& e) {
+                qWarning() << "Account file not closed cleanly:" << e.what();
+            }
+        }
     }
 
 private:
+    void openAccountFile() {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dataDir);
+        std::string path = (dataDir + "/accounts.dat").toStdString();
+        std::string snapshotPath = (dataDir + "/accounts.snap").toStdString();
+        std::string journalPath = (dataDir + "/journal.log").toStdString();
+
+        // Seeded with the demo accounts on first run; afterwards the account
+        // file is rebuilt from the latest snapshot plus the journal after it.
+        AccountFile accountFile;
+        accountFilePath = QString::fromStdString(path);
+        accountImportPath = dataDir + "/accounts.csv";
+        try {
+            journal = std::make_unique<Journal>(journalPath);
+            dispenseLog = std::make_unique<Journal>((dataDir + "/dispense.log").toStdString());
+            // A first run with accounts.csv in the data folder imports it
+            // instead of seeding the demo accounts.
+            if (!QFile::exists(QString::fromStdString(snapshotPath)) && !QFile::exists(QString::fromStdString(path)) &&
+                QFile::exists(accountImportPath)) {
+                QDateTime importing = QFileInfo(accountImportPath).lastModified();
+                atm::AccountStore imported;
+                atm::ImportStats s = atm::importAccounts(accountImportPath.toStdString(), imported);
+                AccountFile::create(path, imported);
+                accountImportModified = importing;   // all of it is served already
+                qDebug() << "Imported" << s.records << "accounts in" << s.totalSeconds() * 1000 << "ms: count"
+                         << s.countSeconds * 1000 << "allocate" << s.allocateSeconds * 1000 << "parse"
+                         << s.parseSeconds * 1000 << "index" << s.indexSeconds * 1000;
+            }
+            atm::RecoveryReport recovery = atm::recoverAccounts(path, snapshotPath, journalPath, {
+                Account(1001, "Tanmay Ravindra Padale", atm::rupees(1800), atm::hashPin("1234"), 4000000000008823),
+                Account(1002, "Swayam Bagul", atm::rupees(1500, 50), atm::hashPin("5678"), 4000000000007783),
+                Account(1003, "Yash Pratap Gautam", atm::rupees(2000), atm::hashPin("1111"), 4000000000005886)
+            });
+            accountFile = AccountFile::open(path);
+            // Compaction leaves the journal records history replay reads below.
+            atm::SnapshotOptions snapshotOptions;
+            snapshotOptions.keepJournalRecords = kHistoryReplayRecords;
+            snapshotter = std::make_unique<Snapshotter>(snapshotPath, *journal, snapshotOptions);
+            if (recovery.openedInPlace) {
+                qDebug() << "Ready in" << recovery.readySeconds() * 1000 << "ms: closed cleanly, opened in place";
+            } else {
+                qDebug() << "Ready in" << recovery.readySeconds() * 1000 << "ms: snapshot at LSN"
+                         << recovery.snapshotLsn << "," << recovery.replayed << "journal records replayed on"
+                         << recovery.threads << "thread(s)";
+            }
+        } catch (const std::exception& e) {
+            QMessageBox::critical(nullptr, "Account Data", e.what());
+        }
+        accounts = std::make_unique<ShardedAccountStore>(std::move(accountFile));
+        std::string hotCardPath = (dataDir + "/hotcards.txt").toStdString();
+        if (QFile::exists(QString::fromStdString(hotCardPath))) {
+            try {
+                accounts->hotCards().replace(atm::HotCardList::readFile(hotCardPath));
+            } catch (const std::exception& e) {
+                QMessageBox::warning(nullptr, "Hot Card List", e.what());
+            }
+        }
+        // Routing follows bins.txt as it is edited; the new table is swapped
+        // in atomically. Accounts added to accounts.csv are served the same
+        // way, starting with any added while the app was not running.
+        // The directory is watched too, to see the files created or replaced.
+        binTablePath = dataDir + "/bins.txt";
+        reloadBinTable();
+        reloadAccounts();
+        dataFileWatcher.addPath(dataDir);
+        connect(&dataFileWatcher, &QFileSystemWatcher::fileChanged, this, [this] {
+            reloadBinTable();
+            reloadAccounts();
+        });
+        connect(&dataFileWatcher, &QFileSystemWatcher::directoryChanged, this, [this] {
+            reloadBinTable();
+            reloadAccounts();
+        });
+        if (journal) {
+            std::uint64_t lastLsn = journal->lastLsn();
+            accounts->history().replay(journalPath, lastLsn > kHistoryReplayRecords ? lastLsn - kHistoryReplayRecords : 0);
+        }
+    }
+
+    // Appends a completed transaction to the journal. The customer is only
+    // told it succeeded once this returns its LSN (0 on failure).
+    std::uint64_t recordTransaction(atm::TxnType type, int amount, atm::Money balanceAfter) {
+        try {
+            if (!journal) throw std::runtime_error("The transaction journal is not open.");
+            return journal->append(atm::makeJournalRecord(type, currentSession.accountNumber(),
+                                                          atm::rupees(amount), balanceAfter, kTerminalId));
+        } catch (const std::exception& e) {
+            QMessageBox::critical(this, "Journal", e.what());
+            return 0;
+        }
+    }
+
+    // Records cash handed out for the withdrawal journaled as debitLsn, for
+    // reconciliation against the account journal.
+    void recordDispense(std::uint64_t debitLsn, int amount, atm::Money balanceAfter) {
+        try {
+            if (dispenseLog) {
+                dispenseLog->append(atm::makeJournalRecord(atm::TxnType::Withdrawal, currentSession.accountNumber(),
+                                                           atm::rupees(amount), balanceAfter, kTerminalId, debitLsn));
+            }
+        } catch (const std::exception& e) {
+            qWarning() << "Dispense log write failed:" << e.what();
+        }
+    }
+
     void applyModernStyle() {
         QString styleSheet = R"(
             QWidget {
@@ -499,28 +604,34 @@ private:
 
         connect(verifyAccBtn, &QPushButton::clicked, [this]() {
             int accNum = accInput->text().toInt();
-            pendingAccount = nullptr;
-            for (int i = 0; i < 3; i++) {
-                if (accounts[i].getAccountNumber() == accNum) {
-                    pendingAccount = &accounts[i];
-                    break;
-                }
-            }
+            pendingAccount = accounts->findByAccount(accNum);
             if (pendingAccount) switchToPinMode();
             else QMessageBox::critical(this, "Error", "Account Number not found.");
         });
 
         connect(loginBtn, &QPushButton::clicked, [this]() {
             if (!pendingAccount) return;
-            if (pendingAccount->validatePin(pinInput->text().toInt())) {
-                currentSession = pendingAccount;
-                refreshDashboard();
-                stackedLayout->setCurrentIndex(1);
-                resetLoginUI();
-            } else {
-                QMessageBox::critical(this, "Access Denied", "Invalid PIN code.");
-                pinInput->clear();
+            std::uint64_t id = ++pinCheckId;
+            long long pan = pendingAccount.cardNumber() ? pendingAccount.cardNumber() : pendingAccount.accountNumber();
+            atm::PinBlock block;
+            try {
+                block = atm::encryptPinBlock(pinPadKey, atm::PinBlockFormat::Iso4, pinInput->text().toStdString(), pan);
+            } catch (const std::invalid_argument&) {
+                finishLogin(id, atm::PinResult::Mismatch);   // not 4 to 12 digits
+                return;
             }
+            bool queued = pinVerifier.submit(pendingAccount.pinCredential(), block, pan,
+                                             [this, id](atm::PinResult result) {
+                // Worker thread: hand the result back to the GUI thread.
+                QMetaObject::invokeMethod(this, [this, id, result]() { finishLogin(id, result); },
+                                          Qt::QueuedConnection);
+            });
+            if (!queued) {
+                finishLogin(id, atm::PinResult::Busy);
+                return;
+            }
+            loginBtn->setEnabled(false);
+            loginBtn->setText("Verifying...");
         });
 
         connect(cancelBtn, &QPushButton::clicked, [this]() {
@@ -555,17 +666,65 @@ private:
         pageLayout->addWidget(card);
     }
 
+    void reloadBinTable() {
+        QFileInfo info(binTablePath);
+        if (!info.exists()) return;
+        if (!dataFileWatcher.files().contains(binTablePath)) dataFileWatcher.addPath(binTablePath);
+        if (info.lastModified() == binTableModified) return;
+        binTableModified = info.lastModified();
+        try {
+            accounts->binRoutes().reload(binTablePath.toStdString());
+            qDebug() << "BIN table loaded:" << accounts->binRoutes().table()->prefixCount() << "prefixes";
+        } catch (const std::exception& e) {
+            QMessageBox::warning(this, "BIN Table", e.what());
+        }
+    }
+
+    // Serves the accounts added to accounts.csv next to the existing ones,
+    // whose balances are kept, and adds them to the snapshot so a restart
+    // keeps them. Customers signed in carry on undisturbed.
+    void reloadAccounts() {
+        QFileInfo info(accountImportPath);
+        if (!info.exists()) return;
+        if (!dataFileWatcher.files().contains(accountImportPath)) dataFileWatcher.addPath(accountImportPath);
+        if (info.lastModified() == accountImportModified) return;
+        accountImportModified = info.lastModified();
+        try {
+            atm::AccountStore imported;
+            atm::importAccounts(accountImportPath.toStdString(), imported);
+            atm::ReloadReport report = accounts->reload(imported, accountFilePath.toStdString(),
+                [this](const std::vector<Account>& added, const std::vector<atm::CardLink>& cards) {
+                    if (snapshotter) snapshotter->addAccounts(added, cards);
+                });
+            qDebug() << "Accounts reloaded:" << report.added << "added," << report.skipped
+                     << "skipped (card in use)," << report.accounts << "served; built in"
+                     << report.buildSeconds * 1000 << "ms, balances held for" << report.freezeSeconds * 1000 << "ms";
+        } catch (const std::exception& e) {
+            QMessageBox::warning(this, "Accounts", e.what());
+        }
+    }
+
     void handleNfcSuccess(long long cardNum) {
-        pendingAccount = nullptr;
-        for (int i = 0; i < 3; i++) {
-            if (accounts[i].getCardNumber() == cardNum) {
-                pendingAccount = &accounts[i];
-                break;
-            }
+        // Off-us cards are routed by issuer prefix before any account lookup.
+        atm::BinRouter::Pinned bins = accounts->binRoutes().table();
+        atm::BinTable::RouteId route = bins->route(cardNum);
+        if (route != atm::BinTable::kOnUs) {
+            QString message = route == atm::BinTable::kUnrouted
+                                  ? QString("No route for this card's issuer.")
+                                  : QString("Card issued by another bank: forwarding to the %1 network is not available on "
+                                            "this ATM.").arg(qString(bins->routeName(route)));
+            QMessageBox::warning(this, "Card Not Supported", message);
+            resetLoginUI();
+            return;
         }
+        bool blocked = false;
+        pendingAccount = accounts->findByCard(cardNum, &blocked);
         if (pendingAccount) {
             nfcStatusLabel->setVisible(false);
             switchToPinMode();
+        } else if (blocked) {
+            QMessageBox::warning(this, "Card Blocked", "This card has been blocked. Please contact your bank.");
+            resetLoginUI();
         } else {
             QMessageBox::warning(this, "NFC Error", "Card detected but not recognized in database.");
             resetLoginUI();
@@ -581,7 +740,7 @@ private:
         nfcCardImage->setVisible(false);
 
         titleLabel->setText("AUTHENTICATION");
-        userLabel->setText("Hi, " + pendingAccount->getName());
+        userLabel->setText("Hi, " + qString(pendingAccount.holderName()));
         userLabel->setVisible(true);
         pinInput->setVisible(true);
         loginBtn->setVisible(true);
@@ -611,13 +770,22 @@ private:
 
         QPushButton* depositBtn = new QPushButton("💰  Deposit Funds");
         QPushButton* withdrawBtn = new QPushButton("💸  Withdraw Cash");
+        QPushButton* statementBtn = new QPushButton("🧾  Mini Statement");
         QPushButton* logoutBtn = new QPushButton("⏏  Eject Card");
         logoutBtn->setObjectName("logoutBtn");
 
         connect(depositBtn, &QPushButton::clicked, [this]() {
             bool ok;
-            double amount = QInputDialog::getDouble(this, "Deposit", "Amount:", 0, 0, 10000, 2, &ok);
-            if (ok && currentSession && currentSession->deposit(amount)) {
+            int amount = QInputDialog::getInt(this, "Deposit", "Amount:", 0, 0, 10000, atm::kNoteDenomination, &ok);
+            atm::Money balanceAfter;
+            if (ok && currentSession && currentSession.deposit(atm::rupees(amount), &balanceAfter) == TxnStatus::Ok) {
+                if (!recordTransaction(atm::TxnType::Deposit, amount, balanceAfter)) {
+                    // Not on the books, so it must not stay in the balance either.
+                    currentSession.reverseDeposit(atm::rupees(amount));
+                    refreshDashboard();
+                    return;
+                }
+                accounts->sync(currentSession);
                 QMessageBox::information(this, "Success", "Funds Deposited.");
                 refreshDashboard();
             }
@@ -625,19 +793,39 @@ private:
 
         connect(withdrawBtn, &QPushButton::clicked, [this]() {
             bool ok;
-            double amount = QInputDialog::getDouble(this, "Withdraw", "Amount:", 0, 0, 10000, 2, &ok);
+            int amount = QInputDialog::getInt(this, "Withdraw", "Amount:", 0, 0, 10000, atm::kNoteDenomination, &ok);
             if (ok && currentSession) {
-                if (currentSession->withdraw(amount)) {
+                atm::Money balanceAfter;
+                TxnStatus status = currentSession.tryWithdraw(atm::rupees(amount), &balanceAfter);
+                if (status == TxnStatus::Ok) {
+                    std::uint64_t lsn = recordTransaction(atm::TxnType::Withdrawal, amount, balanceAfter);
+                    if (!lsn) {
+                        currentSession.reverseWithdrawal(atm::rupees(amount));
+                        refreshDashboard();
+                        return;
+                    }
+                    accounts->sync(currentSession);
                     QMessageBox::information(this, "Success", "Please take your cash.");
+                    recordDispense(lsn, amount, balanceAfter);
                     refreshDashboard();
-                } else {
+                } else if (status == TxnStatus::InsufficientFunds) {
                     QMessageBox::warning(this, "Error", "Insufficient funds.");
+                } else {
+                    QMessageBox::warning(this, "Error", "Amount must be a multiple of 100.");
                 }
             }
         });
 
+        connect(statementBtn, &QPushButton::clicked, [this]() {
+            if (currentSession) showMiniStatement();
+        });
+
         connect(logoutBtn, &QPushButton::clicked, [this]() {
-            currentSession = nullptr;
+            currentSession = AccountHandle();
+            atm::SessionArena::Stats s = sessionArena.stats();
+            sessionArena.release();
+            qDebug() << "Session used" << s.allocations << "arena allocations (" << s.bytes << "bytes);"
+                     << s.heapAllocations << "heap allocations by the arena since startup";
             resetLoginUI();
             stackedLayout->setCurrentIndex(0);
         });
@@ -649,6 +837,7 @@ private:
         cardLayout->addSpacing(20);
         cardLayout->addWidget(depositBtn);
         cardLayout->addWidget(withdrawBtn);
+        cardLayout->addWidget(statementBtn);
         cardLayout->addSpacing(20);
         cardLayout->addWidget(logoutBtn);
 
@@ -684,7 +873,7 @@ private:
 
         connect(genQrBtn, &QPushButton::clicked, [this]() {
             double amount = upiAmtInput->text().toDouble();
-            if (amount <= 0 || amount > 10000 || amount % 100 != 0) {
+            if (amount > 10000 || amount != static_cast<int>(amount) || !atm::isValidCashAmount(atm::rupees(static_cast<int>(amount)))) {
                 QMessageBox::warning(this, "Invalid", "Please enter a valid amount.");
                 return;
             }
@@ -749,8 +938,35 @@ private:
     }
 
     // --- Helper Functions ---
+    static atm::PinVerifierOptions pinVerifierOptions(const atm::Aes128* key) {
+        atm::PinVerifierOptions options;
+        options.pinKey = key;
+        return options;
+    }
+
+    void finishLogin(std::uint64_t id, atm::PinResult result) {
+        if (id != pinCheckId) return;   // the login was cancelled or retried meanwhile
+        loginBtn->setEnabled(true);
+        loginBtn->setText("Access Account ➜");
+        if (!pendingAccount) return;
+        if (result == atm::PinResult::Match) {
+            currentSession = pendingAccount;
+            refreshDashboard();
+            stackedLayout->setCurrentIndex(1);
+            resetLoginUI();
+        } else if (result == atm::PinResult::Busy) {
+            QMessageBox::warning(this, "Please Wait", "The ATM is busy. Please try again.");
+        } else {
+            QMessageBox::critical(this, "Access Denied", "Invalid PIN code.");
+            pinInput->clear();
+        }
+    }
+
     void resetLoginUI() {
-        pendingAccount = nullptr;
+        pendingAccount = AccountHandle();
+        ++pinCheckId;
+        loginBtn->setEnabled(true);
+        loginBtn->setText("Access Account ➜");
         accInput->clear();
         pinInput->clear();
         titleLabel->setText("BANK ATM");
@@ -771,8 +987,36 @@ private:
 
     void refreshDashboard() {
         if (!currentSession) return;
-        welcomeLabel->setText("Hello, " + currentSession->getName());
-        balanceLabel->setText("₹" + QString::number(currentSession->getBalance(), 'f', 2));
+        welcomeLabel->setText("Hello, " + qString(currentSession.holderName()));
+        std::pmr::memory_resource* session = sessionArena.resource();
+        atm::AccountSnapshot money = currentSession.snapshot();
+        balanceLabel->setText("₹" + qString(atm::formatMoney(money.available(), session)));
+        balanceLabel->setToolTip(QString("On hold: ₹%1\nWithdrawn today: ₹%2")
+                                     .arg(qString(atm::formatMoney(money.holds, session)))
+                                     .arg(qString(atm::formatMoney(money.day >= atm::currentDay() ? money.withdrawnToday : 0,
+                                                                   session))));
+    }
+
+    // Core strings become QStrings only here, at the UI edge.
+    static QString qString(std::string_view text) {
+        return QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+    }
+
+    void showMiniStatement() {
+        QString text;
+        std::pmr::memory_resource* session = sessionArena.resource();
+        for (const atm::HistoryEntry& e : currentSession.recentTransactions(kMiniStatementLines, session)) {
+            bool credit = e.type == atm::TxnType::Deposit || e.type == atm::TxnType::Credit;
+            text += QString("%1   %2   %3₹%4   Bal ₹%5\n")
+                        .arg(QDateTime::fromMSecsSinceEpoch(e.timestampUs / 1000).toString("dd-MM-yyyy hh:mm"))
+                        .arg(atm::txnTypeName(e.type))
+                        .arg(credit ? "+" : "-")
+                        .arg(qString(atm::formatMoney(e.amount, session)))
+                        .arg(qString(atm::formatMoney(e.balanceAfter, session)));
+        }
+        if (text.isEmpty()) text = "No recent transactions.\n";
+        text += "\nAvailable Balance: ₹" + qString(atm::formatMoney(currentSession.balance(), session));
+        QMessageBox::information(this, "Mini Statement", text);
     }
 
     void generateAndShowQR(double amount) {
@@ -5,7 +5,6 @@
 #include <QTcpServer>
 #include <QTcpSocket>
 #include <QHostAddress>
-#include <string>
 
 // We moved the class definition here
 class NfcWorker : public QThread {
@@ -17,9 +16,6 @@ signals:
 
 protected:
     void run() override; // Implementation is in the cpp file
-
-private:
-    std::string parseJsonValue(std::string body, std::string key);
 };
 
 #endif // NFCWORKER_H
@@ -0,0 +1,40 @@
+# Micro-benchmarks for the core library: ./app/atm_bench <benchmark> [args]
+CONFIG -= qt
+CONFIG += c++17 console ltcg
+
+TARGET = atm_bench
+TEMPLATE = app
+
+DESTDIR = ./app
+
+SOURCES += \
+    main.cpp \
+    bench_bins.cpp \
+    bench_cards.cpp \
+    bench_columns.cpp \
+    bench_eod.cpp \
+    bench_hotcards.cpp \
+    bench_import.cpp \
+    bench_journal.cpp \
+    bench_layout.cpp \
+    bench_names.cpp \
+    bench_namesearch.cpp \
+    bench_pinblocks.cpp \
+    bench_pins.cpp \
+    bench_query.cpp \
+    bench_reconcile.cpp \
+    bench_recovery.cpp \
+    bench_reload.cpp \
+    bench_scaling.cpp \
+    bench_segments.cpp \
+    bench_seqlock.cpp \
+    bench_session.cpp
+
+HEADERS += bench.h
+
+INCLUDEPATH += ../core
+DEPENDPATH += ../core
+LIBS += -L$$OUT_PWD/../core/lib -latm_core
+
+win32-msvc*: PRE_TARGETDEPS += $$OUT_PWD/../core/lib/atm_core.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/../core/lib/libatm_core.a
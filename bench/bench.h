@@ -0,0 +1,57 @@
+#ifndef ATM_BENCH_H
+#define ATM_BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+namespace bench {
+
+class Stopwatch {
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {}
+    void reset() { start = std::chrono::steady_clock::now(); }
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Stores a result where the optimizer cannot prove it unused.
+inline volatile std::int64_t keepSink;
+
+inline void keep(std::int64_t value) {
+    keepSink = value;
+}
+
+inline long argOr(int argc, char** argv, int index, long fallback) {
+    return index < argc ? std::strtol(argv[index], nullptr, 10) : fallback;
+}
+
+// --- Benchmarks (one source file each) ---
+int runBins(int argc, char** argv);
+int runCards(int argc, char** argv);
+int runColumns(int argc, char** argv);
+int runEod(int argc, char** argv);
+int runHotCards(int argc, char** argv);
+int runImport(int argc, char** argv);
+int runJournal(int argc, char** argv);
+int runLayout(int argc, char** argv);
+int runNames(int argc, char** argv);
+int runNameSearch(int argc, char** argv);
+int runPinBlocks(int argc, char** argv);
+int runPins(int argc, char** argv);
+int runQuery(int argc, char** argv);
+int runReconcile(int argc, char** argv);
+int runRecovery(int argc, char** argv);
+int runReload(int argc, char** argv);
+int runScaling(int argc, char** argv);
+int runSegments(int argc, char** argv);
+int runSeqlock(int argc, char** argv);
+int runSession(int argc, char** argv);
+
+} // namespace bench
+
+#endif // ATM_BENCH_H
@@ -0,0 +1,90 @@
+// BIN routing: cards classified by longest issuer prefix, one at a time
+// and through the lockstep batch, and the cost of building and publishing
+// a new table (a reload).
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "bin_table.h"
+
+namespace {
+
+const char* const kRoutes[] = {"onus", "VISA", "MASTERCARD", "RUPAY", "AMEX", "DISCOVER"};
+
+std::vector<atm::BinTable::Entry> makeEntries(std::size_t count) {
+    std::mt19937_64 rng(43);
+    std::uniform_int_distribution<int> length(6, atm::BinTable::kMaxPrefixDigits);
+    std::uniform_int_distribution<std::size_t> route(0, std::size(kRoutes) - 1);
+    std::vector<atm::BinTable::Entry> entries;
+    // Network-wide defaults first, then issuer prefixes inside them.
+    entries.push_back({"4", "VISA"});
+    entries.push_back({"5", "MASTERCARD"});
+    entries.push_back({"6", "RUPAY"});
+    std::vector<std::string> seen{"4", "5", "6"};
+    while (entries.size() < count) {
+        std::string prefix = std::to_string(4 + rng() % 3);
+        int digits = length(rng);
+        while (static_cast<int>(prefix.size()) < digits) prefix += static_cast<char>('0' + rng() % 10);
+        entries.push_back({prefix, kRoutes[route(rng)]});
+    }
+    // Drop repeats (rare at these lengths).
+    std::sort(entries.begin(), entries.end(),
+              [](const atm::BinTable::Entry& a, const atm::BinTable::Entry& b) { return a.prefix < b.prefix; });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const atm::BinTable::Entry& a, const atm::BinTable::Entry& b) { return a.prefix == b.prefix; }),
+                  entries.end());
+    return entries;
+}
+
+} // namespace
+
+namespace bench {
+
+int runBins(int argc, char** argv) {
+    std::size_t prefixes = static_cast<std::size_t>(argOr(argc, argv, 1, 50000));
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 2, 10000000));
+
+    std::vector<atm::BinTable::Entry> entries = makeEntries(prefixes);
+    Stopwatch sw;
+    atm::BinTable table(entries);
+    double build = sw.seconds();
+    atm::BinRouter router;
+    sw.reset();
+    router.replace(table);
+    double publish = sw.seconds();
+
+    std::mt19937_64 rng(44);
+    std::uniform_int_distribution<long long> pan(3000000000000000LL, 6999999999999999LL);
+    std::vector<long long> pans(count);
+    for (long long& p : pans) p = pan(rng);
+
+    atm::BinRouter::Pinned bins = router.table();
+    std::vector<atm::BinTable::RouteId> single(count), batch(count);
+    sw.reset();
+    for (std::size_t i = 0; i < count; i++) single[i] = bins->route(pans[i]);
+    double singleSeconds = sw.seconds();
+    sw.reset();
+    bins->route(pans.data(), count, batch.data());
+    double batchSeconds = sw.seconds();
+    if (single != batch) {
+        std::fprintf(stderr, "batch and single routing disagree\n");
+        return 1;
+    }
+
+    std::size_t onUs = 0;
+    for (atm::BinTable::RouteId r : batch) onUs += r == atm::BinTable::kOnUs;
+    keep(static_cast<std::int64_t>(onUs));
+
+    std::printf("%zu prefixes -> %zu ranges (built in %.1f ms, published in %.1f us), %zu cards, %.1f%% on-us\n",
+                bins->prefixCount(), bins->rangeCount(), build * 1e3, publish * 1e6, count, 100.0 * onUs / count);
+    std::printf("%-10s %10s %12s\n", "", "ns/card", "Mcards/s");
+    std::printf("%-10s %10.2f %12.1f\n", "single", singleSeconds * 1e9 / count, count / singleSeconds / 1e6);
+    std::printf("%-10s %10.2f %12.1f\n", "batch", batchSeconds * 1e9 / count, count / batchSeconds / 1e6);
+    return 0;
+}
+
+} // namespace bench
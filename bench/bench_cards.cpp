@@ -0,0 +1,56 @@
+// Card-number pre-validation (length and Luhn check digit) one number at
+// a time versus the batch validateCardNumbers(), which runs eight numbers
+// wide with AVX2. Half of the numbers carry a wrong check digit, as a
+// replayed stream of garbled taps would.
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "card_number.h"
+#include "cpu_features.h"
+
+namespace bench {
+
+int runCards(int argc, char** argv) {
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 1, 4000000));
+    int rounds = static_cast<int>(argOr(argc, argv, 2, 5));
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<long long> body(400000000000000LL, 499999999999999LL);
+    std::vector<long long> pans(count);
+    for (std::size_t i = 0; i < count; i++) {
+        long long pan = atm::appendLuhnDigit(body(rng));
+        pans[i] = i & 1 ? pan ^ 1 : pan;   // flips the check digit's low bit: always invalid
+    }
+    std::unique_ptr<bool[]> valid(new bool[count]);
+
+    Stopwatch sw;
+    std::size_t scalarValid = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (std::size_t i = 0; i < count; i++) scalarValid += atm::isValidCardNumber(pans[i]);
+    }
+    double scalar = sw.seconds();
+
+    sw.reset();
+    std::size_t batchValid = 0;
+    for (int r = 0; r < rounds; r++) batchValid += atm::validateCardNumbers(pans.data(), count, valid.get());
+    double batch = sw.seconds();
+    keep(static_cast<std::int64_t>(scalarValid + batchValid));
+    if (scalarValid != batchValid) {
+        std::fprintf(stderr, "batch and single checks disagree: %zu vs %zu\n", batchValid, scalarValid);
+        return 1;
+    }
+
+    double checks = static_cast<double>(count) * rounds;
+    std::printf("%zu card numbers x %d rounds, %zu valid per round, AVX2 %s\n", count, rounds, batchValid / rounds,
+                atm::cpuHasAvx2() ? "yes" : "no");
+    std::printf("%-24s %10s %12s\n", "", "ns/card", "Mcards/s");
+    std::printf("%-24s %10.2f %12.1f\n", "isValidCardNumber", scalar * 1e9 / checks, checks / scalar / 1e6);
+    std::printf("%-24s %10.2f %12.1f\n", "validateCardNumbers", batch * 1e9 / checks, checks / batch / 1e6);
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,105 @@
+// Columnar journal export: export throughput from 1 thread up to the
+// requested maximum, the size of each encoded column, and summing the
+// amount column from the export against reading every journal record.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "journal.h"
+#include "journal_columns.h"
+
+using atm::JournalColumn;
+using atm::JournalRecord;
+using atm::TxnType;
+
+namespace {
+
+// A day's traffic shape: mostly cash in whole notes from a few terminals,
+// some interest credits in arbitrary paise, timestamps a few ms apart.
+void writeJournal(const std::string& path, std::size_t count) {
+    atm::JournalOptions options;
+    options.durability = atm::Durability::Async;
+    atm::Journal journal(path, options);
+    std::mt19937_64 rng(11);
+    std::vector<JournalRecord> batch;
+    batch.reserve(4096);
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint64_t roll = rng() % 100;
+        TxnType type = roll < 55 ? TxnType::Withdrawal : roll < 90 ? TxnType::Deposit : roll < 97 ? TxnType::Credit : TxnType::Debit;
+        atm::Money amount = type == TxnType::Credit ? static_cast<atm::Money>(rng() % 50000)
+                                                    : atm::rupees(100 * static_cast<long long>(1 + rng() % 100));
+        batch.push_back(atm::makeJournalRecord(type, static_cast<int>(100000 + rng() % 2000000), amount,
+                                               static_cast<atm::Money>(rng() % 10000000000LL),
+                                               static_cast<std::uint32_t>(1 + rng() % 40)));
+        if (batch.size() == batch.capacity()) {
+            journal.append(batch.data(), batch.size());
+            batch.clear();
+        }
+    }
+    journal.append(batch.data(), batch.size());
+    journal.flush();
+}
+
+} // namespace
+
+namespace bench {
+
+int runColumns(int argc, char** argv) {
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 1, 4000000));
+    unsigned maxThreads = static_cast<unsigned>(argOr(argc, argv, 2, std::thread::hardware_concurrency()));
+    if (maxThreads == 0) maxThreads = 1;
+
+    const std::string journalPath = "bench_columns_journal.tmp";
+    const std::string columnPath = "bench_columns_export.tmp";
+    std::remove(journalPath.c_str());
+    writeJournal(journalPath, count);
+    std::printf("%zu journal records (%.0f MB)\n\n", count, count * sizeof(JournalRecord) / 1e6);
+
+    std::printf("%8s %10s %12s %10s\n", "threads", "export s", "M rows/s", "ratio");
+    atm::ColumnExportStats stats;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        atm::ColumnExportOptions options;
+        options.threads = threads;
+        stats = atm::exportJournalColumns(journalPath, columnPath, options);
+        std::printf("%8u %10.2f %12.2f %9.1fx\n", threads, stats.seconds, stats.rows / stats.seconds / 1e6,
+                    static_cast<double>(stats.journalBytes) / stats.fileBytes);
+    }
+    std::printf("\n%-10s %12s %10s\n", "column", "bytes", "bits/row");
+    for (std::size_t c = 0; c < atm::kJournalColumns; c++) {
+        std::printf("%-10s %12llu %10.2f\n", atm::journalColumnName(static_cast<JournalColumn>(c)),
+                    static_cast<unsigned long long>(stats.columnBytes[c]), stats.columnBytes[c] * 8.0 / stats.rows);
+    }
+
+    // Total of the amount column: the export reads one column, the journal
+    // every byte of every record.
+    Stopwatch sw;
+    atm::ColumnFile file = atm::ColumnFile::open(columnPath);
+    std::vector<std::int64_t> values;
+    std::int64_t columnSum = 0;
+    for (std::size_t g = 0; g < file.rowGroupCount(); g++) {
+        file.readColumn(g, JournalColumn::Amount, values);
+        for (std::int64_t v : values) columnSum += v;
+    }
+    double columnSeconds = sw.seconds();
+
+    sw.reset();
+    atm::JournalReader reader(journalPath);
+    JournalRecord record;
+    std::int64_t journalSum = 0;
+    while (reader.next(record)) journalSum += record.amount;
+    double journalSeconds = sw.seconds();
+    keep(columnSum + journalSum);
+
+    std::printf("\nsum of amounts: column scan %.3f s (%.1f MB read), journal scan %.3f s (%.1f MB), %s\n", columnSeconds,
+                file.bytesRead() / 1e6, journalSeconds, count * sizeof(JournalRecord) / 1e6,
+                columnSum == journalSum ? "same total" : "TOTALS DIFFER");
+    std::remove(journalPath.c_str());
+    std::remove(columnPath.c_str());
+    return 0;
+}
+
+} // namespace bench
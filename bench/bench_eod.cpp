@@ -0,0 +1,93 @@
+// End-of-day batch over a large account set: interest on every account,
+// a share of dormant accounts and open withdrawal totals, from 1 thread up
+// to the requested maximum, then once more with the interest journaled.
+// Reports wall time, accounts per second, and what that rate means for a
+// 50 million account bank.
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "bench.h"
+#include "end_of_day.h"
+#include "journal.h"
+#include "sharded_account_store.h"
+
+using atm::Account;
+using atm::AccountStore;
+using atm::EndOfDayOptions;
+using atm::EndOfDayReport;
+using atm::ShardedAccountStore;
+
+namespace {
+
+constexpr double kTargetAccounts = 50e6;
+
+void printRow(const char* label, const EndOfDayReport& r) {
+    std::printf("%-10s %8u %10.1f %10.1f %10.1f %12.2f %12.1f\n", label, r.threads, r.snapshotSeconds * 1000,
+                r.processSeconds * 1000, r.wallSeconds() * 1000, r.recordsPerSecond() / 1e6,
+                kTargetAccounts / r.recordsPerSecond());
+}
+
+} // namespace
+
+namespace bench {
+
+int runEod(int argc, char** argv) {
+    std::size_t accounts = static_cast<std::size_t>(argOr(argc, argv, 1, 2000000));
+    unsigned maxThreads = static_cast<unsigned>(argOr(argc, argv, 2, std::thread::hardware_concurrency()));
+    if (maxThreads == 0) maxThreads = 1;
+
+    std::uint32_t today = atm::currentDay();
+    std::vector<Account> seed;
+    seed.reserve(accounts);
+    for (std::size_t i = 0; i < accounts; i++) {
+        int number = static_cast<int>(100000 + i);
+        seed.emplace_back(number, "Holder " + std::to_string(i), atm::rupees(1000 + static_cast<long long>(i % 90000)),
+                          atm::PinCredential(), 4000000000000000LL + static_cast<long long>(i));
+        Account& a = seed.back();
+        // 1 in 20 untouched for three years, 1 in 4 withdrew today.
+        a.markActive(i % 20 == 0 ? today - 1100 : today - static_cast<std::uint32_t>(i % 300));
+        if (i % 4 == 0) a.applyWithdrawal(atm::rupees(500), today);
+    }
+    AccountStore backing;
+    backing.bulkLoad(std::move(seed));
+    ShardedAccountStore store(backing);
+
+    std::printf("%zu accounts (%.0f MB of records), %u hardware threads\n", accounts,
+                accounts * sizeof(Account) / 1e6, std::thread::hardware_concurrency());
+    std::printf("%-10s %8s %10s %10s %10s %12s %12s\n", "journal", "threads", "snap ms", "process ms", "wall ms",
+                "M accts/s", "50M est s");
+
+    EndOfDayOptions options;
+    options.businessDay = today;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        options.threads = threads;
+        EndOfDayReport r = atm::runEndOfDay(store, nullptr, options);
+        printRow("none", r);
+        keep(r.interestTotal);
+        options.businessDay++;   // each pass closes the next day, so counters roll again
+    }
+
+    // Same batch with one interest record per account in an async journal.
+    std::string path = "bench_eod_journal.tmp";
+    std::remove(path.c_str());
+    {
+        atm::JournalOptions journalOptions;
+        journalOptions.durability = atm::Durability::Async;
+        atm::Journal journal(path, journalOptions);
+        options.threads = maxThreads;
+        EndOfDayReport r = atm::runEndOfDay(store, &journal, options);
+        journal.flush();
+        printRow("async", r);
+        std::printf("%zu interest records journaled, %zu newly dormant, %zu counters reset\n", r.interestCredited,
+                    r.newlyDormant, r.countersReset);
+    }
+    std::remove(path.c_str());
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,82 @@
+// Hot-card list: lookup cost for cards on and off the list, bulk replace
+// time, incremental updates, and lookups while a new list is being
+// published from another thread.
+
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "hot_card_list.h"
+
+using atm::HotCardList;
+
+namespace {
+
+std::vector<long long> randomCards(std::size_t n, unsigned seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<long long> pan(4000000000000000LL, 4999999999999999LL);
+    std::vector<long long> cards(n);
+    for (long long& c : cards) c = pan(rng);
+    return cards;
+}
+
+double lookupNs(const HotCardList& list, const std::vector<long long>& probes, std::size_t lookups) {
+    std::int64_t hits = 0;
+    bench::Stopwatch sw;
+    for (std::size_t i = 0; i < lookups; i++) hits += list.contains(probes[i % probes.size()]);
+    double ns = sw.seconds() * 1e9 / lookups;
+    bench::keep(hits);
+    return ns;
+}
+
+} // namespace
+
+namespace bench {
+
+int runHotCards(int argc, char** argv) {
+    std::size_t cards = static_cast<std::size_t>(argOr(argc, argv, 1, 1000000));
+    std::size_t lookups = static_cast<std::size_t>(argOr(argc, argv, 2, 10000000));
+
+    std::vector<long long> listed = randomCards(cards, 1);
+    std::vector<long long> others = randomCards(1 << 20, 2);
+
+    HotCardList list;
+    Stopwatch sw;
+    list.replace(listed);
+    std::printf("%zu cards on the list, replace() %.1f ms\n", list.size(), sw.seconds() * 1000);
+
+    std::printf("lookup, card not listed:  %6.1f ns\n", lookupNs(list, others, lookups));
+    std::printf("lookup, card listed:      %6.1f ns\n", lookupNs(list, listed, lookups));
+
+    sw.reset();
+    const std::size_t updates = 20000;
+    for (std::size_t i = 0; i < updates; i++) {
+        list.add(others[i]);
+        list.remove(listed[i]);
+    }
+    std::printf("add + remove:             %6.1f us per pair (delta folded every 1024 changes)\n",
+                sw.seconds() * 1e6 / updates);
+
+    // A reader thread keeps looking up while the list is replaced.
+    std::atomic<bool> stop{false};
+    double duringReplace = 0;
+    std::thread reader([&] {
+        std::size_t rounds = 0;
+        double total = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            total += lookupNs(list, others, 100000);
+            rounds++;
+        }
+        duringReplace = rounds ? total / rounds : 0;
+    });
+    for (int i = 0; i < 5; i++) list.replace(listed);
+    stop = true;
+    reader.join();
+    std::printf("lookup during 5 replaces: %6.1f ns\n", duringReplace);
+    return 0;
+}
+
+} // namespace bench
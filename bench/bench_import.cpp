@@ -0,0 +1,96 @@
+// Bulk CSV import: generates an account file and loads it into an
+// AccountStore, reporting the time spent in each stage. The file carries
+// pre-hashed PINs; a second, smaller file with plaintext PINs then shows
+// what hashing them at kDefaultPinCost during the import costs, projected
+// to 50M records.
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "account_import.h"
+#include "account_store.h"
+#include "bench.h"
+#include "card_number.h"
+#include "pin_hash.h"
+
+namespace {
+
+// Holder i's first card; i's second card, when it has one, is issued
+// from the next body up.
+long long cardFor(std::size_t i, int which = 0) {
+    return atm::appendLuhnDigit(400000000000000LL + static_cast<long long>(i) * 2 + which);
+}
+
+void writeAccounts(const std::string& path, std::size_t records, bool plainPins = false) {
+    std::FILE* out = std::fopen(path.c_str(), "wb");
+    if (!out) return;
+    std::fputs("account,name,balance,pin,cards\n", out);
+    // Pre-hashed, as an export from another system would be, unless the
+    // plaintext cost is what is being measured.
+    const std::string pin = plainPins ? std::string("1234")
+                                      : atm::formatPinCredential(atm::hashPin("1234", atm::kMinPinCost));
+    char line[224];
+    for (std::size_t i = 0; i < records; i++) {
+        long long card = cardFor(i);
+        int n;
+        if (i % 10 == 0) {
+            // Some holders have a second card and a quoted name.
+            n = std::snprintf(line, sizeof(line), "%zu,\"Holder, %zu\",%zu.%02zu,%s,%lld,%lld\n", 100000 + i, i,
+                              i % 100000, i % 100, pin.c_str(), card, cardFor(i, 1));
+        } else {
+            n = std::snprintf(line, sizeof(line), "%zu,Holder %zu,%zu.%02zu,%s,%lld\n", 100000 + i, i,
+                              i % 100000, i % 100, pin.c_str(), card);
+        }
+        std::fwrite(line, 1, static_cast<std::size_t>(n), out);
+    }
+    std::fclose(out);
+}
+
+} // namespace
+
+namespace bench {
+
+int runImport(int argc, char** argv) {
+    std::size_t records = static_cast<std::size_t>(argOr(argc, argv, 1, 5000000));
+    unsigned maxThreads = static_cast<unsigned>(argOr(argc, argv, 2, std::max(1u, std::thread::hardware_concurrency())));
+    std::size_t plainRecords = static_cast<std::size_t>(argOr(argc, argv, 3, 2000));
+    const std::string path = "bench_import.csv";
+
+    Stopwatch sw;
+    writeAccounts(path, records);
+    std::printf("wrote %zu records to %s in %.1f s\n", records, path.c_str(), sw.seconds());
+    std::printf("%8s %9s %9s %9s %9s %9s %12s\n", "threads", "count ms", "alloc ms", "parse ms", "index ms",
+                "total ms", "Mrecords/s");
+
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        atm::AccountStore store;
+        atm::ImportStats s = atm::importAccounts(path, store, threads);
+        std::printf("%8u %9.0f %9.0f %9.0f %9.0f %9.0f %12.2f\n", s.threads, s.countSeconds * 1000,
+                    s.allocateSeconds * 1000, s.parseSeconds * 1000, s.indexSeconds * 1000,
+                    s.totalSeconds() * 1000, s.records / s.totalSeconds() / 1e6);
+        // Spot check: the last account's second card (if any) and primary card resolve to it.
+        std::size_t last = records - 1;
+        const atm::Account* byCard = store.findByCard(cardFor(last));
+        if (!byCard || byCard->getAccountNumber() != static_cast<int>(100000 + last)) {
+            std::printf("lookup check failed\n");
+            return 1;
+        }
+        keep(static_cast<std::int64_t>(s.extraCards));
+    }
+    std::remove(path.c_str());
+
+    writeAccounts(path, plainRecords, true);
+    atm::AccountStore store;
+    atm::ImportStats s = atm::importAccounts(path, store, maxThreads, atm::kDefaultPinCost);
+    std::remove(path.c_str());
+    double perRecord = s.totalSeconds() / static_cast<double>(s.records);
+    std::printf("plaintext PINs, cost %d: %zu records on %u threads in %.0f ms, %.0f records/s; "
+                "50M records would take %.1f hours\n",
+                atm::kDefaultPinCost, s.records, s.threads, s.totalSeconds() * 1000, 1 / perRecord,
+                perRecord * 50e6 / 3600);
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,161 @@
+// Array-of-Account (the layout both frontends started with) against the
+// columnar AccountTable, for lookups, balance inquiries and batch updates.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "account_table.h"
+#include "bench.h"
+
+using atm::Account;
+using atm::AccountStore;
+using atm::AccountTable;
+using atm::Money;
+using atm::TxnStatus;
+
+namespace {
+
+std::vector<Account> makeAccounts(std::size_t n) {
+    std::vector<Account> accounts;
+    accounts.reserve(n);
+    const atm::PinCredential pin = atm::hashPin("1234", atm::kMinPinCost);
+    for (std::size_t i = 0; i < n; i++) {
+        accounts.emplace_back(static_cast<int>(100000 + i), "Account Holder " + std::to_string(i),
+                              atm::rupees(1000 + static_cast<long long>(i % 5000)), pin, 4000000000000000LL + static_cast<long long>(i) * 7);
+    }
+    return accounts;
+}
+
+// The original findAccount(): walk the array until the number matches.
+const Account* linearFind(const std::vector<Account>& accounts, int accNum) {
+    for (const Account& account : accounts) {
+        if (account.getAccountNumber() == accNum) return &account;
+    }
+    return nullptr;
+}
+
+double nsPerOp(double seconds, std::size_t ops) {
+    return seconds * 1e9 / static_cast<double>(ops);
+}
+
+void lookupCrossover(std::size_t ops) {
+    std::printf("Lookup by account number (ns/lookup)\n");
+    std::printf("%10s %14s %14s %14s\n", "accounts", "AoS scan", "SoA SIMD scan", "hash index");
+
+    const std::size_t sizes[] = {8, 16, 32, 64, 256, 2048, 8192, 32768};
+    for (std::size_t n : sizes) {
+        std::vector<Account> accounts = makeAccounts(n);
+        AccountStore store;
+        store.bulkLoad(accounts);
+        AccountTable table = AccountTable::fromStore(store);
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> pick(0, static_cast<int>(n) - 1);
+        std::vector<int> keys(ops);
+        for (int& k : keys) k = 100000 + pick(rng);
+        std::size_t rounds = std::max<std::size_t>(1, ops * 16 / (n + 16));
+        if (rounds > ops) rounds = ops;
+
+        std::int64_t found = 0;
+        bench::Stopwatch sw;
+        for (std::size_t i = 0; i < rounds; i++) found += linearFind(accounts, keys[i])->getAccountNumber();
+        double aos = nsPerOp(sw.seconds(), rounds);
+
+        sw.reset();
+        for (std::size_t i = 0; i < rounds; i++) found += table.scanAccount(keys[i]);
+        double scan = nsPerOp(sw.seconds(), rounds);
+
+        sw.reset();
+        for (std::size_t i = 0; i < ops; i++) found += store.findByAccount(keys[i])->getAccountNumber();
+        double hash = nsPerOp(sw.seconds(), ops);
+
+        bench::keep(found);
+        std::printf("%10zu %14.1f %14.1f %14.1f\n", n, aos, scan, hash);
+    }
+    std::printf("AccountTable switches from scanning to hashing above %zu rows.\n\n", AccountTable::kScanLimit);
+}
+
+void largeTable(std::size_t n, std::size_t ops) {
+    std::vector<Account> accounts = makeAccounts(n);
+    AccountStore store;
+    store.bulkLoad(accounts);
+    AccountTable table = AccountTable::fromStore(store);
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<std::uint32_t> pick(0, static_cast<std::uint32_t>(n) - 1);
+    std::vector<std::uint32_t> rows(ops);
+    for (std::uint32_t& r : rows) r = pick(rng);
+
+    std::printf("%zu accounts, %zu random operations (ns/op)\n", n, ops);
+    std::printf("%-34s %12s %12s\n", "", "AoS Account", "AccountTable");
+
+    // Lookup through each layout's hash index.
+    std::int64_t acc = 0;
+    bench::Stopwatch sw;
+    for (std::uint32_t r : rows) acc += store.findByAccount(100000 + static_cast<int>(r))->getAccountNumber();
+    double aosLookup = nsPerOp(sw.seconds(), ops);
+    sw.reset();
+    for (std::uint32_t r : rows) acc += table.findByAccount(100000 + static_cast<int>(r));
+    double soaLookup = nsPerOp(sw.seconds(), ops);
+    std::printf("%-34s %12.1f %12.1f\n", "lookup (hash index)", aosLookup, soaLookup);
+
+    // Balance inquiry for a random account.
+    Money total = 0;
+    sw.reset();
+    for (std::uint32_t r : rows) total += store.begin()[r].getBalance();
+    double aosInquiry = nsPerOp(sw.seconds(), ops);
+    sw.reset();
+    for (std::uint32_t r : rows) total += table.balance(r);
+    double soaInquiry = nsPerOp(sw.seconds(), ops);
+    std::printf("%-34s %12.1f %12.1f\n", "balance inquiry (random)", aosInquiry, soaInquiry);
+
+    // Balance sweep over every account (what a branch report does).
+    sw.reset();
+    for (const Account& a : store) total += a.getBalance();
+    double aosSweep = nsPerOp(sw.seconds(), n);
+    sw.reset();
+    for (std::uint32_t r = 0; r < table.size(); r++) total += table.balance(r);
+    double soaSweep = nsPerOp(sw.seconds(), n);
+    std::printf("%-34s %12.2f %12.2f\n", "balance sweep (per account)", aosSweep, soaSweep);
+
+    // Batch of deposits and withdrawals at random accounts.
+    std::vector<Money> amounts(ops);
+    for (std::size_t i = 0; i < ops; i++) amounts[i] = (i & 1) ? atm::rupees(100) : -atm::rupees(100);
+    std::vector<TxnStatus> results(ops);
+    sw.reset();
+    for (std::size_t i = 0; i < ops; i++) {
+        Account& a = store.begin()[rows[i]];
+        results[i] = amounts[i] >= 0 ? a.deposit(amounts[i]) : a.tryWithdraw(-amounts[i]);
+    }
+    double aosBatch = nsPerOp(sw.seconds(), ops);
+    sw.reset();
+    table.applyBatch(rows.data(), amounts.data(), ops, results.data());
+    double soaBatch = nsPerOp(sw.seconds(), ops);
+    std::printf("%-34s %12.1f %12.1f\n", "batch update", aosBatch, soaBatch);
+
+    AccountStore::MemoryUsage mem = store.memoryUsage();
+    std::printf("%-34s %12.1f %12.1f\n", "memory (MiB, records + indexes)",
+                mem.total() / 1048576.0, table.memoryBytes() / 1048576.0);
+
+    bench::keep(acc + total);
+}
+
+} // namespace
+
+namespace bench {
+
+int runLayout(int argc, char** argv) {
+    std::size_t accounts = static_cast<std::size_t>(argOr(argc, argv, 1, 1000000));
+    std::size_t ops = static_cast<std::size_t>(argOr(argc, argv, 2, 1000000));
+
+    lookupCrossover(ops / 10);
+    largeTable(accounts, ops);
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,92 @@
+// Holder names held one std::string per account versus interned in a
+// NamePool: build time, memory, and a pass that reads every name (as a
+// statement print run or a search index build would). Names are drawn
+// from small first/last name lists, so duplicates are common, as they
+// are in a real customer base.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.h"
+#include "name_pool.h"
+
+namespace {
+
+const char* const kFirst[] = {"Aarav", "Vivaan", "Aditya", "Vihaan", "Arjun", "Sai", "Reyansh", "Ayaan", "Krishna",
+                              "Ishaan", "Ananya", "Diya", "Saanvi", "Aadhya", "Pari", "Anika", "Navya", "Myra",
+                              "Tanmay", "Swayam", "Yash Pratap", "Priyanka", "Lakshmi", "Meenakshi"};
+const char* const kLast[] = {"Sharma", "Verma", "Gupta", "Padale", "Bagul", "Gautam", "Iyer", "Nair", "Reddy",
+                             "Chatterjee", "Banerjee", "Mukherjee", "Deshpande", "Kulkarni", "Patil", "Joshi",
+                             "Srinivasan", "Subramanian", "Venkataraman", "Krishnamurthy"};
+
+std::vector<std::string> makeNames(std::size_t count) {
+    std::mt19937 rng(41);
+    std::uniform_int_distribution<std::size_t> first(0, std::size(kFirst) - 1);
+    std::uniform_int_distribution<std::size_t> last(0, std::size(kLast) - 1);
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (std::size_t i = 0; i < count; i++) names.push_back(std::string(kFirst[first(rng)]) + " " + kLast[last(rng)]);
+    return names;
+}
+
+// Heap bytes behind a std::string, approximating the allocator's rounding
+// to 16 bytes; short strings live inside the object.
+std::size_t heapBytes(const std::string& s) {
+    return s.capacity() > 15 ? (s.capacity() + 1 + 15) / 16 * 16 : 0;
+}
+
+} // namespace
+
+namespace bench {
+
+int runNames(int argc, char** argv) {
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 1, 2000000));
+    std::vector<std::string> source = makeNames(count);
+
+    Stopwatch sw;
+    std::vector<std::string> strings;
+    strings.reserve(count);
+    for (const std::string& name : source) strings.push_back(std::string(name.data(), name.size()));
+    double stringBuild = sw.seconds();
+    std::size_t stringBytes = strings.capacity() * sizeof(std::string);
+    for (const std::string& s : strings) stringBytes += heapBytes(s);
+
+    sw.reset();
+    atm::NamePool pool;
+    std::vector<std::uint32_t> refs;
+    refs.reserve(count);
+    for (const std::string& name : source) refs.push_back(pool.intern(name));
+    double poolBuild = sw.seconds();
+    std::size_t poolBytes = pool.memoryBytes() + refs.capacity() * sizeof(std::uint32_t);
+
+    sw.reset();
+    std::int64_t stringSum = 0;
+    for (const std::string& s : strings) stringSum += static_cast<std::int64_t>(s.size()) + s.back();
+    double stringRead = sw.seconds();
+
+    sw.reset();
+    std::int64_t poolSum = 0;
+    for (std::uint32_t ref : refs) {
+        std::string_view s = pool.view(ref);
+        poolSum += static_cast<std::int64_t>(s.size()) + s.back();
+    }
+    double poolRead = sw.seconds();
+    keep(stringSum + poolSum);
+    if (stringSum != poolSum) {
+        std::fprintf(stderr, "name pool returned different text\n");
+        return 1;
+    }
+
+    std::printf("%zu names, %zu distinct\n", count, pool.size() - 1);
+    std::printf("%-22s %10s %12s %12s\n", "", "MiB", "build ns", "read ns");
+    std::printf("%-22s %10.1f %12.1f %12.2f\n", "std::string each", stringBytes / 1048576.0, stringBuild * 1e9 / count,
+                stringRead * 1e9 / count);
+    std::printf("%-22s %10.1f %12.1f %12.2f\n", "NamePool (interned)", poolBytes / 1048576.0, poolBuild * 1e9 / count,
+                poolRead * 1e9 / count);
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,134 @@
+// Finding customers by the start of a name word: a linear scan over every
+// holder name, as the console had to before, against the NameIndex trie.
+// Names are a first name from a short list and a surname built from
+// syllables, so some prefixes match a handful of accounts and others
+// millions; queries stop at a screenful either way.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.h"
+#include "name_index.h"
+
+namespace {
+
+const char* const kFirst[] = {"Aarav", "Vivaan", "Aditya", "Vihaan", "Arjun", "Sai", "Reyansh", "Ayaan", "Krishna",
+                              "Ishaan", "Ananya", "Diya", "Saanvi", "Aadhya", "Pari", "Anika", "Navya", "Myra",
+                              "Tanmay", "Swayam", "Yash Pratap", "Priyanka", "Lakshmi", "Meenakshi"};
+const char* const kSyllables[] = {"ra", "vi", "ku", "an", "sha", "ar", "ma", "pa", "te", "la", "de", "sai",
+                                  "na", "ir", "gu", "pt", "ba", "go", "ja", "ke", "mu", "ni", "re", "su"};
+
+std::vector<std::string> makeNames(std::size_t count) {
+    std::mt19937 rng(43);
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        std::string name = kFirst[rng() % std::size(kFirst)];
+        name += ' ';
+        std::size_t surname = name.size();
+        for (unsigned s = 0, n = 2 + rng() % 3; s < n; s++) name += kSyllables[rng() % std::size(kSyllables)];
+        name[surname] = static_cast<char>(name[surname] - 'a' + 'A');
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// What the console did: every name, every word start, compared ignoring
+// case. prefix is already lower case.
+std::size_t scanNames(const std::vector<std::string>& names, std::string_view prefix, std::size_t limit,
+                      std::vector<int>& out) {
+    out.clear();
+    for (std::size_t i = 0; i < names.size() && out.size() < limit; i++) {
+        const std::string& name = names[i];
+        for (std::size_t start = 0; start + prefix.size() <= name.size(); start++) {
+            if (start > 0 && name[start - 1] != ' ') continue;
+            std::size_t k = 0;
+            while (k < prefix.size() && lower(name[start + k]) == prefix[k]) k++;
+            if (k == prefix.size()) {
+                out.push_back(static_cast<int>(i));
+                break;
+            }
+        }
+    }
+    return out.size();
+}
+
+} // namespace
+
+namespace bench {
+
+int runNameSearch(int argc, char** argv) {
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 1, 10000000));
+    std::size_t queries = static_cast<std::size_t>(argOr(argc, argv, 2, 2000));
+    const std::size_t kLimit = 20;
+    const std::size_t kAdded = 100000;
+    std::vector<std::string> names = makeNames(count + kAdded);
+
+    Stopwatch sw;
+    atm::NameIndex index;
+    index.reserve(count + kAdded);
+    for (std::size_t i = 0; i < count; i++) index.add(names[i], static_cast<int>(i));
+    double build = sw.seconds();
+    sw.reset();
+    for (std::size_t i = count; i < count + kAdded; i++) index.add(names[i], static_cast<int>(i));
+    double added = sw.seconds();
+    std::printf("%zu names: index built in %.2f s (%.0f ns a name), %zu nodes, %.1f MiB; %zu more added at %.0f ns each\n",
+                count, build, build * 1e9 / count, index.nodeCount(), index.memoryBytes() / 1048576.0, kAdded,
+                added * 1e9 / kAdded);
+
+    // Prefixes of one to six letters of a random word of a random name:
+    // short ones match a great many accounts, long ones a few.
+    std::mt19937 rng(7);
+    std::vector<std::string> prefixes;
+    for (std::size_t q = 0; q < queries; q++) {
+        const std::string& name = names[rng() % names.size()];
+        std::size_t start = rng() % 2 ? 0 : name.find(' ') + 1;
+        std::string prefix;
+        for (std::size_t k = start, n = 1 + rng() % 6; k < name.size() && name[k] != ' ' && prefix.size() < n; k++) {
+            prefix.push_back(lower(name[k]));
+        }
+        prefixes.push_back(prefix);
+    }
+
+    std::vector<int> out;
+    std::size_t indexFound = 0, scanFound = 0, mismatches = 0;
+    sw.reset();
+    for (const std::string& prefix : prefixes) {
+        out.clear();
+        indexFound += index.find(prefix, out, kLimit);
+    }
+    double indexSeconds = sw.seconds();
+
+    // The scan is far slower; a sample of the same queries is enough.
+    std::size_t scanQueries = std::min<std::size_t>(queries, 50);
+    sw.reset();
+    for (std::size_t q = 0; q < scanQueries; q++) scanFound += scanNames(names, prefixes[q], kLimit, out);
+    double scanSeconds = sw.seconds();
+    // Both stop at the limit, in different orders: the counts must agree.
+    for (std::size_t q = 0; q < scanQueries; q++) {
+        std::vector<int> viaIndex;
+        mismatches += index.find(prefixes[q], viaIndex, kLimit) != scanNames(names, prefixes[q], kLimit, out);
+    }
+    keep(indexFound + scanFound);
+
+    std::printf("%-20s %12s %14s\n", "up to 20 matches", "us/query", "matches/query");
+    std::printf("%-20s %12.2f %14.1f\n", "linear scan", scanSeconds * 1e6 / scanQueries,
+                static_cast<double>(scanFound) / scanQueries);
+    std::printf("%-20s %12.2f %14.1f\n", "NameIndex", indexSeconds * 1e6 / queries,
+                static_cast<double>(indexFound) / queries);
+    if (mismatches) {
+        std::fprintf(stderr, "%zu queries found a different number of accounts through the index\n", mismatches);
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,76 @@
+// ISO 9564 PIN block translation at the security-module stand-in:
+// format 0 and format 4 blocks re-enciphered to format 4 under a second
+// key, one call per block versus batched, on AES-NI and on the portable
+// AES code. Everything runs on one thread, so the rates are per core.
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "aes.h"
+#include "bench.h"
+#include "pin_block.h"
+
+using atm::Aes128;
+using atm::PinBlock;
+using atm::PinBlockFormat;
+
+namespace {
+
+double translationsPerSecond(const Aes128& from, PinBlockFormat format, const Aes128& to,
+                             const std::vector<PinBlock>& in, const std::vector<long long>& pans, std::size_t batch) {
+    std::vector<PinBlock> out(in.size());
+    std::unique_ptr<bool[]> ok(new bool[in.size()]);
+    std::size_t translated = 0;
+    bench::Stopwatch sw;
+    for (std::size_t i = 0; i < in.size(); i += batch) {
+        std::size_t n = std::min(batch, in.size() - i);
+        translated += atm::translatePinBlocks(from, format, to, &in[i], &pans[i], n, &out[i], ok.get() + i);
+    }
+    double rate = translated / sw.seconds();
+    bench::keep(static_cast<std::int64_t>(out[in.size() / 2].bytes[0]));
+    return rate;
+}
+
+} // namespace
+
+namespace bench {
+
+int runPinBlocks(int argc, char** argv) {
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 1, 200000));
+
+    std::uint8_t fromKey[16], toKey[16];
+    for (int i = 0; i < 16; i++) {
+        fromKey[i] = static_cast<std::uint8_t>(i * 7 + 1);
+        toKey[i] = static_cast<std::uint8_t>(i * 13 + 5);
+    }
+
+    std::vector<long long> pans(count);
+    for (std::size_t i = 0; i < count; i++) pans[i] = 4000000000000000LL + static_cast<long long>(i) * 7919;
+
+    std::printf("%zu translations per run, one thread\n", count);
+    std::printf("%-10s %-8s %14s %14s\n", "AES", "format", "1 per call/s", "batched/s");
+    for (bool hardware : {true, false}) {
+        Aes128 from(fromKey, hardware);
+        Aes128 to(toKey, hardware);
+        if (hardware && !from.hardwareAccelerated()) {
+            std::printf("(no AES-NI on this CPU)\n");
+            continue;
+        }
+        for (PinBlockFormat format : {PinBlockFormat::Iso0, PinBlockFormat::Iso4}) {
+            std::vector<PinBlock> blocks(count);
+            for (std::size_t i = 0; i < count; i++) {
+                blocks[i] = atm::encryptPinBlock(from, format, std::to_string(1000 + i % 9000), pans[i]);
+            }
+            double single = translationsPerSecond(from, format, to, blocks, pans, 1);
+            double batched = translationsPerSecond(from, format, to, blocks, pans, 64);
+            std::printf("%-10s %-8s %14.0f %14.0f\n", hardware ? "AES-NI" : "portable",
+                        format == PinBlockFormat::Iso0 ? "ISO-0" : "ISO-4", single, batched);
+        }
+    }
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,69 @@
+// PIN verification: hash cost per work factor, then a burst of logins
+// against the bounded PinVerifier pool, reporting how long submission
+// blocks the caller, how many logins were refused, and queue latency.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "bench.h"
+#include "pin_hash.h"
+#include "pin_verifier.h"
+
+namespace bench {
+
+int runPins(int argc, char** argv) {
+    unsigned threads = static_cast<unsigned>(argOr(argc, argv, 1, 2));
+    std::size_t logins = static_cast<std::size_t>(argOr(argc, argv, 2, 500));
+    long targetMs = argOr(argc, argv, 3, 20);
+
+    for (int cost = 8; cost <= 14; cost += 2) {
+        atm::PinCredential credential = atm::hashPin("1234", cost);
+        Stopwatch sw;
+        bool ok = atm::verifyPin(credential, "1234");
+        std::printf("cost %2d (%6u iterations): %8.2f ms per check%s\n", cost, 1u << cost, sw.seconds() * 1000,
+                    ok ? "" : "  MISMATCH");
+    }
+    int cost = atm::calibratePinCost(std::chrono::milliseconds(targetMs));
+    std::printf("calibrated cost for %ld ms: %d\n\n", targetMs, cost);
+
+    atm::PinCredential credential = atm::hashPin("1234", cost);
+    atm::PinVerifierOptions options;
+    options.threads = threads;
+    atm::PinVerifier verifier(options);
+
+    // One caller (a GUI thread, say) submits the whole burst back to back.
+    std::atomic<std::size_t> matched{0};
+    std::atomic<std::size_t> done{0};
+    std::size_t refused = 0;
+    double worstSubmitUs = 0;
+    Stopwatch total;
+    for (std::size_t i = 0; i < logins; i++) {
+        const char* pin = i % 4 == 0 ? "4321" : "1234";
+        auto start = std::chrono::steady_clock::now();
+        bool queued = verifier.submit(credential, pin, [&](atm::PinResult r) {
+            if (r == atm::PinResult::Match) matched.fetch_add(1, std::memory_order_relaxed);
+            done.fetch_add(1, std::memory_order_release);
+        });
+        worstSubmitUs = std::max(worstSubmitUs,
+                                 std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        if (!queued) refused++;
+    }
+    double submitSeconds = total.seconds();
+    while (done.load(std::memory_order_acquire) < logins - refused) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    double seconds = total.seconds();
+
+    atm::PinVerifier::Stats s = verifier.stats();
+    std::printf("burst of %zu logins on %u worker(s), queue limit %zu:\n", logins, threads, options.maxQueue);
+    std::printf("  submitted in %.2f ms, slowest submit() %.1f us\n", submitSeconds * 1000, worstSubmitUs);
+    std::printf("  checked %llu (%zu matched), refused busy %llu, max queue depth %zu\n",
+                static_cast<unsigned long long>(s.completed), matched.load(), static_cast<unsigned long long>(s.rejected),
+                s.maxQueueDepth);
+    std::printf("  latency mean %.1f ms, p99 <= %.1f ms, max %.1f ms; %.0f checks/s\n", s.meanLatencyUs / 1000,
+                s.p99LatencyUs / 1000, s.maxLatencyUs / 1000, s.completed / seconds);
+    return 0;
+}
+
+} // namespace bench
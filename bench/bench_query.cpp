@@ -0,0 +1,187 @@
+// Journal queries: the cost of indexing sealed segments in the background,
+// then one account's entries over the whole journal and over a time window,
+// through the segment indexes against a full scan that filters every record.
+
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "journal.h"
+#include "journal_index.h"
+#include "journal_segments.h"
+
+using atm::Journal;
+using atm::JournalOptions;
+using atm::JournalQuery;
+using atm::JournalQueryStats;
+using atm::JournalReader;
+using atm::JournalRecord;
+using atm::TxnType;
+
+namespace {
+
+constexpr int kFirstAccount = 100000;
+
+// A few busy accounts among many quiet ones, as on a real ledger.
+int pickAccount(std::mt19937_64& rng, int accounts) {
+    return kFirstAccount + static_cast<int>(rng() % 8 == 0 ? rng() % 1000 : rng() % static_cast<unsigned>(accounts));
+}
+
+void writeJournal(const std::string& path, std::size_t count, int accounts, JournalOptions options) {
+    options.durability = atm::Durability::Async;
+    options.groupSize = 4096;
+    Journal journal(path, options);
+    std::mt19937_64 rng(11);
+    for (std::size_t i = 0; i < count; i++) {
+        TxnType type = rng() % 2 ? TxnType::Withdrawal : TxnType::Deposit;
+        journal.append(atm::makeJournalRecord(type, pickAccount(rng, accounts),
+                                              atm::rupees(100 * static_cast<long long>(1 + rng() % 100)),
+                                              static_cast<atm::Money>(rng() % 10000000000LL),
+                                              static_cast<std::uint32_t>(1 + rng() % 40)));
+    }
+    journal.flush();
+}
+
+void removeJournal(const std::string& path) {
+    for (const atm::JournalSegment& s : atm::listJournalSegments(path)) {
+        std::remove(s.path.c_str());
+        std::remove(atm::segmentIndexPath(path, s.firstLsn).c_str());
+    }
+    std::remove(path.c_str());
+}
+
+std::int64_t timestampAt(const std::string& path, std::uint64_t lsn) {
+    JournalReader reader(path);
+    JournalRecord record{};
+    reader.seek(lsn);
+    reader.next(record);
+    return record.timestampUs;
+}
+
+struct QueryTimes {
+    double millis = 0;
+    double entries = 0;
+    double postings = 0;
+    double blocks = 0;
+};
+
+QueryTimes timeQueries(const std::string& path, const std::vector<int>& accounts, std::int64_t fromUs, std::int64_t toUs) {
+    QueryTimes t;
+    for (int account : accounts) {
+        JournalQuery query;
+        query.accountNumber = account;
+        query.fromUs = fromUs;
+        query.toUs = toUs;
+        JournalQueryStats s;
+        t.entries += atm::queryJournal(path, query, &s).size();
+        t.millis += s.seconds * 1e3;
+        t.postings += s.postingsRead;
+        t.blocks += s.blocksRead;
+    }
+    double n = static_cast<double>(accounts.size());
+    t.millis /= n;
+    t.entries /= n;
+    t.postings /= n;
+    t.blocks /= n;
+    return t;
+}
+
+} // namespace
+
+namespace bench {
+
+int runQuery(int argc, char** argv) {
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 1, 4000000));
+    int accounts = static_cast<int>(argOr(argc, argv, 2, 200000));
+    std::uint64_t segmentMb = static_cast<std::uint64_t>(argOr(argc, argv, 3, 16));
+    const std::size_t kQueries = 200;
+    const std::string path = "bench_query.tmp";
+    removeJournal(path);
+
+    // Compressed but not indexed, then indexed by the next open's
+    // background thread, so indexing is timed on its own.
+    JournalOptions options;
+    options.segmentBytes = segmentMb << 20;
+    options.indexSegments = false;
+    writeJournal(path, count, accounts, options);
+    {
+        Journal journal(path, options);
+        journal.finishSegments();
+    }
+    options.indexSegments = true;
+    Stopwatch sw;
+    {
+        Journal journal(path, options);
+        journal.finishSegments();
+    }
+    double indexSeconds = sw.seconds();
+    std::uint64_t indexBytes = 0, segmentBytes = 0, indexed = 0;
+    std::vector<atm::JournalSegment> segments = atm::listJournalSegments(path);
+    for (const atm::JournalSegment& s : segments) {
+        segmentBytes += s.fileBytes;
+        indexed += s.records();
+        std::ifstream index(atm::segmentIndexPath(path, s.firstLsn), std::ios::binary | std::ios::ate);
+        if (index) indexBytes += static_cast<std::uint64_t>(index.tellg());
+    }
+    std::printf("%zu records over %d accounts, %zu compressed segments of %llu MB\n", count, accounts, segments.size(),
+                static_cast<unsigned long long>(segmentMb));
+    std::printf("index: %.2f M rec/s on the background thread, %.1f MB of indexes for %.1f MB of segments "
+                "(%.2f bytes per record)\n\n",
+                indexed / indexSeconds / 1e6, indexBytes / 1e6, segmentBytes / 1e6,
+                static_cast<double>(indexBytes) / indexed);
+
+    std::mt19937_64 rng(3);
+    std::vector<int> busy, quiet;
+    for (std::size_t i = 0; i < kQueries; i++) {
+        busy.push_back(kFirstAccount + static_cast<int>(rng() % 1000));
+        quiet.push_back(kFirstAccount + 1000 + static_cast<int>(rng() % static_cast<unsigned>(accounts - 1000)));
+    }
+    // The middle tenth of the journal by time.
+    std::int64_t fromUs = timestampAt(path, count * 45 / 100);
+    std::int64_t toUs = timestampAt(path, count * 55 / 100);
+    const std::int64_t kAll = std::numeric_limits<std::int64_t>::max();
+
+    std::printf("%-34s %10s %10s %10s %12s\n", "one account", "ms/query", "entries", "postings", "blocks read");
+    struct Row {
+        const char* label;
+        const std::vector<int>* accounts;
+        std::int64_t from, to;
+    } rows[] = {
+        {"busy account, whole journal", &busy, -kAll, kAll},
+        {"quiet account, whole journal", &quiet, -kAll, kAll},
+        {"busy account, middle tenth", &busy, fromUs, toUs},
+        {"quiet account, middle tenth", &quiet, fromUs, toUs},
+    };
+    for (const Row& row : rows) {
+        QueryTimes t = timeQueries(path, *row.accounts, row.from, row.to);
+        std::printf("%-34s %10.3f %10.1f %10.1f %12.1f\n", row.label, t.millis, t.entries, t.postings, t.blocks);
+    }
+
+    // What the query replaces: read everything, keep one account's entries.
+    int account = busy.front();
+    JournalReader reader(path);
+    JournalRecord record;
+    std::size_t scanned = 0, found = 0;
+    sw.reset();
+    while (reader.next(record)) {
+        scanned++;
+        found += record.accountNumber == account;
+    }
+    double scanMillis = sw.seconds() * 1e3;
+    JournalQuery query;
+    query.accountNumber = account;
+    std::size_t viaIndex = atm::queryJournal(path, query).size();
+    std::printf("%-34s %10.3f %10zu %10s %12llu\n", "full scan, for comparison", scanMillis, found, "-",
+                static_cast<unsigned long long>(reader.blocksRead()));
+    if (viaIndex != found) std::printf("MISMATCH: %zu entries through the index, %zu by scanning\n", viaIndex, found);
+    bench::keep(scanned);
+
+    removeJournal(path);
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,135 @@
+// Cash reconciliation on generated journals several times the size of the
+// sort memory: withdrawals in the account journal, their dispenses in a
+// second journal in a different order, with known numbers of missing,
+// extra and altered dispenses. Checks that exactly those are reported and
+// times the external sorts and the merge-join.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "journal.h"
+#include "reconcile.h"
+
+using atm::Journal;
+using atm::JournalRecord;
+using atm::TxnType;
+
+namespace {
+
+constexpr std::size_t kBatch = 4096;
+
+atm::JournalOptions fastWrites() {
+    atm::JournalOptions options;
+    options.durability = atm::Durability::Async;
+    options.groupSize = kBatch;
+    return options;
+}
+
+struct Injected {
+    std::size_t missing = 0;    // debited, never dispensed
+    std::size_t extra = 0;      // dispensed with no debit
+    std::size_t amounts = 0;    // dispensed a different amount
+};
+
+// Writes count withdrawals (with a deposit every tenth, which must be
+// ignored) and their dispenses. Dispenses are written in shuffled blocks,
+// as if several terminals fed one log.
+Injected writeJournals(const std::string& debitPath, const std::string& dispensePath, std::size_t count) {
+    Injected injected;
+    std::mt19937_64 rng(7);
+    Journal debits(debitPath, fastWrites());
+    Journal dispenses(dispensePath, fastWrites());
+    std::vector<JournalRecord> debitBatch, dispenseBatch;
+    debitBatch.reserve(kBatch);
+    std::uint64_t nextLsn = 1;
+
+    for (std::size_t i = 0; i < count; i += kBatch) {
+        std::size_t n = std::min(kBatch, count - i);
+        debitBatch.clear();
+        for (std::size_t k = 0; k < n; k++) {
+            int account = static_cast<int>(100000 + rng() % 1000000);
+            TxnType type = (i + k) % 10 == 9 ? TxnType::Deposit : TxnType::Withdrawal;
+            debitBatch.push_back(atm::makeJournalRecord(type, account, atm::rupees(100 * (1 + rng() % 100)), 0, 1));
+        }
+        debits.append(debitBatch.data(), debitBatch.size());
+
+        dispenseBatch.clear();
+        for (std::size_t k = 0; k < n; k++) {
+            JournalRecord d = debitBatch[k];
+            std::uint64_t lsn = nextLsn + k;
+            if (d.txnType() != TxnType::Withdrawal) continue;
+            std::uint64_t roll = rng() % 10000;
+            if (roll < 3) {
+                injected.missing++;
+                continue;
+            }
+            d.txnId = lsn;
+            if (roll < 5) {
+                d.amount += atm::rupees(100);
+                injected.amounts++;
+            }
+            dispenseBatch.push_back(d);
+            if (roll < 6) {
+                JournalRecord extra = d;
+                extra.txnId = (std::uint64_t(1) << 40) + lsn;   // an ID the account journal never issued
+                dispenseBatch.push_back(extra);
+                injected.extra++;
+            }
+        }
+        nextLsn += n;
+        std::shuffle(dispenseBatch.begin(), dispenseBatch.end(), rng);
+        dispenses.append(dispenseBatch.data(), dispenseBatch.size());
+    }
+    debits.flush();
+    dispenses.flush();
+    return injected;
+}
+
+} // namespace
+
+namespace bench {
+
+int runReconcile(int argc, char** argv) {
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 1, 4000000));
+    std::size_t memoryMb = static_cast<std::size_t>(argOr(argc, argv, 2, 32));
+    unsigned maxThreads = static_cast<unsigned>(argOr(argc, argv, 3, std::thread::hardware_concurrency()));
+    if (maxThreads == 0) maxThreads = 1;
+
+    const std::string debitPath = "bench_reconcile_debits.tmp";
+    const std::string dispensePath = "bench_reconcile_dispenses.tmp";
+    std::remove(debitPath.c_str());
+    std::remove(dispensePath.c_str());
+
+    Stopwatch sw;
+    Injected injected = writeJournals(debitPath, dispensePath, count);
+    std::printf("%zu journal records (%.0f MB per journal) written in %.2f s; sort memory %zu MB\n", count,
+                count * sizeof(JournalRecord) / 1e6, sw.seconds(), memoryMb);
+    std::printf("injected: %zu missing, %zu extra, %zu amount changes\n\n", injected.missing, injected.extra,
+                injected.amounts);
+    std::printf("%8s %8s %8s %10s %10s %10s %12s %8s\n", "threads", "runs", "passes", "sort s", "join s", "total s",
+                "M recs/s", "result");
+
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        atm::SortOptions options;
+        options.memoryBytes = memoryMb << 20;
+        options.threads = threads;
+        atm::ReconcileReport r = atm::reconcileCash(dispensePath, debitPath, options);
+        bool exact = r.debitedNotDispensed == injected.missing && r.dispensedNotDebited == injected.extra &&
+                     r.amountDiffers == injected.amounts && r.accountDiffers == 0;
+        double sortSeconds = r.totalSeconds() - r.joinSeconds;
+        double records = static_cast<double>(r.dispenseSort.records + r.debitSort.records);
+        std::printf("%8u %8zu %8u %10.2f %10.2f %10.2f %12.2f %8s\n", threads, r.debitSort.runs, r.debitSort.mergePasses,
+                    sortSeconds, r.joinSeconds, r.totalSeconds(), records / r.totalSeconds() / 1e6,
+                    exact ? "exact" : "WRONG");
+    }
+    std::remove(debitPath.c_str());
+    std::remove(dispensePath.c_str());
+    return 0;
+}
+
+} // namespace bench
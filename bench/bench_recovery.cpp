@@ -0,0 +1,88 @@
+// Time-to-ready after a restart: the account file is rebuilt from a
+// snapshot and the journal tail after it is replayed, partitioned by
+// account across 1 to N threads. Then the two whole-file costs that are
+// left: a restart after a clean shutdown, which opens the file in place,
+// and the copy each snapshot starts from.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "account.h"
+#include "account_file.h"
+#include "bench.h"
+#include "journal.h"
+#include "snapshot.h"
+
+using atm::Account;
+using atm::AccountFile;
+using atm::Journal;
+using atm::JournalOptions;
+
+namespace bench {
+
+int runRecovery(int argc, char** argv) {
+    int accounts = static_cast<int>(argOr(argc, argv, 1, 1000000));
+    std::size_t tail = static_cast<std::size_t>(argOr(argc, argv, 2, 2000000));
+    const std::string accountsPath = "bench_recovery.dat";
+    const std::string snapshotPath = "bench_recovery.snap";
+    const std::string journalPath = "bench_recovery.log";
+    std::remove(journalPath.c_str());
+
+    std::vector<Account> seed;
+    seed.reserve(accounts);
+    const atm::PinCredential pin = atm::hashPin("1234", atm::kMinPinCost);
+    for (int i = 0; i < accounts; i++) {
+        seed.emplace_back(100000 + i, "Holder " + std::to_string(i), atm::rupees(50000), pin, 4000000000000000LL + i);
+    }
+    AccountFile::create(snapshotPath, seed, 0);
+
+    {
+        JournalOptions options;
+        options.durability = atm::Durability::Async;
+        options.groupSize = 8192;
+        Journal journal(journalPath, options);
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> pick(0, accounts - 1);
+        for (std::size_t i = 0; i < tail; i++) {
+            atm::TxnType type = (i & 1) ? atm::TxnType::Deposit : atm::TxnType::Withdrawal;
+            journal.append(atm::makeJournalRecord(type, 100000 + pick(rng), atm::rupees(100), 0, 1));
+        }
+    }
+
+    unsigned maxThreads = static_cast<unsigned>(argOr(argc, argv, 3, std::max(1u, std::thread::hardware_concurrency())));
+    std::printf("%d accounts, %zu journal records after the snapshot, %u hardware threads\n",
+                accounts, tail, std::thread::hardware_concurrency());
+    std::printf("%8s %10s %10s %10s %14s\n", "threads", "load ms", "replay ms", "ready ms", "Mrecords/s");
+
+    std::uint64_t lastLsn = 0;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        atm::RecoveryReport report = atm::recoverAccounts(accountsPath, snapshotPath, journalPath, seed, threads);
+        std::printf("%8u %10.1f %10.1f %10.1f %14.2f\n", report.threads, report.loadSeconds * 1000,
+                    report.replaySeconds * 1000, report.readySeconds() * 1000,
+                    report.replayed / report.replaySeconds / 1e6);
+        lastLsn = report.lastLsn;
+    }
+
+    AccountFile::open(accountsPath).closeCleanly(lastLsn);
+    atm::RecoveryReport clean = atm::recoverAccounts(accountsPath, snapshotPath, journalPath, seed);
+    std::printf("clean restart: %.1f ms (%s)\n", clean.readySeconds() * 1000,
+                clean.openedInPlace ? "opened in place" : "rebuilt");
+
+    auto start = std::chrono::steady_clock::now();
+    AccountFile::copy(snapshotPath, snapshotPath + ".next");
+    std::printf("snapshot copy: %.1f ms\n",
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    std::remove((snapshotPath + ".next").c_str());
+
+    std::remove(accountsPath.c_str());
+    std::remove(snapshotPath.c_str());
+    std::remove(journalPath.c_str());
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,164 @@
+// Replacing the account set under load. Session threads look accounts up
+// and deposit into them while the main thread reloads the set several
+// times, each reload adding 1% new accounts. Every thread also keeps a
+// handle for a long session (2^18 operations) and deposits through it, so
+// writes through handles to a replaced set are exercised too, and a set
+// is only freed once the sessions that began on it are over.
+//
+// Reported: the cost of a reload (built beside the live set, then a short
+// freeze while live balances move over), session throughput with and
+// without reloads running, and the longest lookup against the longest
+// deposit: lookups pin an epoch and never wait, deposits may wait out a
+// freeze. At the end every deposit must be on the books and every
+// replaced set freed once the handles are gone.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "bench.h"
+#include "sharded_account_store.h"
+
+using atm::Account;
+using atm::AccountHandle;
+using atm::AccountStore;
+using atm::ShardedAccountStore;
+
+namespace {
+
+const int kFirstAccount = 100000;
+const atm::Money kAmount = atm::rupees(100);
+const atm::Money kOpening = atm::rupees(50000);
+
+struct SessionTotals {
+    std::size_t ops = 0;
+    std::size_t opsDuringReloads = 0;
+    std::size_t deposits = 0;
+    double longestLookup = 0;
+    double longestDeposit = 0;
+};
+
+std::vector<Account> makeAccounts(int first, int count) {
+    std::vector<Account> accounts;
+    accounts.reserve(count);
+    const atm::PinCredential pin = atm::hashPin("1234", atm::kMinPinCost);
+    for (int i = first; i < first + count; i++) {
+        accounts.emplace_back(i, "Holder " + std::to_string(i), kOpening, pin, 4000000000000000LL + i);
+    }
+    return accounts;
+}
+
+void session(ShardedAccountStore& store, const std::atomic<int>& served, const std::atomic<bool>& reloading,
+             const std::atomic<bool>& stop, unsigned seed, SessionTotals& totals) {
+    std::mt19937 rng(seed);
+    AccountHandle kept;
+    std::size_t i = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (i % (1 << 18) == 0) kept = store.findByAccount(kFirstAccount + static_cast<int>((seed + i) % 1000));
+        bool during = reloading.load(std::memory_order_relaxed);
+        bench::Stopwatch sw;
+        AccountHandle account = i % 16 == 0 ? kept
+                                            : store.findByAccount(kFirstAccount + static_cast<int>(
+                                                                      rng() % served.load(std::memory_order_relaxed)));
+        totals.longestLookup = std::max(totals.longestLookup, sw.seconds());
+        sw.reset();
+        if (account && account.deposit(kAmount) == atm::TxnStatus::Ok) totals.deposits++;
+        totals.longestDeposit = std::max(totals.longestDeposit, sw.seconds());
+        totals.ops++;
+        if (during) totals.opsDuringReloads++;
+        i++;
+    }
+}
+
+} // namespace
+
+namespace bench {
+
+int runReload(int argc, char** argv) {
+    int accounts = static_cast<int>(argOr(argc, argv, 1, 1000000));
+    int reloads = static_cast<int>(argOr(argc, argv, 2, 5));
+    int threads = static_cast<int>(argOr(argc, argv, 3, 4));
+    const std::string path = "bench_reload.dat";
+    const int addedPerReload = std::max(1, accounts / 100);
+
+    AccountStore backing;
+    backing.bulkLoad(makeAccounts(kFirstAccount, accounts));
+    ShardedAccountStore store(backing);
+    std::printf("%d accounts, %d reloads adding %d each, %d session threads\n", accounts, reloads, addedPerReload,
+                threads);
+
+    std::atomic<int> served{accounts};
+    std::atomic<bool> reloading{false};
+    std::atomic<bool> stop{false};
+    std::vector<SessionTotals> totals(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back(session, std::ref(store), std::cref(served), std::cref(reloading), std::cref(stop),
+                          1000u + t, std::ref(totals[t]));
+    }
+
+    // Half a second of sessions alone before the reloads, and as long as
+    // they took after, for the throughput comparison.
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    std::printf("%8s %10s %8s %12s %12s %10s\n", "reload", "accounts", "added", "build ms", "freeze ms", "reclaimed");
+    Stopwatch sw;
+    double buildSeconds = 0;
+    for (int r = 0; r < reloads; r++) {
+        // The incoming file repeats the accounts already served (they keep
+        // their live balances) and brings some new ones.
+        int first = kFirstAccount + accounts + r * addedPerReload;
+        AccountStore incoming;
+        incoming.bulkLoad(makeAccounts(kFirstAccount, first - kFirstAccount + addedPerReload));
+        reloading.store(true);
+        atm::ReloadReport report = store.reload(incoming, path);
+        reloading.store(false);
+        served.store(static_cast<int>(report.accounts));
+        buildSeconds += report.buildSeconds;
+        std::printf("%8d %10zu %8zu %12.1f %12.2f %10zu\n", r + 1, report.accounts, report.added,
+                    report.buildSeconds * 1e3, report.freezeSeconds * 1e3, report.reclaimed);
+    }
+    double reloadSeconds = sw.seconds();
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<long>(reloadSeconds * 1000)));
+    stop.store(true);
+    for (std::thread& th : pool) th.join();
+
+    SessionTotals sum;
+    for (const SessionTotals& t : totals) {
+        sum.ops += t.ops;
+        sum.opsDuringReloads += t.opsDuringReloads;
+        sum.deposits += t.deposits;
+        sum.longestLookup = std::max(sum.longestLookup, t.longestLookup);
+        sum.longestDeposit = std::max(sum.longestDeposit, t.longestDeposit);
+    }
+    double quietSeconds = 0.5 + reloadSeconds;
+    std::printf("sessions: %.2f Mops/s quiet, %.2f Mops/s while reloading (%.0f ms building in all)\n",
+                static_cast<double>(sum.ops - sum.opsDuringReloads) / quietSeconds / 1e6,
+                static_cast<double>(sum.opsDuringReloads) / reloadSeconds / 1e6, buildSeconds * 1e3);
+    std::printf("longest lookup %.3f ms, longest deposit %.3f ms\n", sum.longestLookup * 1e3,
+                sum.longestDeposit * 1e3);
+
+    atm::Money onBooks = 0;
+    {
+        auto noReload = store.holdReloads();
+        for (const Account& account : store.accountStore()) onBooks += account.getBalance() - kOpening;
+    }
+    std::size_t reclaimed = store.reclaim();
+    std::printf("generation %llu: %zu deposits made, %lld on the books; %zu replaced sets freed after the sessions, "
+                "%zu left\n",
+                static_cast<unsigned long long>(store.generation()), sum.deposits,
+                static_cast<long long>(onBooks / kAmount), reclaimed, store.retiredGenerations());
+    std::remove(path.c_str());
+    if (onBooks != static_cast<atm::Money>(sum.deposits) * kAmount || store.retiredGenerations() != 0) {
+        std::fprintf(stderr, "deposits lost or replaced sets not freed\n");
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,78 @@
+// Throughput of ShardedAccountStore as concurrent sessions go from 1 to 64
+// threads: random deposits and withdrawals, plus a share of two-account
+// transfers that take shard locks exclusively.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "bench.h"
+#include "sharded_account_store.h"
+
+using atm::Account;
+using atm::AccountHandle;
+using atm::AccountStore;
+using atm::ShardedAccountStore;
+
+namespace {
+
+void session(ShardedAccountStore& store, int accounts, std::size_t ops, int transferPercent, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick(0, accounts - 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (std::size_t i = 0; i < ops; i++) {
+        AccountHandle a = store.findByAccount(100000 + pick(rng));
+        if (percent(rng) < transferPercent) {
+            AccountHandle b = store.findByAccount(100000 + pick(rng));
+            store.transfer(a, b, atm::rupees(100));
+        } else if (i & 1) {
+            a.deposit(atm::rupees(100));
+        } else {
+            a.tryWithdraw(atm::rupees(100));
+        }
+    }
+}
+
+} // namespace
+
+namespace bench {
+
+int runScaling(int argc, char** argv) {
+    int accounts = static_cast<int>(argOr(argc, argv, 1, 100000));
+    std::size_t opsPerThread = static_cast<std::size_t>(argOr(argc, argv, 2, 200000));
+    int transferPercent = static_cast<int>(argOr(argc, argv, 3, 5));
+
+    std::vector<Account> seed;
+    seed.reserve(accounts);
+    const atm::PinCredential pin = atm::hashPin("1234", atm::kMinPinCost);
+    for (int i = 0; i < accounts; i++) {
+        seed.emplace_back(100000 + i, "Holder " + std::to_string(i), atm::rupees(50000), pin, 4000000000000000LL + i);
+    }
+    AccountStore backing;
+    backing.bulkLoad(std::move(seed));
+    ShardedAccountStore store(backing);
+
+    std::printf("%d accounts, %zu shards, %zu ops/thread, %d%% transfers, %u hardware threads\n",
+                accounts, store.shardCount(), opsPerThread, transferPercent, std::thread::hardware_concurrency());
+    std::printf("%8s %14s %10s\n", "threads", "Mops/s", "speedup");
+
+    double base = 0;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        std::vector<std::thread> pool;
+        Stopwatch sw;
+        for (int t = 0; t < threads; t++) {
+            pool.emplace_back(session, std::ref(store), accounts, opsPerThread, transferPercent, 1000u + t);
+        }
+        for (std::thread& th : pool) th.join();
+        double mops = static_cast<double>(opsPerThread) * threads / sw.seconds() / 1e6;
+        if (threads == 1) base = mops;
+        std::printf("%8d %14.2f %9.2fx\n", threads, mops, mops / base);
+    }
+    return 0;
+}
+
+} // namespace bench
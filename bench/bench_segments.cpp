@@ -0,0 +1,150 @@
+// Segmented journal: sealed segments compressed by the journal's background
+// thread, then a full scan and random point reads over the compressed
+// segments against the same records in one uncompressed file, and how much
+// compaction frees once a snapshot covers most of the journal.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "journal.h"
+#include "journal_segments.h"
+
+using atm::Journal;
+using atm::JournalOptions;
+using atm::JournalReader;
+using atm::JournalRecord;
+using atm::TxnType;
+
+namespace {
+
+// Appended one at a time, so timestamps advance as they would in service.
+void writeJournal(const std::string& path, std::size_t count, JournalOptions options) {
+    options.durability = atm::Durability::Async;
+    options.groupSize = 4096;
+    Journal journal(path, options);
+    std::mt19937_64 rng(5);
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint64_t roll = rng() % 100;
+        TxnType type = roll < 55 ? TxnType::Withdrawal : roll < 90 ? TxnType::Deposit : TxnType::Credit;
+        atm::Money amount = type == TxnType::Credit ? static_cast<atm::Money>(rng() % 50000)
+                                                    : atm::rupees(100 * static_cast<long long>(1 + rng() % 100));
+        journal.append(atm::makeJournalRecord(type, static_cast<int>(100000 + rng() % 2000000), amount,
+                                              static_cast<atm::Money>(rng() % 10000000000LL),
+                                              static_cast<std::uint32_t>(1 + rng() % 40)));
+    }
+    journal.flush();
+}
+
+std::uint64_t segmentFileBytes(const std::string& path) {
+    std::uint64_t bytes = 0;
+    for (const atm::JournalSegment& s : atm::listJournalSegments(path)) bytes += s.fileBytes;
+    return bytes;
+}
+
+void removeJournal(const std::string& path) {
+    for (const atm::JournalSegment& s : atm::listJournalSegments(path)) {
+        std::remove(s.path.c_str());
+        std::remove(atm::segmentIndexPath(path, s.firstLsn).c_str());
+    }
+    std::remove(path.c_str());
+}
+
+struct ReadTimes {
+    double scanSeconds;
+    double lookupMicros;
+    double blocksPerLookup;
+};
+
+ReadTimes timeReads(const std::string& path, std::size_t count, std::size_t lookups) {
+    ReadTimes t{};
+    JournalReader reader(path);
+    JournalRecord record;
+    std::int64_t sum = 0;
+    bench::Stopwatch sw;
+    while (reader.next(record)) sum += record.amount;
+    t.scanSeconds = sw.seconds();
+
+    std::mt19937_64 rng(9);
+    std::uint64_t blocksBefore = reader.blocksRead();
+    sw.reset();
+    for (std::size_t i = 0; i < lookups; i++) {
+        reader.seek(1 + rng() % count);
+        if (reader.next(record)) sum += record.amount;
+    }
+    t.lookupMicros = sw.seconds() * 1e6 / lookups;
+    t.blocksPerLookup = static_cast<double>(reader.blocksRead() - blocksBefore) / lookups;
+    bench::keep(sum);
+    return t;
+}
+
+} // namespace
+
+namespace bench {
+
+int runSegments(int argc, char** argv) {
+    std::size_t count = static_cast<std::size_t>(argOr(argc, argv, 1, 4000000));
+    std::uint64_t segmentMb = static_cast<std::uint64_t>(argOr(argc, argv, 2, 16));
+    const std::size_t kLookups = 20000;
+    const std::string flatPath = "bench_segments_flat.tmp";
+    const std::string segmentedPath = "bench_segments.tmp";
+    removeJournal(flatPath);
+    removeJournal(segmentedPath);
+
+    JournalOptions flat;
+    flat.segmentBytes = 0;
+    Stopwatch sw;
+    writeJournal(flatPath, count, flat);
+    double flatWrite = sw.seconds();
+
+    // Sealed but left raw, then compressed by the next open's background
+    // thread, so compression is timed on its own.
+    JournalOptions raw;
+    raw.segmentBytes = segmentMb << 20;
+    raw.compressSegments = false;
+    sw.reset();
+    writeJournal(segmentedPath, count, raw);
+    double segmentedWrite = sw.seconds();
+    std::uint64_t rawBytes = segmentFileBytes(segmentedPath);
+    std::size_t segments = atm::listJournalSegments(segmentedPath).size();
+
+    JournalOptions compressed;
+    compressed.segmentBytes = raw.segmentBytes;
+    sw.reset();
+    {
+        Journal journal(segmentedPath, compressed);
+        journal.finishSegments();
+    }
+    double compressSeconds = sw.seconds();
+    std::uint64_t packedBytes = segmentFileBytes(segmentedPath);
+
+    std::printf("%zu records (%.0f MB), %zu sealed segments of %llu MB\n", count, count * sizeof(JournalRecord) / 1e6,
+                segments, static_cast<unsigned long long>(segmentMb));
+    std::printf("write: one file %.2f M rec/s, rolling segments %.2f M rec/s\n", count / flatWrite / 1e6,
+                count / segmentedWrite / 1e6);
+    std::printf("compress: %.1f MB -> %.1f MB (%.2fx) at %.0f MB/s on the background thread\n\n", rawBytes / 1e6,
+                packedBytes / 1e6, static_cast<double>(rawBytes) / packedBytes, rawBytes / compressSeconds / 1e6);
+
+    ReadTimes flatReads = timeReads(flatPath, count, kLookups);
+    ReadTimes packedReads = timeReads(segmentedPath, count, kLookups);
+    std::printf("%-22s %12s %14s %16s\n", "", "scan M rec/s", "point read us", "blocks per read");
+    std::printf("%-22s %12.2f %14.2f %16s\n", "one uncompressed file", count / flatReads.scanSeconds / 1e6,
+                flatReads.lookupMicros, "-");
+    std::printf("%-22s %12.2f %14.2f %16.2f\n", "compressed segments", count / packedReads.scanSeconds / 1e6,
+                packedReads.lookupMicros, packedReads.blocksPerLookup);
+
+    // A snapshot at 90% of the journal covers every segment before it.
+    {
+        Journal journal(segmentedPath, compressed);
+        std::size_t removed = journal.compact(count * 9 / 10);
+        std::printf("\ncompaction to LSN %zu: %zu of %zu segments removed, %.1f MB -> %.1f MB on disk\n",
+                    count * 9 / 10, removed, segments, packedBytes / 1e6, segmentFileBytes(segmentedPath) / 1e6);
+    }
+    removeJournal(flatPath);
+    removeJournal(segmentedPath);
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,130 @@
+// Read-mostly traffic on a few hot accounts: 95% balance snapshots, 5%
+// withdrawals. Account's seqlock is compared with the same money fields
+// behind a std::mutex. Every snapshot is also checked for tearing:
+// withdrawals move money from the balance to today's total, so the two
+// must always add up to the opening balance.
+
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "account.h"
+#include "bench.h"
+#include "pin_hash.h"
+
+using atm::Account;
+using atm::AccountSnapshot;
+using atm::Money;
+
+namespace {
+
+const Money kOpening = atm::rupees(1000000000);
+const Money kWithdrawal = atm::rupees(100);
+
+// The pre-seqlock alternative: the same fields under one lock per account.
+struct alignas(64) LockedAccount {
+    std::mutex lock;
+    Money balance = kOpening;
+    Money holds = 0;
+    Money withdrawnToday = 0;
+    std::uint32_t day = 0;
+
+    AccountSnapshot snapshot() {
+        std::lock_guard<std::mutex> guard(lock);
+        return {balance, holds, withdrawnToday, day};
+    }
+
+    void withdraw(Money amount) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (amount > balance - holds) return;
+        balance -= amount;
+        withdrawnToday += amount;
+    }
+};
+
+template <typename Accounts>
+std::size_t session(Accounts& accounts, std::size_t ops, unsigned seed, std::int64_t* sink) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> pick(0, accounts.size() - 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::size_t torn = 0;
+    std::int64_t sum = 0;
+    for (std::size_t i = 0; i < ops; i++) {
+        auto& account = accounts[pick(rng)];
+        if (percent(rng) < 5) {
+            if constexpr (std::is_same<typename Accounts::value_type, Account>::value) {
+                account.tryWithdraw(kWithdrawal);
+            } else {
+                account.withdraw(kWithdrawal);
+            }
+        } else {
+            AccountSnapshot s = account.snapshot();
+            if (s.balance + s.withdrawnToday != kOpening) torn++;
+            sum += s.available();
+        }
+    }
+    *sink = sum;
+    return torn;
+}
+
+template <typename Accounts>
+double run(Accounts& accounts, int threads, std::size_t opsPerThread, std::size_t* torn) {
+    std::vector<std::thread> pool;
+    std::vector<std::size_t> tornPerThread(threads);
+    std::vector<std::int64_t> sums(threads);
+    bench::Stopwatch sw;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            tornPerThread[t] = session(accounts, opsPerThread, 2000u + t, &sums[t]);
+        });
+    }
+    for (std::thread& th : pool) th.join();
+    double seconds = sw.seconds();
+    for (int t = 0; t < threads; t++) {
+        *torn += tornPerThread[t];
+        bench::keep(sums[t]);
+    }
+    return static_cast<double>(opsPerThread) * threads / seconds / 1e6;
+}
+
+} // namespace
+
+namespace bench {
+
+int runSeqlock(int argc, char** argv) {
+    int maxThreads = static_cast<int>(argOr(argc, argv, 1, 8));
+    std::size_t opsPerThread = static_cast<std::size_t>(argOr(argc, argv, 2, 2000000));
+    std::size_t hot = static_cast<std::size_t>(argOr(argc, argv, 3, 4));
+    if (maxThreads < 1 || hot < 1) {
+        std::fprintf(stderr, "need at least one thread and one account\n");
+        return 1;
+    }
+
+    std::printf("%zu hot accounts, %zu ops/thread (95%% snapshots, 5%% withdrawals), %u hardware threads\n", hot,
+                opsPerThread, std::thread::hardware_concurrency());
+    std::printf("%8s %14s %14s %10s %8s\n", "threads", "mutex Mops/s", "seqlock Mops/s", "speedup", "torn");
+
+    const atm::PinCredential pin = atm::hashPin("1234", atm::kMinPinCost);
+    std::uint32_t today = atm::currentDay();
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<LockedAccount> locked(hot);
+        std::vector<Account> seqlocked;
+        seqlocked.reserve(hot);
+        for (std::size_t i = 0; i < hot; i++) {
+            seqlocked.emplace_back(100000 + static_cast<int>(i), "Holder " + std::to_string(i), kOpening, pin);
+            seqlocked.back().resetDailyTotals(today);
+        }
+
+        std::size_t torn = 0;
+        double mutexMops = run(locked, threads, opsPerThread, &torn);
+        double seqlockMops = run(seqlocked, threads, opsPerThread, &torn);
+        std::printf("%8d %14.2f %14.2f %9.2fx %8zu\n", threads, mutexMops, seqlockMops, seqlockMops / mutexMops, torn);
+    }
+    return 0;
+}
+
+} // namespace bench
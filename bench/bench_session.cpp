@@ -0,0 +1,123 @@
+// Session temporaries on the global heap versus a SessionArena: a card
+// tap is parsed, the balance and a mini-statement are formatted and a UPI
+// link is built, then the session ends. Global operator new is counted
+// (for this whole program) to show what each variant costs the heap once
+// warmed up.
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "bench.h"
+#include "nfc_request.h"
+#include "pin_hash.h"
+#include "session_arena.h"
+#include "sharded_account_store.h"
+
+namespace {
+
+thread_local std::uint64_t heapAllocations = 0;
+
+const char kRequest[] =
+    "POST /tap HTTP/1.1\r\nHost: atm.local\r\nContent-Type: application/json\r\nContent-Length: 32\r\n\r\n"
+    "{\"cardNum\": \"4000000000000042\"}";
+
+std::int64_t heapSession(atm::ShardedAccountStore& store) {
+    std::string body = atm::httpRequestBody(std::string(kRequest));
+    std::string card = atm::parseJsonValue(body, "cardNum");
+    atm::AccountHandle account = store.findByCard(std::stoll(card));
+    std::int64_t sum = static_cast<std::int64_t>(atm::formatMoney(account.balance()).size());
+    for (const atm::HistoryEntry& e : account.recentTransactions(10)) {
+        sum += static_cast<std::int64_t>(atm::formatMoney(e.amount).size() + atm::formatMoney(e.balanceAfter).size());
+    }
+    std::string upi = "upi://pay?pa=atm@bank&pn=ATM%20Machine%20Simulation&am=" + std::to_string(2000) + "&cu=INR";
+    return sum + static_cast<std::int64_t>(upi.size());
+}
+
+std::int64_t arenaSession(atm::ShardedAccountStore& store, atm::SessionArena& arena) {
+    std::pmr::memory_resource* memory = arena.resource();
+    std::string_view body = atm::httpRequestBody(std::string_view(kRequest, sizeof(kRequest) - 1));
+    std::pmr::string card = atm::parseJsonValue(body, "cardNum", memory);
+    long long cardNumber = 0;
+    std::from_chars(card.data(), card.data() + card.size(), cardNumber);
+    atm::AccountHandle account = store.findByCard(cardNumber);
+    std::int64_t sum = static_cast<std::int64_t>(atm::formatMoney(account.balance(), memory).size());
+    for (const atm::HistoryEntry& e : account.recentTransactions(10, memory)) {
+        sum += static_cast<std::int64_t>(atm::formatMoney(e.amount, memory).size() +
+                                         atm::formatMoney(e.balanceAfter, memory).size());
+    }
+    std::pmr::string upi("upi://pay?pa=atm@bank&pn=ATM%20Machine%20Simulation&am=", memory);
+    char amount[16];
+    upi.append(amount, std::to_chars(amount, amount + sizeof(amount), 2000).ptr);
+    upi += "&cu=INR";
+    sum += static_cast<std::int64_t>(upi.size());
+    arena.release();
+    return sum;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    heapAllocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace bench {
+
+int runSession(int argc, char** argv) {
+    std::size_t sessions = static_cast<std::size_t>(argOr(argc, argv, 1, 200000));
+
+    std::vector<atm::Account> seed;
+    const atm::PinCredential pin = atm::hashPin("1234", atm::kMinPinCost);
+    for (int i = 0; i < 100; i++) {
+        seed.emplace_back(100000 + i, "Account Holder Number " + std::to_string(i), atm::rupees(50000), pin,
+                          4000000000000000LL + i);
+    }
+    atm::AccountStore backing;
+    backing.bulkLoad(std::move(seed));
+    atm::ShardedAccountStore store(backing);
+    atm::AccountHandle account = store.findByCard(4000000000000042LL);
+    for (int i = 0; i < 10; i++) account.deposit(atm::rupees(100 * (i + 1)));
+
+    std::printf("%zu sessions each\n", sessions);
+    std::printf("%-8s %12s %18s\n", "", "ns/session", "heap allocs/session");
+
+    heapSession(store);   // warm-up
+    std::uint64_t before = heapAllocations;
+    Stopwatch sw;
+    std::int64_t sum = 0;
+    for (std::size_t i = 0; i < sessions; i++) sum += heapSession(store);
+    double heapNs = sw.seconds() * 1e9 / sessions;
+    std::printf("%-8s %12.0f %18.2f\n", "heap", heapNs, static_cast<double>(heapAllocations - before) / sessions);
+
+    atm::SessionArena arena;
+    arenaSession(store, arena);   // warm-up
+    before = heapAllocations;
+    sw.reset();
+    for (std::size_t i = 0; i < sessions; i++) sum += arenaSession(store, arena);
+    double arenaNs = sw.seconds() * 1e9 / sessions;
+    std::printf("%-8s %12.0f %18.2f\n", "arena", arenaNs, static_cast<double>(heapAllocations - before) / sessions);
+    keep(sum);
+
+    atm::SessionArena::Stats s = arena.stats();
+    std::printf("arena: %llu sessions, peak %llu bytes per session, %llu heap allocations (%llu bytes) in total\n",
+                static_cast<unsigned long long>(s.sessions), static_cast<unsigned long long>(s.peakBytes),
+                static_cast<unsigned long long>(s.heapAllocations), static_cast<unsigned long long>(s.heapBytes));
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <cstring>
+
+#include "bench.h"
+
+namespace {
+
+struct Benchmark {
+    const char* name;
+    const char* usage;
+    int (*run)(int argc, char** argv);
+};
+
+const Benchmark kBenchmarks[] = {
+    {"bins", "bins [prefixes] [cards]  BIN routing by longest issuer prefix: single vs lockstep batch, reload cost", bench::runBins},
+    {"cards", "cards [count] [rounds]  Card-number length + Luhn checks, one at a time vs the AVX2 batch", bench::runCards},
+    {"columns", "columns [records] [max threads]  Columnar journal export: throughput, bytes per column, one-column scan vs journal scan", bench::runColumns},
+    {"eod", "eod [accounts] [max threads]  End-of-day batch: interest, dormancy, counter resets; accounts/s and a 50M estimate", bench::runEod},
+    {"hotcards", "hotcards [cards] [lookups]  Hot-card list lookups, replace and incremental updates", bench::runHotCards},
+    {"import", "import [records] [max threads] [plaintext records]  Parallel CSV account import, per-stage timings, cost of plaintext PINs", bench::runImport},
+    {"journal", "journal [threads] [records/thread]  Journal durability modes: per-transaction, grouped, async", bench::runJournal},
+    {"layout", "layout [accounts] [ops]  Account array vs columnar AccountTable", bench::runLayout},
+    {"names", "names [accounts]  Holder names as one std::string each vs interned in a NamePool", bench::runNames},
+    {"namesearch", "namesearch [names] [queries]  Finding holders by name prefix: linear scan vs the NameIndex trie, incremental adds", bench::runNameSearch},
+    {"pinblocks", "pinblocks [blocks]  ISO 9564 PIN block translation per core, single vs batched, AES-NI vs portable", bench::runPinBlocks},
+    {"pins", "pins [workers] [logins] [target ms]  PIN hash cost and a login burst on the bounded verifier pool", bench::runPins},
+    {"query", "query [records] [accounts] [segment MB]  Journal queries: segment index build cost, one account over the journal and a time window vs a full scan", bench::runQuery},
+    {"reconcile", "reconcile [withdrawals] [memory MB] [max threads]  Dispense vs debit journal reconciliation: external sort + merge-join", bench::runReconcile},
+    {"recovery", "recovery [accounts] [tail records] [max threads]  Restart from snapshot plus parallel journal replay, clean restart, snapshot copy", bench::runRecovery},
+    {"reload", "reload [accounts] [reloads] [threads]  Replacing the account set under live sessions: build and freeze cost, lookups never waiting, old sets reclaimed", bench::runReload},
+    {"scaling", "scaling [accounts] [ops/thread] [transfer %]  ShardedAccountStore, 1 to 64 threads", bench::runScaling},
+    {"segments", "segments [records] [segment MB]  Segmented journal: background compression, scans and point reads, compaction", bench::runSegments},
+    {"seqlock", "seqlock [max threads] [ops] [hot accounts]  95/5 snapshot/withdrawal mix: seqlock vs mutex, torn reads counted", bench::runSeqlock},
+    {"session", "session [sessions]  Session temporaries on the global heap vs a SessionArena, heap allocations counted", bench::runSession},
+};
+
+void printUsage() {
+    std::printf("usage: atm_bench <benchmark> [args]\n\n");
+    for (const Benchmark& b : kBenchmarks) std::printf("  %s\n", b.usage);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    for (const Benchmark& b : kBenchmarks) {
+        // Arguments after the benchmark name are passed on with argv[0]
+        // set to the benchmark name.
+        if (std::strcmp(argv[1], b.name) == 0) return b.run(argc - 1, argv + 1);
+    }
+    std::printf("unknown benchmark '%s'\n\n", argv[1]);
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,278 @@
+#include "account.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <immintrin.h>
+#endif
+
+namespace atm {
+
+static_assert(std::is_standard_layout<Account>::value, "Account records are stored in mapped files");
+static_assert(sizeof(Account) == 128, "Account file format depends on the record size");
+static_assert(std::atomic<Money>::is_always_lock_free, "Balances in a shared mapping must be address-free atomics");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "The seqlock word lives in a shared mapping");
+static_assert(sizeof(std::atomic<Money>) == sizeof(Money), "Balance word must match the on-disk layout");
+
+namespace {
+
+inline void cpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+} // namespace
+
+bool isValidCashAmount(Money amount) {
+    return amount > 0 && amount % rupees(kNoteDenomination) == 0;
+}
+
+std::uint32_t currentDay() {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+    return static_cast<std::uint32_t>(seconds.count() / 86400);
+}
+
+Account::Account(int accNum, std::string_view accHolder, Money bal, const PinCredential& pinHash, long long cardNum)
+    : cardNumber(cardNum), accountNumber(accNum), pin(pinHash), balance(bal), holds(0), withdrawnToday(0), sequence(0),
+      withdrawalDay(0), activeDay(0), flags(0), interestDay(0), accountHolderName{} {
+    std::memcpy(accountHolderName, accHolder.data(), std::min(accHolder.size(), kNameCapacity - 1));
+}
+
+Account::Account(const Account& other)
+    : cardNumber(other.cardNumber), accountNumber(other.accountNumber), pin(other.pin), sequence(0) {
+    AccountSnapshot s = other.snapshot();
+    balance.store(s.balance, std::memory_order_relaxed);
+    holds.store(s.holds, std::memory_order_relaxed);
+    withdrawnToday.store(s.withdrawnToday, std::memory_order_relaxed);
+    withdrawalDay.store(s.day, std::memory_order_relaxed);
+    activeDay.store(other.lastActiveDay(), std::memory_order_relaxed);
+    flags.store(other.flags.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    interestDay.store(other.interestPaidDay(), std::memory_order_relaxed);
+    std::memcpy(accountHolderName, other.accountHolderName, sizeof(accountHolderName));
+}
+
+Account& Account::operator=(const Account& other) {
+    if (this == &other) return *this;
+    AccountSnapshot s = other.snapshot();
+    std::uint32_t started = beginWrite();
+    cardNumber = other.cardNumber;
+    accountNumber = other.accountNumber;
+    pin = other.pin;
+    balance.store(s.balance, std::memory_order_relaxed);
+    holds.store(s.holds, std::memory_order_relaxed);
+    withdrawnToday.store(s.withdrawnToday, std::memory_order_relaxed);
+    withdrawalDay.store(s.day, std::memory_order_relaxed);
+    activeDay.store(other.lastActiveDay(), std::memory_order_relaxed);
+    flags.store(other.flags.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    interestDay.store(other.interestPaidDay(), std::memory_order_relaxed);
+    std::memcpy(accountHolderName, other.accountHolderName, sizeof(accountHolderName));
+    endWrite(started);
+    return *this;
+}
+
+// --- Seqlock ---
+
+std::uint32_t Account::beginWrite() const {
+    std::uint32_t s = sequence.load(std::memory_order_relaxed);
+    for (;;) {
+        if (s & 1) {
+            // Another writer on this account; its critical section is a
+            // handful of stores.
+            cpuRelax();
+            s = sequence.load(std::memory_order_relaxed);
+        } else if (sequence.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            // Field stores must not become visible before the odd sequence.
+            std::atomic_thread_fence(std::memory_order_release);
+            return s + 1;
+        }
+    }
+}
+
+AccountSnapshot Account::snapshot() const {
+    for (int attempt = 0; attempt < kMaxReadRetries; attempt++) {
+        std::uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            cpuRelax();
+            continue;
+        }
+        AccountSnapshot s{balance.load(std::memory_order_relaxed), holds.load(std::memory_order_relaxed),
+                          withdrawnToday.load(std::memory_order_relaxed), withdrawalDay.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) return s;
+    }
+    // Writers kept winning: read once under the write side instead.
+    std::uint32_t started = beginWrite();
+    AccountSnapshot s{balance.load(std::memory_order_relaxed), holds.load(std::memory_order_relaxed),
+                      withdrawnToday.load(std::memory_order_relaxed), withdrawalDay.load(std::memory_order_relaxed)};
+    endWrite(started);
+    return s;
+}
+
+void Account::rollDay(std::uint32_t today) {
+    if (withdrawalDay.load(std::memory_order_relaxed) < today) {
+        withdrawalDay.store(today, std::memory_order_relaxed);
+        withdrawnToday.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Activity and the dormancy flag are not part of the seqlocked money
+// fields, so they are plain relaxed stores, skipped when unchanged.
+void Account::markActive(std::uint32_t day) {
+    if (activeDay.load(std::memory_order_relaxed) < day) activeDay.store(day, std::memory_order_relaxed);
+    if (flags.load(std::memory_order_relaxed) & kDormant) flags.fetch_and(~kDormant, std::memory_order_relaxed);
+}
+
+void Account::setDormant(bool dormant) {
+    if (dormant) {
+        flags.fetch_or(kDormant, std::memory_order_relaxed);
+    } else {
+        flags.fetch_and(~kDormant, std::memory_order_relaxed);
+    }
+}
+
+// --- Money operations ---
+
+TxnStatus Account::deposit(Money amount, Money* balanceAfter) {
+    if (!isValidCashAmount(amount)) return TxnStatus::InvalidAmount;
+    TxnStatus status = credit(amount, balanceAfter);
+    if (status == TxnStatus::Ok) markActive(currentDay());
+    return status;
+}
+
+TxnStatus Account::tryWithdraw(Money amount, Money* balanceAfter) {
+    if (!isValidCashAmount(amount)) return TxnStatus::InvalidAmount;
+    std::uint32_t today = currentDay();
+    std::uint32_t started = beginWrite();
+    Money current = balance.load(std::memory_order_relaxed);
+    if (amount > current - holds.load(std::memory_order_relaxed)) {
+        endWrite(started);
+        return TxnStatus::InsufficientFunds;
+    }
+    rollDay(today);
+    balance.store(current - amount, std::memory_order_relaxed);
+    withdrawnToday.store(withdrawnToday.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    endWrite(started);
+    markActive(today);
+    if (balanceAfter) *balanceAfter = current - amount;
+    return TxnStatus::Ok;
+}
+
+TxnStatus Account::credit(Money amount, Money* balanceAfter) {
+    if (amount <= 0) return TxnStatus::InvalidAmount;
+    std::uint32_t started = beginWrite();
+    Money after = balance.load(std::memory_order_relaxed) + amount;
+    balance.store(after, std::memory_order_relaxed);
+    endWrite(started);
+    if (balanceAfter) *balanceAfter = after;
+    return TxnStatus::Ok;
+}
+
+TxnStatus Account::debit(Money amount, Money* balanceAfter) {
+    if (amount <= 0) return TxnStatus::InvalidAmount;
+    std::uint32_t started = beginWrite();
+    Money current = balance.load(std::memory_order_relaxed);
+    // Checked inside the write section, so two concurrent debits can
+    // never overdraw the account together.
+    if (amount > current - holds.load(std::memory_order_relaxed)) {
+        endWrite(started);
+        return TxnStatus::InsufficientFunds;
+    }
+    balance.store(current - amount, std::memory_order_relaxed);
+    endWrite(started);
+    markActive(currentDay());
+    if (balanceAfter) *balanceAfter = current - amount;
+    return TxnStatus::Ok;
+}
+
+TxnStatus Account::placeHold(Money amount) {
+    if (amount <= 0) return TxnStatus::InvalidAmount;
+    std::uint32_t started = beginWrite();
+    Money held = holds.load(std::memory_order_relaxed);
+    if (amount > balance.load(std::memory_order_relaxed) - held) {
+        endWrite(started);
+        return TxnStatus::InsufficientFunds;
+    }
+    holds.store(held + amount, std::memory_order_relaxed);
+    endWrite(started);
+    return TxnStatus::Ok;
+}
+
+void Account::releaseHold(Money amount) {
+    if (amount <= 0) return;
+    std::uint32_t started = beginWrite();
+    Money held = holds.load(std::memory_order_relaxed);
+    holds.store(held - std::min(amount, held), std::memory_order_relaxed);
+    endWrite(started);
+}
+
+bool Account::resetDailyTotals(std::uint32_t day) {
+    std::uint32_t started = beginWrite();
+    bool rolled = withdrawalDay.load(std::memory_order_relaxed) < day;
+    if (rolled) {
+        withdrawalDay.store(day, std::memory_order_relaxed);
+        withdrawnToday.store(0, std::memory_order_relaxed);
+    }
+    endWrite(started);
+    return rolled;
+}
+
+bool Account::clearInterruptedWrite() {
+    std::uint32_t s = sequence.load(std::memory_order_relaxed);
+    if (!(s & 1)) return false;
+    // The fields hold whatever the dead writer got to store; each is a
+    // whole word, and journal replay brings the balance back in line.
+    sequence.store(s + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void Account::reverseDeposit(Money amount, Money* balanceAfter) {
+    std::uint32_t started = beginWrite();
+    Money after = balance.load(std::memory_order_relaxed) - amount;
+    balance.store(after, std::memory_order_relaxed);
+    endWrite(started);
+    if (balanceAfter) *balanceAfter = after;
+}
+
+void Account::reverseWithdrawal(Money amount, Money* balanceAfter) {
+    std::uint32_t started = beginWrite();
+    Money after = balance.load(std::memory_order_relaxed) + amount;
+    balance.store(after, std::memory_order_relaxed);
+    // The withdrawal counted towards today's total; if the day has been
+    // closed since, that total is gone already.
+    if (withdrawalDay.load(std::memory_order_relaxed) == currentDay()) {
+        Money withdrawn = withdrawnToday.load(std::memory_order_relaxed);
+        withdrawnToday.store(withdrawn - std::min(amount, withdrawn), std::memory_order_relaxed);
+    }
+    endWrite(started);
+    if (balanceAfter) *balanceAfter = after;
+}
+
+void Account::applyDelta(Money delta, std::uint32_t customerDay) {
+    std::uint32_t started = beginWrite();
+    balance.store(balance.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    endWrite(started);
+    if (customerDay) markActive(customerDay);
+}
+
+void Account::applyWithdrawal(Money amount, std::uint32_t day) {
+    std::uint32_t started = beginWrite();
+    balance.store(balance.load(std::memory_order_relaxed) - amount, std::memory_order_relaxed);
+    std::uint32_t current = withdrawalDay.load(std::memory_order_relaxed);
+    if (day > current) {
+        withdrawalDay.store(day, std::memory_order_relaxed);
+        withdrawnToday.store(amount, std::memory_order_relaxed);
+    } else if (day == current) {
+        withdrawnToday.store(withdrawnToday.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    endWrite(started);
+    markActive(day);
+}
+
+} // namespace atm
@@ -0,0 +1,162 @@
+#ifndef ATM_ACCOUNT_H
+#define ATM_ACCOUNT_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "money.h"
+#include "pin_hash.h"
+
+namespace atm {
+
+// Cash is handled in whole notes, so deposits and withdrawals must be
+// positive multiples of the smallest note the machine accepts.
+constexpr int kNoteDenomination = 100;
+
+enum class TxnStatus {
+    Ok,
+    InvalidAmount,
+    InsufficientFunds
+};
+
+bool isValidCashAmount(Money amount);
+
+// A consistent view of an account's money fields, taken without locking.
+struct AccountSnapshot {
+    Money balance;
+    Money holds;             // reserved by pending operations, not yet debited
+    Money withdrawnToday;    // cash withdrawn on `day`
+    std::uint32_t day;       // days since the Unix epoch (UTC)
+
+    Money available() const { return balance - holds; }
+};
+
+// Today as an AccountSnapshot::day value.
+std::uint32_t currentDay();
+
+// Fixed-size, standard-layout record so the same layout can live in a
+// std::vector or directly in a memory-mapped account file.
+//
+// The money fields (balance, holds, today's withdrawals) change together,
+// so they are versioned by a seqlock. A writer makes the sequence odd
+// with a CAS, updates the fields and makes it even again; concurrent
+// writers on one account take turns on that CAS. Writers are therefore
+// not lock-free (the balance used to be a single CAS-updated word): a
+// writer descheduled inside its few stores holds up the other writers on
+// that account until it runs again, and one killed there would hold them
+// up for good, which is why AccountFile::copy() clears sequences left odd
+// by a crash, and a file is copied before it is served after one. Readers
+// never write: snapshot() copies the fields and retries if the sequence
+// was odd or moved meanwhile, so balance inquiries never make a writer
+// wait. Only a reader that keeps losing the race (kMaxReadRetries) falls
+// back to taking the write side once.
+//
+// Every field is a naturally aligned atomic word, so nothing is ever torn
+// when its page is written back to the account file.
+class Account {
+public:
+    static constexpr std::size_t kNameCapacity = 44;   // including the terminating NUL
+    static constexpr int kMaxReadRetries = 64;
+    // Set by the end-of-day job on an account without customer activity
+    // for the dormancy period; the next customer transaction clears it.
+    static constexpr std::uint32_t kDormant = 1;
+
+private:
+    long long cardNumber;
+    int accountNumber;
+    PinCredential pin;
+    std::atomic<Money> balance;
+    std::atomic<Money> holds;
+    std::atomic<Money> withdrawnToday;
+    mutable std::atomic<std::uint32_t> sequence;   // odd while a write is in progress
+    std::atomic<std::uint32_t> withdrawalDay;
+    std::atomic<std::uint32_t> activeDay;   // last customer-initiated transaction, 0 if none yet
+    std::atomic<std::uint32_t> flags;       // kDormant
+    std::atomic<std::uint32_t> interestDay; // last business day interest was credited for, 0 if none
+    char accountHolderName[kNameCapacity];
+
+    friend class AccountTable;
+
+    std::uint32_t beginWrite() const;
+    void endWrite(std::uint32_t started) const { sequence.store(started + 1, std::memory_order_release); }
+    void rollDay(std::uint32_t today);
+
+public:
+    // Names longer than kNameCapacity - 1 bytes are truncated.
+    Account(int accNum = 0, std::string_view accHolder = "", Money bal = 0, const PinCredential& pinHash = PinCredential(),
+            long long cardNum = 0);
+    Account(const Account& other);
+    Account& operator=(const Account& other);
+
+    int getAccountNumber() const { return accountNumber; }
+    long long getCardNumber() const { return cardNumber; }
+    const PinCredential& pinCredential() const { return pin; }
+    // Runs the full PIN hash on the calling thread; interactive callers
+    // should go through a PinVerifier with pinCredential() instead.
+    bool validatePin(std::string_view enteredPin) const { return verifyPin(pin, enteredPin); }
+    std::string_view getName() const { return accountHolderName; }
+    // The balance alone is one word and needs no seqlock.
+    Money getBalance() const { return balance.load(std::memory_order_acquire); }
+    AccountSnapshot snapshot() const;
+    // Day of the last deposit, withdrawal or debit; credits (incoming
+    // transfers, interest) are not customer activity.
+    std::uint32_t lastActiveDay() const { return activeDay.load(std::memory_order_relaxed); }
+    bool isDormant() const { return flags.load(std::memory_order_relaxed) & kDormant; }
+    void setDormant(bool dormant);
+    // Records customer activity on day and clears the dormant flag.
+    void markActive(std::uint32_t day);
+    // Last business day the end-of-day job credited interest for (journal
+    // replay restores it), so a rerun never pays a day twice.
+    std::uint32_t interestPaidDay() const { return interestDay.load(std::memory_order_relaxed); }
+    void setInterestPaidDay(std::uint32_t day) { interestDay.store(day, std::memory_order_relaxed); }
+
+    // Cash operations: amount must be a whole number of notes.
+    // balanceAfter, when given, receives the balance this operation produced.
+    // Withdrawals and debits may not exceed the available balance.
+    TxnStatus deposit(Money amount, Money* balanceAfter = nullptr);
+    TxnStatus tryWithdraw(Money amount, Money* balanceAfter = nullptr);
+
+    // Book entries (transfers, interest): any positive amount.
+    TxnStatus credit(Money amount, Money* balanceAfter = nullptr);
+    TxnStatus debit(Money amount, Money* balanceAfter = nullptr);
+
+    // Reserves amount of the available balance (e.g. while a UPI payment
+    // is pending), and gives back up to amount of it.
+    TxnStatus placeHold(Money amount);
+    void releaseHold(Money amount);
+
+    // Starts a new day's withdrawal total (end-of-day processing). Days
+    // only ever roll forward, so after closing day d with
+    // resetDailyTotals(d + 1) the rest of the calendar day counts towards
+    // d + 1, and closing d again is a no-op. Returns false if the total was
+    // already on day or later.
+    bool resetDailyTotals(std::uint32_t day);
+
+    // Makes an odd sequence even again: the record was in a mapped file
+    // when a process died inside a write. Only for records no other thread
+    // can reach yet (a file being copied). Returns whether the
+    // sequence was odd.
+    bool clearInterruptedWrite();
+
+    // Takes back a cash operation that went through here but could not be
+    // journaled. Unchecked, like the replay entries below: a deposit that
+    // never reached the journal has to come back out even if the account
+    // has been drawn on since.
+    void reverseDeposit(Money amount, Money* balanceAfter = nullptr);
+    void reverseWithdrawal(Money amount, Money* balanceAfter = nullptr);
+
+    // Journal replay (and taking back a book entry that never reached the
+    // journal): applies a change that was already validated when it first
+    // happened, so no amount or overdraft checks. A nonzero customerDay
+    // marks the account active on that day.
+    void applyDelta(Money delta, std::uint32_t customerDay = 0);
+    // Same for a replayed cash withdrawal, which also counts towards the
+    // daily total of the day it happened on.
+    void applyWithdrawal(Money amount, std::uint32_t day);
+};
+
+} // namespace atm
+
+#endif // ATM_ACCOUNT_H
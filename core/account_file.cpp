@@ -0,0 +1,225 @@
+#include "account_file.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+#include "checksum.h"
+
+namespace atm {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'G', 'A', 'T', 'M', 'A', 'C', 'C'};
+constexpr std::uint32_t kFormatVersion = 7;   // 2: int64 paise balance word, 3: journal LSN, 4: hashed PINs, 5: seqlocked money fields, 6: activity day and flags, 7: clean-close flag, 8: interest day
+constexpr std::size_t kPageSize = 4096;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t recordSize;
+    std::uint64_t recordCount;
+    std::uint64_t recordsOffset;
+    std::uint64_t accountIndexOffset;
+    std::uint64_t accountIndexCapacity;
+    std::uint64_t accountIndexCount;
+    std::uint64_t cardIndexOffset;
+    std::uint64_t cardIndexCapacity;
+    std::uint64_t cardIndexCount;
+    std::uint64_t fileSize;
+    std::uint64_t journalLsn;       // balances include every journal record up to here
+    std::uint32_t closedCleanly;    // 1 from closeCleanly() until markOpen()
+    std::uint32_t headerChecksum;   // CRC-32 of every field above
+};
+
+static_assert(sizeof(FileHeader) <= kPageSize, "Header must fit in the first page");
+
+std::uint64_t pageAlign(std::uint64_t offset) {
+    return (offset + kPageSize - 1) / kPageSize * kPageSize;
+}
+
+std::uint32_t headerChecksum(const FileHeader& h) {
+    return crc32(&h, offsetof(FileHeader, headerChecksum));
+}
+
+[[noreturn]] void malformed(const std::string& path, const char* why) {
+    throw std::runtime_error("Account file " + path + " is not usable: " + why);
+}
+
+bool sectionFits(std::uint64_t offset, std::uint64_t bytes, std::uint64_t fileSize) {
+    return offset % kPageSize == 0 && offset <= fileSize && bytes <= fileSize - offset;
+}
+
+// Sequences left odd by a process that died inside a write would make the
+// next writer on that account spin for ever (see Account).
+void clearInterruptedWrites(Account* records, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) records[i].clearInterruptedWrite();
+}
+
+void replaceFile(const std::string& tmpPath, const std::string& path) {
+    std::remove(path.c_str());   // rename() does not replace on Windows
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot move " + tmpPath + " to " + path);
+    }
+}
+
+} // namespace
+
+void AccountFile::create(const std::string& path, const std::vector<Account>& accounts, std::uint64_t journalLsn) {
+    // Build the indexes in memory with the same code the store uses, then
+    // lay the finished slot arrays out on disk.
+    AccountStore built;
+    built.bulkLoad(accounts);
+    create(path, built, journalLsn);
+}
+
+void AccountFile::create(const std::string& path, const AccountStore& built, std::uint64_t journalLsn) {
+    const HashIndex& accIndex = built.accountIndex();
+    const HashIndex& cardIndex = built.cardIndex();
+
+    FileHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.formatVersion = kFormatVersion;
+    h.recordSize = sizeof(Account);
+    h.recordCount = built.size();
+    h.recordsOffset = kPageSize;
+    h.accountIndexOffset = pageAlign(h.recordsOffset + h.recordCount * sizeof(Account));
+    h.accountIndexCapacity = accIndex.capacity();
+    h.accountIndexCount = accIndex.size();
+    h.cardIndexOffset = pageAlign(h.accountIndexOffset + h.accountIndexCapacity * sizeof(HashIndex::Slot));
+    h.cardIndexCapacity = cardIndex.capacity();
+    h.cardIndexCount = cardIndex.size();
+    h.fileSize = pageAlign(h.cardIndexOffset + h.cardIndexCapacity * sizeof(HashIndex::Slot));
+    h.journalLsn = journalLsn;
+    h.headerChecksum = headerChecksum(h);
+
+    std::string tmpPath = path + ".tmp";
+    {
+        MappedFile out = MappedFile::create(tmpPath, h.fileSize);
+        unsigned char* base = out.data();
+        Account* records = reinterpret_cast<Account*>(base + h.recordsOffset);
+        for (std::size_t i = 0; i < h.recordCount; i++) new (&records[i]) Account(built.begin()[i]);
+        if (h.accountIndexCapacity) {
+            std::memcpy(base + h.accountIndexOffset, accIndex.data(), h.accountIndexCapacity * sizeof(HashIndex::Slot));
+        }
+        if (h.cardIndexCapacity) {
+            std::memcpy(base + h.cardIndexOffset, cardIndex.data(), h.cardIndexCapacity * sizeof(HashIndex::Slot));
+        }
+        // The header goes in last, so a crash mid-build never leaves a file
+        // that validates.
+        out.sync();
+        std::memcpy(base, &h, sizeof(h));
+        out.sync(0, sizeof(h));
+    }
+    replaceFile(tmpPath, path);
+}
+
+void AccountFile::copy(const std::string& from, const std::string& to) {
+    // Validate the source first so a damaged file is never propagated.
+    AccountFile source = open(from);
+    std::string tmpPath = to + ".tmp";
+    {
+        MappedFile out = MappedFile::create(tmpPath, source.mapping.size());
+        std::memcpy(out.data() + kPageSize, source.mapping.data() + kPageSize, out.size() - kPageSize);
+        // The source may have been left by a process that died inside a
+        // write; every file is copied before it is served after a crash
+        // (see recoverAccounts()), so this is where such records are fixed.
+        std::ptrdiff_t recordsOffset = reinterpret_cast<const unsigned char*>(source.store.begin()) -
+                                       source.mapping.data();
+        clearInterruptedWrites(reinterpret_cast<Account*>(out.data() + recordsOffset), source.store.size());
+        out.sync();
+        FileHeader h;
+        std::memcpy(&h, source.mapping.data(), sizeof(h));
+        h.closedCleanly = 0;   // the copy is about to be written to
+        h.headerChecksum = headerChecksum(h);
+        std::memcpy(out.data(), &h, sizeof(h));
+        out.sync(0, kPageSize);
+    }
+    replaceFile(tmpPath, to);
+}
+
+AccountFile AccountFile::open(const std::string& path) {
+    AccountFile file;
+    file.mapping = MappedFile::open(path);
+    if (file.mapping.size() < kPageSize) malformed(path, "truncated header");
+
+    FileHeader h;
+    std::memcpy(&h, file.mapping.data(), sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) malformed(path, "bad magic");
+    if (h.headerChecksum != headerChecksum(h)) malformed(path, "header checksum mismatch");
+    if (h.formatVersion != kFormatVersion) malformed(path, "unsupported format version");
+    if (h.recordSize != sizeof(Account)) malformed(path, "record size mismatch");
+    if (h.fileSize != file.mapping.size()) malformed(path, "file size does not match header");
+    if (!sectionFits(h.recordsOffset, h.recordCount * sizeof(Account), h.fileSize) ||
+        !sectionFits(h.accountIndexOffset, h.accountIndexCapacity * sizeof(HashIndex::Slot), h.fileSize) ||
+        !sectionFits(h.cardIndexOffset, h.cardIndexCapacity * sizeof(HashIndex::Slot), h.fileSize)) {
+        malformed(path, "section out of bounds");
+    }
+    if (h.accountIndexCount != h.recordCount) malformed(path, "index does not cover every record");
+
+    unsigned char* base = file.mapping.data();
+    HashIndex accIndex = HashIndex::view(reinterpret_cast<const HashIndex::Slot*>(base + h.accountIndexOffset),
+                                         h.accountIndexCapacity, h.accountIndexCount);
+    HashIndex cardIndex;
+    if (h.cardIndexCapacity) {
+        cardIndex = HashIndex::view(reinterpret_cast<const HashIndex::Slot*>(base + h.cardIndexOffset),
+                                    h.cardIndexCapacity, h.cardIndexCount);
+    }
+    Account* records = reinterpret_cast<Account*>(base + h.recordsOffset);
+    file.store = AccountStore::view(records, h.recordCount, std::move(accIndex), std::move(cardIndex));
+    return file;
+}
+
+AccountFile AccountFile::openOrCreate(const std::string& path, const std::vector<Account>& seed) {
+    if (!std::ifstream(path, std::ios::binary).good()) create(path, seed);
+    return open(path);
+}
+
+std::uint64_t AccountFile::journalLsn() const {
+    FileHeader h;
+    std::memcpy(&h, mapping.data(), sizeof(h));
+    return h.journalLsn;
+}
+
+void AccountFile::setJournalLsn(std::uint64_t lsn) {
+    FileHeader h;
+    std::memcpy(&h, mapping.data(), sizeof(h));
+    writeHeader(lsn, h.closedCleanly != 0);
+}
+
+bool AccountFile::closedCleanly() const {
+    FileHeader h;
+    std::memcpy(&h, mapping.data(), sizeof(h));
+    return h.closedCleanly != 0;
+}
+
+void AccountFile::markOpen() {
+    writeHeader(journalLsn(), false);
+}
+
+void AccountFile::closeCleanly(std::uint64_t lsn) {
+    // Records first: the flag may only reach the disk after them.
+    mapping.sync();
+    writeHeader(lsn, true);
+}
+
+void AccountFile::writeHeader(std::uint64_t lsn, bool clean) {
+    FileHeader h;
+    std::memcpy(&h, mapping.data(), sizeof(h));
+    h.journalLsn = lsn;
+    h.closedCleanly = clean ? 1 : 0;
+    h.headerChecksum = headerChecksum(h);
+    std::memcpy(mapping.data(), &h, sizeof(h));
+    mapping.sync(0, sizeof(h));
+}
+
+void AccountFile::sync(const Account& account) const {
+    std::size_t offset = reinterpret_cast<const unsigned char*>(&account) - mapping.data();
+    mapping.sync(offset, sizeof(Account));
+}
+
+} // namespace atm
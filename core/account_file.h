@@ -0,0 +1,84 @@
+#ifndef ATM_ACCOUNT_FILE_H
+#define ATM_ACCOUNT_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "mapped_file.h"
+
+namespace atm {
+
+// On-disk account set served straight from a memory mapping.
+//
+// Layout (native byte order, every section page aligned):
+//   [header page][Account records][account-number index][card-number index]
+//
+// The index sections are HashIndex slot arrays written at creation time,
+// so opening a file only validates the header: no parsing and no index
+// rebuild, whatever the number of accounts. Balance updates land in the
+// mapped records (an aligned word each, so never torn) and reach the disk
+// on sync() or normal kernel write-back.
+//
+// The header also carries the journal LSN the balances are current up to,
+// which is what makes a copy of the file a snapshot (see snapshot.h).
+class AccountFile {
+public:
+    AccountFile() = default;
+
+    // Writes a new file for accounts, replacing path atomically (the file is
+    // built under a temporary name and renamed into place).
+    static void create(const std::string& path, const std::vector<Account>& accounts, std::uint64_t journalLsn = 0);
+    // Same, from a store whose indexes are already built (e.g. by a bulk
+    // import); its slot arrays are written as they are.
+    static void create(const std::string& path, const AccountStore& accounts, std::uint64_t journalLsn = 0);
+
+    // Makes to a byte-for-byte copy of the account file at from, replacing
+    // to atomically. Indexes are copied, not rebuilt; seqlock sequences a
+    // crash left odd are made even in the copy. from must not be written
+    // to meanwhile.
+    static void copy(const std::string& from, const std::string& to);
+
+    // Opens path; throws std::runtime_error if it is missing or malformed.
+    // Records are served as they are: a file a crash may have left mid-write
+    // goes through copy() first (recoverAccounts() does this).
+    static AccountFile open(const std::string& path);
+
+    // Opens path, creating it from seed first if it does not exist yet.
+    static AccountFile openOrCreate(const std::string& path, const std::vector<Account>& seed);
+
+    AccountStore& accounts() { return store; }
+    const AccountStore& accounts() const { return store; }
+
+    // Forces the page holding account to disk.
+    void sync(const Account& account) const;
+    // Forces the whole file to disk.
+    void sync() const { mapping.sync(); }
+
+    std::uint64_t journalLsn() const;
+    // Rewrites the header with a new journal LSN and syncs it.
+    void setJournalLsn(std::uint64_t lsn);
+
+    // Clean close: a file whose records were all synced after the last
+    // change, with every journal record up to journalLsn() applied, can be
+    // served again as it is (see recoverAccounts()). closeCleanly() syncs
+    // the records and then sets the flag; markOpen() clears it before the
+    // file is written to again. New files and copies start out not clean.
+    bool closedCleanly() const;
+    void markOpen();
+    void closeCleanly(std::uint64_t journalLsn);
+
+    const std::string& path() const { return mapping.path(); }
+
+private:
+    MappedFile mapping;
+    AccountStore store;
+
+    void writeHeader(std::uint64_t journalLsn, bool clean);
+};
+
+} // namespace atm
+
+#endif // ATM_ACCOUNT_FILE_H
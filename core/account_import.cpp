@@ -0,0 +1,341 @@
+#include "account_import.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+#include "card_number.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "pin_hash.h"
+
+namespace atm {
+
+namespace {
+
+// Files smaller than this are parsed on one thread.
+constexpr std::size_t kParallelImportMin = 1 << 20;
+constexpr int kChunksPerThread = 4;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool isBlank(const char* p, const char* end) {
+    for (; p < end; p++) {
+        if (*p != ' ' && *p != '\t' && *p != '\r') return false;
+    }
+    return true;
+}
+
+const char* lineEnd(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<std::size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+struct ParseError {
+    const char* at;
+    const char* message;
+};
+
+// Field-by-field parser over one line (without its newline). Every
+// function either consumes its field and the delimiter after it, or
+// throws ParseError pointing at the offending byte.
+class LineParser {
+public:
+    LineParser(const char* begin, const char* end, char delimiter) : p(begin), end(end), delimiter(delimiter) {
+        if (this->end > p && this->end[-1] == '\r') this->end--;
+    }
+
+    bool atEnd() {
+        skipSpaces();
+        return p == end;
+    }
+
+    std::uint64_t number(int maxDigits, const char* what) {
+        skipSpaces();
+        std::uint64_t value = 0;
+        int digits = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (++digits > maxDigits) throw ParseError{p, what};
+            value = value * 10 + static_cast<std::uint64_t>(*p++ - '0');
+        }
+        if (digits == 0) throw ParseError{p, what};
+        finishField(what);
+        return value;
+    }
+
+    // Rupees with up to two decimals, returned in paise.
+    Money amount(const char* what) {
+        skipSpaces();
+        Money whole = 0;
+        int digits = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (++digits > 15) throw ParseError{p, what};
+            whole = whole * 10 + (*p++ - '0');
+        }
+        Money paise = 0;
+        if (p < end && *p == '.') {
+            p++;
+            int decimals = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                if (++decimals > 2) throw ParseError{p, what};
+                paise = paise * 10 + (*p++ - '0');
+            }
+            if (decimals == 1) paise *= 10;
+            digits += decimals;
+        }
+        if (digits == 0) throw ParseError{p, what};
+        finishField(what);
+        return whole * kPaisePerRupee + paise;
+    }
+
+    // Copies the field into buffer (truncating at capacity) and returns it.
+    std::string_view text(char* buffer, std::size_t capacity) {
+        skipSpaces();
+        std::size_t length = 0;
+        if (delimiter == ',' && p < end && *p == '"') {
+            p++;
+            for (;;) {
+                if (p == end) throw ParseError{p, "unterminated quoted name"};
+                if (*p == '"') {
+                    if (p + 1 < end && p[1] == '"') {
+                        p++;
+                    } else {
+                        p++;
+                        break;
+                    }
+                }
+                if (length < capacity) buffer[length++] = *p;
+                p++;
+            }
+            finishField("text after quoted name");
+            return std::string_view(buffer, length);
+        }
+        const char* start = p;
+        while (p < end && *p != delimiter) p++;
+        const char* stop = p;
+        while (stop > start && (stop[-1] == ' ' || stop[-1] == '\t')) stop--;
+        length = std::min<std::size_t>(static_cast<std::size_t>(stop - start), capacity);
+        std::memcpy(buffer, start, length);
+        if (p < end) p++;
+        return std::string_view(buffer, length);
+    }
+
+private:
+    const char* p;
+    const char* end;
+    char delimiter;
+
+    void skipSpaces() {
+        while (p < end && (*p == ' ' || (*p == '\t' && delimiter != '\t'))) p++;
+    }
+
+    void finishField(const char* what) {
+        skipSpaces();
+        if (p == end) return;
+        if (*p != delimiter) throw ParseError{p, what};
+        p++;
+    }
+};
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    std::size_t records = 0;
+    std::size_t firstRow = 0;
+    std::vector<CardLink> extraCards;
+    const char* errorAt = nullptr;
+    const char* errorMessage = nullptr;
+};
+
+std::size_t countRecords(const char* p, const char* end) {
+    std::size_t records = 0;
+    while (p < end) {
+        const char* eol = lineEnd(p, end);
+        if (!isBlank(p, eol)) records++;
+        p = eol + 1;
+    }
+    return records;
+}
+
+// A PIN field holds either a credential exported by formatPinCredential()
+// or plain digits, which are hashed here at the given cost.
+PinCredential parsePin(LineParser& line, char* buffer, std::size_t capacity, int pinCost, const char* lineStart) {
+    std::string_view field = line.text(buffer, capacity);
+    PinCredential credential;
+    if (!field.empty() && field[0] == '$') {
+        if (!parsePinCredential(field, credential)) throw ParseError{lineStart, "bad PIN hash"};
+        return credential;
+    }
+    if (!isValidPin(field)) throw ParseError{lineStart, "bad PIN"};
+    return hashPin(field, pinCost);
+}
+
+// Card numbers are collected as they are parsed and their length and
+// check digit verified kCardBatch at a time with validateCardNumbers().
+class CardBatch {
+public:
+    void add(long long card, const char* line) {
+        cards[count] = card;
+        lines[count] = line;
+        if (++count == kCardBatch) check();
+    }
+
+    // Throws ParseError for the first invalid card since the last check.
+    void check() {
+        std::size_t n = count;
+        count = 0;
+        if (validateCardNumbers(cards, n, valid) == n) return;
+        for (std::size_t i = 0; i < n; i++) {
+            if (!valid[i]) throw ParseError{lines[i], "bad card number (length or check digit)"};
+        }
+    }
+
+private:
+    static constexpr std::size_t kCardBatch = 1024;
+
+    long long cards[kCardBatch];
+    const char* lines[kCardBatch];
+    bool valid[kCardBatch];
+    std::size_t count = 0;
+};
+
+void parseChunk(Chunk& chunk, char delimiter, int pinCost, Account* out) {
+    std::size_t row = chunk.firstRow;
+    char name[Account::kNameCapacity];
+    char pinField[96];
+    std::unique_ptr<CardBatch> cards = std::make_unique<CardBatch>();
+    const char* p = chunk.begin;
+    try {
+        while (p < chunk.end) {
+            const char* eol = lineEnd(p, chunk.end);
+            if (isBlank(p, eol)) {
+                p = eol + 1;
+                continue;
+            }
+            LineParser line(p, eol, delimiter);
+            std::uint64_t accountNumber = line.number(10, "bad account number");
+            if (accountNumber == 0 || accountNumber > INT_MAX) throw ParseError{p, "bad account number"};
+            std::string_view holder = line.text(name, sizeof(name) - 1);
+            Money balance = line.amount("bad balance");
+            PinCredential pin = parsePin(line, pinField, sizeof(pinField), pinCost, p);
+
+            long long primaryCard = 0;
+            while (!line.atEnd()) {
+                std::uint64_t card = line.number(19, "bad card number");
+                if (card > static_cast<std::uint64_t>(LLONG_MAX)) throw ParseError{p, "bad card number"};
+                cards->add(static_cast<long long>(card), p);
+                if (primaryCard == 0) {
+                    primaryCard = static_cast<long long>(card);
+                } else {
+                    chunk.extraCards.push_back(CardLink{static_cast<long long>(card), static_cast<std::uint32_t>(row)});
+                }
+            }
+            if (primaryCard == 0) throw ParseError{p, "missing card number"};
+            out[row - chunk.firstRow] = Account(static_cast<int>(accountNumber), holder, balance, pin, primaryCard);
+            row++;
+            p = eol + 1;
+        }
+        cards->check();
+    } catch (const ParseError& e) {
+        chunk.errorAt = e.at;
+        chunk.errorMessage = e.message;
+        // Cards still pending come from earlier lines; report those first.
+        try {
+            cards->check();
+        } catch (const ParseError& earlier) {
+            chunk.errorAt = earlier.at;
+            chunk.errorMessage = earlier.message;
+        }
+    }
+}
+
+} // namespace
+
+AccountImport parseAccounts(const std::string& path, unsigned threads, int pinCost) {
+    auto start = std::chrono::steady_clock::now();
+    AccountImport result;
+    threads = resolveThreads(threads);
+    if (pinCost < kMinPinCost || pinCost > kMaxPinCost) throw std::invalid_argument("PIN hash cost out of range");
+
+    std::ifstream probe(path, std::ios::binary | std::ios::ate);
+    if (!probe) throw std::runtime_error("Cannot read account import file " + path);
+    if (probe.tellg() == 0) return result;
+    probe.close();
+
+    MappedFile file = MappedFile::open(path);
+    const char* const begin = reinterpret_cast<const char*>(file.data());
+    const char* const end = begin + file.size();
+    result.stats.bytes = file.size();
+
+    const char* data = begin;
+    const char* firstEol = lineEnd(begin, end);
+    char delimiter = std::memchr(begin, '\t', static_cast<std::size_t>(firstEol - begin)) ? '\t' : ',';
+    const char* first = begin;
+    while (first < firstEol && (*first == ' ' || *first == '\t')) first++;
+    if (first < firstEol && (*first < '0' || *first > '9')) data = std::min(firstEol + 1, end);   // header line
+
+    // Cut at line boundaries; a chunk may be empty if lines are long.
+    if (file.size() < kParallelImportMin) threads = 1;
+    std::size_t chunkCount = std::size_t{threads} * (threads > 1 ? kChunksPerThread : 1);
+    std::vector<Chunk> chunks(chunkCount);
+    const char* cut = data;
+    for (std::size_t k = 0; k < chunkCount; k++) {
+        const char* target = data + static_cast<std::size_t>(end - data) * (k + 1) / chunkCount;
+        const char* next = k + 1 == chunkCount ? end : std::max(cut, std::min(lineEnd(target, end) + 1, end));
+        chunks[k].begin = cut;
+        chunks[k].end = next;
+        cut = next;
+    }
+
+    runOnThreads(threads, [&](unsigned t) {
+        for (std::size_t k = t; k < chunkCount; k += threads) chunks[k].records = countRecords(chunks[k].begin, chunks[k].end);
+    });
+    std::size_t total = 0;
+    for (Chunk& c : chunks) {
+        c.firstRow = total;
+        total += c.records;
+    }
+    if (total > 0xFFFFFFFEu) throw std::invalid_argument("Too many accounts in " + path);
+    result.stats.countSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    result.accounts.resize(total);
+    result.stats.allocateSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    runOnThreads(threads, [&](unsigned t) {
+        for (std::size_t k = t; k < chunkCount; k += threads) {
+            parseChunk(chunks[k], delimiter, pinCost, result.accounts.data() + chunks[k].firstRow);
+        }
+    });
+    for (const Chunk& c : chunks) {
+        if (c.errorAt) {
+            std::size_t line = 1 + static_cast<std::size_t>(std::count(begin, c.errorAt, '\n'));
+            throw std::invalid_argument(path + ":" + std::to_string(line) + ": " + c.errorMessage);
+        }
+        result.extraCards.insert(result.extraCards.end(), c.extraCards.begin(), c.extraCards.end());
+    }
+    result.stats.parseSeconds = secondsSince(start);
+
+    result.stats.records = total;
+    result.stats.extraCards = result.extraCards.size();
+    result.stats.threads = threads;
+    return result;
+}
+
+ImportStats importAccounts(const std::string& path, AccountStore& store, unsigned threads, int pinCost) {
+    AccountImport parsed = parseAccounts(path, threads, pinCost);
+    auto start = std::chrono::steady_clock::now();
+    store.bulkLoad(std::move(parsed.accounts), parsed.extraCards, parsed.stats.threads ? parsed.stats.threads : 1);
+    parsed.stats.indexSeconds = secondsSince(start);
+    return parsed.stats;
+}
+
+} // namespace atm
@@ -0,0 +1,66 @@
+#ifndef ATM_ACCOUNT_IMPORT_H
+#define ATM_ACCOUNT_IMPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "pin_hash.h"
+
+namespace atm {
+
+// Bulk import of accounts from a CSV or TSV file, one account per line:
+//
+//   account number, holder name, balance, PIN, card number[, card number...]
+//
+// The PIN is either a hash in the form written by formatPinCredential()
+// or plain digits, which are hashed during the import at pinCost (on the
+// parse threads, so a large plaintext file is dominated by hashing).
+//
+// The delimiter is a tab if the first line contains one, otherwise a comma.
+// A first line that does not start with a digit is taken as a header.
+// CSV names may be double-quoted ("" for a literal quote); balances are
+// rupees with up to two decimals. Every account needs at least one card
+// number, and each must pass the length and Luhn check of card_number.h.
+// Blank lines are skipped.
+//
+// The file is mapped, not read, and cut into chunks at line boundaries.
+// Every chunk is counted and then parsed on its own thread straight into
+// its slice of the final account array, with a hand-written field parser.
+// Indexes are built in parallel by AccountStore::bulkLoad.
+
+struct ImportStats {
+    std::size_t records = 0;
+    std::size_t extraCards = 0;
+    std::uint64_t bytes = 0;
+    unsigned threads = 0;
+    double countSeconds = 0;      // file mapped and lines counted per chunk
+    double allocateSeconds = 0;   // final account array allocated
+    double parseSeconds = 0;
+    double indexSeconds = 0;      // hash indexes built (importAccounts only)
+
+    double totalSeconds() const { return countSeconds + allocateSeconds + parseSeconds + indexSeconds; }
+};
+
+struct AccountImport {
+    std::vector<Account> accounts;
+    std::vector<CardLink> extraCards;   // every card after an account's first
+    ImportStats stats;
+};
+
+// Parses path without building indexes. threads == 0 uses every core.
+// pinCost must be in [kMinPinCost, kMaxPinCost].
+// Throws std::runtime_error if the file cannot be read and
+// std::invalid_argument, naming the line, on malformed input.
+AccountImport parseAccounts(const std::string& path, unsigned threads = 0, int pinCost = kDefaultPinCost);
+
+// Parses path and bulk loads the result into store.
+ImportStats importAccounts(const std::string& path, AccountStore& store, unsigned threads = 0,
+                          int pinCost = kDefaultPinCost);
+
+} // namespace atm
+
+#endif // ATM_ACCOUNT_IMPORT_H
@@ -0,0 +1,175 @@
+#include "account_store.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "parallel.h"
+
+namespace atm {
+
+namespace {
+
+std::uint64_t accountKey(int accountNumber) {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(accountNumber));
+}
+
+std::uint64_t cardKey(long long cardNumber) {
+    return static_cast<std::uint64_t>(cardNumber);
+}
+
+} // namespace
+
+AccountStore::AccountStore(AccountStore&& other) noexcept {
+    *this = std::move(other);
+}
+
+AccountStore& AccountStore::operator=(AccountStore&& other) noexcept {
+    owned = std::move(other.owned);
+    records = other.borrowed ? other.records : owned.data();
+    count = other.count;
+    borrowed = other.borrowed;
+    byAccount = std::move(other.byAccount);
+    byCard = std::move(other.byCard);
+    other.records = nullptr;
+    other.count = 0;
+    other.borrowed = false;
+    return *this;
+}
+
+AccountStore AccountStore::view(Account* records, std::size_t count, HashIndex byAccount, HashIndex byCard) {
+    AccountStore store;
+    store.records = records;
+    store.count = count;
+    store.borrowed = true;
+    store.byAccount = std::move(byAccount);
+    store.byCard = std::move(byCard);
+    return store;
+}
+
+void AccountStore::requireOwned() const {
+    if (borrowed) throw std::logic_error("Accounts served from a mapped file cannot be added in place");
+}
+
+void AccountStore::reserve(std::size_t expectedAccounts) {
+    requireOwned();
+    owned.reserve(expectedAccounts);
+    records = owned.data();
+    byAccount.reserve(expectedAccounts);
+    byCard.reserve(expectedAccounts);
+}
+
+bool AccountStore::add(const Account& account) {
+    requireOwned();
+    std::uint64_t accKey = accountKey(account.getAccountNumber());
+    if (byAccount.find(accKey) != HashIndex::kNotFound) return false;
+    if (account.getCardNumber() != 0 && byCard.find(cardKey(account.getCardNumber())) != HashIndex::kNotFound) {
+        return false;
+    }
+
+    std::uint32_t row = static_cast<std::uint32_t>(owned.size());
+    owned.push_back(account);
+    records = owned.data();
+    count = owned.size();
+    byAccount.insert(accKey, row);
+    if (account.getCardNumber() != 0) byCard.insert(cardKey(account.getCardNumber()), row);
+    return true;
+}
+
+void AccountStore::bulkLoad(std::vector<Account> loaded, const std::vector<CardLink>& extraCards, unsigned threads) {
+    requireOwned();
+    threads = resolveThreads(threads);
+    const std::size_t n = loaded.size();
+
+    std::vector<std::uint64_t> keys(n);
+    std::vector<std::size_t> cardsInSlice(threads, 0);
+    runOnThreads(threads, [&](unsigned t) {
+        Slice s = sliceOf(n, t, threads);
+        for (std::size_t i = s.begin; i < s.end; i++) {
+            keys[i] = accountKey(loaded[i].getAccountNumber());
+            if (loaded[i].getCardNumber() != 0) cardsInSlice[t]++;
+        }
+    });
+
+    HashIndex accIndex;
+    std::uint32_t dup = accIndex.build(keys.data(), n, threads);
+    if (dup != HashIndex::kNotFound) {
+        throw std::invalid_argument("Duplicate account number " + std::to_string(loaded[dup].getAccountNumber()));
+    }
+
+    // Accounts without a card are not indexed, so the card keys are
+    // compacted: each slice writes at the offset of the cards before it.
+    std::vector<std::size_t> cardStart(threads + 1, 0);
+    for (unsigned t = 0; t < threads; t++) cardStart[t + 1] = cardStart[t] + cardsInSlice[t];
+    std::size_t cardCount = cardStart[threads] + extraCards.size();
+    std::vector<std::uint64_t> cardKeys(cardCount);
+    std::vector<std::uint32_t> cardRows(cardCount);
+    runOnThreads(threads, [&](unsigned t) {
+        Slice s = sliceOf(n, t, threads);
+        std::size_t out = cardStart[t];
+        for (std::size_t i = s.begin; i < s.end; i++) {
+            if (loaded[i].getCardNumber() == 0) continue;
+            cardKeys[out] = cardKey(loaded[i].getCardNumber());
+            cardRows[out++] = static_cast<std::uint32_t>(i);
+        }
+    });
+    for (std::size_t e = 0; e < extraCards.size(); e++) {
+        if (extraCards[e].row >= n) throw std::invalid_argument("Card linked to a missing account");
+        cardKeys[cardStart[threads] + e] = cardKey(extraCards[e].cardNumber);
+        cardRows[cardStart[threads] + e] = extraCards[e].row;
+    }
+
+    HashIndex cardIndex;
+    dup = cardIndex.build(cardKeys.data(), cardRows.data(), cardCount, threads);
+    if (dup != HashIndex::kNotFound) {
+        throw std::invalid_argument("Duplicate card number " + std::to_string(static_cast<long long>(cardKeys[dup])));
+    }
+
+    owned = std::move(loaded);
+    records = owned.data();
+    count = owned.size();
+    byAccount = std::move(accIndex);
+    byCard = std::move(cardIndex);
+}
+
+Account* AccountStore::findByAccount(int accountNumber) {
+    std::uint32_t row = byAccount.find(accountKey(accountNumber));
+    return row == HashIndex::kNotFound ? nullptr : &records[row];
+}
+
+const Account* AccountStore::findByAccount(int accountNumber) const {
+    return const_cast<AccountStore*>(this)->findByAccount(accountNumber);
+}
+
+Account* AccountStore::findByCard(long long cardNumber) {
+    std::uint32_t row = byCard.find(cardKey(cardNumber));
+    return row == HashIndex::kNotFound ? nullptr : &records[row];
+}
+
+const Account* AccountStore::findByCard(long long cardNumber) const {
+    return const_cast<AccountStore*>(this)->findByCard(cardNumber);
+}
+
+std::vector<CardLink> AccountStore::extraCards() const {
+    std::vector<CardLink> extra;
+    const HashIndex::Slot* slots = byCard.data();
+    for (std::size_t i = 0; i < byCard.capacity(); i++) {
+        const HashIndex::Slot& slot = slots[i];
+        if (slot.value == HashIndex::kNotFound || slot.key == cardKey(records[slot.value].getCardNumber())) continue;
+        extra.push_back(CardLink{static_cast<long long>(slot.key), slot.value});
+    }
+    return extra;
+}
+
+AccountStore::MemoryUsage AccountStore::memoryUsage() const {
+    // A view reports zero: its pages belong to the mapping and are only
+    // resident once touched.
+    MemoryUsage usage;
+    usage.records = owned.capacity() * sizeof(Account);
+    usage.accountIndex = byAccount.memoryBytes();
+    usage.cardIndex = byCard.memoryBytes();
+    return usage;
+}
+
+} // namespace atm
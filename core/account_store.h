@@ -0,0 +1,89 @@
+#ifndef ATM_ACCOUNT_STORE_H
+#define ATM_ACCOUNT_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "account.h"
+#include "hash_index.h"
+
+namespace atm {
+
+// An additional card issued on an account: the card index maps it to the
+// same record as the account's primary card.
+struct CardLink {
+    long long cardNumber;
+    std::uint32_t row;   // the account's position in the store
+};
+
+// Resolves account-number and card-number lookups through hash indexes
+// instead of scanning. Records and indexes are either owned (add(),
+// bulkLoad()) or borrowed from an AccountFile mapping (view()).
+// Pointers returned by the find functions stay valid until the next add()
+// or bulkLoad().
+class AccountStore {
+public:
+    struct MemoryUsage {
+        std::size_t records;
+        std::size_t accountIndex;
+        std::size_t cardIndex;
+
+        std::size_t total() const { return records + accountIndex + cardIndex; }
+    };
+
+    AccountStore() = default;
+    AccountStore(const AccountStore&) = delete;
+    AccountStore& operator=(const AccountStore&) = delete;
+    AccountStore(AccountStore&& other) noexcept;
+    AccountStore& operator=(AccountStore&& other) noexcept;
+
+    // Serves records and indexes that live elsewhere, typically in a mapped
+    // file. Balances are updated in place; add() and bulkLoad() throw.
+    static AccountStore view(Account* records, std::size_t count, HashIndex byAccount, HashIndex byCard);
+
+    void reserve(std::size_t expectedAccounts);
+
+    // Returns false if the account number or card number is already taken.
+    bool add(const Account& account);
+
+    // Replaces the contents and builds both indexes in one pass sized up
+    // front, on threads threads (0: one per core). extraCards adds cards
+    // beyond each account's primary one. Throws std::invalid_argument on a
+    // duplicate account or card.
+    void bulkLoad(std::vector<Account> accounts, const std::vector<CardLink>& extraCards = {}, unsigned threads = 1);
+
+    // Every card in the card index other than its account's primary one,
+    // in no particular order.
+    std::vector<CardLink> extraCards() const;
+
+    Account* findByAccount(int accountNumber);
+    const Account* findByAccount(int accountNumber) const;
+    Account* findByCard(long long cardNumber);
+    const Account* findByCard(long long cardNumber) const;
+
+    Account* begin() { return records; }
+    Account* end() { return records + count; }
+    const Account* begin() const { return records; }
+    const Account* end() const { return records + count; }
+
+    std::size_t size() const { return count; }
+    bool isView() const { return borrowed; }
+    const HashIndex& accountIndex() const { return byAccount; }
+    const HashIndex& cardIndex() const { return byCard; }
+    MemoryUsage memoryUsage() const;
+
+private:
+    std::vector<Account> owned;
+    Account* records = nullptr;
+    std::size_t count = 0;
+    bool borrowed = false;
+    HashIndex byAccount;
+    HashIndex byCard;   // accounts without a card (cardNumber 0) are not indexed
+
+    void requireOwned() const;
+};
+
+} // namespace atm
+
+#endif // ATM_ACCOUNT_STORE_H
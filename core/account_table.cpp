@@ -0,0 +1,213 @@
+#include "account_table.h"
+
+#include "cpu_features.h"
+
+#ifdef ATM_X86
+    #include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace atm {
+
+namespace {
+
+unsigned firstSetBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+std::size_t scanScalar32(const std::int32_t* keys, std::size_t from, std::size_t n, std::int32_t key) {
+    for (std::size_t i = from; i < n; i++) {
+        if (keys[i] == key) return i;
+    }
+    return n;
+}
+
+std::size_t scanScalar64(const std::int64_t* keys, std::size_t from, std::size_t n, std::int64_t key) {
+    for (std::size_t i = from; i < n; i++) {
+        if (keys[i] == key) return i;
+    }
+    return n;
+}
+
+#ifdef ATM_X86
+
+ATM_TARGET("avx2")
+std::size_t scanAvx2_32(const std::int32_t* keys, std::size_t n, std::int32_t key) {
+    const __m256i needle = _mm256_set1_epi32(key);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), needle);
+        __m256i b = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i + 8)), needle);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(a))) |
+                        static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(b))) << 8;
+        if (mask) return i + firstSetBit(mask);
+    }
+    return scanScalar32(keys, i, n, key);
+}
+
+ATM_TARGET("avx2")
+std::size_t scanAvx2_64(const std::int64_t* keys, std::size_t n, std::int64_t key) {
+    const __m256i needle = _mm256_set1_epi64x(key);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), needle);
+        __m256i b = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i + 4)), needle);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(a))) |
+                        static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(b))) << 4;
+        if (mask) return i + firstSetBit(mask);
+    }
+    return scanScalar64(keys, i, n, key);
+}
+
+ATM_TARGET("sse2")
+std::size_t scanSse2_32(const std::int32_t* keys, std::size_t n, std::int32_t key) {
+    const __m128i needle = _mm_set1_epi32(key);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), needle);
+        __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i + 4)), needle);
+        unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(a))) |
+                        static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(b))) << 4;
+        if (mask) return i + firstSetBit(mask);
+    }
+    return scanScalar32(keys, i, n, key);
+}
+
+ATM_TARGET("sse2")
+std::size_t scanSse2_64(const std::int64_t* keys, std::size_t n, std::int64_t key) {
+    // SSE2 has no 64-bit compare: match both 32-bit halves instead.
+    const __m128i needle = _mm_set1_epi64x(key);
+    std::size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), needle);
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(eq)));
+        if (mask) return i + firstSetBit(mask);
+    }
+    return scanScalar64(keys, i, n, key);
+}
+
+#endif
+
+std::size_t scanKeys(const std::int32_t* keys, std::size_t n, std::int32_t key) {
+#ifdef ATM_X86
+    if (cpuHasAvx2()) return scanAvx2_32(keys, n, key);
+    return scanSse2_32(keys, n, key);
+#else
+    return scanScalar32(keys, 0, n, key);
+#endif
+}
+
+std::size_t scanKeys(const std::int64_t* keys, std::size_t n, std::int64_t key) {
+#ifdef ATM_X86
+    if (cpuHasAvx2()) return scanAvx2_64(keys, n, key);
+    return scanSse2_64(keys, n, key);
+#else
+    return scanScalar64(keys, 0, n, key);
+#endif
+}
+
+std::uint64_t accountKey(int accountNumber) {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(accountNumber));
+}
+
+} // namespace
+
+AccountTable AccountTable::fromStore(const AccountStore& store) {
+    AccountTable table;
+    table.reserve(store.size());
+    for (const Account& account : store) table.append(account);
+    return table;
+}
+
+void AccountTable::reserve(std::size_t expectedAccounts) {
+    accountNumbers.reserve(expectedAccounts);
+    cardNumbers.reserve(expectedAccounts);
+    balances.reserve(expectedAccounts);
+    pins.reserve(expectedAccounts);
+    nameRefs.reserve(expectedAccounts);
+    byAccount.reserve(expectedAccounts);
+    byCard.reserve(expectedAccounts);
+}
+
+bool AccountTable::append(const Account& account) {
+    std::uint32_t row = static_cast<std::uint32_t>(size());
+    long long card = account.getCardNumber();
+    if (byAccount.find(accountKey(account.getAccountNumber())) != HashIndex::kNotFound) return false;
+    if (card != 0 && byCard.find(static_cast<std::uint64_t>(card)) != HashIndex::kNotFound) return false;
+
+    byAccount.insert(accountKey(account.getAccountNumber()), row);
+    if (card != 0) byCard.insert(static_cast<std::uint64_t>(card), row);
+
+    nameRefs.push_back(names.intern(account.getName()));
+
+    accountNumbers.push_back(account.getAccountNumber());
+    cardNumbers.push_back(card);
+    balances.push_back(account.getBalance());
+    pins.push_back(account.pin);
+    return true;
+}
+
+std::uint32_t AccountTable::scanAccount(int accountNumber) const {
+    std::size_t row = scanKeys(accountNumbers.data(), size(), accountNumber);
+    return row == size() ? kNotFound : static_cast<std::uint32_t>(row);
+}
+
+std::uint32_t AccountTable::scanCard(long long cardNumber) const {
+    if (cardNumber == 0) return kNotFound;
+    std::size_t row = scanKeys(cardNumbers.data(), size(), cardNumber);
+    return row == size() ? kNotFound : static_cast<std::uint32_t>(row);
+}
+
+std::uint32_t AccountTable::findByAccount(int accountNumber) const {
+    if (size() <= kScanLimit) return scanAccount(accountNumber);
+    return byAccount.find(accountKey(accountNumber));
+}
+
+std::uint32_t AccountTable::findByCard(long long cardNumber) const {
+    if (size() <= kScanLimit) return scanCard(cardNumber);
+    return byCard.find(static_cast<std::uint64_t>(cardNumber));
+}
+
+std::string_view AccountTable::name(std::uint32_t row) const {
+    return names.view(nameRefs[row]);
+}
+
+TxnStatus AccountTable::deposit(std::uint32_t row, Money amount) {
+    if (!isValidCashAmount(amount)) return TxnStatus::InvalidAmount;
+    balances[row] += amount;
+    return TxnStatus::Ok;
+}
+
+TxnStatus AccountTable::tryWithdraw(std::uint32_t row, Money amount) {
+    if (!isValidCashAmount(amount)) return TxnStatus::InvalidAmount;
+    if (amount > balances[row]) return TxnStatus::InsufficientFunds;
+    balances[row] -= amount;
+    return TxnStatus::Ok;
+}
+
+std::size_t AccountTable::applyBatch(const std::uint32_t* rows, const Money* amounts, std::size_t count, TxnStatus* results) {
+    std::size_t applied = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        results[i] = amounts[i] >= 0 ? deposit(rows[i], amounts[i]) : tryWithdraw(rows[i], -amounts[i]);
+        if (results[i] == TxnStatus::Ok) applied++;
+    }
+    return applied;
+}
+
+std::size_t AccountTable::memoryBytes() const {
+    return accountNumbers.capacity() * sizeof(std::int32_t) + cardNumbers.capacity() * sizeof(std::int64_t) +
+           balances.capacity() * sizeof(Money) + pins.capacity() * sizeof(PinCredential) +
+           names.memoryBytes() + nameRefs.capacity() * sizeof(std::uint32_t) +
+           byAccount.memoryBytes() + byCard.memoryBytes();
+}
+
+} // namespace atm
@@ -0,0 +1,80 @@
+#ifndef ATM_ACCOUNT_TABLE_H
+#define ATM_ACCOUNT_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "hash_index.h"
+#include "money.h"
+#include "name_pool.h"
+
+namespace atm {
+
+// Column-oriented (struct-of-arrays) account set. Keys, balances and PINs
+// each sit in their own contiguous array so a lookup or a balance sweep
+// only pulls in the column it needs; holder names, which are only read
+// for display, are interned in a NamePool and referenced by offset.
+//
+// Lookups on tables of up to kScanLimit rows scan the key column with
+// AVX2 or SSE2 compares (picked at runtime); larger tables use a
+// HashIndex. Rows are addressed by number and never move.
+class AccountTable {
+public:
+    static constexpr std::uint32_t kNotFound = HashIndex::kNotFound;
+    // Up to this many rows a vector scan of the key column beats hashing
+    // (see `atm_bench layout`).
+    static constexpr std::size_t kScanLimit = 16;
+
+    AccountTable() = default;
+
+    static AccountTable fromStore(const AccountStore& store);
+
+    void reserve(std::size_t expectedAccounts);
+
+    // Returns false if the account number or card number is already taken.
+    bool append(const Account& account);
+
+    std::uint32_t findByAccount(int accountNumber) const;
+    std::uint32_t findByCard(long long cardNumber) const;
+
+    // Always scan, whatever the table size (used to measure the crossover).
+    std::uint32_t scanAccount(int accountNumber) const;
+    std::uint32_t scanCard(long long cardNumber) const;
+
+    int accountNumber(std::uint32_t row) const { return accountNumbers[row]; }
+    long long cardNumber(std::uint32_t row) const { return cardNumbers[row]; }
+    Money balance(std::uint32_t row) const { return balances[row]; }
+    const PinCredential& pinCredential(std::uint32_t row) const { return pins[row]; }
+    std::string_view name(std::uint32_t row) const;
+
+    // Single-writer updates: unlike Account, the columns are plain words.
+    TxnStatus deposit(std::uint32_t row, Money amount);
+    TxnStatus tryWithdraw(std::uint32_t row, Money amount);
+
+    // Applies deposits (positive amounts) and withdrawals (negative) row by
+    // row; results[i] receives the outcome of entry i. Returns how many
+    // succeeded.
+    std::size_t applyBatch(const std::uint32_t* rows, const Money* amounts, std::size_t count, TxnStatus* results);
+
+    std::size_t size() const { return accountNumbers.size(); }
+    std::size_t memoryBytes() const;
+
+private:
+    std::vector<std::int32_t> accountNumbers;
+    std::vector<std::int64_t> cardNumbers;
+    std::vector<Money> balances;
+    std::vector<PinCredential> pins;
+    std::vector<std::uint32_t> nameRefs;   // offsets into names
+    NamePool names;
+    HashIndex byAccount;
+    HashIndex byCard;
+};
+
+} // namespace atm
+
+#endif // ATM_ACCOUNT_TABLE_H
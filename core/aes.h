@@ -0,0 +1,42 @@
+#ifndef ATM_AES_H
+#define ATM_AES_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace atm {
+
+// AES-128 block cipher (FIPS 197), ECB over whole blocks only: callers
+// build their own modes from it. The batch calls are the fast path: with
+// AES-NI (picked at runtime) eight independent blocks are kept in flight
+// at once to hide the instruction latency; elsewhere a portable
+// byte-oriented implementation is used.
+class Aes128 {
+public:
+    static constexpr std::size_t kBlockSize = 16;
+    static constexpr std::size_t kKeySize = 16;
+
+    // allowHardware = false pins the portable code (for comparisons).
+    explicit Aes128(const std::uint8_t key[kKeySize], bool allowHardware = true);
+    // A fresh random key, e.g. a session key for a demo terminal.
+    static Aes128 generate();
+
+    // in and out may be the same buffer.
+    void encrypt(const std::uint8_t* in, std::uint8_t* out, std::size_t blocks) const;
+    void decrypt(const std::uint8_t* in, std::uint8_t* out, std::size_t blocks) const;
+
+    // Whether this key runs on AES-NI.
+    bool hardwareAccelerated() const { return useAesNi; }
+
+private:
+    static constexpr int kRounds = 10;
+    alignas(16) std::uint8_t encryptKeys[kRounds + 1][kBlockSize];
+    // Round keys for the equivalent inverse cipher (InvMixColumns applied
+    // to rounds 1..9), in decryption order, as AESDEC expects.
+    alignas(16) std::uint8_t decryptKeys[kRounds + 1][kBlockSize];
+    bool useAesNi;
+};
+
+} // namespace atm
+
+#endif // ATM_AES_H
@@ -0,0 +1,160 @@
+#include "append_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <cstring>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace atm {
+
+namespace {
+
+[[noreturn]] void fail(const std::string& what, const std::string& path) {
+#ifdef _WIN32
+    throw std::runtime_error(what + " " + path + " (error " + std::to_string(GetLastError()) + ")");
+#else
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+#endif
+}
+
+} // namespace
+
+AppendFile::~AppendFile() {
+    close();
+}
+
+AppendFile::AppendFile(AppendFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+AppendFile& AppendFile::operator=(AppendFile&& other) noexcept {
+    if (this != &other) {
+        close();
+#ifdef _WIN32
+        handle = other.handle;
+        other.handle = nullptr;
+#else
+        fd = other.fd;
+        other.fd = -1;
+#endif
+        filePath = std::move(other.filePath);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+AppendFile AppendFile::open(const std::string& path) {
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) fail("Cannot open", path);
+    LARGE_INTEGER zero = {};
+    SetFilePointerEx(h, zero, nullptr, FILE_END);
+    AppendFile file;
+    file.handle = h;
+    file.filePath = path;
+    return file;
+}
+
+void AppendFile::write(const void* data, std::size_t length) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        DWORD chunk = length > 0x40000000 ? 0x40000000 : static_cast<DWORD>(length);
+        DWORD written = 0;
+        if (!WriteFile(static_cast<HANDLE>(handle), p, chunk, &written, nullptr)) fail("Cannot write", filePath);
+        p += written;
+        length -= written;
+    }
+}
+
+void AppendFile::datasync() {
+    if (!FlushFileBuffers(static_cast<HANDLE>(handle))) fail("Cannot sync", filePath);
+}
+
+void AppendFile::truncate(std::uint64_t length) {
+    LARGE_INTEGER pos;
+    pos.QuadPart = static_cast<LONGLONG>(length);
+    if (!SetFilePointerEx(static_cast<HANDLE>(handle), pos, nullptr, FILE_BEGIN) ||
+        !SetEndOfFile(static_cast<HANDLE>(handle))) {
+        fail("Cannot truncate", filePath);
+    }
+}
+
+std::uint64_t AppendFile::size() const {
+    LARGE_INTEGER s;
+    if (!GetFileSizeEx(static_cast<HANDLE>(handle), &s)) fail("Cannot stat", filePath);
+    return static_cast<std::uint64_t>(s.QuadPart);
+}
+
+bool AppendFile::isOpen() const {
+    return handle != nullptr;
+}
+
+void AppendFile::close() {
+    if (handle) CloseHandle(static_cast<HANDLE>(handle));
+    handle = nullptr;
+}
+
+#else
+
+AppendFile AppendFile::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) fail("Cannot open", path);
+    AppendFile file;
+    file.fd = fd;
+    file.filePath = path;
+    return file;
+}
+
+void AppendFile::write(const void* data, std::size_t length) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t n = ::write(fd, p, length);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fail("Cannot write", filePath);
+        }
+        p += n;
+        length -= static_cast<std::size_t>(n);
+    }
+}
+
+void AppendFile::datasync() {
+#ifdef __APPLE__
+    // macOS has no fdatasync; F_FULLFSYNC also flushes the drive cache.
+    if (fcntl(fd, F_FULLFSYNC) != 0 && fsync(fd) != 0) fail("Cannot sync", filePath);
+#else
+    if (fdatasync(fd) != 0) fail("Cannot sync", filePath);
+#endif
+}
+
+void AppendFile::truncate(std::uint64_t length) {
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0) fail("Cannot truncate", filePath);
+}
+
+std::uint64_t AppendFile::size() const {
+    struct stat st;
+    if (fstat(fd, &st) != 0) fail("Cannot stat", filePath);
+    return static_cast<std::uint64_t>(st.st_size);
+}
+
+bool AppendFile::isOpen() const {
+    return fd >= 0;
+}
+
+void AppendFile::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+#endif
+
+} // namespace atm
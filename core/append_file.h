@@ -0,0 +1,45 @@
+#ifndef ATM_APPEND_FILE_H
+#define ATM_APPEND_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace atm {
+
+// Append-only file handle with an explicit data sync (fdatasync on POSIX,
+// FlushFileBuffers on Windows). Failures throw std::runtime_error.
+class AppendFile {
+public:
+    AppendFile() = default;
+    ~AppendFile();
+    AppendFile(const AppendFile&) = delete;
+    AppendFile& operator=(const AppendFile&) = delete;
+    AppendFile(AppendFile&& other) noexcept;
+    AppendFile& operator=(AppendFile&& other) noexcept;
+
+    // Opens (creating if needed) path and positions at its end.
+    static AppendFile open(const std::string& path);
+
+    void write(const void* data, std::size_t length);
+    void datasync();
+    // Cuts the file back to length bytes (used to drop a torn tail).
+    void truncate(std::uint64_t length);
+    std::uint64_t size() const;
+    bool isOpen() const;
+    void close();
+
+    const std::string& path() const { return filePath; }
+
+private:
+#ifdef _WIN32
+    void* handle = nullptr;
+#else
+    int fd = -1;
+#endif
+    std::string filePath;
+};
+
+} // namespace atm
+
+#endif // ATM_APPEND_FILE_H
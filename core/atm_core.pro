@@ -0,0 +1,87 @@
+# UI-free core shared by the terminal and Qt frontends.
+CONFIG -= qt
+CONFIG += c++17 staticlib ltcg
+
+TARGET = atm_core
+TEMPLATE = lib
+
+DESTDIR = ./lib
+
+SOURCES += \
+    account.cpp \
+    account_file.cpp \
+    account_import.cpp \
+    account_store.cpp \
+    account_table.cpp \
+    aes.cpp \
+    append_file.cpp \
+    bin_table.cpp \
+    card_number.cpp \
+    checksum.cpp \
+    cpu_features.cpp \
+    cuckoo_filter.cpp \
+    end_of_day.cpp \
+    epoch.cpp \
+    hash_index.cpp \
+    hot_card_list.cpp \
+    journal.cpp \
+    journal_columns.cpp \
+    journal_index.cpp \
+    journal_segments.cpp \
+    journal_sort.cpp \
+    lz_block.cpp \
+    mapped_file.cpp \
+    money.cpp \
+    name_index.cpp \
+    name_pool.cpp \
+    nfc_request.cpp \
+    pin_block.cpp \
+    pin_hash.cpp \
+    pin_verifier.cpp \
+    qrcodegen.cpp \
+    reconcile.cpp \
+    session_arena.cpp \
+    sha256.cpp \
+    sharded_account_store.cpp \
+    snapshot.cpp \
+    transaction_history.cpp
+
+HEADERS += \
+    account.h \
+    account_file.h \
+    account_import.h \
+    account_store.h \
+    account_table.h \
+    aes.h \
+    append_file.h \
+    bin_table.h \
+    card_number.h \
+    checksum.h \
+    cpu_features.h \
+    cuckoo_filter.h \
+    end_of_day.h \
+    epoch.h \
+    hash_index.h \
+    hot_card_list.h \
+    journal.h \
+    journal_columns.h \
+    journal_index.h \
+    journal_segments.h \
+    journal_sort.h \
+    lz_block.h \
+    mapped_file.h \
+    money.h \
+    name_index.h \
+    name_pool.h \
+    nfc_request.h \
+    parallel.h \
+    pin_block.h \
+    pin_hash.h \
+    pin_verifier.h \
+    qrcodegen.hpp \
+    reconcile.h \
+    session_arena.h \
+    sha256.h \
+    sharded_account_store.h \
+    snapshot.h \
+    transaction_history.h
@@ -0,0 +1,248 @@
+#include "bin_table.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace atm {
+
+namespace {
+
+constexpr std::uint64_t kPow10[] = {1ull,
+                                    10ull,
+                                    100ull,
+                                    1000ull,
+                                    10000ull,
+                                    100000ull,
+                                    1000000ull,
+                                    10000000ull,
+                                    100000000ull,
+                                    1000000000ull,
+                                    10000000000ull,
+                                    100000000000ull};
+
+constexpr std::uint64_t kKeyEnd = kPow10[BinTable::kMaxPrefixDigits];
+const std::string kUnroutedName = "unrouted";
+
+// Searches run this many at a time in route(pans, ...).
+constexpr std::size_t kLanes = 8;
+
+// The guide splits the key space by its first four digits, which leaves
+// a handful of ranges to search per slice even with 100k prefixes.
+constexpr std::uint64_t kGuideBuckets = 10000;
+constexpr std::uint64_t kBucketWidth = kKeyEnd / kGuideBuckets;
+
+struct Range {
+    std::uint64_t begin;
+    std::uint64_t end;
+    BinTable::RouteId route;
+    std::size_t entry;
+};
+
+} // namespace
+
+// --- BinTable ---
+
+BinTable::BinTable() : starts{0}, routes{kOnUs}, names{"onus"} {
+    buildGuide();
+}
+
+BinTable::BinTable(const std::vector<Entry>& entries) : names{"onus"} {
+    std::unordered_map<std::string, RouteId> ids{{"onus", kOnUs}};
+    std::vector<Range> ranges;
+    ranges.reserve(entries.size());
+    for (const Entry& e : entries) {
+        std::size_t digits = e.prefix.size();
+        if (digits == 0 || digits > static_cast<std::size_t>(kMaxPrefixDigits) ||
+            e.prefix.find_first_not_of("0123456789") != std::string::npos) {
+            throw std::invalid_argument("Bad BIN prefix '" + e.prefix + "'");
+        }
+        if (e.route.empty()) throw std::invalid_argument("BIN prefix " + e.prefix + " has no route");
+        auto id = ids.find(e.route);
+        if (id == ids.end()) {
+            if (names.size() >= kUnrouted) throw std::invalid_argument("Too many BIN routes");
+            id = ids.emplace(e.route, static_cast<RouteId>(names.size())).first;
+            names.push_back(e.route);
+        }
+        std::uint64_t span = kPow10[kMaxPrefixDigits - digits];
+        std::uint64_t begin = std::stoull(e.prefix) * span;
+        ranges.push_back(Range{begin, begin + span, id->second, ranges.size()});
+    }
+
+    // Prefix ranges never partly overlap: two are either disjoint or one
+    // holds the other. Sorted outer-first, a stack of open ranges gives
+    // the innermost (longest) prefix at every point.
+    std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) {
+        return a.begin != b.begin ? a.begin < b.begin : a.end > b.end;
+    });
+    for (std::size_t i = 1; i < ranges.size(); i++) {
+        if (ranges[i].begin == ranges[i - 1].begin && ranges[i].end == ranges[i - 1].end) {
+            throw std::invalid_argument("BIN prefix " + entries[ranges[i].entry].prefix + " listed twice");
+        }
+    }
+
+    auto emit = [this](std::uint64_t at, RouteId route) {
+        if (!starts.empty() && starts.back() == at) {
+            routes.back() = route;
+            if (routes.size() > 1 && routes[routes.size() - 2] == route) {
+                starts.pop_back();
+                routes.pop_back();
+            }
+        } else if (routes.empty() || routes.back() != route) {
+            starts.push_back(at);
+            routes.push_back(route);
+        }
+    };
+    std::vector<Range> open{Range{0, kKeyEnd, kUnrouted, 0}};
+    emit(0, kUnrouted);
+    for (const Range& r : ranges) {
+        while (open.back().end <= r.begin) {
+            std::uint64_t closed = open.back().end;
+            open.pop_back();
+            emit(closed, open.back().route);
+        }
+        emit(r.begin, r.route);
+        open.push_back(r);
+    }
+    while (open.size() > 1) {
+        std::uint64_t closed = open.back().end;
+        open.pop_back();
+        if (closed < kKeyEnd) emit(closed, open.back().route);
+    }
+    prefixes = entries.size();
+    buildGuide();
+}
+
+void BinTable::buildGuide() {
+    guide.resize(kGuideBuckets + 1);
+    std::size_t range = 0;
+    for (std::uint64_t b = 0; b < kGuideBuckets; b++) {
+        std::uint64_t first = b * kBucketWidth;
+        while (range + 1 < starts.size() && starts[range + 1] <= first) range++;
+        guide[b] = static_cast<std::uint32_t>(range);
+    }
+    guide[kGuideBuckets] = static_cast<std::uint32_t>(starts.size() - 1);
+}
+
+BinTable BinTable::readFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot read BIN table " + path);
+
+    std::vector<Entry> entries;
+    std::string line;
+    for (std::size_t lineNumber = 1; std::getline(in, line); lineNumber++) {
+        std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+        std::size_t prefixEnd = line.find_first_of(" \t", start);
+        std::size_t routeStart = prefixEnd == std::string::npos ? prefixEnd : line.find_first_not_of(" \t", prefixEnd);
+        if (routeStart == std::string::npos || line[routeStart] == '\r') {
+            throw std::invalid_argument(path + ":" + std::to_string(lineNumber) + ": expected <prefix> <route>");
+        }
+        std::size_t routeEnd = line.find_last_not_of(" \t\r") + 1;
+        entries.push_back(Entry{line.substr(start, prefixEnd - start), line.substr(routeStart, routeEnd - routeStart)});
+    }
+    try {
+        return BinTable(entries);
+    } catch (const std::invalid_argument& e) {
+        throw std::invalid_argument(path + ": " + e.what());
+    }
+}
+
+std::uint64_t BinTable::keyOf(long long pan) {
+    if (pan <= 0) return 0;
+    auto value = static_cast<std::uint64_t>(pan);
+    // Constant divisors, so each case is a multiply and a shift; PANs of
+    // one length dominate, so the switch predicts well.
+    switch (value >= 100000000000ull ? 12 + (value >= 1000000000000ull) + (value >= 10000000000000ull) +
+                                            (value >= 100000000000000ull) + (value >= 1000000000000000ull) +
+                                            (value >= 10000000000000000ull) + (value >= 100000000000000000ull) +
+                                            (value >= 1000000000000000000ull)
+                                      : 0) {
+        case 12: return value / 10ull;
+        case 13: return value / 100ull;
+        case 14: return value / 1000ull;
+        case 15: return value / 10000ull;
+        case 16: return value / 100000ull;
+        case 17: return value / 1000000ull;
+        case 18: return value / 10000000ull;
+        case 19: return value / 100000000ull;
+        default: break;
+    }
+    std::uint64_t padded = value;
+    while (padded < kKeyEnd / 10) padded *= 10;
+    return padded;
+}
+
+std::size_t BinTable::rangeOf(std::uint64_t key) const {
+    // Last start <= key, between the guide entries around key's slice.
+    std::size_t bucket = static_cast<std::size_t>(key / kBucketWidth);
+    const std::uint64_t* base = starts.data() + guide[bucket];
+    std::size_t length = guide[bucket + 1] - guide[bucket] + 1;
+    while (length > 1) {
+        std::size_t half = length / 2;
+        base = base[half] <= key ? base + half : base;
+        length -= half;
+    }
+    return static_cast<std::size_t>(base - starts.data());
+}
+
+void BinTable::route(const long long* pans, std::size_t count, RouteId* out) const {
+    const std::uint64_t* first = starts.data();
+    std::size_t i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        // The lanes step together until the longest search is done; a lane
+        // that has finished keeps halving a length of 1, which is a no-op.
+        // Their loads are independent, so the misses overlap.
+        std::uint64_t keys[kLanes];
+        const std::uint64_t* base[kLanes];
+        std::size_t length[kLanes];
+        std::size_t longest = 0;
+        for (std::size_t k = 0; k < kLanes; k++) {
+            keys[k] = keyOf(pans[i + k]);
+            std::size_t bucket = static_cast<std::size_t>(keys[k] / kBucketWidth);
+            base[k] = first + guide[bucket];
+            length[k] = guide[bucket + 1] - guide[bucket] + 1;
+            longest = std::max(longest, length[k]);
+        }
+        for (; longest > 1; longest -= longest / 2) {
+            for (std::size_t k = 0; k < kLanes; k++) {
+                std::size_t half = length[k] / 2;
+                base[k] = base[k][half] <= keys[k] ? base[k] + half : base[k];
+                length[k] -= half;
+            }
+        }
+        for (std::size_t k = 0; k < kLanes; k++) out[i + k] = routes[static_cast<std::size_t>(base[k] - first)];
+    }
+    for (; i < count; i++) out[i] = route(pans[i]);
+}
+
+const std::string& BinTable::routeName(RouteId id) const {
+    return id < names.size() ? names[id] : kUnroutedName;
+}
+
+// --- BinRouter ---
+
+BinRouter::BinRouter() : currentOwner(std::make_shared<const BinTable>()) {
+    current.store(currentOwner.get(), std::memory_order_release);
+}
+
+void BinRouter::replace(BinTable table) {
+    std::shared_ptr<const BinTable> next = std::make_shared<const BinTable>(std::move(table));
+    std::lock_guard<std::mutex> guard(writeLock);
+    current.store(next.get(), std::memory_order_seq_cst);
+    epochs.retire(std::move(currentOwner));
+    currentOwner = std::move(next);
+    epochs.reclaim();
+}
+
+BinRouter::Pinned BinRouter::table() const {
+    Pinned pinned;
+    // Pinned before the load, so the table cannot be freed under the reader.
+    pinned.pin = epochs.pin();
+    pinned.loaded = current.load(std::memory_order_acquire);
+    return pinned;
+}
+
+} // namespace atm
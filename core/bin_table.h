@@ -0,0 +1,112 @@
+#ifndef ATM_BIN_TABLE_H
+#define ATM_BIN_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "epoch.h"
+
+namespace atm {
+
+// Routes cards by issuer prefix (BIN/IIN): the card's leading digits decide
+// whether it is served here (on-us) or sent to a card network, with the
+// longest matching prefix winning ("4" VISA, "400000" onus).
+//
+// Every prefix covers a range of 11-digit keys (a card's first eleven
+// digits). The ranges are flattened once, at build time, into one sorted
+// array of disjoint ranges, and a guide indexed by a key's first four
+// digits narrows each search to the few ranges of its slice. A lookup is
+// a digit count, a division by a constant and a short branchless binary
+// search; route() over an array runs several searches in lockstep to
+// overlap their cache misses.
+class BinTable {
+public:
+    using RouteId = std::uint16_t;
+    static constexpr RouteId kOnUs = 0;            // route name "onus"
+    static constexpr RouteId kUnrouted = 0xFFFF;   // no prefix matched
+    static constexpr int kMaxPrefixDigits = 11;
+
+    struct Entry {
+        std::string prefix;   // 1 to kMaxPrefixDigits digits
+        std::string route;
+    };
+
+    // Every card on-us: the behaviour before any table is loaded.
+    BinTable();
+    // Throws std::invalid_argument on a malformed or repeated prefix, or
+    // more than 65534 route names.
+    explicit BinTable(const std::vector<Entry>& entries);
+
+    // One "<prefix> <route>" pair per line; blank lines and lines starting
+    // with '#' are skipped. Throws std::runtime_error if the file cannot be
+    // read and std::invalid_argument, naming the line, on malformed input.
+    static BinTable readFile(const std::string& path);
+
+    RouteId route(long long pan) const { return routes[rangeOf(keyOf(pan))]; }
+    void route(const long long* pans, std::size_t count, RouteId* out) const;
+
+    // "onus", "VISA", ...; "unrouted" for kUnrouted.
+    const std::string& routeName(RouteId id) const;
+    std::size_t prefixCount() const { return prefixes; }
+    std::size_t rangeCount() const { return starts.size(); }
+
+    // A card's first kMaxPrefixDigits digits (shorter numbers are padded
+    // with zeros on the right).
+    static std::uint64_t keyOf(long long pan);
+
+private:
+    std::vector<std::uint64_t> starts;   // sorted; starts[0] == 0
+    std::vector<RouteId> routes;         // range i is [starts[i], starts[i + 1])
+    std::vector<std::uint32_t> guide;    // first range of each kGuideBuckets slice of the key space
+    std::vector<std::string> names;
+    std::size_t prefixes = 0;
+
+    void buildGuide();
+
+    std::size_t rangeOf(std::uint64_t key) const;
+};
+
+// The BIN table in use. reload()/replace() build the next table off to the
+// side and publish it with one atomic pointer store. Readers pin an epoch
+// and read the raw pointer, so routing takes no lock and no shared
+// reference count and never waits for a reload; a reader keeps the table
+// it loaded until it lets go of it, and replaced tables are freed by
+// epoch-based reclamation after that.
+class BinRouter {
+public:
+    // A table as loaded by table(), kept alive for as long as this is held.
+    class Pinned {
+    public:
+        const BinTable* operator->() const { return loaded; }
+        const BinTable& operator*() const { return *loaded; }
+
+    private:
+        friend class BinRouter;
+        EpochDomain::Guard pin;
+        const BinTable* loaded = nullptr;
+    };
+
+    BinRouter();
+
+    void replace(BinTable table);
+    // Reads path with BinTable::readFile(); on error the current table stays.
+    void reload(const std::string& path) { replace(BinTable::readFile(path)); }
+
+    Pinned table() const;
+    BinTable::RouteId route(long long pan) const { return table()->route(pan); }
+
+private:
+    std::atomic<const BinTable*> current{nullptr};
+    std::shared_ptr<const BinTable> currentOwner;   // keeps current alive; under writeLock
+    mutable EpochDomain epochs;
+    std::mutex writeLock;
+};
+
+} // namespace atm
+
+#endif // ATM_BIN_TABLE_H
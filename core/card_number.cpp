@@ -0,0 +1,183 @@
+#include "card_number.h"
+
+#include <climits>
+
+#include "cpu_features.h"
+
+#ifdef ATM_X86
+    #include <immintrin.h>
+#endif
+
+namespace atm {
+
+namespace {
+
+constexpr long long kMinPan = 100000000000LL;   // 10^11: the smallest 12-digit number
+constexpr long long kChunk = 100000000LL;       // PANs are checked as 8-digit chunks
+
+bool hasPanLength(long long pan) {
+    return pan >= kMinPan;   // any positive long long has at most 19 digits
+}
+
+// Luhn contribution of every two-digit pair "ab" whose b sits at an even
+// distance from the check digit: b + the digit sum of 2a.
+struct PairTable {
+    std::uint8_t sum[100];
+
+    constexpr PairTable() : sum() {
+        for (int a = 0; a < 10; a++) {
+            for (int b = 0; b < 10; b++) sum[a * 10 + b] = static_cast<std::uint8_t>(b + (a * 2 > 9 ? a * 2 - 9 : a * 2));
+        }
+    }
+};
+
+constexpr PairTable kPairs;
+
+// Luhn sum of one chunk whose lowest digit sits at an even distance from
+// the check digit. Every chunk is eight digits, so the pattern repeats.
+unsigned luhnChunk(std::uint32_t chunk) {
+    return kPairs.sum[chunk % 100] + kPairs.sum[chunk / 100 % 100] + kPairs.sum[chunk / 10000 % 100] +
+           kPairs.sum[chunk / 1000000];
+}
+
+unsigned luhnSum(long long pan) {
+    auto value = static_cast<std::uint64_t>(pan);
+    return luhnChunk(static_cast<std::uint32_t>(value % kChunk)) +
+           luhnChunk(static_cast<std::uint32_t>(value / kChunk % kChunk)) +
+           luhnChunk(static_cast<std::uint32_t>(value / kChunk / kChunk));
+}
+
+std::size_t validateScalar(const long long* pans, std::size_t from, std::size_t count, bool* valid) {
+    std::size_t ok = 0;
+    for (std::size_t i = from; i < count; i++) {
+        valid[i] = isValidCardNumber(pans[i]);
+        ok += valid[i];
+    }
+    return ok;
+}
+
+#ifdef ATM_X86
+
+// Unsigned x / 10 in each 32-bit lane: multiply by
+// ceil(2^35 / 10) and keep bits 35 and up, on even and odd lanes apart.
+ATM_TARGET("avx2")
+__m256i div10(__m256i x) {
+    const __m256i magic = _mm256_set1_epi32(static_cast<int>(0xCCCCCCCDu));
+    __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(x, magic), 35);
+    __m256i odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), magic), 35);
+    return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+// The kPairs entry for each 16-bit lane p = "ab" (0..99): with a = p / 10,
+// b + digitsum(2a) = p - 8a - (a > 4 ? 9 : 0).
+ATM_TARGET("avx2")
+__m256i pairSums(__m256i pairs) {
+    __m256i tens = _mm256_mulhi_epu16(pairs, _mm256_set1_epi16(6554));   // p / 10 for p < 100
+    __m256i sum = _mm256_sub_epi16(pairs, _mm256_slli_epi16(tens, 3));
+    __m256i carry = _mm256_and_si256(_mm256_cmpgt_epi16(tens, _mm256_set1_epi16(4)), _mm256_set1_epi16(9));
+    return _mm256_sub_epi16(sum, carry);
+}
+
+// luhnChunk() for eight 8-digit chunks, left as two 16-bit partial sums
+// per 32-bit lane. Each chunk is cut into 4-digit halves (one per 16-bit
+// lane) and those into digit pairs, so the digits are never taken apart
+// one by one.
+ATM_TARGET("avx2")
+__m256i luhnChunks(__m256i chunk) {
+    const __m256i magic = _mm256_set1_epi32(static_cast<int>(0xD1B71759u));   // ceil(2^45 / 10000)
+    __m256i evenHigh = _mm256_srli_epi64(_mm256_mul_epu32(chunk, magic), 45);
+    __m256i oddHigh = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(chunk, 32), magic), 45);
+    __m256i high = _mm256_blend_epi32(evenHigh, _mm256_slli_epi64(oddHigh, 32), 0xAA);
+    __m256i low = _mm256_sub_epi32(chunk, _mm256_mullo_epi32(high, _mm256_set1_epi32(10000)));
+    __m256i quads = _mm256_or_si256(low, _mm256_slli_epi32(high, 16));
+
+    // x / 100 = (x * 5243) >> 19 for x < 43699.
+    __m256i upperPairs = _mm256_srli_epi16(_mm256_mulhi_epu16(quads, _mm256_set1_epi16(5243)), 3);
+    __m256i lowerPairs = _mm256_sub_epi16(quads, _mm256_mullo_epi16(upperPairs, _mm256_set1_epi16(100)));
+    return _mm256_add_epi16(pairSums(lowerPairs), pairSums(upperPairs));
+}
+
+ATM_TARGET("avx2")
+std::size_t validateAvx2(const long long* pans, std::size_t count, bool* valid) {
+    const __m256i ten = _mm256_set1_epi32(10);
+    std::size_t ok = 0;
+    std::size_t i = 0;
+    alignas(32) std::uint32_t sums[8];
+    for (; i + 8 <= count; i += 8) {
+        // Splitting into 8-digit chunks is two constant divisions per
+        // number; the digit work then runs eight numbers wide.
+        std::uint32_t lo[8], mid[8], hi[8];
+        for (int k = 0; k < 8; k++) {
+            auto value = static_cast<std::uint64_t>(pans[i + k]);
+            std::uint64_t upper = value / kChunk;
+            lo[k] = static_cast<std::uint32_t>(value - upper * kChunk);
+            mid[k] = static_cast<std::uint32_t>(upper % kChunk);
+            hi[k] = static_cast<std::uint32_t>(upper / kChunk);
+        }
+        // Built from registers rather than reloaded from memory, which
+        // would stall on store forwarding.
+        __m256i partial = _mm256_add_epi16(
+            luhnChunks(_mm256_setr_epi32(lo[0], lo[1], lo[2], lo[3], lo[4], lo[5], lo[6], lo[7])),
+            _mm256_add_epi16(luhnChunks(_mm256_setr_epi32(mid[0], mid[1], mid[2], mid[3], mid[4], mid[5], mid[6], mid[7])),
+                             luhnChunks(_mm256_setr_epi32(hi[0], hi[1], hi[2], hi[3], hi[4], hi[5], hi[6], hi[7]))));
+        __m256i sum = _mm256_madd_epi16(partial, _mm256_set1_epi16(1));
+        __m256i rest = _mm256_sub_epi32(sum, _mm256_mullo_epi32(div10(sum), ten));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(sums), rest);
+        for (int k = 0; k < 8; k++) {
+            valid[i + k] = sums[k] == 0 && hasPanLength(pans[i + k]);
+            ok += valid[i + k];
+        }
+    }
+    return ok + validateScalar(pans, i, count, valid);
+}
+
+#endif
+
+} // namespace
+
+const char* cardCheckName(CardCheck check) {
+    switch (check) {
+        case CardCheck::Ok: return "Ok";
+        case CardCheck::BadLength: return "bad length";
+        case CardCheck::BadDigit: return "bad digit";
+        case CardCheck::BadChecksum: return "bad checksum";
+    }
+    return "unknown";
+}
+
+bool isValidCardNumber(long long pan) {
+    return hasPanLength(pan) && luhnSum(pan) % 10 == 0;
+}
+
+CardCheck checkCardNumber(std::string_view digits, long long* pan) {
+    if (digits.size() < static_cast<std::size_t>(kMinPanDigits) || digits.size() > static_cast<std::size_t>(kMaxPanDigits)) {
+        return CardCheck::BadLength;
+    }
+    std::uint64_t value = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9') return CardCheck::BadDigit;
+        value = value * 10 + static_cast<std::uint64_t>(c - '0');   // 19 digits cannot wrap 64 bits
+    }
+    // Leading zeros do not count: "000000000000" is not a 12-digit number.
+    if (value > static_cast<std::uint64_t>(LLONG_MAX) || !hasPanLength(static_cast<long long>(value))) {
+        return CardCheck::BadLength;
+    }
+    if (luhnSum(static_cast<long long>(value)) % 10 != 0) return CardCheck::BadChecksum;
+    if (pan) *pan = static_cast<long long>(value);
+    return CardCheck::Ok;
+}
+
+std::size_t validateCardNumbers(const long long* pans, std::size_t count, bool* valid) {
+#ifdef ATM_X86
+    if (cpuHasAvx2()) return validateAvx2(pans, count, valid);
+#endif
+    return validateScalar(pans, 0, count, valid);
+}
+
+long long appendLuhnDigit(long long body) {
+    // With a 0 appended, the digits body will carry are already in place.
+    unsigned sum = luhnSum(body * 10);
+    return body * 10 + static_cast<long long>((10 - sum % 10) % 10);
+}
+
+} // namespace atm
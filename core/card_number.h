@@ -0,0 +1,46 @@
+#ifndef ATM_CARD_NUMBER_H
+#define ATM_CARD_NUMBER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace atm {
+
+// Primary account numbers (ISO/IEC 7812) are 12 to 19 digits, the last of
+// which is a Luhn check digit. Checking both before a lookup turns away a
+// mistyped, truncated or garbled tap without touching the account store.
+//
+// 19-digit numbers above LLONG_MAX do not fit the long long card numbers
+// used everywhere else and are rejected as BadLength, as are numbers whose
+// leading zeros pad them to 12 digits.
+constexpr int kMinPanDigits = 12;
+constexpr int kMaxPanDigits = 19;
+
+enum class CardCheck : std::uint8_t {
+    Ok,
+    BadLength,
+    BadDigit,
+    BadChecksum
+};
+
+// "Ok", "bad length", ... for messages.
+const char* cardCheckName(CardCheck check);
+
+bool isValidCardNumber(long long pan);
+
+// digits must be the bare number: no spaces, sign or separators. On Ok,
+// pan (when given) receives its value.
+CardCheck checkCardNumber(std::string_view digits, long long* pan = nullptr);
+
+// Batch form for imports and replayed tap streams: valid[i] tells whether
+// pans[i] passes. Eight numbers at a time with AVX2 when the CPU has it.
+// Returns how many are valid.
+std::size_t validateCardNumbers(const long long* pans, std::size_t count, bool* valid);
+
+// body followed by its Luhn check digit (for issuing test cards).
+long long appendLuhnDigit(long long body);
+
+} // namespace atm
+
+#endif // ATM_CARD_NUMBER_H
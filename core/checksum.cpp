@@ -0,0 +1,30 @@
+#include "checksum.h"
+
+#include <array>
+
+namespace atm {
+
+namespace {
+
+std::array<std::uint32_t, 256> makeTable() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; i++) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}
+
+const std::array<std::uint32_t, 256> kTable = makeTable();
+
+} // namespace
+
+std::uint32_t crc32(const void* data, std::size_t length, std::uint32_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    std::uint32_t c = ~seed;
+    for (std::size_t i = 0; i < length; i++) c = kTable[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return ~c;
+}
+
+} // namespace atm
@@ -0,0 +1,15 @@
+#ifndef ATM_CHECKSUM_H
+#define ATM_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace atm {
+
+// CRC-32 (IEEE 802.3 polynomial). Pass the previous result as seed to
+// checksum a value split across several buffers.
+std::uint32_t crc32(const void* data, std::size_t length, std::uint32_t seed = 0);
+
+} // namespace atm
+
+#endif // ATM_CHECKSUM_H
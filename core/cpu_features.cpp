@@ -0,0 +1,60 @@
+#include "cpu_features.h"
+
+#if defined(ATM_X86) && defined(_MSC_VER)
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+namespace atm {
+
+#if defined(ATM_X86) && (defined(__GNUC__) || defined(__clang__))
+
+bool cpuHasAvx2() {
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+bool cpuHasAesNi() {
+    static const bool has = __builtin_cpu_supports("aes");
+    return has;
+}
+
+#elif defined(ATM_X86) && defined(_MSC_VER)
+
+namespace {
+
+bool osSavesYmm() {
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    return osxsave && (_xgetbv(0) & 0x6) == 0x6;
+}
+
+} // namespace
+
+bool cpuHasAvx2() {
+    static const bool has = [] {
+        int info[4];
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0 && osSavesYmm();
+    }();
+    return has;
+}
+
+bool cpuHasAesNi() {
+    static const bool has = [] {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 25)) != 0;
+    }();
+    return has;
+}
+
+#else
+
+bool cpuHasAvx2() { return false; }
+bool cpuHasAesNi() { return false; }
+
+#endif
+
+} // namespace atm
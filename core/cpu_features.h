@@ -0,0 +1,25 @@
+#ifndef ATM_CPU_FEATURES_H
+#define ATM_CPU_FEATURES_H
+
+// --- SIMD DISPATCH ---
+// Vector paths are compiled for their instruction set with a function
+// attribute and picked at runtime, so the default build still runs on any
+// x86-64 (SSE2 baseline) and on non-x86 targets (scalar fallback).
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define ATM_X86 1
+#endif
+
+#if defined(ATM_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define ATM_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define ATM_TARGET(isa)
+#endif
+
+namespace atm {
+
+bool cpuHasAvx2();
+bool cpuHasAesNi();
+
+} // namespace atm
+
+#endif // ATM_CPU_FEATURES_H
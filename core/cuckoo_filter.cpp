@@ -0,0 +1,110 @@
+#include "cuckoo_filter.h"
+
+#include "hash_index.h"
+
+namespace atm {
+
+namespace {
+
+constexpr std::uint64_t kLaneOnes = 0x0001000100010001ULL;
+constexpr std::uint64_t kLaneHighs = 0x8000800080008000ULL;
+
+// True if any 16-bit lane of word equals fingerprint (SWAR zero-lane test).
+bool bucketHas(std::uint64_t word, std::uint16_t fingerprint) {
+    std::uint64_t x = word ^ (fingerprint * kLaneOnes);
+    return ((x - kLaneOnes) & ~x & kLaneHighs) != 0;
+}
+
+std::uint16_t lane(std::uint64_t word, int slot) {
+    return static_cast<std::uint16_t>(word >> (slot * 16));
+}
+
+std::uint64_t withLane(std::uint64_t word, int slot, std::uint16_t value) {
+    int shift = slot * 16;
+    return (word & ~(0xFFFFULL << shift)) | (static_cast<std::uint64_t>(value) << shift);
+}
+
+} // namespace
+
+CuckooFilter::CuckooFilter(std::size_t expectedKeys) {
+    // Four slots per bucket tolerate ~95% load; aim for under 50%.
+    std::size_t n = 1;
+    while (n * kSlotsPerBucket < expectedKeys * 2) n <<= 1;
+    buckets.assign(n, 0);
+    mask = n - 1;
+}
+
+CuckooFilter::Position CuckooFilter::locate(std::uint64_t key) const {
+    std::uint64_t h = HashIndex::hash(key);
+    std::uint16_t fp = static_cast<std::uint16_t>(h >> 48);
+    if (fp == 0) fp = 1;   // 0 marks an empty slot
+    std::size_t first = static_cast<std::size_t>(h) & mask;
+    return Position{first, alternate(first, fp), fp};
+}
+
+std::size_t CuckooFilter::alternate(std::size_t bucket, std::uint16_t fingerprint) const {
+    // Partial-key cuckoo hashing: the other bucket depends only on this
+    // one and the fingerprint, so a displaced entry can always be moved.
+    return (bucket ^ static_cast<std::size_t>(fingerprint * 0x5BD1E995u)) & mask;
+}
+
+bool CuckooFilter::place(std::size_t bucket, std::uint16_t fingerprint) {
+    std::uint64_t word = buckets[bucket];
+    for (int slot = 0; slot < kSlotsPerBucket; slot++) {
+        if (lane(word, slot) == 0) {
+            buckets[bucket] = withLane(word, slot, fingerprint);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CuckooFilter::insert(std::uint64_t key) {
+    if (buckets.empty()) return false;
+    Position p = locate(key);
+    if (place(p.first, p.fingerprint) || place(p.second, p.fingerprint)) {
+        count++;
+        return true;
+    }
+
+    std::size_t bucket = (kickState & 1) ? p.first : p.second;
+    std::uint16_t fp = p.fingerprint;
+    for (int kick = 0; kick < kMaxKicks; kick++) {
+        kickState ^= kickState << 13;
+        kickState ^= kickState >> 17;
+        kickState ^= kickState << 5;
+        int slot = static_cast<int>(kickState % kSlotsPerBucket);
+        std::uint16_t victim = lane(buckets[bucket], slot);
+        buckets[bucket] = withLane(buckets[bucket], slot, fp);
+        fp = victim;
+        bucket = alternate(bucket, fp);
+        if (place(bucket, fp)) {
+            count++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CuckooFilter::erase(std::uint64_t key) {
+    if (buckets.empty()) return false;
+    Position p = locate(key);
+    for (std::size_t bucket : {p.first, p.second}) {
+        for (int slot = 0; slot < kSlotsPerBucket; slot++) {
+            if (lane(buckets[bucket], slot) == p.fingerprint) {
+                buckets[bucket] = withLane(buckets[bucket], slot, 0);
+                count--;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool CuckooFilter::contains(std::uint64_t key) const {
+    if (buckets.empty()) return false;
+    Position p = locate(key);
+    return bucketHas(buckets[p.first], p.fingerprint) || bucketHas(buckets[p.second], p.fingerprint);
+}
+
+} // namespace atm
@@ -0,0 +1,52 @@
+#ifndef ATM_CUCKOO_FILTER_H
+#define ATM_CUCKOO_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace atm {
+
+// Approximate set membership with deletion: 16-bit fingerprints in
+// buckets of four, each bucket one 64-bit word. A key can only live in
+// one of two buckets, so contains() reads at most two words and never
+// misses a key that was inserted (false positives run at roughly 1 in
+// 8000). Callers that need a definite answer confirm hits elsewhere.
+class CuckooFilter {
+public:
+    CuckooFilter() = default;
+    // Sized so expectedKeys fill it to well under its maximum load.
+    explicit CuckooFilter(std::size_t expectedKeys);
+
+    // Returns false if the filter is too full; it must then be rebuilt
+    // larger, as the last displaced fingerprint has been dropped.
+    bool insert(std::uint64_t key);
+    // Removes one copy of key's fingerprint. Only erase keys that were inserted.
+    bool erase(std::uint64_t key);
+    bool contains(std::uint64_t key) const;
+
+    std::size_t size() const { return count; }
+    std::size_t memoryBytes() const { return buckets.capacity() * sizeof(std::uint64_t); }
+
+private:
+    static constexpr int kSlotsPerBucket = 4;
+    static constexpr int kMaxKicks = 500;
+
+    std::vector<std::uint64_t> buckets;
+    std::size_t mask = 0;
+    std::size_t count = 0;
+    std::uint32_t kickState = 0x9E3779B9u;
+
+    struct Position {
+        std::size_t first;
+        std::size_t second;
+        std::uint16_t fingerprint;
+    };
+    Position locate(std::uint64_t key) const;
+    std::size_t alternate(std::size_t bucket, std::uint16_t fingerprint) const;
+    bool place(std::size_t bucket, std::uint16_t fingerprint);
+};
+
+} // namespace atm
+
+#endif // ATM_CUCKOO_FILTER_H
@@ -0,0 +1,222 @@
+#include "end_of_day.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "account.h"
+#include "journal.h"
+#include "parallel.h"
+#include "sharded_account_store.h"
+
+namespace atm {
+
+namespace {
+
+// Below this many accounts one thread finishes before others could start.
+constexpr std::size_t kParallelThreshold = 16384;
+// Interest records are handed to the journal this many at a time, so the
+// batch shares syncs instead of waiting on one per account.
+constexpr std::size_t kJournalBatch = 4096;
+constexpr Money kInterestDivisor = 10000 * 365;
+constexpr std::uint64_t kInterestTxnTag = std::uint64_t(1) << 63;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// balance * bps / (10000 * 365), rounded down, without overflowing on
+// large balances.
+Money dailyInterest(Money balance, std::uint32_t bps) {
+    if (balance <= 0 || bps == 0) return 0;
+    return balance / kInterestDivisor * bps + balance % kInterestDivisor * bps / kInterestDivisor;
+}
+
+// Proleptic Gregorian date of a day number (days since 1970-01-01).
+std::string isoDate(std::uint32_t day) {
+    long long z = static_cast<long long>(day) + 719468;
+    long long era = z / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    long long d = doy - (153 * mp + 2) / 5 + 1;
+    long long m = mp < 10 ? mp + 3 : mp - 9;
+    long long y = yoe + era * 400 + (m <= 2);
+    char text[40];
+    std::snprintf(text, sizeof(text), "%04lld-%02d-%02d", y, static_cast<int>(m), static_cast<int>(d));
+    return text;
+}
+
+struct PartTotals {
+    std::size_t interestCredited = 0;
+    std::size_t interestAlreadyPaid = 0;
+    Money interestTotal = 0;
+    std::size_t newlyDormant = 0;
+    std::size_t dormant = 0;
+    std::size_t countersReset = 0;
+    Money totalBalances = 0;
+    Money totalWithdrawn = 0;
+    std::string error;
+};
+
+} // namespace
+
+EndOfDayReport runEndOfDay(ShardedAccountStore& store, Journal* journal, EndOfDayOptions options) {
+    EndOfDayReport report;
+    report.businessDay = options.businessDay ? options.businessDay : currentDay();
+    // The records walked below must stay the ones served until the end.
+    auto noReload = store.holdReloads();
+    report.accounts = store.size();
+    std::uint32_t day = report.businessDay;
+    std::size_t n = report.accounts;
+
+    unsigned threads = n < kParallelThreshold ? 1 : resolveThreads(options.threads);
+    report.threads = threads;
+    std::vector<PartTotals> parts(threads);
+    Account* records = store.accountStore().begin();
+
+    // Phase 1: copy the money fields with transfers held off. Each thread
+    // sums its own slice; later phases read balances only from the copy.
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Money> balances(n);
+    {
+        auto held = store.holdTransfers();
+        if (journal) report.journalLsn = journal->lastLsn();
+        runOnThreads(threads, [&](unsigned part) {
+            Slice slice = sliceOf(n, part, threads);
+            PartTotals& totals = parts[part];
+            for (std::size_t i = slice.begin; i < slice.end; i++) {
+                AccountSnapshot money = records[i].snapshot();
+                balances[i] = money.balance;
+                totals.totalBalances += money.balance;
+                if (money.day == day) totals.totalWithdrawn += money.withdrawnToday;
+            }
+        });
+    }
+    report.snapshotSeconds = secondsSince(start);
+
+    // Phase 2: post interest, flag dormant accounts and roll the counters,
+    // each thread on the same slice it copied.
+    start = std::chrono::steady_clock::now();
+    runOnThreads(threads, [&](unsigned part) {
+        Slice slice = sliceOf(n, part, threads);
+        PartTotals& totals = parts[part];
+        std::vector<JournalRecord> batch;
+        std::vector<Account*> credited;        // batch[i] was credited to credited[i]
+        std::vector<std::uint32_t> paidBefore;   // and its interest day before that
+        if (journal) {
+            batch.reserve(kJournalBatch);
+            credited.reserve(kJournalBatch);
+            paidBefore.reserve(kJournalBatch);
+        }
+        auto post = [&] {
+            if (batch.empty()) return;
+            journal->append(batch.data(), batch.size());
+            batch.clear();
+            credited.clear();
+            paidBefore.clear();
+        };
+
+        try {
+            for (std::size_t i = slice.begin; i < slice.end; i++) {
+                Account& account = records[i];
+                Money interest = dailyInterest(balances[i], options.interestBps);
+                std::uint32_t paid = account.interestPaidDay();
+                if (interest > 0 && paid >= day) {
+                    totals.interestAlreadyPaid++;
+                } else if (interest > 0) {
+                    Money after;
+                    if (account.credit(interest, &after) == TxnStatus::Ok) {
+                        account.setInterestPaidDay(day);
+                        totals.interestCredited++;
+                        totals.interestTotal += interest;
+                        if (journal) {
+                            batch.push_back(makeJournalRecord(TxnType::Credit, account.getAccountNumber(), interest, after,
+                                                              options.terminalId,
+                                                              interestTxnId(day, account.getAccountNumber())));
+                            credited.push_back(&account);
+                            paidBefore.push_back(paid);
+                            if (batch.size() == kJournalBatch) post();
+                        }
+                    }
+                }
+
+                std::uint32_t active = account.lastActiveDay();
+                if (active == 0) {
+                    // No activity on record (e.g. seeded accounts): start
+                    // the dormancy clock today.
+                    account.markActive(day);
+                } else if (day >= active + options.dormantAfterDays && !account.isDormant()) {
+                    account.setDormant(true);
+                    totals.newlyDormant++;
+                }
+                if (account.isDormant()) totals.dormant++;
+
+                if (account.resetDailyTotals(day + 1)) totals.countersReset++;
+            }
+            post();
+        } catch (const std::exception& e) {
+            // Interest the journal never got must not stay in the balances,
+            // or a rerun after the failure would pay it a second time.
+            for (std::size_t i = 0; i < batch.size(); i++) {
+                credited[i]->applyDelta(-batch[i].amount);
+                credited[i]->setInterestPaidDay(paidBefore[i]);
+                totals.interestCredited--;
+                totals.interestTotal -= batch[i].amount;
+            }
+            totals.error = e.what();
+        }
+    });
+    report.processSeconds = secondsSince(start);
+
+    for (const PartTotals& totals : parts) {
+        if (!totals.error.empty()) throw std::runtime_error(totals.error);
+        report.interestCredited += totals.interestCredited;
+        report.interestAlreadyPaid += totals.interestAlreadyPaid;
+        report.interestTotal += totals.interestTotal;
+        report.newlyDormant += totals.newlyDormant;
+        report.dormant += totals.dormant;
+        report.countersReset += totals.countersReset;
+        report.totalBalances += totals.totalBalances;
+        report.totalWithdrawn += totals.totalWithdrawn;
+    }
+    return report;
+}
+
+std::uint64_t interestTxnId(std::uint32_t businessDay, int accountNumber) {
+    return kInterestTxnTag | std::uint64_t(businessDay) << 32 | static_cast<std::uint32_t>(accountNumber);
+}
+
+std::uint32_t interestDayOf(std::uint64_t txnId) {
+    return txnId & kInterestTxnTag ? static_cast<std::uint32_t>((txnId & ~kInterestTxnTag) >> 32) : 0;
+}
+
+std::string endOfDaySummaryName(std::uint32_t businessDay) {
+    return "eod-" + isoDate(businessDay) + ".txt";
+}
+
+void writeEndOfDaySummary(const std::string& path, const EndOfDayReport& report) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot write " + path);
+    out << "End-of-day summary\n"
+        << "Business day:       " << isoDate(report.businessDay) << " (" << report.businessDay << ")\n"
+        << "Journal LSN:        " << report.journalLsn << "\n"
+        << "Accounts:           " << report.accounts << "\n"
+        << "Total balances:     " << formatMoney(report.totalBalances) << "\n"
+        << "Cash withdrawn:     " << formatMoney(report.totalWithdrawn) << "\n"
+        << "Interest credited:  " << formatMoney(report.interestTotal) << " to " << report.interestCredited << " accounts\n"
+        << "Already paid:       " << report.interestAlreadyPaid << " accounts (earlier run)\n"
+        << "Dormant accounts:   " << report.dormant << " (" << report.newlyDormant << " new)\n"
+        << "Counters reset:     " << report.countersReset << "\n"
+        << "Threads:            " << report.threads << "\n"
+        << "Snapshot seconds:   " << report.snapshotSeconds << "\n"
+        << "Process seconds:    " << report.processSeconds << "\n"
+        << "Accounts/s:         " << static_cast<long long>(report.recordsPerSecond()) << "\n";
+    out.flush();
+    if (!out) throw std::runtime_error("Cannot write " + path);
+}
+
+} // namespace atm
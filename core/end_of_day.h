@@ -0,0 +1,95 @@
+#ifndef ATM_END_OF_DAY_H
+#define ATM_END_OF_DAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "money.h"
+
+namespace atm {
+
+class Journal;
+class ShardedAccountStore;
+
+// End-of-day batch
+//
+// Closes a business day over every account:
+//   - credits a day's interest on positive balances,
+//   - flags accounts with no customer activity for the dormancy period,
+//   - starts the next day's withdrawal totals.
+//
+// The job reads the money fields once, into columns, while every shard is
+// held shared: transfers wait for that pass, so the totals it reports
+// never count money in flight between two accounts, while deposits and
+// withdrawals keep going. Everything after that works from the copy, on
+// threads over equal slices of the account set, and posts its changes
+// through the normal seqlocked operations, so sessions never see a
+// half-applied account.
+//
+// Interest is journaled as Credit records, so it survives a restart like
+// any other transaction. Each carries interestTxnId(day, account) as its
+// transaction ID, and crediting it (or replaying it) sets the account's
+// interest day, so interest is paid at most once per account and day
+// however often the day is run. It is not added to the mini-statement history,
+// which would give every idle account a ring; statements filled from the
+// journal at startup do show it. The dormant flag is recomputed from each
+// account's last activity day at every run. Counter resets are not
+// journaled: after a restart the closed day's withdrawals are replayed
+// into the total again, which can only make the limit stricter for the
+// rest of that calendar day.
+
+struct EndOfDayOptions {
+    std::uint32_t businessDay = 0;       // day being closed; 0: currentDay()
+    std::uint32_t interestBps = 350;     // annual rate in basis points, accrued daily (actual/365)
+    std::uint32_t dormantAfterDays = 730;
+    unsigned threads = 0;                // 0: one per hardware thread
+    std::uint32_t terminalId = 0;        // stamped on the interest journal records
+};
+
+struct EndOfDayReport {
+    std::uint32_t businessDay = 0;
+    std::uint64_t journalLsn = 0;        // last journal record before the snapshot
+    std::size_t accounts = 0;
+    std::size_t interestCredited = 0;    // accounts that earned a nonzero amount
+    std::size_t interestAlreadyPaid = 0; // skipped: paid for businessDay by an earlier run
+    Money interestTotal = 0;
+    std::size_t newlyDormant = 0;
+    std::size_t dormant = 0;             // flagged after this run, including newlyDormant
+    std::size_t countersReset = 0;
+    Money totalBalances = 0;             // before interest, as of the snapshot
+    Money totalWithdrawn = 0;            // cash withdrawn on businessDay, as of the snapshot
+    unsigned threads = 0;
+    double snapshotSeconds = 0;          // transfers held while the columns were copied
+    double processSeconds = 0;           // interest, dormancy and counters, including the journal
+
+    double wallSeconds() const { return snapshotSeconds + processSeconds; }
+    double recordsPerSecond() const { return wallSeconds() > 0 ? accounts / wallSeconds() : 0; }
+};
+
+// Runs the batch. Running a day again, e.g. after a failure, finishes it:
+// accounts already paid for the day are skipped, and the dormancy and
+// counter steps are idempotent. journal may be null (the interest is then
+// not recorded, e.g. in benchmarks). Throws std::runtime_error if the
+// journal cannot be written: interest already journaled stays credited,
+// and interest credited but not yet journaled (at most one batch per
+// thread) is taken back, so balances always match the journal. An account
+// reload waits for it.
+EndOfDayReport runEndOfDay(ShardedAccountStore& store, Journal* journal, EndOfDayOptions options = EndOfDayOptions());
+
+// Transaction ID of the interest an account earned on businessDay. The top
+// bit keeps these apart from LSNs, which the journal uses by default.
+std::uint64_t interestTxnId(std::uint32_t businessDay, int accountNumber);
+// The business day of an interestTxnId(), 0 for any other transaction ID.
+std::uint32_t interestDayOf(std::uint64_t txnId);
+
+// "eod-YYYY-MM-DD.txt": the summary file name for a business day.
+std::string endOfDaySummaryName(std::uint32_t businessDay);
+
+// Writes report as a plain-text summary. Throws std::runtime_error if the
+// file cannot be written.
+void writeEndOfDaySummary(const std::string& path, const EndOfDayReport& report);
+
+} // namespace atm
+
+#endif // ATM_END_OF_DAY_H
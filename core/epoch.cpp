@@ -0,0 +1,127 @@
+#include "epoch.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+namespace atm {
+
+EpochDomain::Guard::Guard(const Guard& other) : domain(other.domain), epoch(other.epoch) {
+    // other's pin already holds the minimum at or below epoch, so a second
+    // slot at the same epoch protects exactly what other does.
+    if (other.slot) slot = domain->acquire(epoch);
+}
+
+EpochDomain::Guard& EpochDomain::Guard::operator=(const Guard& other) {
+    if (this != &other) *this = Guard(other);
+    return *this;
+}
+
+EpochDomain::Guard::Guard(Guard&& other) noexcept : domain(other.domain), slot(other.slot), epoch(other.epoch) {
+    other.slot = nullptr;
+}
+
+EpochDomain::Guard& EpochDomain::Guard::operator=(Guard&& other) noexcept {
+    if (this != &other) {
+        release();
+        domain = other.domain;
+        slot = other.slot;
+        epoch = other.epoch;
+        other.slot = nullptr;
+    }
+    return *this;
+}
+
+void EpochDomain::Guard::release() {
+    if (slot) slot->store(0, std::memory_order_release);
+    slot = nullptr;
+}
+
+EpochDomain::EpochDomain() = default;
+
+EpochDomain::~EpochDomain() {
+    Block* block = first.next.load(std::memory_order_acquire);
+    while (block) {
+        Block* next = block->next.load(std::memory_order_acquire);
+        delete block;
+        block = next;
+    }
+}
+
+EpochDomain::Guard EpochDomain::pin() {
+    Guard guard;
+    guard.domain = this;
+    guard.epoch = epoch.load(std::memory_order_seq_cst);
+    guard.slot = acquire(guard.epoch);
+    return guard;
+}
+
+// Claims a free slot and stores at in it. Each thread starts from its own
+// place in the first block, so readers on different threads rarely touch
+// the same cache line; when every slot is taken a block is appended.
+std::atomic<std::uint64_t>* EpochDomain::acquire(std::uint64_t at) {
+    thread_local const std::size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+    Block* block = &first;
+    for (;;) {
+        for (std::size_t i = 0; i < kSlotsPerBlock; i++) {
+            std::atomic<std::uint64_t>& slot = block->slots[(start + i) % kSlotsPerBlock].pinned;
+            std::uint64_t free = 0;
+            // Sequentially consistent, so the pin is visible to reclaim()
+            // before the caller loads the pointer it protects.
+            if (slot.load(std::memory_order_relaxed) == 0 &&
+                slot.compare_exchange_strong(free, at, std::memory_order_seq_cst)) {
+                return &slot;
+            }
+        }
+        Block* next = block->next.load(std::memory_order_acquire);
+        if (!next) {
+            Block* added = new Block;
+            if (block->next.compare_exchange_strong(next, added, std::memory_order_acq_rel)) {
+                next = added;
+            } else {
+                delete added;   // another thread got there first; next is theirs
+            }
+        }
+        block = next;
+    }
+}
+
+std::uint64_t EpochDomain::oldestPinned() const {
+    std::uint64_t oldest = UINT64_MAX;
+    for (const Block* block = &first; block; block = block->next.load(std::memory_order_acquire)) {
+        for (const Slot& slot : block->slots) {
+            std::uint64_t pinned = slot.pinned.load(std::memory_order_seq_cst);
+            if (pinned != 0 && pinned < oldest) oldest = pinned;
+        }
+    }
+    return oldest;
+}
+
+void EpochDomain::retire(std::shared_ptr<const void> object) {
+    // The caller has already published the replacement, so a reader that
+    // pins the epoch after this increment can only load the new pointer.
+    std::uint64_t at = epoch.fetch_add(1, std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> guard(retiredLock);
+    retired.push_back(Retired{at, std::move(object)});
+}
+
+std::size_t EpochDomain::reclaim() {
+    std::vector<std::shared_ptr<const void>> dropped;
+    {
+        std::lock_guard<std::mutex> guard(retiredLock);
+        std::uint64_t oldest = oldestPinned();
+        auto keep = std::stable_partition(retired.begin(), retired.end(),
+                                          [&](const Retired& r) { return r.epoch >= oldest; });
+        for (auto it = keep; it != retired.end(); ++it) dropped.push_back(std::move(it->object));
+        retired.erase(keep, retired.end());
+    }
+    // Destroyed outside the lock: an old copy can be large.
+    return dropped.size();
+}
+
+std::size_t EpochDomain::retiredCount() const {
+    std::lock_guard<std::mutex> guard(retiredLock);
+    return retired.size();
+}
+
+} // namespace atm
@@ -0,0 +1,97 @@
+#ifndef ATM_EPOCH_H
+#define ATM_EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace atm {
+
+// Epoch-based reclamation, for data published through an atomic pointer
+// and replaced while readers may still be using the old copy.
+//
+// A reader pins the current epoch into a slot of its own for as long as
+// it uses what it loaded: one compare-and-swap, no lock, and nothing
+// shared with other readers but the epoch counter it reads. A writer
+// publishes the replacement, then retires the old copy, which stamps it
+// with the epoch and moves the epoch on. reclaim() frees whatever was
+// retired before the oldest epoch still pinned, so an old copy lives
+// exactly as long as someone who might have seen it.
+//
+// Slots come in cache-line-sized cells, 64 to a block; blocks are added
+// without locking when every slot is taken and kept until the domain goes.
+class EpochDomain {
+public:
+    // Keeps everything current at or after the pin from being reclaimed.
+    // Copies pin another slot at the same epoch. Movable; an empty guard
+    // pins nothing.
+    class Guard {
+    public:
+        Guard() = default;
+        ~Guard() { release(); }
+        Guard(const Guard& other);
+        Guard& operator=(const Guard& other);
+        Guard(Guard&& other) noexcept;
+        Guard& operator=(Guard&& other) noexcept;
+
+        explicit operator bool() const { return slot != nullptr; }
+
+    private:
+        friend class EpochDomain;
+
+        EpochDomain* domain = nullptr;
+        std::atomic<std::uint64_t>* slot = nullptr;
+        std::uint64_t epoch = 0;
+
+        void release();
+    };
+
+    EpochDomain();
+    // Frees everything still retired; no guard may outlive the domain.
+    ~EpochDomain();
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    Guard pin();
+
+    // Hands object over, already unpublished, to be dropped once no guard
+    // pinned before this call is left.
+    void retire(std::shared_ptr<const void> object);
+    // Drops what can be dropped now and returns how many objects that was.
+    std::size_t reclaim();
+
+    std::uint64_t currentEpoch() const { return epoch.load(std::memory_order_acquire); }
+    std::size_t retiredCount() const;
+
+private:
+    static constexpr std::size_t kSlotsPerBlock = 64;
+
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> pinned{0};   // epoch pinned, 0 when free
+    };
+
+    struct Block {
+        Slot slots[kSlotsPerBlock];
+        std::atomic<Block*> next{nullptr};
+    };
+
+    struct Retired {
+        std::uint64_t epoch;
+        std::shared_ptr<const void> object;
+    };
+
+    std::atomic<std::uint64_t> epoch{1};
+    Block first;
+    mutable std::mutex retiredLock;   // writers only
+    std::vector<Retired> retired;
+
+    std::atomic<std::uint64_t>* acquire(std::uint64_t at);
+    std::uint64_t oldestPinned() const;
+};
+
+} // namespace atm
+
+#endif // ATM_EPOCH_H
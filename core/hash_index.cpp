@@ -0,0 +1,234 @@
+#include "hash_index.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "parallel.h"
+
+namespace atm {
+
+static_assert(sizeof(HashIndex::Slot) == 16, "Account file index pages depend on the slot size");
+
+namespace {
+
+std::size_t capacityFor(std::size_t keys) {
+    std::size_t cap = 16;
+    while (cap < keys * 2) cap <<= 1;   // load factor <= 0.5
+    return cap;
+}
+
+// Below this many keys the partitioning passes cost more than they save.
+constexpr std::size_t kParallelBuildMin = 1 << 16;
+
+unsigned log2Of(std::size_t powerOfTwo) {
+    unsigned bits = 0;
+    while ((std::size_t{1} << bits) < powerOfTwo) bits++;
+    return bits;
+}
+
+} // namespace
+
+std::uint64_t HashIndex::hash(std::uint64_t key) {
+    // splitmix64 finalizer: account and card numbers are dense and
+    // sequential, so the low bits need mixing before masking.
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+HashIndex::HashIndex(const HashIndex& other)
+    : slots(other.slots), table(other.table), tableSize(other.tableSize), mask(other.mask), count(other.count) {
+    if (!slots.empty()) table = slots.data();
+}
+
+HashIndex::HashIndex(HashIndex&& other) noexcept
+    : slots(std::move(other.slots)), table(other.table), tableSize(other.tableSize), mask(other.mask), count(other.count) {
+    other.table = nullptr;
+    other.tableSize = other.mask = other.count = 0;
+}
+
+HashIndex& HashIndex::operator=(HashIndex other) noexcept {
+    slots.swap(other.slots);
+    std::swap(table, other.table);
+    std::swap(tableSize, other.tableSize);
+    std::swap(mask, other.mask);
+    std::swap(count, other.count);
+    return *this;
+}
+
+HashIndex HashIndex::view(const Slot* table, std::size_t capacity, std::size_t count) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("Hash index capacity must be a power of two");
+    }
+    HashIndex index;
+    index.table = table;
+    index.tableSize = capacity;
+    index.mask = capacity - 1;
+    index.count = count;
+    return index;
+}
+
+void HashIndex::reserve(std::size_t expectedKeys) {
+    std::size_t cap = capacityFor(expectedKeys);
+    if (cap > tableSize) rehash(cap);
+}
+
+void HashIndex::clear() {
+    slots.clear();
+    slots.shrink_to_fit();
+    table = nullptr;
+    tableSize = mask = count = 0;
+}
+
+void HashIndex::rehash(std::size_t newCapacity) {
+    const Slot* oldTable = table;
+    std::size_t oldSize = tableSize;
+    std::vector<Slot> old;
+    old.swap(slots);
+
+    slots.assign(newCapacity, Slot{0, kNotFound, 0});
+    table = slots.data();
+    tableSize = newCapacity;
+    mask = newCapacity - 1;
+    count = 0;
+    for (std::size_t i = 0; i < oldSize; i++) {
+        if (oldTable[i].value != kNotFound) insertUnchecked(oldTable[i].key, oldTable[i].value);
+    }
+}
+
+bool HashIndex::insertUnchecked(std::uint64_t key, std::uint32_t value) {
+    std::size_t i = hash(key) & mask;
+    while (slots[i].value != kNotFound) {
+        if (slots[i].key == key) return false;
+        i = (i + 1) & mask;
+    }
+    slots[i] = Slot{key, value, 0};
+    count++;
+    return true;
+}
+
+bool HashIndex::insert(std::uint64_t key, std::uint32_t value) {
+    // Inserting into a borrowed table copies it first (rehash below).
+    if (slots.empty() || (count + 1) * 2 > tableSize) rehash(capacityFor(count + 1));
+    return insertUnchecked(key, value);
+}
+
+void HashIndex::assign(std::uint64_t key, std::uint32_t value) {
+    if (slots.empty() || (count + 1) * 2 > tableSize) rehash(capacityFor(count + 1));
+    std::size_t i = hash(key) & mask;
+    while (slots[i].value != kNotFound && slots[i].key != key) i = (i + 1) & mask;
+    if (slots[i].value == kNotFound) count++;
+    slots[i] = Slot{key, value, 0};
+}
+
+std::uint32_t HashIndex::find(std::uint64_t key) const {
+    if (tableSize == 0) return kNotFound;
+    std::size_t i = hash(key) & mask;
+    while (table[i].value != kNotFound) {
+        if (table[i].key == key) return table[i].value;
+        i = (i + 1) & mask;
+    }
+    return kNotFound;
+}
+
+std::uint32_t HashIndex::build(const std::uint64_t* keys, std::size_t n, unsigned threads) {
+    return build(keys, nullptr, n, threads);
+}
+
+std::uint32_t HashIndex::build(const std::uint64_t* keys, const std::uint32_t* values, std::size_t n,
+                               unsigned threads) {
+    clear();
+    rehash(capacityFor(n));
+    auto valueAt = [&](std::size_t i) { return values ? values[i] : static_cast<std::uint32_t>(i); };
+
+    if (threads <= 1 || n < kParallelBuildMin) {
+        for (std::size_t i = 0; i < n; i++) {
+            if (!insertUnchecked(keys[i], valueAt(i))) return static_cast<std::uint32_t>(i);
+        }
+        return kNotFound;
+    }
+
+    // Partition p owns slots [p << regionBits, (p + 1) << regionBits).
+    // A few partitions per thread keep the threads evenly loaded.
+    unsigned tableBits = log2Of(tableSize);
+    unsigned partBits = std::min(log2Of(std::size_t{threads} * 4), tableBits);
+    unsigned regionBits = tableBits - partBits;
+    std::size_t parts = std::size_t{1} << partBits;
+    auto partitionOf = [&](std::uint64_t key) { return (hash(key) & mask) >> regionBits; };
+
+    // 1. Count keys per partition in each thread's slice of the input.
+    std::vector<std::vector<std::size_t>> counts(threads, std::vector<std::size_t>(parts, 0));
+    runOnThreads(threads, [&](unsigned t) {
+        Slice s = sliceOf(n, t, threads);
+        for (std::size_t i = s.begin; i < s.end; i++) counts[t][partitionOf(keys[i])]++;
+    });
+
+    // 2. Scatter keys into partition order; within a partition, slices
+    //    stay in input order so single-partition behaviour is unchanged.
+    std::vector<std::size_t> partStart(parts + 1, 0);
+    std::vector<std::vector<std::size_t>> cursor(threads, std::vector<std::size_t>(parts));
+    std::size_t offset = 0;
+    for (std::size_t p = 0; p < parts; p++) {
+        partStart[p] = offset;
+        for (unsigned t = 0; t < threads; t++) {
+            cursor[t][p] = offset;
+            offset += counts[t][p];
+        }
+    }
+    partStart[parts] = offset;
+
+    struct Entry {
+        std::uint64_t key;
+        std::uint32_t value;
+        std::uint32_t position;
+    };
+    std::unique_ptr<Entry[]> scattered(new Entry[n]);
+    runOnThreads(threads, [&](unsigned t) {
+        Slice s = sliceOf(n, t, threads);
+        for (std::size_t i = s.begin; i < s.end; i++) {
+            scattered[cursor[t][partitionOf(keys[i])]++] =
+                Entry{keys[i], valueAt(i), static_cast<std::uint32_t>(i)};
+        }
+    });
+
+    // 3. Fill each region from its own partition. A probe that reaches the
+    //    end of the region is deferred rather than entering a neighbour.
+    std::vector<std::vector<Entry>> overflow(threads);
+    std::vector<std::size_t> placed(threads, 0);
+    std::vector<std::uint32_t> duplicate(threads, kNotFound);
+    runOnThreads(threads, [&](unsigned t) {
+        for (std::size_t p = t; p < parts; p += threads) {
+            std::size_t regionEnd = (p + 1) << regionBits;
+            for (std::size_t e = partStart[p]; e < partStart[p + 1]; e++) {
+                const Entry& entry = scattered[e];
+                std::size_t i = hash(entry.key) & mask;
+                while (i < regionEnd && slots[i].value != kNotFound && slots[i].key != entry.key) i++;
+                if (i == regionEnd) {
+                    overflow[t].push_back(entry);
+                } else if (slots[i].value != kNotFound) {
+                    duplicate[t] = std::min(duplicate[t], entry.position);
+                } else {
+                    slots[i] = Slot{entry.key, entry.value, 0};
+                    placed[t]++;
+                }
+            }
+        }
+    });
+
+    // 4. Deferred keys continue their probe past the region boundary.
+    for (std::size_t p : placed) count += p;
+    std::uint32_t firstDuplicate = *std::min_element(duplicate.begin(), duplicate.end());
+    for (const std::vector<Entry>& list : overflow) {
+        for (const Entry& entry : list) {
+            if (!insertUnchecked(entry.key, entry.value)) firstDuplicate = std::min(firstDuplicate, entry.position);
+        }
+    }
+    return firstDuplicate;
+}
+
+} // namespace atm
@@ -0,0 +1,77 @@
+#ifndef ATM_HASH_INDEX_H
+#define ATM_HASH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace atm {
+
+// Open-addressing (linear probing) map from a 64-bit key to a 32-bit row
+// number. The table is a single flat array of 16-byte slots kept at most
+// half full, so a lookup is one hash and, almost always, one cache line.
+//
+// The slot array is either owned or borrowed from elsewhere (an account
+// file mapping); a borrowed table is read-only.
+class HashIndex {
+public:
+    static constexpr std::uint32_t kNotFound = 0xFFFFFFFFu;
+
+    struct Slot {
+        std::uint64_t key;
+        std::uint32_t value;    // kNotFound marks an empty slot
+        std::uint32_t reserved;
+    };
+
+    HashIndex() = default;
+    HashIndex(const HashIndex& other);
+    HashIndex(HashIndex&& other) noexcept;
+    HashIndex& operator=(HashIndex other) noexcept;
+
+    // Wraps an existing table without copying it. capacity must be a power
+    // of two and the slots must have been produced by another HashIndex.
+    static HashIndex view(const Slot* table, std::size_t capacity, std::size_t count);
+
+    // Sizes the table for expectedKeys entries without rehashing later.
+    void reserve(std::size_t expectedKeys);
+    void clear();
+
+    // Returns false (and leaves the table unchanged) if key is present.
+    bool insert(std::uint64_t key, std::uint32_t value);
+    // Inserts key, or points it at value if it is present.
+    void assign(std::uint64_t key, std::uint32_t value);
+    std::uint32_t find(std::uint64_t key) const;
+
+    // Bulk build: keys[i] maps to values[i] (to i when values is null).
+    // Returns the position i of a duplicate key - the first one when
+    // built on one thread - or kNotFound if every key was unique.
+    //
+    // With threads > 1 the keys are partitioned by home slot and each
+    // contiguous region of the table is filled by a single thread; the few
+    // keys whose probe runs off the end of their region are placed
+    // afterwards. The result is a valid linear-probing table either way.
+    std::uint32_t build(const std::uint64_t* keys, std::size_t count, unsigned threads = 1);
+    std::uint32_t build(const std::uint64_t* keys, const std::uint32_t* values, std::size_t count,
+                        unsigned threads = 1);
+
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return tableSize; }
+    const Slot* data() const { return table; }
+    std::size_t memoryBytes() const { return slots.capacity() * sizeof(Slot); }
+
+    static std::uint64_t hash(std::uint64_t key);
+
+private:
+    std::vector<Slot> slots;
+    const Slot* table = nullptr;
+    std::size_t tableSize = 0;
+    std::size_t mask = 0;
+    std::size_t count = 0;
+
+    void rehash(std::size_t newCapacity);
+    bool insertUnchecked(std::uint64_t key, std::uint32_t value);
+};
+
+} // namespace atm
+
+#endif // ATM_HASH_INDEX_H
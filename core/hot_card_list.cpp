@@ -0,0 +1,167 @@
+#include "hot_card_list.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "card_number.h"
+
+namespace atm {
+
+namespace {
+
+bool sortedHas(const std::vector<long long>& v, long long card) {
+    return !v.empty() && std::binary_search(v.begin(), v.end(), card);
+}
+
+void sortedInsert(std::vector<long long>& v, long long card) {
+    v.insert(std::lower_bound(v.begin(), v.end(), card), card);
+}
+
+void sortedErase(std::vector<long long>& v, long long card) {
+    v.erase(std::lower_bound(v.begin(), v.end(), card));
+}
+
+} // namespace
+
+HotCardList::HotCardList() {
+    auto empty = std::make_shared<Generation>();
+    empty->base = buildBase({});
+    current.store(empty.get(), std::memory_order_release);
+    currentOwner = std::move(empty);
+}
+
+void HotCardList::publish(std::shared_ptr<const Generation> next) {
+    current.store(next.get(), std::memory_order_seq_cst);
+    epochs.retire(std::move(currentOwner));
+    currentOwner = std::move(next);
+    epochs.reclaim();
+}
+
+std::shared_ptr<const HotCardList::Base> HotCardList::buildBase(std::vector<long long> sortedCards) {
+    // A failed insert means an unlucky cycle of displacements; retry with
+    // more room rather than give up on a card.
+    for (std::size_t room = sortedCards.size();; room *= 2) {
+        auto base = std::make_shared<Base>();
+        base->filter = CuckooFilter(std::max<std::size_t>(room, 64));
+        bool complete = true;
+        for (long long card : sortedCards) {
+            if (!base->filter.insert(static_cast<std::uint64_t>(card))) {
+                complete = false;
+                break;
+            }
+        }
+        if (complete) {
+            base->cards = std::move(sortedCards);
+            return base;
+        }
+    }
+}
+
+std::shared_ptr<const HotCardList::Base> HotCardList::foldDelta(const Generation& g) {
+    std::vector<long long> cards;
+    cards.reserve(g.size());
+    std::set_difference(g.base->cards.begin(), g.base->cards.end(), g.removed.begin(), g.removed.end(),
+                        std::back_inserter(cards));
+    std::size_t kept = cards.size();
+    cards.insert(cards.end(), g.added.begin(), g.added.end());
+    std::inplace_merge(cards.begin(), cards.begin() + kept, cards.end());
+
+    // Patch a copy of the filter rather than rehashing every card.
+    auto base = std::make_shared<Base>();
+    base->filter = g.base->filter;
+    for (long long card : g.removed) base->filter.erase(static_cast<std::uint64_t>(card));
+    for (long long card : g.added) {
+        if (!base->filter.insert(static_cast<std::uint64_t>(card))) return buildBase(std::move(cards));
+    }
+    base->cards = std::move(cards);
+    return base;
+}
+
+void HotCardList::replace(std::vector<long long> cards) {
+    std::sort(cards.begin(), cards.end());
+    cards.erase(std::unique(cards.begin(), cards.end()), cards.end());
+    auto next = std::make_shared<Generation>();
+    next->base = buildBase(std::move(cards));
+
+    std::lock_guard<std::mutex> guard(writeLock);
+    publish(std::move(next));
+}
+
+bool HotCardList::add(long long cardNumber) {
+    std::lock_guard<std::mutex> guard(writeLock);
+    const Generation* g = currentOwner.get();
+    auto next = std::make_shared<Generation>(*g);
+    if (sortedHas(next->removed, cardNumber)) {
+        sortedErase(next->removed, cardNumber);
+    } else if (sortedHas(g->added, cardNumber) || sortedHas(g->base->cards, cardNumber)) {
+        return false;
+    } else {
+        sortedInsert(next->added, cardNumber);
+    }
+    if (next->added.size() + next->removed.size() > kMaxDelta) {
+        next->base = foldDelta(*next);
+        next->added.clear();
+        next->removed.clear();
+    }
+    publish(std::move(next));
+    return true;
+}
+
+bool HotCardList::remove(long long cardNumber) {
+    std::lock_guard<std::mutex> guard(writeLock);
+    const Generation* g = currentOwner.get();
+    auto next = std::make_shared<Generation>(*g);
+    if (sortedHas(next->added, cardNumber)) {
+        sortedErase(next->added, cardNumber);
+    } else if (sortedHas(g->base->cards, cardNumber) && !sortedHas(g->removed, cardNumber)) {
+        sortedInsert(next->removed, cardNumber);
+    } else {
+        return false;
+    }
+    if (next->added.size() + next->removed.size() > kMaxDelta) {
+        next->base = foldDelta(*next);
+        next->added.clear();
+        next->removed.clear();
+    }
+    publish(std::move(next));
+    return true;
+}
+
+bool HotCardList::contains(long long cardNumber) const {
+    // Pinned before the load, so g cannot be freed under the lookup.
+    EpochDomain::Guard pin = epochs.pin();
+    const Generation* g = current.load(std::memory_order_acquire);
+    if (sortedHas(g->added, cardNumber)) return true;
+    if (!g->base->filter.contains(static_cast<std::uint64_t>(cardNumber))) return false;
+    return sortedHas(g->base->cards, cardNumber) && !sortedHas(g->removed, cardNumber);
+}
+
+std::size_t HotCardList::size() const {
+    EpochDomain::Guard pin = epochs.pin();
+    return current.load(std::memory_order_acquire)->size();
+}
+
+std::vector<long long> HotCardList::readFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot read hot card list " + path);
+
+    std::vector<long long> cards;
+    std::string line;
+    for (std::size_t lineNumber = 1; std::getline(in, line); lineNumber++) {
+        std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue;
+        std::size_t end = line.find_last_not_of(" \t\r") + 1;
+        long long card = 0;
+        CardCheck check = checkCardNumber(std::string_view(line).substr(start, end - start), &card);
+        if (check != CardCheck::Ok) {
+            throw std::invalid_argument(path + ":" + std::to_string(lineNumber) + ": not a card number (" +
+                                        cardCheckName(check) + ")");
+        }
+        cards.push_back(card);
+    }
+    return cards;
+}
+
+} // namespace atm
@@ -0,0 +1,77 @@
+#ifndef ATM_HOT_CARD_LIST_H
+#define ATM_HOT_CARD_LIST_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cuckoo_filter.h"
+#include "epoch.h"
+
+namespace atm {
+
+// Blocked / lost / stolen cards, checked on every card lookup.
+//
+// The published list is an immutable generation: a cuckoo filter that
+// answers nearly every lookup (cards not on the list) from two cache
+// lines, and a sorted array that confirms the filter's hits exactly.
+// Small add()/remove() changes go to short sorted delta arrays carried in
+// the same generation; once those grow past a limit they are folded into
+// a new base. Every change, including a full replace(), builds the next
+// generation off to the side and publishes it with one atomic pointer
+// store. A lookup pins an epoch (one compare-and-swap on a slot of its
+// own) and reads the raw pointer, so it takes no lock and touches no
+// shared reference count; replaced generations are freed by epoch-based
+// reclamation once no lookup can still be reading them.
+class HotCardList {
+public:
+    HotCardList();
+
+    // Replaces the whole list at once (the daily push).
+    void replace(std::vector<long long> cards);
+    // Returns false if the card was already listed.
+    bool add(long long cardNumber);
+    // Returns false if the card was not listed.
+    bool remove(long long cardNumber);
+
+    bool contains(long long cardNumber) const;
+    std::size_t size() const;
+
+    // One card number per line; blank lines and lines starting with '#'
+    // are skipped. Throws std::runtime_error if the file cannot be read
+    // and std::invalid_argument on a line that is not a valid card number
+    // (checkCardNumber()).
+    static std::vector<long long> readFile(const std::string& path);
+
+private:
+    static constexpr std::size_t kMaxDelta = 1024;
+
+    struct Base {
+        CuckooFilter filter;
+        std::vector<long long> cards;   // sorted, unique
+    };
+
+    struct Generation {
+        std::shared_ptr<const Base> base;
+        std::vector<long long> added;     // sorted; not in base
+        std::vector<long long> removed;   // sorted; in base
+        std::size_t size() const { return base->cards.size() + added.size() - removed.size(); }
+    };
+
+    std::atomic<const Generation*> current{nullptr};
+    std::shared_ptr<const Generation> currentOwner;   // keeps current alive; writers only
+    mutable EpochDomain epochs;
+    std::mutex writeLock;                             // one writer at a time
+
+    // Under writeLock: makes next current and retires the one it replaces.
+    void publish(std::shared_ptr<const Generation> next);
+    static std::shared_ptr<const Base> buildBase(std::vector<long long> sortedCards);
+    static std::shared_ptr<const Base> foldDelta(const Generation& generation);
+};
+
+} // namespace atm
+
+#endif // ATM_HOT_CARD_LIST_H
@@ -0,0 +1,598 @@
+#include "journal.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <stdexcept>
+#include <type_traits>
+
+#include "checksum.h"
+#include "journal_index.h"
+#include "journal_segments.h"
+
+namespace atm {
+
+namespace {
+
+constexpr std::uint32_t kRecordMagic = 0x314A474E;   // "NGJ1"
+
+// Async mode blocks appenders once this many groups are waiting to be written.
+constexpr std::size_t kMaxPendingGroups = 4;
+
+// Records JournalReader reads from a raw file at a time.
+constexpr std::size_t kReadRecords = 4096;
+
+static_assert(sizeof(JournalRecord) == 64, "Journal file format depends on the record size");
+static_assert(std::is_trivially_copyable<JournalRecord>::value, "Journal records are written as raw bytes");
+
+std::uint32_t recordChecksum(const JournalRecord& r) {
+    return crc32(&r, offsetof(JournalRecord, checksum));
+}
+
+std::int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool fileExists(const std::string& path) {
+    return std::ifstream(path).good();
+}
+
+// rename() that replaces the target on Windows too.
+bool renameOver(const std::string& from, const std::string& to) {
+    std::remove(to.c_str());
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+} // namespace
+
+const char* txnTypeName(TxnType type) {
+    switch (type) {
+        case TxnType::Deposit: return "Deposit";
+        case TxnType::Withdrawal: return "Withdrawal";
+        case TxnType::Credit: return "Credit";
+        case TxnType::Debit: return "Debit";
+    }
+    return "Unknown";
+}
+
+Money JournalRecord::delta() const {
+    switch (txnType()) {
+        case TxnType::Deposit:
+        case TxnType::Credit:
+            return amount;
+        case TxnType::Withdrawal:
+        case TxnType::Debit:
+            return -amount;
+    }
+    return 0;
+}
+
+bool JournalRecord::isValid() const {
+    return magic == kRecordMagic && checksum == recordChecksum(*this);
+}
+
+JournalRecord makeJournalRecord(TxnType type, int accountNumber, Money amount, Money balanceAfter,
+                                std::uint32_t terminalId, std::uint64_t txnId) {
+    JournalRecord r{};
+    r.magic = kRecordMagic;
+    r.type = static_cast<std::uint16_t>(type);
+    r.txnId = txnId;
+    r.amount = amount;
+    r.balanceAfter = balanceAfter;
+    r.accountNumber = accountNumber;
+    r.terminalId = terminalId;
+    return r;
+}
+
+// --- Journal ---
+
+Journal::Journal(const std::string& path, JournalOptions opts) : options(opts), journalPath(path) {
+    if (options.groupSize == 0) options.groupSize = 1;
+    file = AppendFile::open(path);
+    recoverTail();
+    if (options.segmentBytes > 0 && (options.compressSegments || options.indexSegments)) {
+        recoverSegments();
+        segmentWorker = std::thread(&Journal::segmentLoop, this);
+    }
+    if (options.durability != Durability::PerTransaction) {
+        pending.reserve(options.groupSize);
+        flusher = std::thread(&Journal::flusherLoop, this);
+    }
+}
+
+Journal::~Journal() {
+    if (flusher.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        pendingChanged.notify_all();
+        flusher.join();
+    }
+    // The segment in hand is finished; the rest wait for the next open.
+    if (segmentWorker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(segmentMutex);
+            stoppingSegments = true;
+        }
+        segmentsChanged.notify_all();
+        segmentWorker.join();
+    }
+}
+
+void Journal::recoverTail() {
+    std::uint64_t size = file.size();
+    std::uint64_t end = size - size % sizeof(JournalRecord);
+
+    // Only the last group can be torn, so walk back from the end until a
+    // record validates instead of reading the whole file.
+    std::ifstream in(file.path(), std::ios::binary);
+    JournalRecord last{};
+    while (end > 0) {
+        in.seekg(static_cast<std::streamoff>(end - sizeof(JournalRecord)));
+        if (in.read(reinterpret_cast<char*>(&last), sizeof(last)) && last.isValid()) break;
+        in.clear();
+        end -= sizeof(JournalRecord);
+    }
+    if (end != size) file.truncate(end);
+    if (end > 0) {
+        nextLsn = last.lsn + 1;
+    } else {
+        // A new active file carries on from the newest sealed segment
+        // (compaction always leaves that one in place).
+        std::vector<JournalSegment> segments = listJournalSegments(journalPath);
+        for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
+            if (it->lastLsn == 0) continue;
+            nextLsn = it->lastLsn + 1;
+            break;
+        }
+    }
+    activeBytes = end;
+    activeFirstLsn = nextLsn - end / sizeof(JournalRecord);
+    durable.store(nextLsn - 1, std::memory_order_release);
+}
+
+void Journal::recoverSegments() {
+    for (const JournalSegment& segment : listJournalSegments(journalPath)) {
+        std::string raw = sealedSegmentPath(journalPath, segment.firstLsn);
+        std::string packed = compressedSegmentPath(journalPath, segment.firstLsn);
+        std::string index = segmentIndexPath(journalPath, segment.firstLsn);
+        std::remove((packed + ".tmp").c_str());
+        std::remove((index + ".tmp").c_str());
+        bool queue = options.indexSegments && !fileExists(index);
+        if (!segment.compressed) {
+            queue = queue || options.compressSegments;
+        } else if (fileExists(raw)) {
+            // Both copies: a crash came between the swap's rename and the
+            // raw file's removal, or the compressed one is damaged.
+            if (segment.lastLsn != 0) {
+                std::remove(raw.c_str());
+            } else {
+                std::remove(packed.c_str());
+                queue = true;
+            }
+        }
+        if (queue) segmentQueue.push_back(segment.firstLsn);
+    }
+}
+
+std::uint64_t Journal::lastLsn() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return nextLsn - 1;
+}
+
+void Journal::writeBatch(const JournalRecord* records, std::size_t count) {
+    // A seal that could not reopen the active file left it closed.
+    if (!file.isOpen()) file = AppendFile::open(journalPath);
+    try {
+        file.write(records, count * sizeof(JournalRecord));
+        file.datasync();
+    } catch (...) {
+        // Callers take back whatever append() refused, so no part of the
+        // batch may be left for replay to find.
+        try {
+            file.truncate(activeBytes);
+        } catch (const std::exception&) {
+            // The original error is the one to report.
+        }
+        throw;
+    }
+    recordCount.fetch_add(count, std::memory_order_relaxed);
+    syncCount.fetch_add(1, std::memory_order_relaxed);
+    activeBytes += count * sizeof(JournalRecord);
+}
+
+// Called by whichever thread writes (the flusher, or an appender holding
+// the lock in PerTransaction mode) once everything up to lastWritten is
+// durable and published, so a failure here never fails an append: it is
+// kept for segmentError() and the active file is sealed (or reopened)
+// after a later write.
+void Journal::sealActive(std::uint64_t lastWritten) {
+    if (options.segmentBytes == 0 || activeBytes < options.segmentBytes) return;
+    std::string sealedPath = sealedSegmentPath(journalPath, activeFirstLsn);
+    file.close();
+    bool moved = std::rename(journalPath.c_str(), sealedPath.c_str()) == 0;
+    try {
+        file = AppendFile::open(journalPath);
+    } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(segmentMutex);
+        segmentFailure = e.what();
+    }
+    if (!moved) {
+        // Keep appending to the same file and try again after the next write.
+        std::lock_guard<std::mutex> lock(segmentMutex);
+        segmentFailure = "Cannot move " + journalPath + " to " + sealedPath;
+        return;
+    }
+    sealedCount.fetch_add(1, std::memory_order_relaxed);
+    std::uint64_t sealedFirst = activeFirstLsn;
+    activeFirstLsn = lastWritten + 1;
+    activeBytes = 0;
+    if (segmentWorker.joinable()) {
+        std::lock_guard<std::mutex> lock(segmentMutex);
+        segmentQueue.push_back(sealedFirst);
+        segmentsChanged.notify_all();
+    }
+}
+
+// Indexes each queued segment if it has no index yet, then compresses it
+// if it is still raw. The work is done unlocked; the results are swapped in
+// under segmentMutex, unless compaction removed the segment meanwhile.
+void Journal::segmentLoop() {
+    std::unique_lock<std::mutex> lock(segmentMutex);
+    for (;;) {
+        segmentsChanged.wait(lock, [&] { return stoppingSegments || !segmentQueue.empty(); });
+        if (stoppingSegments) break;
+        std::uint64_t firstLsn = segmentQueue.front();
+        segmentQueue.erase(segmentQueue.begin());
+        segmentBusy = true;
+        lock.unlock();
+
+        std::string raw = sealedSegmentPath(journalPath, firstLsn);
+        std::string packed = compressedSegmentPath(journalPath, firstLsn);
+        std::string index = segmentIndexPath(journalPath, firstLsn);
+        bool isRaw = fileExists(raw);
+        bool indexing = options.indexSegments && !fileExists(index);
+        bool compressing = options.compressSegments && isRaw;
+        std::string indexError, compressError;
+        if (indexing) {
+            JournalSegment segment;
+            segment.path = isRaw ? raw : packed;
+            segment.firstLsn = firstLsn;
+            segment.compressed = !isRaw;
+            try {
+                indexJournalSegment(segment, index + ".tmp");
+            } catch (const std::exception& e) {
+                indexError = e.what();
+            }
+        }
+        if (compressing) {
+            try {
+                compressJournalSegment(raw, packed + ".tmp");
+            } catch (const std::exception& e) {
+                compressError = e.what();
+            }
+        }
+
+        lock.lock();
+        if (indexing) {
+            if (!indexError.empty() || (!fileExists(raw) && !fileExists(packed))) {
+                std::remove((index + ".tmp").c_str());   // failed, or compacted meanwhile
+            } else if (renameOver(index + ".tmp", index)) {
+                indexedCount.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                std::remove((index + ".tmp").c_str());
+                indexError = "Cannot move " + index + ".tmp to " + index;
+            }
+        }
+        if (compressing) {
+            if (!compressError.empty() || !fileExists(raw)) {
+                std::remove((packed + ".tmp").c_str());
+            } else if (renameOver(packed + ".tmp", packed)) {
+                std::remove(raw.c_str());
+                compressedCount.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                std::remove((packed + ".tmp").c_str());
+                compressError = "Cannot move " + packed + ".tmp to " + packed;
+            }
+        }
+        if (!indexError.empty()) segmentFailure = indexError;
+        if (!compressError.empty()) segmentFailure = compressError;
+        segmentBusy = false;
+        segmentsChanged.notify_all();
+    }
+}
+
+std::size_t Journal::compact(std::uint64_t coveredLsn) {
+    std::lock_guard<std::mutex> lock(segmentMutex);
+    std::size_t removed = compactJournalSegments(journalPath, coveredLsn);
+    segmentQueue.erase(std::remove_if(segmentQueue.begin(), segmentQueue.end(),
+                                      [&](std::uint64_t first) {
+                                          return !fileExists(sealedSegmentPath(journalPath, first)) &&
+                                                 !fileExists(compressedSegmentPath(journalPath, first));
+                                      }),
+                       segmentQueue.end());
+    return removed;
+}
+
+void Journal::finishSegments() {
+    std::unique_lock<std::mutex> lock(segmentMutex);
+    segmentsChanged.wait(lock, [&] { return stoppingSegments || (segmentQueue.empty() && !segmentBusy); });
+}
+
+std::string Journal::segmentError() const {
+    std::lock_guard<std::mutex> lock(segmentMutex);
+    return segmentFailure;
+}
+
+std::uint64_t Journal::append(JournalRecord record) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (options.durability == Durability::Async) {
+        // Async appenders do not wait for syncs, so cap the backlog they can
+        // build up ahead of the flusher.
+        durableChanged.wait(lock, [&] {
+            return pending.size() < kMaxPendingGroups * options.groupSize || !failure.empty();
+        });
+    }
+    if (!failure.empty()) throw std::runtime_error(failure);
+
+    record.lsn = nextLsn++;
+    if (record.txnId == 0) record.txnId = record.lsn;
+    record.timestampUs = nowMicros();
+    record.checksum = recordChecksum(record);
+
+    if (options.durability == Durability::PerTransaction) {
+        // Holding the lock keeps file order equal to LSN order.
+        try {
+            writeBatch(&record, 1);
+        } catch (const std::exception& e) {
+            failure = e.what();
+            throw;
+        }
+        durable.store(record.lsn, std::memory_order_release);
+        sealActive(record.lsn);
+        return record.lsn;
+    }
+
+    if (pending.empty()) oldestPending = std::chrono::steady_clock::now();
+    pending.push_back(record);
+    // The first record opens the group window; a full group closes it early.
+    if (pending.size() == 1 || pending.size() >= options.groupSize) pendingChanged.notify_one();
+
+    if (options.durability == Durability::Grouped) waitLocked(lock, record.lsn);
+    return record.lsn;
+}
+
+std::uint64_t Journal::append(JournalRecord* records, std::size_t count) {
+    if (count == 0) return lastLsn();
+    std::unique_lock<std::mutex> lock(mutex);
+    if (options.durability == Durability::Async) {
+        durableChanged.wait(lock, [&] {
+            return pending.size() < kMaxPendingGroups * options.groupSize || !failure.empty();
+        });
+    }
+    if (!failure.empty()) throw std::runtime_error(failure);
+
+    std::int64_t now = nowMicros();
+    for (std::size_t i = 0; i < count; ++i) {
+        JournalRecord& record = records[i];
+        record.lsn = nextLsn++;
+        if (record.txnId == 0) record.txnId = record.lsn;
+        record.timestampUs = now;
+        record.checksum = recordChecksum(record);
+    }
+    std::uint64_t last = records[count - 1].lsn;
+
+    if (options.durability == Durability::PerTransaction) {
+        try {
+            writeBatch(records, count);
+        } catch (const std::exception& e) {
+            failure = e.what();
+            throw;
+        }
+        durable.store(last, std::memory_order_release);
+        sealActive(last);
+        return last;
+    }
+
+    if (pending.empty()) oldestPending = std::chrono::steady_clock::now();
+    pending.insert(pending.end(), records, records + count);
+    pendingChanged.notify_one();
+
+    if (options.durability == Durability::Grouped) waitLocked(lock, last);
+    return last;
+}
+
+void Journal::waitLocked(std::unique_lock<std::mutex>& lock, std::uint64_t lsn) {
+    durableChanged.wait(lock, [&] {
+        return durable.load(std::memory_order_acquire) >= lsn || !failure.empty();
+    });
+    if (durable.load(std::memory_order_acquire) < lsn) throw std::runtime_error(failure);
+}
+
+void Journal::waitDurable(std::uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (durable.load(std::memory_order_acquire) >= lsn) return;
+    if (flusher.joinable()) {
+        flushRequested = true;
+        pendingChanged.notify_one();
+    }
+    waitLocked(lock, lsn);
+}
+
+void Journal::flush() {
+    waitDurable(lastLsn());
+}
+
+void Journal::flusherLoop() {
+    std::vector<JournalRecord> batch;
+    batch.reserve(options.groupSize);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        pendingChanged.wait(lock, [&] { return stopping || !pending.empty(); });
+        if (pending.empty()) break;   // stopping with nothing left to write
+
+        // Let the group fill up until it is big enough, its window closes,
+        // someone needs it now, or the journal is shutting down.
+        pendingChanged.wait_until(lock, oldestPending + options.groupWindow, [&] {
+            return stopping || flushRequested || pending.size() >= options.groupSize;
+        });
+        flushRequested = false;
+        batch.swap(pending);
+        lock.unlock();
+
+        std::string error;
+        try {
+            writeBatch(batch.data(), batch.size());
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+
+        std::uint64_t written = batch.back().lsn;
+        lock.lock();
+        if (error.empty()) {
+            durable.store(written, std::memory_order_release);
+        } else {
+            failure = error;
+        }
+        batch.clear();
+        durableChanged.notify_all();
+        if (!failure.empty()) break;
+
+        lock.unlock();
+        sealActive(written);
+        lock.lock();
+    }
+}
+
+// --- JournalReader ---
+
+JournalReader::JournalReader(const std::string& path) : journalPath(path), active(path, std::ios::binary) {
+    // The active file is opened before the segments are listed. If it is
+    // sealed in between, the stream still reads it under its new name, and
+    // its first LSN shows which listed segment it already is.
+    std::vector<JournalSegment> segments = listJournalSegments(path);
+    std::uint64_t activeFirst = 0;
+    std::uint64_t activeBytes = 0;
+    if (active.is_open()) {
+        JournalRecord first;
+        if (active.read(reinterpret_cast<char*>(&first), sizeof(first)) && first.isValid()) activeFirst = first.lsn;
+        active.clear();
+        active.seekg(0, std::ios::end);
+        activeBytes = static_cast<std::uint64_t>(active.tellg());
+        active.seekg(0);
+    }
+    for (const JournalSegment& s : segments) {
+        if (activeFirst != 0 && s.firstLsn >= activeFirst) continue;
+        sources.push_back(Source{s.path, s.firstLsn, s.records() * sizeof(JournalRecord), s.compressed, false});
+        total += sources.back().bytes;
+    }
+    sources.push_back(Source{path, activeFirst, activeBytes, false, true});
+    total += activeBytes;
+    openSource(0, 0);
+}
+
+JournalReader::~JournalReader() = default;
+
+void JournalReader::openSource(std::size_t index, std::uint64_t lsn) {
+    // Seeks within the compressed segment already open keep its index.
+    bool reuse = segment && index == current;
+    current = index;
+    if (!reuse) segment.reset();
+    sealed.close();
+    sealed.clear();
+    pos = filled = 0;
+    nextBlock = 0;
+    skipRecords = 0;
+    if (index >= sources.size()) return;
+
+    Source& s = sources[index];
+    std::uint64_t skip = s.firstLsn != 0 && lsn > s.firstLsn ? lsn - s.firstLsn : 0;
+    if (s.isActive || !s.compressed) {
+        std::ifstream& in = s.isActive ? active : sealed;
+        if (!s.isActive) in.open(s.path, std::ios::binary);
+        if (in.is_open()) {
+            in.clear();
+            in.seekg(static_cast<std::streamoff>(skip * sizeof(JournalRecord)));
+            return;
+        }
+        if (s.isActive) return;
+        // Compressed since the listing.
+        s.path = compressedSegmentPath(journalPath, s.firstLsn);
+        s.compressed = true;
+    }
+    if (!reuse) {
+        if (!fileExists(s.path)) return;   // compacted since the listing
+        try {
+            segment = std::make_unique<CompressedSegment>(CompressedSegment::open(s.path));
+        } catch (const std::exception&) {
+            corrupt = true;
+            return;
+        }
+    }
+    nextBlock = segment->blockFor(lsn);
+    if (nextBlock < segment->blockCount() && lsn > segment->block(nextBlock).firstLsn) {
+        skipRecords = lsn - segment->block(nextBlock).firstLsn;
+    }
+}
+
+bool JournalReader::fill() {
+    while (!corrupt && current < sources.size()) {
+        const Source& s = sources[current];
+        if (segment) {
+            if (nextBlock < segment->blockCount()) {
+                if (!segment->readBlock(nextBlock++, buffer)) {
+                    corrupt = true;
+                    return false;
+                }
+                blocksDecoded++;
+                filled = buffer.size();
+                pos = static_cast<std::size_t>(std::min<std::uint64_t>(skipRecords, filled));
+                skipRecords = 0;
+                if (pos < filled) return true;
+                continue;
+            }
+        } else if (!s.compressed) {
+            std::ifstream& in = s.isActive ? active : sealed;
+            if (in.is_open()) {
+                buffer.resize(kReadRecords);
+                in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(JournalRecord)));
+                filled = static_cast<std::size_t>(in.gcount()) / sizeof(JournalRecord);
+                pos = 0;
+                if (filled > 0) return true;
+            }
+        }
+        openSource(current + 1, 0);
+    }
+    return false;
+}
+
+void JournalReader::seek(std::uint64_t lsn) {
+    corrupt = false;
+    good = 0;
+    std::size_t index = 0;
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        if (sources[i].firstLsn != 0 && sources[i].firstLsn <= lsn) index = i;
+    }
+    for (std::size_t i = 0; i < index; i++) good += sources[i].bytes;
+    if (sources[index].firstLsn != 0 && lsn > sources[index].firstLsn) {
+        good += std::min(sources[index].bytes, (lsn - sources[index].firstLsn) * sizeof(JournalRecord));
+    }
+    openSource(index, lsn);
+}
+
+bool JournalReader::next(JournalRecord& record) {
+    if (corrupt) return false;
+    if (pos == filled && !fill()) return false;
+    if (!buffer[pos].isValid()) {
+        corrupt = true;
+        return false;
+    }
+    record = buffer[pos++];
+    good += sizeof(JournalRecord);
+    return true;
+}
+
+} // namespace atm
@@ -0,0 +1,244 @@
+#ifndef ATM_JOURNAL_H
+#define ATM_JOURNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "append_file.h"
+#include "money.h"
+
+namespace atm {
+
+enum class TxnType : std::uint16_t {
+    Deposit = 1,
+    Withdrawal = 2,
+    Credit = 3,     // book entries: transfers in, interest
+    Debit = 4       // book entries: transfers out, fees
+};
+
+// "Deposit", "Withdrawal", ... as shown on statements.
+const char* txnTypeName(TxnType type);
+
+// One journal entry: 64 bytes, native byte order, CRC-32 over the first 60.
+struct JournalRecord {
+    std::uint32_t magic;
+    std::uint16_t type;
+    std::uint16_t reserved;
+    std::uint64_t lsn;          // assigned by Journal::append, strictly increasing
+    std::uint64_t txnId;        // caller's transaction reference (the LSN if left 0)
+    std::int64_t timestampUs;   // wall clock, microseconds since the Unix epoch
+    Money amount;
+    Money balanceAfter;
+    std::int32_t accountNumber;
+    std::uint32_t terminalId;
+    std::uint32_t reserved2;
+    std::uint32_t checksum;
+
+    TxnType txnType() const { return static_cast<TxnType>(type); }
+    // The signed change this entry makes to the account balance.
+    Money delta() const;
+    bool isValid() const;
+};
+
+JournalRecord makeJournalRecord(TxnType type, int accountNumber, Money amount, Money balanceAfter,
+                                std::uint32_t terminalId, std::uint64_t txnId = 0);
+
+enum class Durability {
+    PerTransaction,   // every append is written and synced on its own
+    Grouped,          // appends wait for a shared sync (group commit)
+    Async             // appends return once queued; syncs happen in the background
+};
+
+struct JournalOptions {
+    Durability durability = Durability::Grouped;
+    // A group is synced once this many records are pending...
+    std::size_t groupSize = 512;
+    // ...or once the oldest pending record has waited this long.
+    std::chrono::microseconds groupWindow{200};
+    // The active file is sealed into a segment once it reaches this size
+    // (0: one file that grows for ever). See journal_segments.h.
+    std::uint64_t segmentBytes = std::uint64_t(64) << 20;
+    // Sealed segments are compressed by a background thread...
+    bool compressSegments = true;
+    // ...which also writes each one's account and time index, for
+    // queryJournal() (journal_index.h).
+    bool indexSegments = true;
+};
+
+// Append-only, checksummed transaction journal.
+//
+// Callers record a deposit or withdrawal here before acknowledging it.
+// In Grouped and Async modes a background flusher writes whatever has
+// accumulated as one batch followed by a single data sync, so the sync
+// cost is shared by every transaction in the batch.
+//
+// On open, a torn tail left by a crash (a partial or mis-checksummed last
+// record) is cut off and numbering continues after the last good record.
+// Sealed segments left uncompressed or unindexed by a shutdown or crash
+// are compressed and indexed then.
+class Journal {
+public:
+    explicit Journal(const std::string& path, JournalOptions options = JournalOptions());
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Stamps the record with the next LSN, a timestamp and its checksum,
+    // and returns the LSN once it is as durable as the mode promises.
+    // Throws std::runtime_error if the journal can no longer be written;
+    // a failed write is cut back off the file, so a record append() threw
+    // for is never found by a later replay (except in Async mode, which
+    // returns before the write).
+    std::uint64_t append(JournalRecord record);
+    // Appends count records as one contiguous run of LSNs, stamping them in
+    // place, and returns the last LSN. Meant for batch jobs posting many
+    // entries at once: one lock, one wait, and in PerTransaction mode one
+    // write and sync for the whole run.
+    std::uint64_t append(JournalRecord* records, std::size_t count);
+
+    // Blocks until every record up to and including lsn is on disk.
+    void waitDurable(std::uint64_t lsn);
+    // Blocks until everything appended so far is on disk.
+    void flush();
+
+    std::uint64_t lastLsn() const;
+    std::uint64_t durableLsn() const { return durable.load(std::memory_order_acquire); }
+    // Path of the active file; sealed segments are named after it.
+    const std::string& path() const { return journalPath; }
+
+    // Deletes the sealed segments whose records all have LSNs up to
+    // coveredLsn, typically the LSN of a snapshot already on disk, and
+    // returns how many it deleted. The active file is never touched.
+    std::size_t compact(std::uint64_t coveredLsn);
+    // Blocks until every segment sealed so far has been compressed and
+    // indexed.
+    void finishSegments();
+    // Message of the last failed seal, segment compression or indexing,
+    // empty if none. None of them fails an append: a seal is retried after
+    // the next write, and a segment stays readable and is retried on the
+    // next open.
+    std::string segmentError() const;
+
+    struct Stats {
+        std::uint64_t records;
+        std::uint64_t syncs;
+        std::uint64_t segmentsSealed;
+        std::uint64_t segmentsCompressed;
+        std::uint64_t segmentsIndexed;
+    };
+    Stats stats() const {
+        return Stats{recordCount.load(), syncCount.load(), sealedCount.load(), compressedCount.load(),
+                     indexedCount.load()};
+    }
+
+private:
+    JournalOptions options;
+    std::string journalPath;
+    AppendFile file;               // the active segment; only the writer touches it
+    std::uint64_t activeFirstLsn = 1;
+    std::uint64_t activeBytes = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable pendingChanged;   // wakes the flusher
+    std::condition_variable durableChanged;   // wakes appenders waiting on a sync
+    std::vector<JournalRecord> pending;
+    std::chrono::steady_clock::time_point oldestPending;
+    std::uint64_t nextLsn = 1;
+    bool flushRequested = false;
+    bool stopping = false;
+    std::string failure;
+
+    std::atomic<std::uint64_t> durable{0};
+    std::atomic<std::uint64_t> recordCount{0};
+    std::atomic<std::uint64_t> syncCount{0};
+    std::thread flusher;
+
+    // Sealed segments: the work queue, and the renames and deletes of
+    // compression, indexing and compaction, are serialized by segmentMutex.
+    mutable std::mutex segmentMutex;
+    std::condition_variable segmentsChanged;
+    std::vector<std::uint64_t> segmentQueue;   // first LSNs of segments to compress or index
+    bool segmentBusy = false;
+    bool stoppingSegments = false;
+    std::string segmentFailure;
+    std::atomic<std::uint64_t> sealedCount{0};
+    std::atomic<std::uint64_t> compressedCount{0};
+    std::atomic<std::uint64_t> indexedCount{0};
+    std::thread segmentWorker;
+
+    void recoverTail();
+    void recoverSegments();
+    void flusherLoop();
+    void segmentLoop();
+    void writeBatch(const JournalRecord* records, std::size_t count);
+    void sealActive(std::uint64_t lastWritten);
+    void waitLocked(std::unique_lock<std::mutex>& lock, std::uint64_t lsn);
+};
+
+class CompressedSegment;
+
+// Sequential reader over a journal: its sealed segments, oldest first, then
+// the active file. Stops at the end or at the first record that fails its
+// checksum (a torn tail), or a compressed block that fails its own.
+// Segments compacted away while the reader is open are skipped.
+class JournalReader {
+public:
+    explicit JournalReader(const std::string& path);
+    ~JournalReader();
+
+    // Positions the reader so next() starts at the record with the given
+    // LSN (or the end of the journal). LSNs are dense, so this is a seek
+    // within one segment, decompressing only the block that holds it,
+    // rather than a scan.
+    void seek(std::uint64_t lsn);
+    bool next(JournalRecord& record);
+    bool isOpen() const { return active.is_open() || sources.size() > 1; }
+    // Bytes covered by the records returned so far.
+    std::uint64_t validBytes() const { return good; }
+    // Bytes of records in the journal when it was opened, compressed
+    // segments counted at their uncompressed size.
+    std::uint64_t totalBytes() const { return total; }
+    // Compressed blocks decoded so far.
+    std::uint64_t blocksRead() const { return blocksDecoded; }
+
+private:
+    struct Source {
+        std::string path;
+        std::uint64_t firstLsn;   // 0: the active file, which was empty
+        std::uint64_t bytes;      // of records, uncompressed
+        bool compressed;
+        bool isActive;
+    };
+
+    std::string journalPath;
+    std::vector<Source> sources;   // sealed segments, then the active file
+    std::size_t current = 0;
+    std::ifstream active;          // opened first, so a segment sealed meanwhile is not missed
+    std::ifstream sealed;
+    std::unique_ptr<CompressedSegment> segment;
+    std::size_t nextBlock = 0;
+    std::uint64_t skipRecords = 0;   // to drop from the next compressed block, after a seek
+    std::vector<JournalRecord> buffer;
+    std::size_t pos = 0;
+    std::size_t filled = 0;
+    std::uint64_t good = 0;
+    std::uint64_t total = 0;
+    std::uint64_t blocksDecoded = 0;
+    bool corrupt = false;
+
+    void openSource(std::size_t index, std::uint64_t lsn);
+    bool fill();
+};
+
+} // namespace atm
+
+#endif // ATM_JOURNAL_H
@@ -0,0 +1,472 @@
+#include "journal_columns.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+#include "checksum.h"
+#include "journal.h"
+#include "parallel.h"
+
+namespace atm {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'G', 'A', 'T', 'M', 'C', 'O', 'L'};
+constexpr std::uint32_t kFormatVersion = 1;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t columns;
+};
+
+// At the start of every chunk. Values decode as reference + step * packed
+// (FrameOfReference), the running sum of first and such deltas (Delta), or
+// dictionary[packed] (Dictionary, with dictionarySize entries following).
+struct ChunkHeader {
+    std::uint8_t encoding;
+    std::uint8_t bitWidth;
+    std::uint16_t reserved;
+    std::uint32_t dictionarySize;
+    std::int64_t first;
+    std::int64_t reference;
+    std::uint64_t step;
+};
+
+// Footer entry per chunk; ColumnFile::ChunkInfo without the padding, so
+// the bytes on disk are fully defined.
+struct FooterChunk {
+    std::uint64_t offset;
+    std::uint64_t bytes;
+    std::int64_t min;
+    std::int64_t max;
+    std::uint8_t encoding;
+    std::uint8_t bitWidth;
+    std::uint16_t reserved;
+    std::uint32_t checksum;
+};
+
+struct Trailer {
+    std::uint64_t footerOffset;
+    std::uint64_t rowGroups;
+    std::uint64_t rows;
+    std::uint32_t footerChecksum;
+    std::uint32_t reserved;
+    char magic[8];
+};
+
+static_assert(sizeof(ChunkHeader) == 32, "Chunks stay 8-byte aligned");
+static_assert(sizeof(FooterChunk) == 40, "Column file footer layout");
+static_assert(sizeof(Trailer) == 40, "Column file trailer layout");
+
+// Each column's encoding: timestamps and the increasing IDs as deltas,
+// terminal IDs through a dictionary, the rest as frame of reference.
+constexpr ColumnEncoding kEncodings[kJournalColumns] = {
+    ColumnEncoding::Delta,              // Lsn
+    ColumnEncoding::Delta,              // Timestamp
+    ColumnEncoding::FrameOfReference,   // Type
+    ColumnEncoding::FrameOfReference,   // Account
+    ColumnEncoding::FrameOfReference,   // Amount
+    ColumnEncoding::FrameOfReference,   // BalanceAfter
+    ColumnEncoding::Dictionary,         // Terminal
+    ColumnEncoding::Delta               // TxnId
+};
+
+std::int64_t columnValue(const JournalRecord& r, std::size_t column) {
+    switch (static_cast<JournalColumn>(column)) {
+        case JournalColumn::Lsn: return static_cast<std::int64_t>(r.lsn);
+        case JournalColumn::Timestamp: return r.timestampUs;
+        case JournalColumn::Type: return r.type;
+        case JournalColumn::Account: return r.accountNumber;
+        case JournalColumn::Amount: return r.amount;
+        case JournalColumn::BalanceAfter: return r.balanceAfter;
+        case JournalColumn::Terminal: return r.terminalId;
+        case JournalColumn::TxnId: return static_cast<std::int64_t>(r.txnId);
+        case JournalColumn::Count: break;
+    }
+    return 0;
+}
+
+std::uint8_t bitsFor(std::uint64_t value) {
+    std::uint8_t bits = 0;
+    while (value) {
+        bits++;
+        value >>= 1;
+    }
+    return bits;
+}
+
+std::size_t wordsFor(std::size_t count, unsigned width) {
+    return (count * width + 63) / 64;
+}
+
+// Appends count values of width bits each, least significant bit first.
+void pack(const std::uint64_t* values, std::size_t count, unsigned width, std::vector<std::uint64_t>& out) {
+    std::size_t base = out.size();
+    out.resize(base + wordsFor(count, width), 0);
+    if (width == 0) return;
+    std::uint64_t* words = out.data() + base;
+    std::size_t bit = 0;
+    for (std::size_t i = 0; i < count; i++, bit += width) {
+        std::size_t word = bit / 64;
+        unsigned shift = bit % 64;
+        words[word] |= values[i] << shift;
+        if (shift + width > 64) words[word + 1] |= values[i] >> (64 - shift);
+    }
+}
+
+void unpack(const std::uint64_t* words, std::size_t count, unsigned width, std::uint64_t* out) {
+    if (width == 0) {
+        std::fill(out, out + count, 0);
+        return;
+    }
+    std::uint64_t mask = width == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << width) - 1;
+    std::size_t bit = 0;
+    for (std::size_t i = 0; i < count; i++, bit += width) {
+        std::size_t word = bit / 64;
+        unsigned shift = bit % 64;
+        std::uint64_t v = words[word] >> shift;
+        if (shift + width > 64) v |= words[word + 1] << (64 - shift);
+        out[i] = v & mask;
+    }
+}
+
+// Frame of reference over values: fills reference and step in h and the
+// offsets to pack in packed.
+void frameOfReference(const std::int64_t* values, std::size_t count, ChunkHeader& h, std::vector<std::uint64_t>& packed) {
+    std::int64_t min = count ? *std::min_element(values, values + count) : 0;
+    std::uint64_t step = 0;
+    packed.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        packed[i] = static_cast<std::uint64_t>(values[i]) - static_cast<std::uint64_t>(min);
+        if (step != 1) step = std::gcd(step, packed[i]);   // most columns reach 1 within a few values
+    }
+    if (step == 0) step = 1;
+    std::uint64_t largest = 0;
+    for (std::uint64_t p : packed) largest = std::max(largest, p);
+    if (step > 1) {
+        for (std::uint64_t& p : packed) p /= step;
+        largest /= step;
+    }
+    h.reference = min;
+    h.step = step;
+    h.bitWidth = bitsFor(largest);
+}
+
+// Encodes one column chunk onto the end of out.
+void encodeChunk(const std::vector<std::int64_t>& values, ColumnEncoding encoding, std::vector<std::uint64_t>& out,
+                 std::vector<std::int64_t>& scratch, std::vector<std::uint64_t>& packed) {
+    ChunkHeader h{};
+    h.encoding = static_cast<std::uint8_t>(encoding);
+    std::size_t count = values.size();
+    std::vector<std::int64_t> dictionary;
+
+    switch (encoding) {
+        case ColumnEncoding::Delta:
+            h.first = count ? values[0] : 0;
+            scratch.resize(count ? count - 1 : 0);
+            for (std::size_t i = 1; i < count; i++) {
+                scratch[i - 1] = static_cast<std::int64_t>(static_cast<std::uint64_t>(values[i]) -
+                                                           static_cast<std::uint64_t>(values[i - 1]));
+            }
+            frameOfReference(scratch.data(), scratch.size(), h, packed);
+            break;
+        case ColumnEncoding::FrameOfReference:
+            frameOfReference(values.data(), count, h, packed);
+            break;
+        case ColumnEncoding::Dictionary:
+            // Dictionary columns have few distinct values, so collecting
+            // them into a sorted vector beats sorting a copy of the chunk.
+            for (std::int64_t v : values) {
+                auto at = std::lower_bound(dictionary.begin(), dictionary.end(), v);
+                if (at == dictionary.end() || *at != v) dictionary.insert(at, v);
+            }
+            packed.resize(count);
+            for (std::size_t i = 0; i < count; i++) {
+                packed[i] = static_cast<std::uint64_t>(
+                    std::lower_bound(dictionary.begin(), dictionary.end(), values[i]) - dictionary.begin());
+            }
+            h.dictionarySize = static_cast<std::uint32_t>(dictionary.size());
+            h.step = 1;
+            h.bitWidth = bitsFor(dictionary.empty() ? 0 : dictionary.size() - 1);
+            break;
+    }
+
+    std::size_t base = out.size();
+    out.resize(base + sizeof(ChunkHeader) / 8 + dictionary.size());
+    std::memcpy(out.data() + base, &h, sizeof(h));
+    if (!dictionary.empty()) {
+        std::memcpy(out.data() + base + sizeof(ChunkHeader) / 8, dictionary.data(), dictionary.size() * sizeof(std::int64_t));
+    }
+    pack(packed.data(), packed.size(), h.bitWidth, out);
+}
+
+struct EncodedGroup {
+    std::vector<std::uint64_t> words;   // every chunk, back to back
+    ColumnFile::RowGroup info;          // chunk offsets relative to words
+};
+
+void encodeGroup(const JournalRecord* records, std::size_t rows, EncodedGroup& group) {
+    std::vector<std::int64_t> values(rows), scratch;
+    std::vector<std::uint64_t> packed;
+    group.words.clear();
+    group.info.rows = rows;
+    for (std::size_t c = 0; c < kJournalColumns; c++) {
+        for (std::size_t i = 0; i < rows; i++) values[i] = columnValue(records[i], c);
+        std::size_t start = group.words.size();
+        encodeChunk(values, kEncodings[c], group.words, scratch, packed);
+
+        ColumnFile::ChunkInfo& chunk = group.info.chunks[c];
+        chunk.offset = start * 8;
+        chunk.bytes = (group.words.size() - start) * 8;
+        auto range = std::minmax_element(values.begin(), values.end());
+        chunk.min = rows ? *range.first : 0;
+        chunk.max = rows ? *range.second : 0;
+        const ChunkHeader* h = reinterpret_cast<const ChunkHeader*>(group.words.data() + start);
+        chunk.encoding = static_cast<ColumnEncoding>(h->encoding);
+        chunk.bitWidth = h->bitWidth;
+        chunk.checksum = crc32(group.words.data() + start, chunk.bytes);
+    }
+}
+
+[[noreturn]] void malformed(const std::string& path, const char* why) {
+    throw std::runtime_error("Column file " + path + " is not usable: " + why);
+}
+
+} // namespace
+
+const char* journalColumnName(JournalColumn column) {
+    switch (column) {
+        case JournalColumn::Lsn: return "lsn";
+        case JournalColumn::Timestamp: return "timestamp";
+        case JournalColumn::Type: return "type";
+        case JournalColumn::Account: return "account";
+        case JournalColumn::Amount: return "amount";
+        case JournalColumn::BalanceAfter: return "balance";
+        case JournalColumn::Terminal: return "terminal";
+        case JournalColumn::TxnId: return "txn";
+        case JournalColumn::Count: break;
+    }
+    return "unknown";
+}
+
+bool parseJournalColumn(const std::string& name, JournalColumn* column) {
+    for (std::size_t c = 0; c < kJournalColumns; c++) {
+        if (name == journalColumnName(static_cast<JournalColumn>(c))) {
+            *column = static_cast<JournalColumn>(c);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* columnEncodingName(ColumnEncoding encoding) {
+    switch (encoding) {
+        case ColumnEncoding::Delta: return "delta";
+        case ColumnEncoding::FrameOfReference: return "frame-of-reference";
+        case ColumnEncoding::Dictionary: return "dictionary";
+    }
+    return "unknown";
+}
+
+ColumnExportStats exportJournalColumns(const std::string& journalPath, const std::string& outputPath,
+                                       ColumnExportOptions options) {
+    auto start = std::chrono::steady_clock::now();
+    ColumnExportStats stats;
+    if (options.rowGroupRows == 0) options.rowGroupRows = 1;
+    unsigned threads = resolveThreads(options.threads);
+    stats.threads = threads;
+
+    JournalReader reader(journalPath);
+    if (!reader.isOpen()) throw std::runtime_error("Cannot read " + journalPath);
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Cannot write " + outputPath);
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kFormatVersion;
+    header.columns = static_cast<std::uint32_t>(kJournalColumns);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::uint64_t offset = sizeof(header);
+
+    // One batch is a row group per thread: read it, encode the groups in
+    // parallel, then write them in order.
+    std::vector<JournalRecord> batch(options.rowGroupRows * threads);
+    std::vector<EncodedGroup> encoded(threads);
+    std::vector<FooterChunk> footer;
+    std::vector<std::uint64_t> groupRows;
+    bool more = true;
+    while (more) {
+        std::size_t filled = 0;
+        JournalRecord record;
+        while (filled < batch.size() && (more = reader.next(record))) {
+            if (record.timestampUs >= options.fromUs && record.timestampUs < options.toUs) batch[filled++] = record;
+        }
+        if (filled == 0) break;
+
+        std::size_t groups = (filled + options.rowGroupRows - 1) / options.rowGroupRows;
+        unsigned workers = static_cast<unsigned>(std::min<std::size_t>(threads, groups));
+        runOnThreads(workers, [&](unsigned part) {
+            for (std::size_t g = part; g < groups; g += workers) {
+                std::size_t first = g * options.rowGroupRows;
+                encodeGroup(batch.data() + first, std::min(options.rowGroupRows, filled - first), encoded[g]);
+            }
+        });
+
+        for (std::size_t g = 0; g < groups; g++) {
+            const EncodedGroup& group = encoded[g];
+            out.write(reinterpret_cast<const char*>(group.words.data()),
+                      static_cast<std::streamsize>(group.words.size() * 8));
+            groupRows.push_back(group.info.rows);
+            for (std::size_t c = 0; c < kJournalColumns; c++) {
+                const ColumnFile::ChunkInfo& chunk = group.info.chunks[c];
+                FooterChunk f{};
+                f.offset = offset + chunk.offset;
+                f.bytes = chunk.bytes;
+                f.min = chunk.min;
+                f.max = chunk.max;
+                f.encoding = static_cast<std::uint8_t>(chunk.encoding);
+                f.bitWidth = chunk.bitWidth;
+                f.checksum = chunk.checksum;
+                footer.push_back(f);
+                stats.columnBytes[c] += chunk.bytes;
+            }
+            offset += group.words.size() * 8;
+            stats.rows += group.info.rows;
+        }
+        if (!out) throw std::runtime_error("Cannot write " + outputPath);
+    }
+
+    // Footer: per row group its row count, then its chunks.
+    Trailer trailer{};
+    trailer.footerOffset = offset;
+    trailer.rowGroups = groupRows.size();
+    trailer.rows = stats.rows;
+    std::uint32_t crc = 0;
+    for (std::size_t g = 0; g < groupRows.size(); g++) {
+        out.write(reinterpret_cast<const char*>(&groupRows[g]), sizeof(std::uint64_t));
+        out.write(reinterpret_cast<const char*>(&footer[g * kJournalColumns]), sizeof(FooterChunk) * kJournalColumns);
+        crc = crc32(&groupRows[g], sizeof(std::uint64_t), crc);
+        crc = crc32(&footer[g * kJournalColumns], sizeof(FooterChunk) * kJournalColumns, crc);
+    }
+    trailer.footerChecksum = crc;
+    std::memcpy(trailer.magic, kMagic, sizeof(kMagic));
+    out.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+    out.close();
+    if (!out) throw std::runtime_error("Cannot write " + outputPath);
+
+    stats.rowGroups = groupRows.size();
+    stats.journalBytes = stats.rows * sizeof(JournalRecord);
+    stats.fileBytes = offset + groupRows.size() * (8 + sizeof(FooterChunk) * kJournalColumns) + sizeof(trailer);
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// --- ColumnFile ---
+
+ColumnFile ColumnFile::open(const std::string& path) {
+    ColumnFile file;
+    file.filePath = path;
+    file.in.open(path, std::ios::binary);
+    if (!file.in) throw std::runtime_error("Cannot read " + path);
+
+    FileHeader header{};
+    Trailer trailer{};
+    file.in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    file.in.seekg(0, std::ios::end);
+    std::uint64_t size = static_cast<std::uint64_t>(file.in.tellg());
+    if (!file.in || size < sizeof(header) + sizeof(trailer)) malformed(path, "too short");
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) malformed(path, "not a column export");
+    if (header.formatVersion != kFormatVersion) malformed(path, "unsupported format version");
+    if (header.columns != kJournalColumns) malformed(path, "unexpected column count");
+
+    file.in.seekg(static_cast<std::streamoff>(size - sizeof(trailer)));
+    file.in.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    std::uint64_t entryBytes = 8 + sizeof(FooterChunk) * kJournalColumns;
+    if (!file.in || std::memcmp(trailer.magic, kMagic, sizeof(kMagic)) != 0 ||
+        trailer.footerOffset + trailer.rowGroups * entryBytes + sizeof(trailer) != size) {
+        malformed(path, "truncated or damaged footer");
+    }
+
+    std::vector<char> footer(trailer.rowGroups * entryBytes);
+    file.in.seekg(static_cast<std::streamoff>(trailer.footerOffset));
+    file.in.read(footer.data(), static_cast<std::streamsize>(footer.size()));
+    if (!file.in || crc32(footer.data(), footer.size()) != trailer.footerChecksum) malformed(path, "footer checksum mismatch");
+
+    file.groups.resize(trailer.rowGroups);
+    for (std::size_t g = 0; g < file.groups.size(); g++) {
+        const char* entry = footer.data() + g * entryBytes;
+        RowGroup& group = file.groups[g];
+        std::memcpy(&group.rows, entry, 8);
+        for (std::size_t c = 0; c < kJournalColumns; c++) {
+            FooterChunk f;
+            std::memcpy(&f, entry + 8 + c * sizeof(FooterChunk), sizeof(f));
+            if (f.offset % 8 != 0 || f.offset < sizeof(header) || f.bytes < sizeof(ChunkHeader) ||
+                f.offset + f.bytes > trailer.footerOffset) {
+                malformed(path, "chunk outside the data section");
+            }
+            group.chunks[c] = ChunkInfo{f.offset, f.bytes, f.min, f.max, static_cast<ColumnEncoding>(f.encoding),
+                                        f.bitWidth, f.checksum};
+        }
+        file.rowCount += group.rows;
+    }
+    if (file.rowCount != trailer.rows) malformed(path, "row count mismatch");
+    return file;
+}
+
+void ColumnFile::readColumn(std::size_t group, JournalColumn column, std::vector<std::int64_t>& out) {
+    const RowGroup& g = groups.at(group);
+    const ChunkInfo& chunk = g.chunk(column);
+    buffer.resize(chunk.bytes / 8);
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(chunk.offset));
+    in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(chunk.bytes));
+    if (!in) throw std::runtime_error("Cannot read " + filePath);
+    chunkBytesRead += chunk.bytes;
+    if (crc32(buffer.data(), chunk.bytes) != chunk.checksum) malformed(filePath, "chunk checksum mismatch");
+
+    ChunkHeader h;
+    std::memcpy(&h, buffer.data(), sizeof(h));
+    const std::uint64_t* body = buffer.data() + sizeof(ChunkHeader) / 8;
+    std::size_t rows = static_cast<std::size_t>(g.rows);
+    std::size_t packedCount = h.encoding == static_cast<std::uint8_t>(ColumnEncoding::Delta) ? (rows ? rows - 1 : 0) : rows;
+    std::size_t dictionaryWords = h.encoding == static_cast<std::uint8_t>(ColumnEncoding::Dictionary) ? h.dictionarySize : 0;
+    if (h.bitWidth > 64 || sizeof(ChunkHeader) / 8 + dictionaryWords + wordsFor(packedCount, h.bitWidth) != buffer.size()) {
+        malformed(filePath, "chunk size does not match its header");
+    }
+
+    out.resize(rows);
+    std::vector<std::uint64_t> packed(packedCount);
+    unpack(body + dictionaryWords, packedCount, h.bitWidth, packed.data());
+    switch (static_cast<ColumnEncoding>(h.encoding)) {
+        case ColumnEncoding::Delta: {
+            std::uint64_t value = static_cast<std::uint64_t>(h.first);
+            if (rows) out[0] = h.first;
+            for (std::size_t i = 1; i < rows; i++) {
+                value += static_cast<std::uint64_t>(h.reference) + h.step * packed[i - 1];
+                out[i] = static_cast<std::int64_t>(value);
+            }
+            break;
+        }
+        case ColumnEncoding::FrameOfReference:
+            for (std::size_t i = 0; i < rows; i++) {
+                out[i] = static_cast<std::int64_t>(static_cast<std::uint64_t>(h.reference) + h.step * packed[i]);
+            }
+            break;
+        case ColumnEncoding::Dictionary: {
+            const std::int64_t* dictionary = reinterpret_cast<const std::int64_t*>(body);
+            for (std::size_t i = 0; i < rows; i++) {
+                if (packed[i] >= h.dictionarySize) malformed(filePath, "dictionary index out of range");
+                out[i] = dictionary[packed[i]];
+            }
+            break;
+        }
+        default:
+            malformed(filePath, "unknown column encoding");
+    }
+}
+
+} // namespace atm
@@ -0,0 +1,127 @@
+#ifndef ATM_JOURNAL_COLUMNS_H
+#define ATM_JOURNAL_COLUMNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace atm {
+
+// Columnar journal export
+//
+// Analytics reads a few fields of many transactions, so the export stores
+// each journal field as its own column, in row groups of up to
+// rowGroupRows transactions. Each column has a fixed encoding, chosen for
+// the values it holds:
+//   - Delta: the first value, then bit-packed differences from the
+//     smallest difference (LSNs and transaction IDs pack to 0 bits,
+//     timestamps to a few).
+//   - FrameOfReference: bit-packed (value - min) / step, where step is the
+//     GCD of those differences, so amounts that are all whole notes pack
+//     as note counts.
+//   - Dictionary: the distinct values once, then bit-packed indexes
+//     (terminal IDs).
+// The footer keeps each chunk's offset, checksum and min/max, so a reader
+// can skip row groups by their statistics and read one column without
+// touching the bytes of the others.
+//
+// Export encodes row groups on several threads and writes them in journal
+// order; memory stays at about threads row groups of records.
+
+enum class JournalColumn : std::uint8_t {
+    Lsn,
+    Timestamp,      // microseconds since the Unix epoch
+    Type,           // TxnType
+    Account,
+    Amount,         // paise
+    BalanceAfter,   // paise
+    Terminal,
+    TxnId,
+    Count
+};
+
+constexpr std::size_t kJournalColumns = static_cast<std::size_t>(JournalColumn::Count);
+
+// "lsn", "timestamp", ... as used on the atmtool command line.
+const char* journalColumnName(JournalColumn column);
+// Returns false if name is not a column name.
+bool parseJournalColumn(const std::string& name, JournalColumn* column);
+
+enum class ColumnEncoding : std::uint8_t { Delta, FrameOfReference, Dictionary };
+
+const char* columnEncodingName(ColumnEncoding encoding);
+
+struct ColumnExportOptions {
+    std::size_t rowGroupRows = 65536;
+    unsigned threads = 0;   // 0: one per hardware thread
+    // Only records with fromUs <= timestamp < toUs are exported.
+    std::int64_t fromUs = std::numeric_limits<std::int64_t>::min();
+    std::int64_t toUs = std::numeric_limits<std::int64_t>::max();
+};
+
+struct ColumnExportStats {
+    std::size_t rows = 0;
+    std::size_t rowGroups = 0;
+    std::uint64_t journalBytes = 0;   // bytes of the exported records as journal entries
+    std::uint64_t fileBytes = 0;
+    std::uint64_t columnBytes[kJournalColumns] = {};
+    unsigned threads = 0;
+    double seconds = 0;
+};
+
+// Writes the records of journalPath in the time range to outputPath.
+// Throws std::runtime_error if a file cannot be read or written.
+ColumnExportStats exportJournalColumns(const std::string& journalPath, const std::string& outputPath,
+                                       ColumnExportOptions options = ColumnExportOptions());
+
+// Reader over an exported file. Opening reads only the footer; each
+// readColumn() reads and checks one chunk.
+class ColumnFile {
+public:
+    struct ChunkInfo {
+        std::uint64_t offset;
+        std::uint64_t bytes;
+        std::int64_t min;
+        std::int64_t max;
+        ColumnEncoding encoding;
+        std::uint8_t bitWidth;
+        std::uint32_t checksum;
+    };
+
+    struct RowGroup {
+        std::uint64_t rows;
+        ChunkInfo chunks[kJournalColumns];
+
+        const ChunkInfo& chunk(JournalColumn column) const { return chunks[static_cast<std::size_t>(column)]; }
+    };
+
+    // Throws std::runtime_error if the file cannot be read or is not an
+    // intact export.
+    static ColumnFile open(const std::string& path);
+
+    std::uint64_t rows() const { return rowCount; }
+    std::size_t rowGroupCount() const { return groups.size(); }
+    const RowGroup& rowGroup(std::size_t index) const { return groups[index]; }
+
+    // Decodes one column of one row group into out (resized to its rows).
+    void readColumn(std::size_t group, JournalColumn column, std::vector<std::int64_t>& out);
+
+    // Chunk bytes read so far, to show what a scan touched.
+    std::uint64_t bytesRead() const { return chunkBytesRead; }
+    const std::string& path() const { return filePath; }
+
+private:
+    std::string filePath;
+    std::ifstream in;
+    std::vector<RowGroup> groups;
+    std::uint64_t rowCount = 0;
+    std::vector<std::uint64_t> buffer;
+    std::uint64_t chunkBytesRead = 0;
+};
+
+} // namespace atm
+
+#endif // ATM_JOURNAL_COLUMNS_H
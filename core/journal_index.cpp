@@ -0,0 +1,499 @@
+#include "journal_index.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "append_file.h"
+#include "checksum.h"
+
+namespace atm {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'G', 'A', 'T', 'M', 'J', 'I', 'X'};
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr std::size_t kScanRecords = 4096;
+
+struct IndexHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t timeIndexRecords;
+    std::uint64_t firstLsn;
+    std::uint64_t lastLsn;
+    std::int64_t minTimestampUs;
+    std::int64_t maxTimestampUs;
+    std::uint64_t timeEntries;
+    std::uint64_t accounts;
+    std::uint64_t postingBytes;
+    std::uint64_t reserved;
+    std::uint32_t reserved2;
+    std::uint32_t checksum;   // of the bytes before it
+};
+
+// maxUpTo: largest timestamp from the segment start to the end of this
+// run; minFrom: smallest from the start of this run to the segment end.
+struct TimeEntry {
+    std::int64_t maxUpTo;
+    std::int64_t minFrom;
+};
+
+struct AccountEntry {
+    std::int32_t accountNumber;
+    std::uint32_t postings;
+    std::uint32_t offset;   // into the posting section
+};
+
+// Ahead of a posting list longer than kPostingSkipInterval, one per group
+// of postings after the first: the group's first value and where it
+// starts, counted from the end of the skip table.
+struct SkipEntry {
+    std::uint32_t lsnOffset;
+    std::uint32_t byteOffset;
+};
+
+static_assert(sizeof(IndexHeader) == 88, "Journal index header layout");
+static_assert(sizeof(TimeEntry) == 16, "Journal index time entry layout");
+static_assert(sizeof(AccountEntry) == 12, "Journal index account entry layout");
+static_assert(sizeof(SkipEntry) == 8, "Journal index skip entry layout");
+
+[[noreturn]] void malformed(const std::string& path, const char* why) {
+    throw std::runtime_error("Journal index " + path + " is not usable: " + why);
+}
+
+template <typename T>
+T readAt(const unsigned char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+void writeVarint(std::vector<unsigned char>& out, std::uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+// Reads one varint at p, never past end. Returns nullptr if it runs over.
+const unsigned char* readVarint(const unsigned char* p, const unsigned char* end, std::uint32_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+        if (p == end) return nullptr;
+        unsigned char b = *p++;
+        value |= static_cast<std::uint32_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return p;
+    }
+    return nullptr;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The records of one sealed segment, raw or compressed: all of those in an
+// LSN range, or just the ones at given LSNs. A raw segment compressed since
+// it was listed is read compressed; one compacted away reads as empty.
+class SegmentRecords {
+public:
+    explicit SegmentRecords(const JournalSegment& segment) : first(segment.firstLsn) {
+        std::string path = segment.path;
+        if (!segment.compressed) {
+            raw.open(path, std::ios::binary);
+            if (raw.is_open()) return;
+            path += ".lz";   // compressedSegmentPath() of the same segment
+        }
+        if (std::ifstream(path).good()) packed = std::make_unique<CompressedSegment>(CompressedSegment::open(path));
+    }
+
+    // Calls fn on each valid record with firstLsn <= lsn <= lastLsn, in
+    // order, stopping at the first bad one.
+    template <typename Fn>
+    void forEach(std::uint64_t firstLsn, std::uint64_t lastLsn, Fn fn) {
+        if (packed) {
+            std::vector<JournalRecord> block;
+            for (std::size_t b = packed->blockFor(firstLsn); b < packed->blockCount(); b++) {
+                if (packed->block(b).firstLsn > lastLsn) return;
+                if (!packed->readBlock(b, block)) return;
+                blocksRead++;
+                for (const JournalRecord& r : block) {
+                    if (r.lsn < firstLsn) continue;
+                    if (r.lsn > lastLsn || !r.isValid()) return;
+                    recordsRead++;
+                    fn(r);
+                }
+            }
+        } else if (raw.is_open()) {
+            std::uint64_t skip = firstLsn > first ? firstLsn - first : 0;
+            raw.clear();
+            raw.seekg(static_cast<std::streamoff>(skip * sizeof(JournalRecord)));
+            std::vector<JournalRecord> buffer(kScanRecords);
+            for (;;) {
+                raw.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(JournalRecord)));
+                std::size_t n = static_cast<std::size_t>(raw.gcount()) / sizeof(JournalRecord);
+                if (n == 0) return;
+                for (std::size_t i = 0; i < n; i++) {
+                    const JournalRecord& r = buffer[i];
+                    if (!r.isValid() || r.lsn > lastLsn) return;
+                    recordsRead++;
+                    fn(r);
+                }
+            }
+        }
+    }
+
+    // Appends the valid records at the given LSNs (ascending) to out.
+    void fetch(const std::vector<std::uint64_t>& lsns, std::vector<JournalRecord>& out) {
+        if (packed) {
+            std::vector<JournalRecord> block;
+            std::size_t loaded = packed->blockCount();
+            for (std::uint64_t lsn : lsns) {
+                std::size_t b = packed->blockFor(lsn);
+                if (b >= packed->blockCount()) break;
+                if (b != loaded) {
+                    if (!packed->readBlock(b, block)) return;
+                    loaded = b;
+                    blocksRead++;
+                }
+                std::uint64_t at = lsn - packed->block(b).firstLsn;
+                if (at < block.size() && block[at].lsn == lsn && block[at].isValid()) {
+                    recordsRead++;
+                    out.push_back(block[at]);
+                }
+            }
+        } else if (raw.is_open()) {
+            JournalRecord r;
+            for (std::uint64_t lsn : lsns) {
+                raw.clear();
+                raw.seekg(static_cast<std::streamoff>((lsn - first) * sizeof(JournalRecord)));
+                if (!raw.read(reinterpret_cast<char*>(&r), sizeof(r))) break;
+                if (r.lsn == lsn && r.isValid()) {
+                    recordsRead++;
+                    out.push_back(r);
+                }
+            }
+        }
+    }
+
+    std::uint64_t blocksRead = 0;
+    std::uint64_t recordsRead = 0;
+
+private:
+    std::uint64_t first;
+    std::ifstream raw;
+    std::unique_ptr<CompressedSegment> packed;
+};
+
+bool matches(const JournalRecord& r, const JournalQuery& q) {
+    return (q.accountNumber == 0 || r.accountNumber == q.accountNumber) && r.timestampUs >= q.fromUs &&
+           r.timestampUs < q.toUs;
+}
+
+} // namespace
+
+SegmentIndexStats indexJournalSegment(const JournalSegment& segment, const std::string& outputPath) {
+    auto start = std::chrono::steady_clock::now();
+    SegmentRecords records(segment);
+
+    // (account, LSN offset) for every record; sorting groups each
+    // account's postings and keeps them in LSN order.
+    std::vector<std::pair<std::int32_t, std::uint32_t>> postings;
+    std::vector<std::int64_t> timestamps;
+    std::uint64_t first = 0, last = 0;
+    records.forEach(0, UINT64_MAX, [&](const JournalRecord& r) {
+        if (timestamps.empty()) first = r.lsn;
+        if (r.lsn != first + timestamps.size()) return;   // LSNs are dense in a sealed segment
+        postings.emplace_back(r.accountNumber, static_cast<std::uint32_t>(r.lsn - first));
+        timestamps.push_back(r.timestampUs);
+        last = r.lsn;
+    });
+    std::sort(postings.begin(), postings.end());
+
+    std::vector<TimeEntry> time((timestamps.size() + kTimeIndexRecords - 1) / kTimeIndexRecords);
+    std::int64_t running = std::numeric_limits<std::int64_t>::min();
+    for (std::size_t t = 0; t < time.size(); t++) {
+        std::size_t end = std::min(timestamps.size(), (t + 1) * kTimeIndexRecords);
+        for (std::size_t i = t * kTimeIndexRecords; i < end; i++) running = std::max(running, timestamps[i]);
+        time[t].maxUpTo = running;
+    }
+    running = std::numeric_limits<std::int64_t>::max();
+    for (std::size_t t = time.size(); t-- > 0;) {
+        std::size_t end = std::min(timestamps.size(), (t + 1) * kTimeIndexRecords);
+        for (std::size_t i = t * kTimeIndexRecords; i < end; i++) running = std::min(running, timestamps[i]);
+        time[t].minFrom = running;
+    }
+
+    std::vector<AccountEntry> accounts;
+    std::vector<unsigned char> bytes;
+    for (std::size_t i = 0; i < postings.size();) {
+        std::size_t end = i;
+        while (end < postings.size() && postings[end].first == postings[i].first) end++;
+        std::size_t count = end - i;
+        accounts.push_back(AccountEntry{postings[i].first, static_cast<std::uint32_t>(count),
+                                        static_cast<std::uint32_t>(bytes.size())});
+        std::size_t skips = count > kPostingSkipInterval ? (count - 1) / kPostingSkipInterval : 0;
+        std::size_t table = bytes.size();
+        bytes.resize(table + skips * sizeof(SkipEntry));
+        std::size_t data = bytes.size();
+        std::uint32_t previous = 0;
+        for (std::size_t k = 0; k < count; k++) {
+            std::uint32_t value = postings[i + k].second;
+            if (k % kPostingSkipInterval == 0) {
+                // Each group starts from zero so it can be decoded alone.
+                previous = 0;
+                if (k > 0) {
+                    SkipEntry skip{value, static_cast<std::uint32_t>(bytes.size() - data)};
+                    std::memcpy(&bytes[table + (k / kPostingSkipInterval - 1) * sizeof(SkipEntry)], &skip, sizeof(skip));
+                }
+            }
+            writeVarint(bytes, value - previous);
+            previous = value;
+        }
+        i = end;
+    }
+
+    IndexHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kFormatVersion;
+    header.timeIndexRecords = static_cast<std::uint32_t>(kTimeIndexRecords);
+    header.firstLsn = first;
+    header.lastLsn = last;
+    header.minTimestampUs = time.empty() ? 0 : time.front().minFrom;
+    header.maxTimestampUs = time.empty() ? 0 : time.back().maxUpTo;
+    header.timeEntries = time.size();
+    header.accounts = accounts.size();
+    header.postingBytes = bytes.size();
+    header.checksum = crc32(&header, offsetof(IndexHeader, checksum));
+
+    std::remove(outputPath.c_str());
+    AppendFile out = AppendFile::open(outputPath);
+    out.write(&header, sizeof(header));
+    out.write(time.data(), time.size() * sizeof(TimeEntry));
+    out.write(accounts.data(), accounts.size() * sizeof(AccountEntry));
+    out.write(bytes.data(), bytes.size());
+    out.datasync();
+
+    SegmentIndexStats stats;
+    stats.records = timestamps.size();
+    stats.accounts = accounts.size();
+    stats.bytes = out.size();
+    stats.seconds = secondsSince(start);
+    return stats;
+}
+
+// --- SegmentIndex ---
+
+SegmentIndex SegmentIndex::open(const std::string& path) {
+    SegmentIndex index;
+    index.file = MappedFile::open(path);
+    const unsigned char* base = index.file.data();
+    std::size_t size = index.file.size();
+    if (size < sizeof(IndexHeader)) malformed(path, "too short");
+    IndexHeader h = readAt<IndexHeader>(base);
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) malformed(path, "not a journal index");
+    if (h.formatVersion != kFormatVersion) malformed(path, "unsupported format version");
+    if (h.checksum != crc32(&h, offsetof(IndexHeader, checksum))) malformed(path, "header checksum mismatch");
+    if (h.timeIndexRecords != kTimeIndexRecords ||
+        sizeof(IndexHeader) + h.timeEntries * sizeof(TimeEntry) + h.accounts * sizeof(AccountEntry) + h.postingBytes != size) {
+        malformed(path, "section sizes do not match the file");
+    }
+    return index;
+}
+
+std::uint64_t SegmentIndex::firstLsn() const {
+    return readAt<IndexHeader>(file.data()).firstLsn;
+}
+
+std::uint64_t SegmentIndex::lastLsn() const {
+    return readAt<IndexHeader>(file.data()).lastLsn;
+}
+
+std::int64_t SegmentIndex::minTimestamp() const {
+    return readAt<IndexHeader>(file.data()).minTimestampUs;
+}
+
+std::int64_t SegmentIndex::maxTimestamp() const {
+    return readAt<IndexHeader>(file.data()).maxTimestampUs;
+}
+
+std::uint64_t SegmentIndex::accountCount() const {
+    return readAt<IndexHeader>(file.data()).accounts;
+}
+
+SegmentIndex::LsnRange SegmentIndex::lsnRange(std::int64_t fromUs, std::int64_t toUs) const {
+    IndexHeader h = readAt<IndexHeader>(file.data());
+    const LsnRange none{1, 0};
+    if (h.timeEntries == 0 || h.maxTimestampUs < fromUs || h.minTimestampUs >= toUs) return none;
+    const unsigned char* time = file.data() + sizeof(IndexHeader);
+    auto entry = [&](std::size_t t) { return readAt<TimeEntry>(time + t * sizeof(TimeEntry)); };
+
+    // First run whose records so far reach fromUs, last run whose records
+    // from there on start before toUs.
+    std::size_t lo = 0, hi = h.timeEntries;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (entry(mid).maxUpTo >= fromUs) hi = mid; else lo = mid + 1;
+    }
+    std::size_t firstRun = lo;
+    lo = 0;
+    hi = h.timeEntries;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (entry(mid).minFrom < toUs) lo = mid + 1; else hi = mid;
+    }
+    if (lo == 0 || firstRun > lo - 1) return none;
+    std::size_t lastRun = lo - 1;
+    return LsnRange{h.firstLsn + firstRun * kTimeIndexRecords,
+                    std::min<std::uint64_t>(h.lastLsn, h.firstLsn + (lastRun + 1) * kTimeIndexRecords - 1)};
+}
+
+std::size_t SegmentIndex::postings(int accountNumber, LsnRange range, std::vector<std::uint64_t>& out) const {
+    IndexHeader h = readAt<IndexHeader>(file.data());
+    if (range.empty() || range.last < h.firstLsn || range.first > h.lastLsn) return 0;
+    const unsigned char* accounts = file.data() + sizeof(IndexHeader) + h.timeEntries * sizeof(TimeEntry);
+    const unsigned char* section = accounts + h.accounts * sizeof(AccountEntry);
+    const unsigned char* end = section + h.postingBytes;
+
+    std::size_t lo = 0, hi = h.accounts;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (readAt<std::int32_t>(accounts + mid * sizeof(AccountEntry)) < accountNumber) lo = mid + 1; else hi = mid;
+    }
+    if (lo == h.accounts) return 0;
+    AccountEntry a = readAt<AccountEntry>(accounts + lo * sizeof(AccountEntry));
+    if (a.accountNumber != accountNumber) return 0;
+
+    std::size_t skipCount = a.postings > kPostingSkipInterval ? (a.postings - 1) / kPostingSkipInterval : 0;
+    const unsigned char* skips = section + a.offset;
+    const unsigned char* data = skips + skipCount * sizeof(SkipEntry);
+    if (a.offset > h.postingBytes || data > end) malformed(file.path(), "posting list outside its section");
+
+    // Enter the list at the last group starting at or before the range.
+    std::uint64_t from = range.first > h.firstLsn ? range.first - h.firstLsn : 0;
+    std::uint64_t to = range.last - h.firstLsn;
+    lo = 0;
+    hi = skipCount;
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        if (readAt<SkipEntry>(skips + mid * sizeof(SkipEntry)).lsnOffset <= from) lo = mid + 1; else hi = mid;
+    }
+    std::size_t k = lo * kPostingSkipInterval;
+    const unsigned char* p = data;
+    if (lo > 0) {
+        p += readAt<SkipEntry>(skips + (lo - 1) * sizeof(SkipEntry)).byteOffset;
+        if (p > end) malformed(file.path(), "skip pointer outside its section");
+    }
+
+    std::size_t decoded = 0;
+    std::uint32_t value = 0;
+    for (; k < a.postings; k++) {
+        std::uint32_t delta;
+        p = readVarint(p, end, delta);
+        if (!p) malformed(file.path(), "posting list runs past its section");
+        value = (k % kPostingSkipInterval == 0 ? 0 : value) + delta;
+        decoded++;
+        if (value < from) continue;
+        if (value > to) break;
+        out.push_back(h.firstLsn + value);
+    }
+    return decoded;
+}
+
+// --- queries ---
+
+std::vector<JournalRecord> queryJournal(const std::string& journalPath, const JournalQuery& query,
+                                        JournalQueryStats* stats) {
+    auto start = std::chrono::steady_clock::now();
+    JournalQueryStats local;
+    JournalQueryStats& s = stats ? *stats : local;
+    s = JournalQueryStats();
+    std::vector<JournalRecord> results;
+
+    // As in JournalReader: the active file is opened before the listing,
+    // and segments it turns out to be already are left out.
+    std::ifstream active(journalPath, std::ios::binary);
+    std::vector<JournalSegment> segments = listJournalSegments(journalPath);
+    JournalRecord head;
+    if (active.read(reinterpret_cast<char*>(&head), sizeof(head)) && head.isValid()) {
+        segments.erase(std::remove_if(segments.begin(), segments.end(),
+                                      [&](const JournalSegment& seg) { return seg.firstLsn >= head.lsn; }),
+                       segments.end());
+    }
+    active.clear();
+    active.seekg(0);
+
+    std::vector<std::uint64_t> lsns;
+    for (const JournalSegment& segment : segments) {
+        SegmentIndex index;
+        bool indexed = true;
+        try {
+            index = SegmentIndex::open(segmentIndexPath(journalPath, segment.firstLsn));
+        } catch (const std::exception&) {
+            indexed = false;
+        }
+
+        SegmentRecords records(segment);
+        if (!indexed) {
+            s.segmentsScanned++;
+            records.forEach(0, UINT64_MAX, [&](const JournalRecord& r) {
+                if (matches(r, query)) results.push_back(r);
+            });
+        } else {
+            SegmentIndex::LsnRange range = index.lsnRange(query.fromUs, query.toUs);
+            if (range.empty()) {
+                s.segmentsSkipped++;
+                continue;
+            }
+            s.segmentsSearched++;
+            if (query.accountNumber == 0) {
+                records.forEach(range.first, range.last, [&](const JournalRecord& r) {
+                    if (matches(r, query)) results.push_back(r);
+                });
+            } else {
+                lsns.clear();
+                s.postingsRead += index.postings(query.accountNumber, range, lsns);
+                std::size_t before = results.size();
+                records.fetch(lsns, results);
+                // The time index narrows to runs of records; the exact
+                // range, and the account, are checked on the records.
+                results.erase(std::remove_if(results.begin() + static_cast<std::ptrdiff_t>(before), results.end(),
+                                             [&](const JournalRecord& r) { return !matches(r, query); }),
+                              results.end());
+            }
+        }
+        s.blocksRead += records.blocksRead;
+        s.recordsRead += records.recordsRead;
+    }
+
+    // The active file: checked on the cheap fields first, checksummed only
+    // when they match.
+    std::vector<JournalRecord> buffer(kScanRecords);
+    bool torn = false;
+    while (!torn && active.is_open()) {
+        active.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(JournalRecord)));
+        std::size_t n = static_cast<std::size_t>(active.gcount()) / sizeof(JournalRecord);
+        if (n == 0) break;
+        s.recordsRead += n;
+        for (std::size_t i = 0; i < n; i++) {
+            if (!matches(buffer[i], query)) continue;
+            if (!buffer[i].isValid()) {
+                torn = true;
+                break;
+            }
+            results.push_back(buffer[i]);
+        }
+    }
+
+    s.seconds = secondsSince(start);
+    return results;
+}
+
+} // namespace atm
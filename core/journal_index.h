@@ -0,0 +1,114 @@
+#ifndef ATM_JOURNAL_INDEX_H
+#define ATM_JOURNAL_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "journal.h"
+#include "journal_segments.h"
+#include "mapped_file.h"
+
+namespace atm {
+
+// Journal indexes and queries
+//
+// Every sealed segment gets an index file, <segment>.idx, written by the
+// journal's segment thread next to the segment. It holds:
+//   - a sparse time index: for each run of kTimeIndexRecords records, the
+//     largest timestamp up to its end and the smallest from its start on.
+//     Both only grow, so a time range maps to an LSN range by two binary
+//     searches even if the wall clock stepped back;
+//   - an account directory sorted by account number, 12 bytes an account;
+//   - per account, a posting list of its LSNs (offsets from the segment's
+//     first LSN) as varint deltas, with a skip pointer every
+//     kPostingSkipInterval postings, so a list can be entered at the first
+//     LSN of the time range instead of decoded from its start.
+//
+// A query looks up the account in each segment whose time span overlaps
+// the range, walks its postings within the LSN range and reads just those
+// records, each compressed block at most once: O(log n + k) per segment.
+// The active file has no index and is scanned; it is at most
+// JournalOptions::segmentBytes long.
+//
+// An index is derived data and can be rebuilt from its segment. Only its
+// header is checksummed, so opening it stays cheap; every record a query
+// returns is read from the segment, checked against its own CRC and
+// matched against the query again, so a damaged index can hide records but
+// never return wrong ones.
+
+constexpr std::size_t kTimeIndexRecords = 1024;
+constexpr std::size_t kPostingSkipInterval = 64;
+
+struct SegmentIndexStats {
+    std::uint64_t records = 0;
+    std::uint64_t accounts = 0;
+    std::uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+// Writes the index of one sealed segment, raw or compressed, to
+// outputPath and syncs it. Throws std::runtime_error if a file cannot be
+// read or written.
+SegmentIndexStats indexJournalSegment(const JournalSegment& segment, const std::string& outputPath);
+
+// Reader over one index file, mapped rather than read, so a lookup only
+// touches the pages its binary searches and posting list land on.
+class SegmentIndex {
+public:
+    // Inclusive; empty when first > last.
+    struct LsnRange {
+        std::uint64_t first;
+        std::uint64_t last;
+
+        bool empty() const { return first > last; }
+    };
+
+    // Throws std::runtime_error if the file cannot be read or its header
+    // and section sizes do not agree.
+    static SegmentIndex open(const std::string& path);
+
+    std::uint64_t firstLsn() const;
+    std::uint64_t lastLsn() const;
+    std::int64_t minTimestamp() const;
+    std::int64_t maxTimestamp() const;
+    std::uint64_t accountCount() const;
+
+    // LSNs that can hold records with fromUs <= timestamp < toUs.
+    LsnRange lsnRange(std::int64_t fromUs, std::int64_t toUs) const;
+    // Appends the LSNs of accountNumber's records within range to out, in
+    // order, and returns how many postings were decoded to find them.
+    std::size_t postings(int accountNumber, LsnRange range, std::vector<std::uint64_t>& out) const;
+
+private:
+    MappedFile file;
+};
+
+struct JournalQuery {
+    int accountNumber = 0;   // 0: every account
+    // fromUs <= timestamp < toUs, microseconds since the Unix epoch.
+    std::int64_t fromUs = std::numeric_limits<std::int64_t>::min();
+    std::int64_t toUs = std::numeric_limits<std::int64_t>::max();
+};
+
+struct JournalQueryStats {
+    std::size_t segmentsSearched = 0;   // through their index
+    std::size_t segmentsSkipped = 0;    // their time span misses the range
+    std::size_t segmentsScanned = 0;    // no usable index yet: read in full
+    std::uint64_t postingsRead = 0;
+    std::uint64_t blocksRead = 0;       // compressed blocks decoded
+    std::uint64_t recordsRead = 0;      // read from segments or the active file
+    double seconds = 0;
+};
+
+// Records of the journal at journalPath matching query, in LSN order.
+// Segments compacted away are not searched. Throws std::runtime_error if a
+// file that is there cannot be read.
+std::vector<JournalRecord> queryJournal(const std::string& journalPath, const JournalQuery& query,
+                                        JournalQueryStats* stats = nullptr);
+
+} // namespace atm
+
+#endif // ATM_JOURNAL_INDEX_H
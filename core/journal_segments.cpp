@@ -0,0 +1,380 @@
+#include "journal_segments.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <stdexcept>
+#include <system_error>
+
+#include "append_file.h"
+#include "checksum.h"
+#include "lz_block.h"
+
+namespace atm {
+
+namespace {
+
+constexpr char kMagic[8] = {'N', 'G', 'A', 'T', 'M', 'J', 'L', 'Z'};
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr std::size_t kLsnDigits = 20;
+constexpr char kCompressedSuffix[] = ".lz";
+constexpr char kIndexSuffix[] = ".idx";
+
+struct SegmentHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t blockRecords;
+    std::uint64_t reserved[2];
+};
+
+struct IndexEntry {
+    std::uint64_t firstLsn;
+    std::uint64_t offset;
+    std::uint32_t bytes;
+    std::uint32_t records;
+    std::uint32_t checksum;
+    std::uint32_t reserved;
+};
+
+struct Trailer {
+    std::uint64_t indexOffset;
+    std::uint64_t blocks;
+    std::uint64_t firstLsn;
+    std::uint64_t lastLsn;
+    std::uint32_t indexChecksum;
+    std::uint32_t reserved;
+    char magic[8];
+};
+
+static_assert(sizeof(SegmentHeader) == 32, "Compressed segment header layout");
+static_assert(sizeof(IndexEntry) == 32, "Compressed segment index layout");
+static_assert(sizeof(Trailer) == 48, "Compressed segment trailer layout");
+
+constexpr std::size_t kRecordBytes = sizeof(JournalRecord);
+
+[[noreturn]] void malformed(const std::string& path, const char* why) {
+    throw std::runtime_error("Journal segment " + path + " is not usable: " + why);
+}
+
+std::string lsnDigits(std::uint64_t lsn) {
+    char text[kLsnDigits + 1];
+    std::snprintf(text, sizeof(text), "%020llu", static_cast<unsigned long long>(lsn));
+    return text;
+}
+
+// Parses "<journal name>.<20 digits>[.lz]".
+bool parseSegmentName(const std::string& name, const std::string& prefix, std::uint64_t* firstLsn, bool* compressed) {
+    if (name.size() < prefix.size() + kLsnDigits || name.compare(0, prefix.size(), prefix) != 0) return false;
+    std::string rest = name.substr(prefix.size() + kLsnDigits);
+    if (rest.empty()) {
+        *compressed = false;
+    } else if (rest == kCompressedSuffix) {
+        *compressed = true;
+    } else {
+        return false;
+    }
+    std::uint64_t lsn = 0;
+    for (std::size_t i = prefix.size(); i < prefix.size() + kLsnDigits; i++) {
+        if (name[i] < '0' || name[i] > '9') return false;
+        lsn = lsn * 10 + static_cast<std::uint64_t>(name[i] - '0');
+    }
+    *firstLsn = lsn;
+    return true;
+}
+
+// LSN of the last valid record of a raw segment, walking back from the end
+// past a torn tail; 0 if there is none.
+std::uint64_t lastValidLsn(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return 0;
+    std::uint64_t end = static_cast<std::uint64_t>(in.tellg());
+    end -= end % kRecordBytes;
+    JournalRecord record;
+    while (end > 0) {
+        in.seekg(static_cast<std::streamoff>(end - kRecordBytes));
+        if (in.read(reinterpret_cast<char*>(&record), kRecordBytes) && record.isValid()) return record.lsn;
+        in.clear();
+        end -= kRecordBytes;
+    }
+    return 0;
+}
+
+std::uint64_t load64(const unsigned char* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+void store64(unsigned char* p, std::uint64_t v) {
+    std::memcpy(p, &v, sizeof(v));
+}
+
+// Transposes an 8x8 byte matrix, row i being x[i] (byte j of x[i] is
+// column j), by swapping 4x4, then 2x2, then single-byte blocks.
+void transpose8(std::uint64_t* x) {
+    for (int i = 0; i < 4; i++) {
+        std::uint64_t a = x[i], b = x[i + 4];
+        x[i] = (a & 0x00000000FFFFFFFFull) | (b << 32);
+        x[i + 4] = (a >> 32) | (b & 0xFFFFFFFF00000000ull);
+    }
+    for (int i : {0, 1, 4, 5}) {
+        const std::uint64_t m = 0x0000FFFF0000FFFFull;
+        std::uint64_t a = x[i], b = x[i + 2];
+        x[i] = (a & m) | ((b & m) << 16);
+        x[i + 2] = ((a >> 16) & m) | (b & ~m);
+    }
+    for (int i : {0, 2, 4, 6}) {
+        const std::uint64_t m = 0x00FF00FF00FF00FFull;
+        std::uint64_t a = x[i], b = x[i + 1];
+        x[i] = (a & m) | ((b & m) << 8);
+        x[i + 1] = ((a >> 8) & m) | (b & ~m);
+    }
+}
+
+// Byte b of record r goes to out[b * count + r]: eight records by eight
+// bytes at a time, the records past the last full eight one byte at a time.
+void shuffle(const JournalRecord* records, std::size_t count, unsigned char* out) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(records);
+    std::size_t whole = count - count % 8;
+    std::uint64_t x[8];
+    for (std::size_t r = 0; r < whole; r += 8) {
+        for (std::size_t b = 0; b < kRecordBytes; b += 8) {
+            for (int i = 0; i < 8; i++) x[i] = load64(bytes + (r + i) * kRecordBytes + b);
+            transpose8(x);
+            for (int i = 0; i < 8; i++) store64(out + (b + i) * count + r, x[i]);
+        }
+    }
+    for (std::size_t r = whole; r < count; r++) {
+        for (std::size_t b = 0; b < kRecordBytes; b++) out[b * count + r] = bytes[r * kRecordBytes + b];
+    }
+}
+
+void unshuffle(const unsigned char* in, std::size_t count, JournalRecord* records) {
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(records);
+    std::size_t whole = count - count % 8;
+    std::uint64_t x[8];
+    for (std::size_t r = 0; r < whole; r += 8) {
+        for (std::size_t b = 0; b < kRecordBytes; b += 8) {
+            for (int i = 0; i < 8; i++) x[i] = load64(in + (b + i) * count + r);
+            transpose8(x);
+            for (int i = 0; i < 8; i++) store64(bytes + (r + i) * kRecordBytes + b, x[i]);
+        }
+    }
+    for (std::size_t r = whole; r < count; r++) {
+        for (std::size_t b = 0; b < kRecordBytes; b++) bytes[r * kRecordBytes + b] = in[b * count + r];
+    }
+}
+
+} // namespace
+
+std::string sealedSegmentPath(const std::string& journalPath, std::uint64_t firstLsn) {
+    return journalPath + "." + lsnDigits(firstLsn);
+}
+
+std::string compressedSegmentPath(const std::string& journalPath, std::uint64_t firstLsn) {
+    return sealedSegmentPath(journalPath, firstLsn) + kCompressedSuffix;
+}
+
+std::string segmentIndexPath(const std::string& journalPath, std::uint64_t firstLsn) {
+    return sealedSegmentPath(journalPath, firstLsn) + kIndexSuffix;
+}
+
+std::vector<JournalSegment> listJournalSegments(const std::string& journalPath) {
+    namespace fs = std::filesystem;
+    fs::path journal(journalPath);
+    fs::path dir = journal.parent_path();
+    if (dir.empty()) dir = ".";
+    std::string prefix = journal.filename().string() + ".";
+
+    std::vector<JournalSegment> segments;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::uint64_t firstLsn;
+        bool compressed;
+        if (!parseSegmentName(it->path().filename().string(), prefix, &firstLsn, &compressed)) continue;
+        JournalSegment segment;
+        segment.firstLsn = firstLsn;
+        segment.compressed = compressed;
+        segment.path = compressed ? compressedSegmentPath(journalPath, firstLsn) : sealedSegmentPath(journalPath, firstLsn);
+        segments.push_back(segment);
+    }
+
+    // A raw segment next to its compressed copy is left over from a crash
+    // before the swap finished; the compressed copy is complete.
+    std::sort(segments.begin(), segments.end(), [](const JournalSegment& a, const JournalSegment& b) {
+        return a.firstLsn != b.firstLsn ? a.firstLsn < b.firstLsn : a.compressed > b.compressed;
+    });
+    segments.erase(std::unique(segments.begin(), segments.end(),
+                               [](const JournalSegment& a, const JournalSegment& b) { return a.firstLsn == b.firstLsn; }),
+                   segments.end());
+
+    for (JournalSegment& segment : segments) {
+        std::error_code sizeError;
+        segment.fileBytes = static_cast<std::uint64_t>(fs::file_size(segment.path, sizeError));
+        if (sizeError) segment.fileBytes = 0;
+        if (!segment.compressed) {
+            segment.lastLsn = lastValidLsn(segment.path);
+            continue;
+        }
+        try {
+            segment.lastLsn = CompressedSegment::open(segment.path).lastLsn();
+        } catch (const std::exception&) {
+            segment.lastLsn = 0;
+        }
+    }
+    return segments;
+}
+
+SegmentCompressStats compressJournalSegment(const std::string& rawPath, const std::string& outputPath,
+                                            std::size_t blockRecords) {
+    auto start = std::chrono::steady_clock::now();
+    if (blockRecords == 0) blockRecords = kSegmentBlockRecords;
+    std::ifstream in(rawPath, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot read " + rawPath);
+    std::remove(outputPath.c_str());
+    AppendFile out = AppendFile::open(outputPath);
+
+    SegmentHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kFormatVersion;
+    header.blockRecords = static_cast<std::uint32_t>(blockRecords);
+    out.write(&header, sizeof(header));
+
+    SegmentCompressStats stats;
+    std::vector<JournalRecord> records(blockRecords);
+    std::vector<unsigned char> shuffled(blockRecords * kRecordBytes);
+    std::vector<char> packed(lzCompressBound(shuffled.size()));
+    std::vector<IndexEntry> index;
+    std::uint64_t offset = sizeof(header);
+    Trailer trailer{};
+
+    bool more = true;
+    while (more) {
+        in.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(blockRecords * kRecordBytes));
+        std::size_t count = static_cast<std::size_t>(in.gcount()) / kRecordBytes;
+        std::size_t valid = 0;
+        while (valid < count && records[valid].isValid()) valid++;
+        more = valid == blockRecords;
+        if (valid == 0) break;
+
+        shuffle(records.data(), valid, shuffled.data());
+        std::size_t bytes = lzCompress(shuffled.data(), valid * kRecordBytes, packed.data());
+        out.write(packed.data(), bytes);
+
+        IndexEntry entry{};
+        entry.firstLsn = records[0].lsn;
+        entry.offset = offset;
+        entry.bytes = static_cast<std::uint32_t>(bytes);
+        entry.records = static_cast<std::uint32_t>(valid);
+        entry.checksum = crc32(packed.data(), bytes);
+        index.push_back(entry);
+        offset += bytes;
+        if (stats.records == 0) trailer.firstLsn = records[0].lsn;
+        trailer.lastLsn = records[valid - 1].lsn;
+        stats.records += valid;
+    }
+
+    out.write(index.data(), index.size() * sizeof(IndexEntry));
+    trailer.indexOffset = offset;
+    trailer.blocks = index.size();
+    trailer.indexChecksum = crc32(index.data(), index.size() * sizeof(IndexEntry));
+    std::memcpy(trailer.magic, kMagic, sizeof(kMagic));
+    out.write(&trailer, sizeof(trailer));
+    out.datasync();
+
+    stats.blocks = index.size();
+    stats.rawBytes = stats.records * kRecordBytes;
+    stats.compressedBytes = offset + index.size() * sizeof(IndexEntry) + sizeof(trailer);
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+std::size_t compactJournalSegments(const std::string& journalPath, std::uint64_t coveredLsn) {
+    std::vector<JournalSegment> segments = listJournalSegments(journalPath);
+    // The newest segment stays: a journal whose active file is empty
+    // numbers on from it.
+    if (!segments.empty()) segments.pop_back();
+    std::size_t removed = 0;
+    for (const JournalSegment& segment : segments) {
+        if (segment.lastLsn == 0 || segment.lastLsn > coveredLsn) continue;
+        if (std::remove(segment.path.c_str()) == 0) removed++;
+        // A raw copy the listing hid behind its compressed one goes too.
+        if (segment.compressed) std::remove(sealedSegmentPath(journalPath, segment.firstLsn).c_str());
+        std::remove(segmentIndexPath(journalPath, segment.firstLsn).c_str());
+    }
+    return removed;
+}
+
+// --- CompressedSegment ---
+
+CompressedSegment CompressedSegment::open(const std::string& path) {
+    CompressedSegment segment;
+    segment.filePath = path;
+    segment.in.open(path, std::ios::binary);
+    if (!segment.in) throw std::runtime_error("Cannot read " + path);
+
+    SegmentHeader header{};
+    Trailer trailer{};
+    segment.in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    segment.in.seekg(0, std::ios::end);
+    segment.size = static_cast<std::uint64_t>(segment.in.tellg());
+    if (!segment.in || segment.size < sizeof(header) + sizeof(trailer)) malformed(path, "too short");
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) malformed(path, "not a compressed journal segment");
+    if (header.formatVersion != kFormatVersion) malformed(path, "unsupported format version");
+
+    segment.in.seekg(static_cast<std::streamoff>(segment.size - sizeof(trailer)));
+    segment.in.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    if (!segment.in || std::memcmp(trailer.magic, kMagic, sizeof(kMagic)) != 0 ||
+        trailer.indexOffset + trailer.blocks * sizeof(IndexEntry) + sizeof(trailer) != segment.size) {
+        malformed(path, "truncated or damaged index");
+    }
+
+    std::vector<IndexEntry> index(trailer.blocks);
+    segment.in.seekg(static_cast<std::streamoff>(trailer.indexOffset));
+    segment.in.read(reinterpret_cast<char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexEntry)));
+    if (!segment.in || crc32(index.data(), index.size() * sizeof(IndexEntry)) != trailer.indexChecksum) {
+        malformed(path, "index checksum mismatch");
+    }
+
+    std::uint32_t largest = 0;
+    for (const IndexEntry& e : index) {
+        if (e.offset < sizeof(header) || e.offset + e.bytes > trailer.indexOffset || e.records == 0 ||
+            e.records > header.blockRecords) {
+            malformed(path, "block outside the data section");
+        }
+        segment.blocks.push_back(Block{e.firstLsn, e.offset, e.bytes, e.records, e.checksum});
+        segment.recordCount += e.records;
+        largest = std::max(largest, e.bytes);
+    }
+    segment.last = trailer.lastLsn;
+    segment.compressed.resize(largest);
+    segment.shuffled.resize(static_cast<std::size_t>(header.blockRecords) * kRecordBytes);
+    return segment;
+}
+
+std::size_t CompressedSegment::blockFor(std::uint64_t lsn) const {
+    if (blocks.empty() || lsn < blocks.front().firstLsn) return 0;
+    if (lsn > last) return blocks.size();
+    auto after = std::upper_bound(blocks.begin(), blocks.end(), lsn,
+                                  [](std::uint64_t value, const Block& b) { return value < b.firstLsn; });
+    return static_cast<std::size_t>(after - blocks.begin()) - 1;
+}
+
+bool CompressedSegment::readBlock(std::size_t index, std::vector<JournalRecord>& out) {
+    const Block& b = blocks[index];
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(b.offset));
+    in.read(compressed.data(), b.bytes);
+    if (!in || crc32(compressed.data(), b.bytes) != b.checksum) return false;
+    std::size_t rawBytes = static_cast<std::size_t>(b.records) * kRecordBytes;
+    if (!lzDecompress(compressed.data(), b.bytes, shuffled.data(), rawBytes)) return false;
+    out.resize(b.records);
+    unshuffle(shuffled.data(), b.records, out.data());
+    blocksDecoded++;
+    return true;
+}
+
+} // namespace atm
@@ -0,0 +1,125 @@
+#ifndef ATM_JOURNAL_SEGMENTS_H
+#define ATM_JOURNAL_SEGMENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "journal.h"
+
+namespace atm {
+
+// Journal segments
+//
+// With JournalOptions::segmentBytes set, the file at the journal path is
+// only the active segment. Once it reaches that size it is sealed: renamed
+// to <path>.<first LSN as 20 digits> and a fresh active file started. The
+// journal then indexes the sealed segment in the background (see
+// journal_index.h), compresses it into <path>.<first LSN>.lz and removes the
+// raw one. Segments whose records a snapshot already holds can be
+// compacted away.
+//
+// A compressed segment is a series of blocks of up to blockRecords
+// records, each compressed on its own, then an index giving every block's
+// first LSN, offset and checksum. Before compression a block is
+// byte-shuffled (byte 0 of every record, then byte 1, ...), which lines up
+// the bytes that barely change from one record to the next: the magic,
+// the high bytes of LSNs, timestamps and balances. A reader seeks to an
+// LSN by binary search over the index and decompresses only the blocks
+// from there on.
+//
+// JournalReader reads the sealed segments and the active file as one
+// journal, so replay, history and the tools need no changes.
+
+constexpr std::size_t kSegmentBlockRecords = 1024;   // 64 KiB before compression
+
+struct JournalSegment {
+    std::string path;
+    std::uint64_t firstLsn = 0;
+    std::uint64_t lastLsn = 0;     // 0 if no record in it is valid
+    std::uint64_t fileBytes = 0;
+    bool compressed = false;
+
+    std::uint64_t records() const { return lastLsn ? lastLsn - firstLsn + 1 : 0; }
+};
+
+// Sealed segments of the journal at journalPath, oldest first; the active
+// file itself is not listed. Unreadable segments are listed with lastLsn 0.
+std::vector<JournalSegment> listJournalSegments(const std::string& journalPath);
+
+std::string sealedSegmentPath(const std::string& journalPath, std::uint64_t firstLsn);
+std::string compressedSegmentPath(const std::string& journalPath, std::uint64_t firstLsn);
+// The segment's index (journal_index.h), whichever form the segment is in.
+std::string segmentIndexPath(const std::string& journalPath, std::uint64_t firstLsn);
+
+struct SegmentCompressStats {
+    std::uint64_t records = 0;
+    std::uint64_t rawBytes = 0;
+    std::uint64_t compressedBytes = 0;   // the whole file, index included
+    std::size_t blocks = 0;
+    double seconds = 0;
+};
+
+// Compresses the raw segment at rawPath into outputPath and syncs it. The
+// raw segment is left in place; the caller swaps the two. Stops at the
+// first record that fails its checksum. Throws std::runtime_error if a
+// file cannot be read or written.
+SegmentCompressStats compressJournalSegment(const std::string& rawPath, const std::string& outputPath,
+                                            std::size_t blockRecords = kSegmentBlockRecords);
+
+// Deletes the sealed segments whose records all have LSNs up to
+// coveredLsn, raw or compressed, with their indexes, and returns how many
+// it deleted. The newest segment is always kept, since a journal whose
+// active file is empty takes its numbering from it. A live journal should
+// go through Journal::compact, which keeps this from racing its own
+// compression.
+std::size_t compactJournalSegments(const std::string& journalPath, std::uint64_t coveredLsn);
+
+// Reader over one compressed segment. Opening reads the header and block
+// index; readBlock() reads and decompresses a single block.
+class CompressedSegment {
+public:
+    struct Block {
+        std::uint64_t firstLsn;
+        std::uint64_t offset;
+        std::uint32_t bytes;
+        std::uint32_t records;
+        std::uint32_t checksum;
+    };
+
+    // Throws std::runtime_error if the file cannot be read or is not an
+    // intact compressed segment.
+    static CompressedSegment open(const std::string& path);
+
+    std::uint64_t firstLsn() const { return blocks.empty() ? 0 : blocks.front().firstLsn; }
+    std::uint64_t lastLsn() const { return last; }
+    std::uint64_t records() const { return recordCount; }
+    std::uint64_t fileBytes() const { return size; }
+    std::size_t blockCount() const { return blocks.size(); }
+    const Block& block(std::size_t index) const { return blocks[index]; }
+
+    // Index of the block holding lsn: 0 if lsn is before the segment,
+    // blockCount() if it is after it.
+    std::size_t blockFor(std::uint64_t lsn) const;
+    // Decompresses one block into out. Returns false if the block fails
+    // its checksum or does not decode.
+    bool readBlock(std::size_t index, std::vector<JournalRecord>& out);
+    std::uint64_t blocksRead() const { return blocksDecoded; }
+
+private:
+    std::string filePath;
+    std::ifstream in;
+    std::vector<Block> blocks;
+    std::uint64_t last = 0;
+    std::uint64_t recordCount = 0;
+    std::uint64_t size = 0;
+    std::uint64_t blocksDecoded = 0;
+    std::vector<char> compressed;
+    std::vector<unsigned char> shuffled;
+};
+
+} // namespace atm
+
+#endif // ATM_JOURNAL_SEGMENTS_H
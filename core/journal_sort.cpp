@@ -0,0 +1,241 @@
+#include "journal_sort.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parallel.h"
+
+namespace atm {
+
+namespace {
+
+// Smallest read buffer worth giving a merge input: below this the merge
+// spends its time seeking between run files.
+constexpr std::size_t kMergeBufferBytes = std::size_t(64) << 10;
+// ...and the largest: past this, bigger reads stop paying off and only
+// cost time to allocate.
+constexpr std::size_t kMaxBufferBytes = std::size_t(4) << 20;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool txnBefore(const JournalRecord& a, const JournalRecord& b) {
+    return a.txnId != b.txnId ? a.txnId < b.txnId : a.lsn < b.lsn;
+}
+
+// Inputs one merge can take within memoryBytes, keeping one buffer for
+// the output.
+std::size_t fanInFor(std::size_t memoryBytes) {
+    return std::max<std::size_t>(2, memoryBytes / kMergeBufferBytes - 1);
+}
+
+// Buffered raw record I/O for run files, which are written and read only
+// here, so records are not re-validated.
+class RunWriter {
+public:
+    RunWriter(const std::string& path, std::size_t capacity)
+        : path(path), out(path, std::ios::binary | std::ios::trunc) {
+        if (!out) throw std::runtime_error("Cannot write " + path);
+        buffer.reserve(std::max<std::size_t>(1, capacity));
+    }
+
+    void put(const JournalRecord& record) {
+        buffer.push_back(record);
+        if (buffer.size() == buffer.capacity()) flush();
+    }
+
+    void close() {
+        flush();
+        out.close();
+        if (!out) throw std::runtime_error("Cannot write " + path);
+    }
+
+private:
+    std::string path;
+    std::ofstream out;
+    std::vector<JournalRecord> buffer;
+
+    void flush() {
+        out.write(reinterpret_cast<const char*>(buffer.data()),
+                  static_cast<std::streamsize>(buffer.size() * sizeof(JournalRecord)));
+        if (!out) throw std::runtime_error("Cannot write " + path);
+        buffer.clear();
+    }
+};
+
+// A sorted chunk goes out in one write, without a second buffer.
+void writeRun(const std::string& path, const std::vector<JournalRecord>& records) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(JournalRecord)));
+    out.close();
+    if (!out) throw std::runtime_error("Cannot write " + path);
+}
+
+class RunReader {
+public:
+    RunReader(const std::string& path, std::size_t capacity)
+        : in(path, std::ios::binary), buffer(std::max<std::size_t>(1, capacity)) {
+        if (!in) throw std::runtime_error("Cannot read " + path);
+    }
+
+    bool next(JournalRecord& record) {
+        if (pos == filled) {
+            in.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(JournalRecord)));
+            filled = static_cast<std::size_t>(in.gcount()) / sizeof(JournalRecord);
+            pos = 0;
+            if (filled == 0) return false;
+        }
+        record = buffer[pos++];
+        return true;
+    }
+
+private:
+    std::ifstream in;
+    std::vector<JournalRecord> buffer;
+    std::size_t pos = 0;
+    std::size_t filled = 0;
+};
+
+// Run files still on disk; whatever is left is removed on the way out,
+// including when a pass throws.
+struct TempFiles {
+    std::vector<std::string> paths;
+
+    ~TempFiles() {
+        for (const std::string& path : paths) std::remove(path.c_str());
+    }
+
+    void release(const std::string& path) {
+        std::remove(path.c_str());
+        paths.erase(std::find(paths.begin(), paths.end(), path));
+    }
+};
+
+// k-way heap merge of sorted runs into output; returns the record count.
+std::size_t mergeRuns(const std::vector<std::string>& inputs, const std::string& output, std::size_t memoryBytes) {
+    std::size_t perBuffer = std::min(memoryBytes / (inputs.size() + 1), kMaxBufferBytes) / sizeof(JournalRecord);
+    std::vector<RunReader> readers;
+    readers.reserve(inputs.size());
+    for (const std::string& path : inputs) readers.emplace_back(path, perBuffer);
+
+    std::vector<JournalRecord> heads(inputs.size());
+    auto later = [&](std::size_t a, std::size_t b) { return txnBefore(heads[b], heads[a]); };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> queue(later);
+    for (std::size_t i = 0; i < readers.size(); i++) {
+        if (readers[i].next(heads[i])) queue.push(i);
+    }
+
+    RunWriter writer(output, perBuffer);
+    std::size_t count = 0;
+    while (!queue.empty()) {
+        std::size_t i = queue.top();
+        queue.pop();
+        writer.put(heads[i]);
+        count++;
+        if (readers[i].next(heads[i])) queue.push(i);
+    }
+    writer.close();
+    return count;
+}
+
+} // namespace
+
+SortStats sortJournalByTxn(const std::string& inputPath, const std::string& outputPath, SortOptions options,
+                           const std::function<bool(const JournalRecord&)>& keep) {
+    SortStats stats;
+    unsigned threads = resolveThreads(options.threads);
+    stats.threads = threads;
+    std::size_t perThread = options.memoryBytes / threads / sizeof(JournalRecord);
+    if (perThread < 2) throw std::invalid_argument("Sort memory too small for " + std::to_string(threads) + " threads");
+
+    // Phase 1: each thread takes the next memory-sized chunk of the input,
+    // sorts it and writes it out as a run, while the others read or sort.
+    auto start = std::chrono::steady_clock::now();
+    JournalReader reader(inputPath);
+    if (!reader.isOpen()) throw std::runtime_error("Cannot read " + inputPath);
+    stats.inputBytes = reader.totalBytes();
+    TempFiles temp;
+    std::vector<std::string> runs;
+    std::mutex mutex;
+    bool exhausted = false;
+    std::string error;
+    std::string runPrefix = options.tempDir + "/" + outputPath.substr(outputPath.find_last_of("/\\") + 1) + ".run";
+
+    runOnThreads(threads, [&](unsigned) {
+        std::vector<JournalRecord> chunk;
+        chunk.reserve(perThread);
+        try {
+            for (;;) {
+                std::string path;
+                chunk.clear();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (exhausted || !error.empty()) return;
+                    JournalRecord record;
+                    while (chunk.size() < perThread && reader.next(record)) {
+                        if (!keep || keep(record)) chunk.push_back(record);
+                    }
+                    if (chunk.size() < perThread) exhausted = true;
+                    if (chunk.empty()) return;
+                    path = runPrefix + std::to_string(runs.size()) + ".tmp";
+                    runs.push_back(path);
+                    temp.paths.push_back(path);
+                }
+                std::sort(chunk.begin(), chunk.end(), txnBefore);
+                writeRun(path, chunk);
+            }
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = e.what();
+        }
+    });
+    if (!error.empty()) throw std::runtime_error(error);
+    stats.validBytes = reader.validBytes();
+    stats.runs = runs.size();
+    stats.runSeconds = secondsSince(start);
+
+    // Phase 2: while there are more runs than one merge can take, merge
+    // groups of them into longer runs, one group per thread at a time.
+    start = std::chrono::steady_clock::now();
+    std::size_t groupFanIn = fanInFor(options.memoryBytes / threads);
+    while (runs.size() > fanInFor(options.memoryBytes)) {
+        std::size_t groups = (runs.size() + groupFanIn - 1) / groupFanIn;
+        std::vector<std::string> merged(groups);
+        for (std::size_t g = 0; g < groups; g++) {
+            merged[g] = runPrefix + "p" + std::to_string(stats.mergePasses) + "." + std::to_string(g) + ".tmp";
+            temp.paths.push_back(merged[g]);
+        }
+        unsigned workers = static_cast<unsigned>(std::min<std::size_t>(threads, groups));
+        runOnThreads(workers, [&](unsigned part) {
+            try {
+                for (std::size_t g = part; g < groups; g += workers) {
+                    std::size_t first = g * groupFanIn;
+                    std::size_t last = std::min(runs.size(), first + groupFanIn);
+                    mergeRuns(std::vector<std::string>(runs.begin() + first, runs.begin() + last), merged[g],
+                              options.memoryBytes / workers);
+                }
+            } catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = e.what();
+            }
+        });
+        if (!error.empty()) throw std::runtime_error(error);
+        for (const std::string& path : runs) temp.release(path);
+        runs.swap(merged);
+        stats.mergePasses++;
+    }
+    stats.records = mergeRuns(runs, outputPath, options.memoryBytes);
+    stats.mergePasses++;
+    stats.mergeSeconds = secondsSince(start);
+    return stats;
+}
+
+} // namespace atm
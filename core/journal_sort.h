@@ -0,0 +1,53 @@
+#ifndef ATM_JOURNAL_SORT_H
+#define ATM_JOURNAL_SORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "journal.h"
+
+namespace atm {
+
+// External merge sort of journal files by transaction ID.
+//
+// Journals are in LSN order and can be far larger than memory. The input
+// is read once into sorted runs of at most memoryBytes in total across
+// the sorting threads, and the runs are merged with a k-way heap merge in
+// as many passes as the fan-in allows (one per ~64 KiB read buffer that
+// fits in memoryBytes), the intermediate passes in parallel. Output
+// records are the input records byte for byte, so their checksums still
+// hold and a JournalReader can read the result.
+//
+// Records with the same transaction ID keep their LSN order.
+
+struct SortOptions {
+    std::size_t memoryBytes = std::size_t(256) << 20;
+    unsigned threads = 0;          // 0: one per hardware thread
+    std::string tempDir = ".";     // run files go here and are removed afterwards
+};
+
+struct SortStats {
+    std::uint64_t inputBytes = 0;  // size of the input, every segment counted uncompressed
+    std::uint64_t validBytes = 0;  // bytes up to the first bad record (a torn tail)
+    std::size_t records = 0;       // records written, after the filter
+    std::size_t runs = 0;          // initial sorted runs
+    unsigned mergePasses = 0;
+    unsigned threads = 0;
+    double runSeconds = 0;
+    double mergeSeconds = 0;
+
+    bool truncated() const { return validBytes != inputBytes; }
+};
+
+// Sorts the records of inputPath for which keep returns true (all of them
+// without a filter) into outputPath. Throws std::runtime_error if a file
+// cannot be read or written, and std::invalid_argument if memoryBytes is
+// too small to hold two records per thread.
+SortStats sortJournalByTxn(const std::string& inputPath, const std::string& outputPath, SortOptions options = SortOptions(),
+                           const std::function<bool(const JournalRecord&)>& keep = nullptr);
+
+} // namespace atm
+
+#endif // ATM_JOURNAL_SORT_H
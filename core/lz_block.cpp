@@ -0,0 +1,166 @@
+#include "lz_block.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace atm {
+
+namespace {
+
+constexpr unsigned kHashBits = 13;
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kMaxOffset = 65535;
+
+std::uint32_t read32(const std::uint8_t* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+std::uint64_t read64(const std::uint8_t* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+unsigned hashOf(std::uint32_t v) {
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// Length of the common run at a and b, b being the later one, up to end.
+std::size_t matchLength(const std::uint8_t* a, const std::uint8_t* b, const std::uint8_t* end) {
+    const std::uint8_t* start = b;
+    while (b + 8 <= end && read64(a) == read64(b)) {
+        a += 8;
+        b += 8;
+    }
+    while (b < end && *a == *b) {
+        a++;
+        b++;
+    }
+    return static_cast<std::size_t>(b - start);
+}
+
+std::uint8_t* writeLength(std::uint8_t* op, std::size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<std::uint8_t>(length);
+    return op;
+}
+
+// One sequence; matchLength 0 for the final, literals-only one.
+std::uint8_t* emit(std::uint8_t* op, const std::uint8_t* literals, std::size_t literalLength,
+                   std::size_t matchLength, std::size_t offset) {
+    std::size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+    *op++ = static_cast<std::uint8_t>((literalLength < 15 ? literalLength : 15) << 4 | (matchCode < 15 ? matchCode : 15));
+    if (literalLength >= 15) op = writeLength(op, literalLength - 15);
+    std::memcpy(op, literals, literalLength);
+    op += literalLength;
+    if (matchLength) {
+        *op++ = static_cast<std::uint8_t>(offset);
+        *op++ = static_cast<std::uint8_t>(offset >> 8);
+        if (matchCode >= 15) op = writeLength(op, matchCode - 15);
+    }
+    return op;
+}
+
+// Reads the extra bytes of a length whose nibble was 15.
+bool readLength(const std::uint8_t*& ip, const std::uint8_t* end, std::size_t& length) {
+    std::uint8_t b;
+    do {
+        if (ip == end) return false;
+        b = *ip++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+} // namespace
+
+std::size_t lzCompressBound(std::size_t n) {
+    return n + n / 255 + 16;
+}
+
+std::size_t lzCompress(const void* data, std::size_t n, void* out) {
+    const std::uint8_t* src = static_cast<const std::uint8_t*>(data);
+    const std::uint8_t* end = src + n;
+    const std::uint8_t* ip = src;
+    const std::uint8_t* anchor = src;
+    std::uint8_t* op = static_cast<std::uint8_t*>(out);
+
+    std::uint32_t table[1u << kHashBits] = {};
+    while (n >= kMinMatch && ip <= end - kMinMatch) {
+        std::uint32_t v = read32(ip);
+        unsigned h = hashOf(v);
+        const std::uint8_t* candidate = src + table[h];
+        table[h] = static_cast<std::uint32_t>(ip - src);
+        if (candidate < ip && static_cast<std::size_t>(ip - candidate) <= kMaxOffset && read32(candidate) == v) {
+            std::size_t length = kMinMatch + matchLength(candidate + kMinMatch, ip + kMinMatch, end);
+            op = emit(op, anchor, static_cast<std::size_t>(ip - anchor), length, static_cast<std::size_t>(ip - candidate));
+            ip += length;
+            anchor = ip;
+            // Index the end of the match too, so back-to-back repeats chain.
+            if (ip <= end - kMinMatch && ip - 2 > src) {
+                table[hashOf(read32(ip - 2))] = static_cast<std::uint32_t>(ip - 2 - src);
+            }
+        } else {
+            // Step faster through data that keeps missing.
+            std::size_t step = 1 + (static_cast<std::size_t>(ip - anchor) >> 6);
+            if (static_cast<std::size_t>(end - ip) < step + kMinMatch) break;
+            ip += step;
+        }
+    }
+    op = emit(op, anchor, static_cast<std::size_t>(end - anchor), 0, 0);
+    return static_cast<std::size_t>(op - static_cast<std::uint8_t*>(out));
+}
+
+bool lzDecompress(const void* data, std::size_t n, void* out, std::size_t outSize) {
+    const std::uint8_t* ip = static_cast<const std::uint8_t*>(data);
+    const std::uint8_t* end = ip + n;
+    std::uint8_t* const dst = static_cast<std::uint8_t*>(out);
+    std::uint8_t* op = dst;
+    std::uint8_t* const outEnd = dst + outSize;
+
+    while (ip < end) {
+        std::uint8_t token = *ip++;
+        std::size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, end, literalLength)) return false;
+        if (literalLength > static_cast<std::size_t>(end - ip) || literalLength > static_cast<std::size_t>(outEnd - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == end) break;   // the final sequence has no match
+
+        if (end - ip < 2) return false;
+        std::size_t offset = ip[0] | static_cast<std::size_t>(ip[1]) << 8;
+        ip += 2;
+        std::size_t length = token & 15;
+        if (length == 15 && !readLength(ip, end, length)) return false;
+        length += kMinMatch;
+        if (offset == 0 || offset > static_cast<std::size_t>(op - dst) || length > static_cast<std::size_t>(outEnd - op)) {
+            return false;
+        }
+        const std::uint8_t* match = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, match, length);
+            op += length;
+        } else {
+            // Overlapping: the match repeats its first offset bytes, so each
+            // copy can take everything written since match, doubling.
+            std::uint8_t* stop = op + length;
+            while (op < stop) {
+                std::size_t chunk = std::min(static_cast<std::size_t>(op - match), static_cast<std::size_t>(stop - op));
+                std::memcpy(op, match, chunk);
+                op += chunk;
+            }
+        }
+    }
+    return op == outEnd;
+}
+
+} // namespace atm
@@ -0,0 +1,31 @@
+#ifndef ATM_LZ_BLOCK_H
+#define ATM_LZ_BLOCK_H
+
+#include <cstddef>
+
+namespace atm {
+
+// Block compression in the LZ4 style: a greedy LZ77 pass with a small hash
+// table of 4-byte prefixes, emitting sequences of
+//   token (literal length << 4 | match length - 4), extra length bytes,
+//   literals, 2-byte little-endian match offset, extra length bytes
+// where a nibble of 15 continues in following bytes (255 = keep adding).
+// The last sequence has literals only. Offsets are 16 bits, so blocks
+// should be at most 64 KiB; larger inputs still work but find fewer
+// matches. Fast rather than small, for data written once and read often.
+
+// Largest compressed size of n input bytes.
+std::size_t lzCompressBound(std::size_t n);
+
+// Compresses n bytes into out, which must have lzCompressBound(n) bytes,
+// and returns the compressed size.
+std::size_t lzCompress(const void* data, std::size_t n, void* out);
+
+// Decompresses n bytes of data into exactly outSize bytes of out. Returns
+// false if the input is malformed or does not decode to outSize bytes;
+// never reads or writes outside the two buffers.
+bool lzDecompress(const void* data, std::size_t n, void* out, std::size_t outSize);
+
+} // namespace atm
+
+#endif // ATM_LZ_BLOCK_H
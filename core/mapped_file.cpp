@@ -0,0 +1,171 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <cstring>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace atm {
+
+namespace {
+
+[[noreturn]] void fail(const std::string& what, const std::string& path) {
+#ifdef _WIN32
+    throw std::runtime_error(what + " " + path + " (error " + std::to_string(GetLastError()) + ")");
+#else
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+#endif
+}
+
+} // namespace
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        base = other.base;
+        length = other.length;
+        filePath = std::move(other.filePath);
+#ifdef _WIN32
+        fileHandle = other.fileHandle;
+        mappingHandle = other.mappingHandle;
+        other.fileHandle = other.mappingHandle = nullptr;
+#endif
+        other.base = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+MappedFile MappedFile::create(const std::string& path, std::size_t size) {
+    return map(path, size, true);
+}
+
+MappedFile MappedFile::open(const std::string& path) {
+    return map(path, 0, false);
+}
+
+#ifdef _WIN32
+
+MappedFile MappedFile::map(const std::string& path, std::size_t size, bool create) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                              create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) fail("Cannot open", path);
+
+    LARGE_INTEGER fileSize;
+    if (create) {
+        fileSize.QuadPart = static_cast<LONGLONG>(size);
+    } else if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        fail("Cannot stat", path);
+    }
+    if (fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("Cannot map empty file " + path);
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, fileSize.HighPart, fileSize.LowPart, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        fail("Cannot map", path);
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        fail("Cannot map", path);
+    }
+
+    MappedFile mf;
+    mf.base = static_cast<unsigned char*>(view);
+    mf.length = static_cast<std::size_t>(fileSize.QuadPart);
+    mf.filePath = path;
+    mf.fileHandle = file;
+    mf.mappingHandle = mapping;
+    return mf;
+}
+
+void MappedFile::sync(std::size_t offset, std::size_t len) const {
+    if (!base) return;
+    if (!FlushViewOfFile(base + offset, len) || !FlushFileBuffers(static_cast<HANDLE>(fileHandle))) {
+        fail("Cannot flush", filePath);
+    }
+}
+
+void MappedFile::release() {
+    if (base) UnmapViewOfFile(base);
+    if (mappingHandle) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+    base = nullptr;
+    mappingHandle = fileHandle = nullptr;
+    length = 0;
+}
+
+#else
+
+MappedFile MappedFile::map(const std::string& path, std::size_t size, bool create) {
+    int fd = ::open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (fd < 0) fail("Cannot open", path);
+
+    if (create) {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            fail("Cannot size", path);
+        }
+    } else {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            fail("Cannot stat", path);
+        }
+        size = static_cast<std::size_t>(st.st_size);
+    }
+    if (size == 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot map empty file " + path);
+    }
+
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);   // the mapping keeps the file referenced
+    if (addr == MAP_FAILED) fail("Cannot map", path);
+
+    MappedFile mf;
+    mf.base = static_cast<unsigned char*>(addr);
+    mf.length = size;
+    mf.filePath = path;
+    return mf;
+}
+
+void MappedFile::sync(std::size_t offset, std::size_t len) const {
+    if (!base) return;
+    // msync wants a page-aligned start address.
+    std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t start = offset - offset % page;
+    if (msync(base + start, len + (offset - start), MS_SYNC) != 0) fail("Cannot flush", filePath);
+}
+
+void MappedFile::release() {
+    if (base) munmap(base, length);
+    base = nullptr;
+    length = 0;
+}
+
+#endif
+
+} // namespace atm
@@ -0,0 +1,48 @@
+#ifndef ATM_MAPPED_FILE_H
+#define ATM_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace atm {
+
+// Read-write shared mapping of a whole file (mmap on POSIX, a file mapping
+// view on Windows). Failures throw std::runtime_error naming the file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Creates (or truncates) path to exactly size bytes and maps it.
+    static MappedFile create(const std::string& path, std::size_t size);
+    // Maps an existing file. Nothing is read until pages are touched.
+    static MappedFile open(const std::string& path);
+
+    unsigned char* data() const { return base; }
+    std::size_t size() const { return length; }
+    const std::string& path() const { return filePath; }
+
+    // Writes the dirty pages covering [offset, offset + len) back to disk.
+    void sync(std::size_t offset, std::size_t len) const;
+    void sync() const { sync(0, length); }
+
+private:
+    unsigned char* base = nullptr;
+    std::size_t length = 0;
+    std::string filePath;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+    void release();
+    static MappedFile map(const std::string& path, std::size_t size, bool create);
+};
+
+} // namespace atm
+
+#endif // ATM_MAPPED_FILE_H
@@ -0,0 +1,31 @@
+#include "money.h"
+
+#include <cstdio>
+
+namespace atm {
+
+namespace {
+
+int format(Money amount, char (&buf)[32]) {
+    // Work on the magnitude as unsigned so INT64_MIN formats correctly.
+    std::uint64_t magnitude = amount < 0 ? 0 - static_cast<std::uint64_t>(amount) : static_cast<std::uint64_t>(amount);
+    return std::snprintf(buf, sizeof(buf), "%s%llu.%02llu", amount < 0 ? "-" : "",
+                         static_cast<unsigned long long>(magnitude / kPaisePerRupee),
+                         static_cast<unsigned long long>(magnitude % kPaisePerRupee));
+}
+
+} // namespace
+
+std::string formatMoney(Money amount) {
+    char buf[32];
+    int length = format(amount, buf);
+    return std::string(buf, static_cast<std::size_t>(length));
+}
+
+std::pmr::string formatMoney(Money amount, std::pmr::memory_resource* memory) {
+    char buf[32];
+    int length = format(amount, buf);
+    return std::pmr::string(buf, static_cast<std::size_t>(length), memory);
+}
+
+} // namespace atm
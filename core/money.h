@@ -0,0 +1,27 @@
+#ifndef ATM_MONEY_H
+#define ATM_MONEY_H
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+namespace atm {
+
+// All amounts are whole paise (1/100 rupee) in a signed 64-bit integer, so
+// balances add and compare exactly and never go through floating point.
+using Money = std::int64_t;
+
+constexpr Money kPaisePerRupee = 100;
+
+constexpr Money rupees(long long whole, int paise = 0) {
+    return whole * kPaisePerRupee + paise;
+}
+
+// "1500.50" style, as shown on screen and receipts.
+std::string formatMoney(Money amount);
+// The same, allocated from memory (e.g. a SessionArena).
+std::pmr::string formatMoney(Money amount, std::pmr::memory_resource* memory);
+
+} // namespace atm
+
+#endif // ATM_MONEY_H
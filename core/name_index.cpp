@@ -0,0 +1,183 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <string>
+
+namespace atm {
+
+namespace {
+
+// Lower-cases ASCII letters, turns runs of blanks into one space and drops
+// leading ones; trailing ones too when trimEnd is set. Other bytes, UTF-8
+// included, are kept as they are.
+std::string fold(std::string_view text, bool trimEnd) {
+    std::string out;
+    out.reserve(text.size());
+    bool blank = true;
+    for (char c : text) {
+        if (c == ' ' || c == '\t') {
+            if (!blank) out.push_back(' ');
+            blank = true;
+            continue;
+        }
+        out.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+        blank = false;
+    }
+    if (trimEnd && !out.empty() && out.back() == ' ') out.pop_back();
+    return out;
+}
+
+std::size_t commonPrefix(std::string_view a, std::string_view b) {
+    std::size_t n = std::min(a.size(), b.size());
+    std::size_t i = 0;
+    while (i < n && a[i] == b[i]) i++;
+    return i;
+}
+
+} // namespace
+
+NameIndex::NameIndex() {
+    nodes.push_back(Node{NamePool::kEmpty, 0, 0, kNone, kNone, kNone, 0});
+}
+
+NameIndex NameIndex::fromStore(const AccountStore& store) {
+    NameIndex index;
+    index.reserve(store.size());
+    for (const Account& account : store) index.add(account.getName(), account.getAccountNumber());
+    return index;
+}
+
+void NameIndex::reserve(std::size_t expectedAccounts) {
+    // Two or three words a name; nodes stay far fewer where names repeat.
+    postings.reserve(expectedAccounts * 2);
+}
+
+void NameIndex::add(std::string_view holderName, int accountNumber) {
+    std::string folded = fold(holderName, true);
+    if (folded.empty()) return;
+    std::uint32_t name = names.intern(folded);
+    for (std::size_t start = 0; start < folded.size(); start++) {
+        if (start == 0 || folded[start - 1] == ' ') insert(name, start, accountNumber);
+    }
+    accounts++;
+}
+
+// Walks the key names[name][start..] down from the root, splitting the
+// edge where it parts from the key, and posts the account at its end.
+void NameIndex::insert(std::uint32_t name, std::size_t start, int accountNumber) {
+    std::size_t keyLength = names.view(name).size();
+    std::uint32_t node = 0;
+    std::size_t pos = start;
+    while (pos < keyLength) {
+        unsigned char c = static_cast<unsigned char>(names.view(name)[pos]);
+        std::uint32_t child = children.find(childKey(node, c));
+        if (child == HashIndex::kNotFound) {
+            auto leaf = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back(Node{name, static_cast<std::uint16_t>(pos), static_cast<std::uint16_t>(keyLength - pos),
+                                 kNone, kNone, kNone, c});
+            link(node, leaf);
+            children.insert(childKey(node, c), leaf);
+            node = leaf;
+            break;
+        }
+
+        std::string_view key = names.view(name).substr(pos);
+        std::string_view edge = label(nodes[child]);
+        std::size_t common = commonPrefix(edge, key);
+        if (common < edge.size()) {
+            // A new node takes the shared part of the label and the
+            // child's place under node; the child keeps the rest, with its
+            // own children and postings, so none of them is re-keyed.
+            auto upper = static_cast<std::uint32_t>(nodes.size());
+            Node shared = nodes[child];
+            shared.length = static_cast<std::uint16_t>(common);
+            shared.child = child;
+            shared.postings = kNone;
+            nodes.push_back(shared);
+            Node& rest = nodes[child];
+            rest.start = static_cast<std::uint16_t>(rest.start + common);
+            rest.length = static_cast<std::uint16_t>(rest.length - common);
+            rest.sibling = kNone;
+            rest.first = static_cast<unsigned char>(edge[common]);
+            if (nodes[node].child == child) {
+                nodes[node].child = upper;
+            } else {
+                std::uint32_t previous = nodes[node].child;
+                while (nodes[previous].sibling != child) previous = nodes[previous].sibling;
+                nodes[previous].sibling = upper;
+            }
+            children.assign(childKey(node, c), upper);
+            children.insert(childKey(upper, rest.first), child);
+            child = upper;
+        }
+        node = child;
+        pos += common;
+    }
+    postings.push_back(Posting{accountNumber, nodes[node].postings});
+    nodes[node].postings = static_cast<std::uint32_t>(postings.size() - 1);
+}
+
+// Puts child into parent's sibling list, which stays sorted by first byte.
+void NameIndex::link(std::uint32_t parent, std::uint32_t child) {
+    unsigned char c = nodes[child].first;
+    std::uint32_t next = nodes[parent].child;
+    if (next == kNone || nodes[next].first > c) {
+        nodes[child].sibling = next;
+        nodes[parent].child = child;
+        return;
+    }
+    while (nodes[next].sibling != kNone && nodes[nodes[next].sibling].first < c) next = nodes[next].sibling;
+    nodes[child].sibling = nodes[next].sibling;
+    nodes[next].sibling = child;
+}
+
+std::size_t NameIndex::find(std::string_view prefix, std::vector<int>& out, std::size_t limit) const {
+    std::string key = fold(prefix, false);
+    if (key.empty() || limit == 0) return 0;
+
+    // Down to the node whose edge the prefix ends on.
+    std::uint32_t node = 0;
+    std::size_t pos = 0;
+    while (pos < key.size()) {
+        std::uint32_t child = children.find(childKey(node, static_cast<unsigned char>(key[pos])));
+        if (child == HashIndex::kNotFound) return 0;
+        std::string_view edge = label(nodes[child]);
+        std::size_t common = commonPrefix(edge, std::string_view(key).substr(pos));
+        if (pos + common < key.size() && common < edge.size()) return 0;
+        node = child;
+        pos += common;
+    }
+
+    // Every key below it, in order: the node's own postings, then each
+    // child's subtree from the smallest first byte.
+    std::size_t first = out.size();
+    auto post = [&](std::uint32_t n) {
+        for (std::uint32_t p = nodes[n].postings; p != kNone; p = postings[p].next) {
+            int account = postings[p].accountNumber;
+            if (std::find(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(), account) != out.end()) continue;
+            out.push_back(account);
+            if (out.size() - first == limit) return false;
+        }
+        return true;
+    };
+    if (!post(node)) return limit;
+    std::vector<std::uint32_t> stack{nodes[node].child};
+    while (!stack.empty()) {
+        std::uint32_t n = stack.back();
+        if (n == kNone) {
+            stack.pop_back();
+            continue;
+        }
+        stack.back() = nodes[n].sibling;
+        if (!post(n)) return limit;
+        stack.push_back(nodes[n].child);
+    }
+    return out.size() - first;
+}
+
+std::size_t NameIndex::memoryBytes() const {
+    return nodes.capacity() * sizeof(Node) + postings.capacity() * sizeof(Posting) + children.memoryBytes() +
+           names.memoryBytes();
+}
+
+} // namespace atm
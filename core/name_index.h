@@ -0,0 +1,88 @@
+#ifndef ATM_NAME_INDEX_H
+#define ATM_NAME_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "account_store.h"
+#include "hash_index.h"
+#include "name_pool.h"
+
+namespace atm {
+
+// Prefix search over account holder names, for operators looking a
+// customer up by part of a name.
+//
+// A radix trie over case-folded names: "Rahul Sharma" is found by "rah",
+// "RAHUL S" and "sharma", since every word of a name starts a key of its
+// own. The folded text of each distinct name is interned once in a
+// NamePool, and trie edges are slices of it (name, start, length), so a
+// split on insert only shortens one slice and adds a node.
+//
+// Going down an edge is one probe of a HashIndex keyed by (node, next
+// byte) rather than a walk along the node's children, which at tens of
+// millions of names would be a cache miss a sibling. The children are
+// also kept in a sibling list sorted by first byte, for listing a subtree
+// in name order. Single writer: add() must not run alongside find().
+class NameIndex {
+public:
+    NameIndex();
+
+    static NameIndex fromStore(const AccountStore& store);
+
+    void reserve(std::size_t accounts);
+
+    // Indexes one account under its holder name. Adding the same account
+    // again under another name keeps both.
+    void add(std::string_view holderName, int accountNumber);
+
+    // Appends to out the accounts having a name word that starts with
+    // prefix, ignoring case, in name order and each once, up to limit of
+    // them; returns how many were appended. An empty prefix matches
+    // nothing. limit is meant to be a screenful: duplicates are weeded out
+    // by a linear search of the results.
+    std::size_t find(std::string_view prefix, std::vector<int>& out, std::size_t limit = 50) const;
+
+    std::size_t size() const { return accounts; }
+    std::size_t nodeCount() const { return nodes.size(); }
+    std::size_t memoryBytes() const;
+
+private:
+    static constexpr std::uint32_t kNone = 0xFFFFFFFF;
+
+    struct Node {
+        std::uint32_t name;       // folded text in names holding the edge label
+        std::uint16_t start;      // label offset within it
+        std::uint16_t length;
+        std::uint32_t child;      // first child, smallest first byte
+        std::uint32_t sibling;
+        std::uint32_t postings;   // accounts whose key ends here
+        unsigned char first;      // first byte of the label
+    };
+
+    struct Posting {
+        std::int32_t accountNumber;
+        std::uint32_t next;
+    };
+
+    std::vector<Node> nodes;   // nodes[0] is the root, with an empty label
+    std::vector<Posting> postings;
+    HashIndex children;        // childKey(parent, first byte) -> node
+    NamePool names;
+    std::size_t accounts = 0;
+
+    std::string_view label(const Node& node) const {
+        return names.view(node.name).substr(node.start, node.length);
+    }
+    static std::uint64_t childKey(std::uint32_t parent, unsigned char first) {
+        return static_cast<std::uint64_t>(parent) << 8 | first;
+    }
+    void insert(std::uint32_t name, std::size_t start, int accountNumber);
+    void link(std::uint32_t parent, std::uint32_t child);
+};
+
+} // namespace atm
+
+#endif // ATM_NAME_INDEX_H
@@ -0,0 +1,54 @@
+#include "name_pool.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace atm {
+
+NamePool::NamePool() {
+    add(std::string_view());
+}
+
+void NamePool::reserve(std::size_t names, std::size_t averageLength) {
+    bytes.reserve(names * (averageLength + 2));
+    lookup.reserve(names);
+}
+
+std::uint64_t NamePool::hashText(std::string_view text) {
+    // FNV-1a; HashIndex mixes the result again before probing.
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (char c : text) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+std::uint32_t NamePool::add(std::string_view text) {
+    if (text.size() > kMaxLength) throw std::invalid_argument("Name longer than 65535 bytes");
+    std::size_t offset = bytes.size();
+    if (offset + 2 + text.size() > 0xFFFFFFFFull) throw std::runtime_error("Name pool is full");
+    bytes.resize(offset + 2 + text.size());
+    bytes[offset] = static_cast<char>(text.size() & 0xFF);
+    bytes[offset + 1] = static_cast<char>(text.size() >> 8);
+    if (!text.empty()) std::memcpy(bytes.data() + offset + 2, text.data(), text.size());
+    count++;
+    return static_cast<std::uint32_t>(offset);
+}
+
+std::uint32_t NamePool::intern(std::string_view text) {
+    if (text.empty()) return kEmpty;
+    std::uint64_t key = hashText(text);
+    std::uint32_t existing = lookup.find(key);
+    if (existing != HashIndex::kNotFound) {
+        if (view(existing) == text) return existing;
+        // A 64-bit hash collision: keep the first string indexed and store
+        // this one unshared.
+        return add(text);
+    }
+    std::uint32_t offset = add(text);
+    lookup.insert(key, offset);
+    return offset;
+}
+
+} // namespace atm
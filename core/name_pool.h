@@ -0,0 +1,62 @@
+#ifndef ATM_NAME_POOL_H
+#define ATM_NAME_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "hash_index.h"
+
+namespace atm {
+
+// Append-only store for holder names and other short display strings.
+//
+// Every string lives in one contiguous buffer behind a two-byte length and
+// is identified by its 32-bit byte offset, so a table of a million names
+// costs the bytes themselves plus four bytes per reference instead of a
+// heap block per name. intern() returns the existing offset when the same
+// text was added before; identical names are stored once.
+//
+// Views returned by view() stay valid until the next add() or intern(),
+// which may grow the buffer. Offsets stay valid for the life of the pool.
+class NamePool {
+public:
+    static constexpr std::size_t kMaxLength = 0xFFFF;
+    // Offset of the empty string, which every pool holds.
+    static constexpr std::uint32_t kEmpty = 0;
+
+    NamePool();
+
+    // Sizes the pool for about names distinct strings of averageLength
+    // bytes. Not worth it when most strings will be duplicates.
+    void reserve(std::size_t names, std::size_t averageLength = 16);
+
+    // Always appends a new copy. Both throw std::invalid_argument for text
+    // longer than kMaxLength and std::runtime_error once the pool would
+    // pass 4 GiB.
+    std::uint32_t add(std::string_view text);
+    std::uint32_t intern(std::string_view text);
+
+    std::string_view view(std::uint32_t offset) const {
+        const char* p = bytes.data() + offset;
+        std::size_t length = static_cast<unsigned char>(p[0]) | static_cast<std::size_t>(static_cast<unsigned char>(p[1])) << 8;
+        return std::string_view(p + 2, length);
+    }
+
+    // Strings stored (the empty one included), and bytes used.
+    std::size_t size() const { return count; }
+    std::size_t bytesUsed() const { return bytes.size(); }
+    std::size_t memoryBytes() const { return bytes.capacity() + lookup.memoryBytes(); }
+
+private:
+    std::vector<char> bytes;
+    HashIndex lookup;   // text hash -> offset, for intern()
+    std::size_t count = 0;
+
+    static std::uint64_t hashText(std::string_view text);
+};
+
+} // namespace atm
+
+#endif // ATM_NAME_POOL_H
@@ -0,0 +1,48 @@
+#include "nfc_request.h"
+
+using std::string;
+
+namespace atm {
+
+std::string_view httpRequestBody(std::string_view rawRequest) {
+    size_t bodyPos = rawRequest.find("\r\n\r\n");
+    if (bodyPos != std::string_view::npos) {
+        return rawRequest.substr(bodyPos + 4);
+    }
+    return rawRequest;
+}
+
+std::pmr::string parseJsonValue(std::string_view body, std::string_view key, std::pmr::memory_resource* memory) {
+    std::pmr::string value(memory);
+    // Find "key" without building the quoted search string.
+    size_t keyPos = 0;
+    for (;;) {
+        keyPos = body.find(key, keyPos);
+        if (keyPos == std::string_view::npos) return value;
+        if (keyPos > 0 && body[keyPos - 1] == '"' && keyPos + key.size() < body.size() && body[keyPos + key.size()] == '"') break;
+        keyPos++;
+    }
+
+    size_t colonPos = body.find(':', keyPos);
+    if (colonPos == std::string_view::npos) return value;
+
+    size_t valueStart = colonPos + 1;
+    size_t valueEnd = body.find_first_of(",}", valueStart);
+    if (valueEnd == std::string_view::npos) valueEnd = body.length();
+
+    for (char c : body.substr(valueStart, valueEnd - valueStart)) {
+        if (c != '\"' && c != ' ' && c != '\n' && c != '\r') value += c;
+    }
+    return value;
+}
+
+string httpRequestBody(const string& rawRequest) {
+    return string(httpRequestBody(std::string_view(rawRequest)));
+}
+
+string parseJsonValue(const string& body, const string& key) {
+    std::pmr::string value = parseJsonValue(std::string_view(body), std::string_view(key), std::pmr::new_delete_resource());
+    return string(value.data(), value.size());
+}
+
+} // namespace atm
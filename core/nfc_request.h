@@ -0,0 +1,22 @@
+#ifndef ATM_NFC_REQUEST_H
+#define ATM_NFC_REQUEST_H
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace atm {
+
+// The phone posts a small JSON body such as {"cardNum": "8825"} over plain
+// HTTP. These helpers pull the value out without a JSON dependency.
+std::string httpRequestBody(const std::string& rawRequest);
+std::string parseJsonValue(const std::string& body, const std::string& key);
+
+// Session variants: the body is a view into the request, and the value is
+// allocated from memory (e.g. a SessionArena).
+std::string_view httpRequestBody(std::string_view rawRequest);
+std::pmr::string parseJsonValue(std::string_view body, std::string_view key, std::pmr::memory_resource* memory);
+
+} // namespace atm
+
+#endif // ATM_NFC_REQUEST_H
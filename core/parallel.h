@@ -0,0 +1,59 @@
+#ifndef ATM_PARALLEL_H
+#define ATM_PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace atm {
+
+// Thread count to use when the caller passes 0: one per hardware thread.
+inline unsigned resolveThreads(unsigned threads) {
+    return threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs fn(0) ... fn(threads - 1) concurrently and waits for all of them.
+// fn(0) runs on the calling thread. If any of them throws, the others
+// still run to the end, and then the exception of the lowest-numbered
+// one that threw is rethrown here.
+template <typename Fn>
+void runOnThreads(unsigned threads, Fn fn) {
+    std::vector<std::exception_ptr> errors(std::max(threads, 1u));
+    auto run = [&](unsigned t) {
+        try {
+            fn(t);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads > 0 ? threads - 1 : 0);
+    try {
+        for (unsigned t = 1; t < threads; t++) pool.emplace_back(run, t);
+    } catch (...) {
+        // Out of threads: wait for the ones already started before giving up.
+        for (std::thread& th : pool) th.join();
+        throw;
+    }
+    run(0u);
+    for (std::thread& th : pool) th.join();
+    for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+// Half-open range [begin, end) of item part out of parts equal slices of n.
+struct Slice {
+    std::size_t begin;
+    std::size_t end;
+};
+
+inline Slice sliceOf(std::size_t n, unsigned part, unsigned parts) {
+    return Slice{n * part / parts, n * (part + 1) / parts};
+}
+
+} // namespace atm
+
+#endif // ATM_PARALLEL_H
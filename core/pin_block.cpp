@@ -0,0 +1,206 @@
+#include "pin_block.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#include "pin_hash.h"
+
+namespace atm {
+
+namespace {
+
+constexpr std::size_t kBatch = 64;   // blocks per pass; keeps the working set on the stack
+
+using Field = std::uint8_t[Aes128::kBlockSize];
+
+void setNibble(std::uint8_t* bytes, std::size_t index, unsigned value) {
+    std::uint8_t& b = bytes[index / 2];
+    b = index % 2 ? static_cast<std::uint8_t>((b & 0xF0) | value) : static_cast<std::uint8_t>((b & 0x0F) | value << 4);
+}
+
+unsigned nibble(const std::uint8_t* bytes, std::size_t index) {
+    return index % 2 ? bytes[index / 2] & 0x0F : bytes[index / 2] >> 4;
+}
+
+// Decimal digits of the PAN (as values 0-9); returns the digit count.
+std::size_t panDigits(long long pan, std::uint8_t digits[20]) {
+    std::uint8_t reversed[20];
+    std::size_t n = 0;
+    unsigned long long v = pan < 0 ? 0 : static_cast<unsigned long long>(pan);
+    do {
+        reversed[n++] = static_cast<std::uint8_t>(v % 10);
+        v /= 10;
+    } while (v != 0);
+    for (std::size_t i = 0; i < n; i++) digits[i] = reversed[n - 1 - i];
+    return n;
+}
+
+// Format 0: four zero nibbles, then the 12 rightmost PAN digits excluding
+// the check digit (left-padded with zeros for short numbers).
+void panField0(long long pan, std::uint8_t* out) {
+    std::uint8_t digits[20];
+    std::size_t n = panDigits(pan, digits);
+    std::size_t body = n > 0 ? n - 1 : 0;
+    std::memset(out, 0, 8);
+    for (std::size_t i = 0; i < 12; i++) {
+        std::size_t from = body >= 12 - i ? body - (12 - i) : SIZE_MAX;
+        setNibble(out, 4 + i, from == SIZE_MAX ? 0 : digits[from]);
+    }
+}
+
+// Format 4: nibble M (PAN length - 12), then the whole PAN (left-padded to
+// 12 digits if shorter), zero-filled.
+void panField4(long long pan, std::uint8_t* out) {
+    std::uint8_t digits[20];
+    std::size_t n = panDigits(pan, digits);
+    std::memset(out, 0, Aes128::kBlockSize);
+    std::size_t width = std::max<std::size_t>(n, 12);
+    setNibble(out, 0, static_cast<unsigned>(width - 12));
+    for (std::size_t i = 0; i < width; i++) {
+        setNibble(out, 1 + i, i < width - n ? 0 : digits[i - (width - n)]);
+    }
+}
+
+std::uint64_t randomWord() {
+    thread_local std::mt19937_64 rng{(std::uint64_t{std::random_device{}()} << 32) ^ std::random_device{}()};
+    return rng();
+}
+
+// Control nibble, length, digits, then fill nibbles up to 16 nibbles.
+void pinField(std::string_view pin, unsigned control, unsigned fill, std::uint8_t* out) {
+    if (pin.size() < kMinPinDigits || pin.size() > kMaxPinDigits) throw std::invalid_argument("PIN must be 4 to 12 digits");
+    setNibble(out, 0, control);
+    setNibble(out, 1, static_cast<unsigned>(pin.size()));
+    for (std::size_t i = 0; i < 14; i++) {
+        if (i < pin.size()) {
+            if (pin[i] < '0' || pin[i] > '9') throw std::invalid_argument("PIN must be 4 to 12 digits");
+            setNibble(out, 2 + i, static_cast<unsigned>(pin[i] - '0'));
+        } else {
+            setNibble(out, 2 + i, fill);
+        }
+    }
+}
+
+bool readPinField(const std::uint8_t* field, unsigned control, unsigned fill, std::string& pin) {
+    pin.clear();
+    if (nibble(field, 0) != control) return false;
+    std::size_t length = nibble(field, 1);
+    if (length < kMinPinDigits || length > kMaxPinDigits) return false;
+    for (std::size_t i = 0; i < 14; i++) {
+        unsigned v = nibble(field, 2 + i);
+        if (i < length ? v > 9 : v != fill) return false;
+    }
+    for (std::size_t i = 0; i < length; i++) pin += static_cast<char>('0' + nibble(field, 2 + i));
+    return true;
+}
+
+void xorInto(std::uint8_t* a, const std::uint8_t* b, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) a[i] ^= b[i];
+}
+
+// Clear format-4 PIN fields to enciphered blocks, in place.
+void encipher4(const Aes128& key, Field* fields, const long long* pans, std::size_t count) {
+    key.encrypt(fields[0], fields[0], count);
+    for (std::size_t i = 0; i < count; i++) {
+        Field pan;
+        panField4(pans[i], pan);
+        xorInto(fields[i], pan, sizeof(pan));
+    }
+    key.encrypt(fields[0], fields[0], count);
+}
+
+// Enciphered blocks to clear PIN fields (format 4) or clear 8-byte blocks
+// in the first half (format 0), in place.
+void decipher(const Aes128& key, PinBlockFormat format, Field* fields, const long long* pans, std::size_t count) {
+    key.decrypt(fields[0], fields[0], count);
+    if (format == PinBlockFormat::Iso0) return;
+    for (std::size_t i = 0; i < count; i++) {
+        Field pan;
+        panField4(pans[i], pan);
+        xorInto(fields[i], pan, sizeof(pan));
+    }
+    key.decrypt(fields[0], fields[0], count);
+}
+
+bool readClear(PinBlockFormat format, std::uint8_t* field, long long pan, std::string& pin) {
+    if (format == PinBlockFormat::Iso4) return readPinField(field, 4, 0xA, pin);
+    for (std::size_t i = 8; i < Aes128::kBlockSize; i++) {
+        if (field[i] != 0) return false;
+    }
+    std::uint8_t panBlock[8];
+    panField0(pan, panBlock);
+    xorInto(field, panBlock, sizeof(panBlock));
+    return readPinField(field, 0, 0xF, pin);
+}
+
+} // namespace
+
+PinBlock encryptPinBlock(const Aes128& key, PinBlockFormat format, std::string_view pin, long long pan) {
+    Field field = {};
+    PinBlock block;
+    if (format == PinBlockFormat::Iso0) {
+        pinField(pin, 0, 0xF, field);
+        std::uint8_t panBlock[8];
+        panField0(pan, panBlock);
+        xorInto(field, panBlock, sizeof(panBlock));
+        key.encrypt(field, block.bytes, 1);
+    } else {
+        pinField(pin, 4, 0xA, field);
+        std::uint64_t fill = randomWord();
+        std::memcpy(field + 8, &fill, sizeof(fill));
+        encipher4(key, &field, &pan, 1);
+        std::memcpy(block.bytes, field, sizeof(field));
+    }
+    return block;
+}
+
+std::size_t decryptPinBlocks(const Aes128& key, PinBlockFormat format, const PinBlock* blocks, const long long* pans,
+                             std::size_t count, std::string* pins) {
+    std::size_t decoded = 0;
+    Field fields[kBatch];
+    for (std::size_t base = 0; base < count; base += kBatch) {
+        std::size_t n = std::min(kBatch, count - base);
+        for (std::size_t i = 0; i < n; i++) std::memcpy(fields[i], blocks[base + i].bytes, sizeof(Field));
+        decipher(key, format, fields, pans + base, n);
+        for (std::size_t i = 0; i < n; i++) decoded += readClear(format, fields[i], pans[base + i], pins[base + i]);
+    }
+    return decoded;
+}
+
+bool decryptPinBlock(const Aes128& key, PinBlockFormat format, const PinBlock& block, long long pan, std::string& pin) {
+    return decryptPinBlocks(key, format, &block, &pan, 1, &pin) == 1;
+}
+
+std::size_t translatePinBlocks(const Aes128& fromKey, PinBlockFormat fromFormat, const Aes128& toKey,
+                               const PinBlock* in, const long long* pans, std::size_t count, PinBlock* out, bool* ok) {
+    std::size_t translated = 0;
+    Field fields[kBatch];
+    std::string pin;
+    for (std::size_t base = 0; base < count; base += kBatch) {
+        std::size_t n = std::min(kBatch, count - base);
+        for (std::size_t i = 0; i < n; i++) std::memcpy(fields[i], in[base + i].bytes, sizeof(Field));
+        decipher(fromKey, fromFormat, fields, pans + base, n);
+        for (std::size_t i = 0; i < n; i++) {
+            bool good = readClear(fromFormat, fields[i], pans[base + i], pin);
+            if (good && fromFormat == PinBlockFormat::Iso0) {
+                // A format-4 field needs fresh random fill.
+                pinField(pin, 4, 0xA, fields[i]);
+                std::uint64_t fill = randomWord();
+                std::memcpy(fields[i] + 8, &fill, sizeof(fill));
+            }
+            if (!good) std::memset(fields[i], 0, sizeof(Field));
+            ok[base + i] = good;
+            translated += good;
+        }
+        encipher4(toKey, fields, pans + base, n);
+        for (std::size_t i = 0; i < n; i++) {
+            if (ok[base + i]) std::memcpy(out[base + i].bytes, fields[i], sizeof(Field));
+            else std::memset(out[base + i].bytes, 0, sizeof(Field));
+        }
+    }
+    return translated;
+}
+
+} // namespace atm
@@ -0,0 +1,60 @@
+#ifndef ATM_PIN_BLOCK_H
+#define ATM_PIN_BLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "aes.h"
+
+namespace atm {
+
+// ISO 9564-1 PIN blocks, so a PIN never travels from the PIN pad in the
+// clear.
+//
+//   Iso0  8-byte block: control nibble 0, PIN length, PIN digits padded
+//         with F, XORed with 12 digits of the PAN. ISO pairs format 0
+//         with TDES; here the 8 bytes are carried in the first half of an
+//         AES block (second half zero) so one key type serves both.
+//   Iso4  16-byte AES block: control nibble 4, PIN length, PIN digits
+//         padded with A, 8 random bytes; enciphered as
+//         E(K, E(K, PIN field) XOR PAN field), so the PAN is bound in.
+//
+// PINs are 4 to 12 decimal digits. The PAN is the card number (callers
+// without one pass the account number).
+enum class PinBlockFormat : std::uint8_t {
+    Iso0 = 0,
+    Iso4 = 4
+};
+
+struct PinBlock {
+    std::uint8_t bytes[Aes128::kBlockSize];
+};
+
+// --- PIN pad side ---
+// Throws std::invalid_argument if pin is not 4 to 12 digits.
+PinBlock encryptPinBlock(const Aes128& key, PinBlockFormat format, std::string_view pin, long long pan);
+
+// --- Security module stand-in ---
+// The batch calls run every AES pass over the whole batch at once, which
+// is what lets AES-NI keep several blocks in flight.
+
+// Recovers the PIN digits into pins[i], or leaves pins[i] empty when the
+// block does not decode (wrong key, wrong PAN or corrupted). Returns how
+// many decoded.
+std::size_t decryptPinBlocks(const Aes128& key, PinBlockFormat format, const PinBlock* blocks, const long long* pans,
+                             std::size_t count, std::string* pins);
+
+bool decryptPinBlock(const Aes128& key, PinBlockFormat format, const PinBlock& block, long long pan, std::string& pin);
+
+// Re-enciphers blocks from (fromKey, fromFormat) to format 4 under toKey,
+// as a switch does between the terminal and issuer key zones. ok[i] says
+// whether block i decoded; out[i] is only meaningful if it did. Returns
+// how many were translated.
+std::size_t translatePinBlocks(const Aes128& fromKey, PinBlockFormat fromFormat, const Aes128& toKey,
+                               const PinBlock* in, const long long* pans, std::size_t count, PinBlock* out, bool* ok);
+
+} // namespace atm
+
+#endif // ATM_PIN_BLOCK_H
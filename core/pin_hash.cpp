@@ -0,0 +1,136 @@
+#include "pin_hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+
+#include "sha256.h"
+
+namespace atm {
+
+static_assert(sizeof(PinCredential) == 28, "PIN credentials are stored inside account records");
+static_assert(std::is_trivially_copyable<PinCredential>::value, "PIN credentials are copied as bytes");
+
+namespace {
+
+constexpr char kCredentialPrefix[] = "$pbkdf2$";
+
+void derive(const PinCredential& credential, std::string_view pin, std::uint8_t digest[sizeof(PinCredential::digest)]) {
+    pbkdf2Sha256(pin.data(), pin.size(), credential.salt, sizeof(credential.salt),
+                 std::uint32_t{1} << credential.cost, digest, sizeof(credential.digest));
+}
+
+void fillSalt(std::uint8_t* salt, std::size_t length) {
+    thread_local std::mt19937_64 rng{(std::uint64_t{std::random_device{}()} << 32) ^ std::random_device{}()};
+    for (std::size_t i = 0; i < length; i += 8) {
+        std::uint64_t word = rng();
+        std::memcpy(salt + i, &word, std::min<std::size_t>(8, length - i));
+    }
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool parseHex(std::string_view text, std::uint8_t* out, std::size_t length) {
+    if (text.size() != length * 2) return false;
+    for (std::size_t i = 0; i < length; i++) {
+        int hi = hexValue(text[2 * i]);
+        int lo = hexValue(text[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = static_cast<std::uint8_t>(hi << 4 | lo);
+    }
+    return true;
+}
+
+void appendHex(std::string& out, const std::uint8_t* data, std::size_t length) {
+    static const char kDigits[] = "0123456789abcdef";
+    for (std::size_t i = 0; i < length; i++) {
+        out += kDigits[data[i] >> 4];
+        out += kDigits[data[i] & 15];
+    }
+}
+
+} // namespace
+
+bool isValidPin(std::string_view pin) {
+    if (pin.size() < kMinPinDigits || pin.size() > kMaxPinDigits) return false;
+    return std::all_of(pin.begin(), pin.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+PinCredential hashPin(std::string_view pin, int cost) {
+    if (!isValidPin(pin)) throw std::invalid_argument("PIN must be 4 to 12 digits");
+    if (cost < kMinPinCost || cost > kMaxPinCost) throw std::invalid_argument("PIN hash cost out of range");
+    PinCredential credential{};
+    credential.cost = static_cast<std::uint8_t>(cost);
+    fillSalt(credential.salt, sizeof(credential.salt));
+    derive(credential, pin, credential.digest);
+    return credential;
+}
+
+bool verifyPin(const PinCredential& credential, std::string_view pin) {
+    if (credential.cost < kMinPinCost || credential.cost > kMaxPinCost || !isValidPin(pin)) return false;
+    std::uint8_t digest[sizeof(credential.digest)];
+    derive(credential, pin, digest);
+    // Constant time, so the comparison itself reveals nothing.
+    unsigned difference = 0;
+    for (std::size_t i = 0; i < sizeof(digest); i++) difference |= digest[i] ^ credential.digest[i];
+    return difference == 0;
+}
+
+int calibratePinCost(std::chrono::microseconds target) {
+    constexpr int kProbeCost = 10;
+    PinCredential probe{};
+    probe.cost = kProbeCost;
+    std::uint8_t digest[sizeof(probe.digest)];
+    auto start = std::chrono::steady_clock::now();
+    derive(probe, "0000", digest);
+    double probeUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    double perIterationUs = probeUs / (1 << kProbeCost);
+    int cost = kMinPinCost;
+    while (cost < kMaxPinCost && perIterationUs * (1 << cost) < static_cast<double>(target.count())) cost++;
+    return cost;
+}
+
+std::string formatPinCredential(const PinCredential& credential) {
+    std::string out = kCredentialPrefix;
+    out += std::to_string(credential.cost);
+    out += '$';
+    appendHex(out, credential.salt, sizeof(credential.salt));
+    out += '$';
+    appendHex(out, credential.digest, sizeof(credential.digest));
+    return out;
+}
+
+bool parsePinCredential(std::string_view text, PinCredential& credential) {
+    std::string_view prefix = kCredentialPrefix;
+    if (text.substr(0, prefix.size()) != prefix) return false;
+    text.remove_prefix(prefix.size());
+
+    std::size_t dollar = text.find('$');
+    if (dollar == std::string_view::npos || dollar == 0 || dollar > 2) return false;
+    int cost = 0;
+    for (char c : text.substr(0, dollar)) {
+        if (c < '0' || c > '9') return false;
+        cost = cost * 10 + (c - '0');
+    }
+    if (cost < kMinPinCost || cost > kMaxPinCost) return false;
+    text.remove_prefix(dollar + 1);
+
+    PinCredential parsed{};
+    parsed.cost = static_cast<std::uint8_t>(cost);
+    dollar = text.find('$');
+    if (dollar == std::string_view::npos) return false;
+    if (!parseHex(text.substr(0, dollar), parsed.salt, sizeof(parsed.salt))) return false;
+    if (!parseHex(text.substr(dollar + 1), parsed.digest, sizeof(parsed.digest))) return false;
+    credential = parsed;
+    return true;
+}
+
+} // namespace atm
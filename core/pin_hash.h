@@ -0,0 +1,53 @@
+#ifndef ATM_PIN_HASH_H
+#define ATM_PIN_HASH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace atm {
+
+// Salted PIN hash as stored in an account record: PBKDF2-HMAC-SHA256 of
+// the PIN's digits exactly as entered (so "0123" is not "123"), 2^cost
+// iterations, truncated to 128 bits. The work
+// factor travels with each credential, so raising kDefaultPinCost only
+// affects PINs hashed from then on.
+struct PinCredential {
+    std::uint8_t salt[8];
+    std::uint8_t digest[16];
+    std::uint8_t cost;          // log2 of the iteration count; 0 means no PIN set
+    std::uint8_t reserved[3];
+};
+
+constexpr int kMinPinCost = 4;
+constexpr int kMaxPinCost = 24;
+constexpr int kDefaultPinCost = 12;
+
+// PINs are 4 to 12 decimal digits (ISO 9564-1).
+constexpr std::size_t kMinPinDigits = 4;
+constexpr std::size_t kMaxPinDigits = 12;
+
+bool isValidPin(std::string_view pin);
+
+// Hashes pin with a fresh random salt. Throws std::invalid_argument if pin
+// is not a valid PIN or cost is outside [kMinPinCost, kMaxPinCost].
+PinCredential hashPin(std::string_view pin, int cost = kDefaultPinCost);
+
+// Slow by design (one full PBKDF2 run); keep it off UI and session threads
+// and go through PinVerifier instead. A credential with no PIN set, or a
+// pin that is not a valid PIN, never matches.
+bool verifyPin(const PinCredential& credential, std::string_view pin);
+
+// The smallest cost whose hash takes at least target on this machine.
+int calibratePinCost(std::chrono::microseconds target);
+
+// "$pbkdf2$<cost>$<salt hex>$<digest hex>", the form accepted in account
+// import files. parsePinCredential returns false on anything else.
+std::string formatPinCredential(const PinCredential& credential);
+bool parsePinCredential(std::string_view text, PinCredential& credential);
+
+} // namespace atm
+
+#endif // ATM_PIN_HASH_H
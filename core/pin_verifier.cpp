@@ -0,0 +1,151 @@
+#include "pin_verifier.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace atm {
+
+PinVerifier::PinVerifier(PinVerifierOptions opts) : options(opts) {
+    if (options.threads == 0) options.threads = 1;
+    workers.reserve(options.threads);
+    for (unsigned t = 0; t < options.threads; t++) workers.emplace_back(&PinVerifier::workerLoop, this);
+}
+
+PinVerifier::~PinVerifier() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    queued.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+bool PinVerifier::submit(const PinCredential& credential, std::string_view pin, Callback done) {
+    return enqueue(Job{credential, std::string(pin), false, PinBlock(), 0, std::move(done), std::chrono::steady_clock::now()});
+}
+
+bool PinVerifier::submit(const PinCredential& credential, const PinBlock& block, long long pan, Callback done) {
+    if (!options.pinKey) throw std::invalid_argument("PinVerifier has no PIN block key");
+    return enqueue(Job{credential, std::string(), true, block, pan, std::move(done), std::chrono::steady_clock::now()});
+}
+
+namespace {
+
+template <typename Submit>
+std::future<PinResult> submitWithFuture(Submit submit) {
+    auto promise = std::make_shared<std::promise<PinResult>>();
+    std::future<PinResult> result = promise->get_future();
+    if (!submit([promise](PinResult r) { promise->set_value(r); })) promise->set_value(PinResult::Busy);
+    return result;
+}
+
+} // namespace
+
+std::future<PinResult> PinVerifier::verify(const PinCredential& credential, std::string_view pin) {
+    return submitWithFuture([&](Callback done) { return submit(credential, pin, std::move(done)); });
+}
+
+std::future<PinResult> PinVerifier::verify(const PinCredential& credential, const PinBlock& block, long long pan) {
+    return submitWithFuture([&](Callback done) { return submit(credential, block, pan, std::move(done)); });
+}
+
+bool PinVerifier::enqueue(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.size() >= options.maxQueue) {
+            rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        jobs.push_back(std::move(job));
+        maxDepth = std::max(maxDepth, jobs.size());
+    }
+    queued.notify_one();
+    return true;
+}
+
+void PinVerifier::workerLoop() {
+    std::vector<Job> batch;
+    std::vector<PinBlock> blocks;
+    std::vector<long long> pans;
+    std::vector<std::string> pins;
+    batch.reserve(kMaxBatch);
+    for (;;) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+            // An even share of what is waiting, so one worker does not
+            // sit on checks another could start.
+            std::size_t take = std::min(kMaxBatch, (jobs.size() + workers.size() - 1) / workers.size());
+            for (std::size_t i = 0; i < take; i++) {
+                batch.push_back(std::move(jobs.front()));
+                jobs.pop_front();
+            }
+        }
+
+        blocks.clear();
+        pans.clear();
+        for (const Job& job : batch) {
+            if (!job.enciphered) continue;
+            blocks.push_back(job.block);
+            pans.push_back(job.pan);
+        }
+        pins.resize(blocks.size());
+        if (!blocks.empty()) {
+            decryptPinBlocks(*options.pinKey, options.pinBlockFormat, blocks.data(), pans.data(), blocks.size(), pins.data());
+        }
+
+        std::size_t next = 0;
+        for (Job& job : batch) {
+            // A block that did not decipher leaves an empty PIN, which never matches.
+            bool match = verifyPin(job.credential, job.enciphered ? pins[next++] : job.pin);
+            auto latency = std::chrono::steady_clock::now() - job.submitted;
+            recordLatency(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+            if (job.done) job.done(match ? PinResult::Match : PinResult::Mismatch);
+        }
+    }
+}
+
+void PinVerifier::recordLatency(std::uint64_t us) {
+    int bucket = 0;
+    while (bucket < kLatencyBuckets - 1 && (std::uint64_t{1} << bucket) <= us) bucket++;
+    latencyHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    totalLatencyUs.fetch_add(us, std::memory_order_relaxed);
+    std::uint64_t seen = maxLatencyUs.load(std::memory_order_relaxed);
+    while (us > seen && !maxLatencyUs.compare_exchange_weak(seen, us, std::memory_order_relaxed)) {
+    }
+    completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+PinVerifier::Stats PinVerifier::stats() const {
+    Stats s{};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        s.queueDepth = jobs.size();
+        s.maxQueueDepth = maxDepth;
+    }
+    s.completed = completed.load(std::memory_order_relaxed);
+    s.rejected = rejected.load(std::memory_order_relaxed);
+    s.maxLatencyUs = static_cast<double>(maxLatencyUs.load(std::memory_order_relaxed));
+    if (s.completed == 0) return s;
+    s.meanLatencyUs = static_cast<double>(totalLatencyUs.load(std::memory_order_relaxed)) / s.completed;
+
+    std::uint64_t counts[kLatencyBuckets];
+    std::uint64_t total = 0;
+    for (int b = 0; b < kLatencyBuckets; b++) total += counts[b] = latencyHistogram[b].load(std::memory_order_relaxed);
+    std::uint64_t rank = total - total / 100;   // the 99th percentile sample
+    std::uint64_t seen = 0;
+    for (int b = 0; b < kLatencyBuckets; b++) {
+        seen += counts[b];
+        if (seen >= rank) {
+            s.p99LatencyUs = std::min(static_cast<double>(std::uint64_t{1} << b), s.maxLatencyUs);
+            break;
+        }
+    }
+    return s;
+}
+
+} // namespace atm
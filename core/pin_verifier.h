@@ -0,0 +1,119 @@
+#ifndef ATM_PIN_VERIFIER_H
+#define ATM_PIN_VERIFIER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "aes.h"
+#include "pin_block.h"
+#include "pin_hash.h"
+
+namespace atm {
+
+enum class PinResult {
+    Match,
+    Mismatch,
+    Busy        // queue full: nothing was checked, ask the customer to retry
+};
+
+struct PinVerifierOptions {
+    unsigned threads = 2;
+    // Checks waiting for a worker beyond this are refused with Busy, so a
+    // burst of logins cannot build an unbounded backlog.
+    std::size_t maxQueue = 64;
+    // Key and format the PIN pads encipher under; needed only for the
+    // PinBlock overloads. Must outlive the verifier.
+    const Aes128* pinKey = nullptr;
+    PinBlockFormat pinBlockFormat = PinBlockFormat::Iso4;
+};
+
+// Bounded worker pool for PIN checks.
+//
+// Submitting never blocks: the check is queued, or refused at once if the
+// queue is full. Completion is reported through a callback that runs on a
+// worker thread (frontends marshal it back to their own thread) or
+// through a future. Latency is measured from submission to completion,
+// so it includes time spent queued.
+//
+// Checks may carry an enciphered PIN block instead of a clear PIN. A
+// worker takes its share of the queue (up to kMaxBatch checks) at once
+// and deciphers all their blocks in one batch before hashing each.
+class PinVerifier {
+public:
+    using Callback = std::function<void(PinResult)>;
+
+    explicit PinVerifier(PinVerifierOptions options = PinVerifierOptions());
+    // Finishes the checks already queued, then stops the workers.
+    ~PinVerifier();
+    PinVerifier(const PinVerifier&) = delete;
+    PinVerifier& operator=(const PinVerifier&) = delete;
+
+    // Returns false, without calling done, if the queue is full.
+    bool submit(const PinCredential& credential, std::string_view pin, Callback done);
+    // The future is ready at once with PinResult::Busy if the queue is full.
+    std::future<PinResult> verify(const PinCredential& credential, std::string_view pin);
+
+    // As above, with the PIN still enciphered under options.pinKey for the
+    // given PAN. A block that does not decipher is a Mismatch. Throws
+    // std::invalid_argument if no PIN key was configured.
+    bool submit(const PinCredential& credential, const PinBlock& block, long long pan, Callback done);
+    std::future<PinResult> verify(const PinCredential& credential, const PinBlock& block, long long pan);
+
+    struct Stats {
+        std::size_t queueDepth;      // waiting now, not counting checks in progress
+        std::size_t maxQueueDepth;
+        std::uint64_t completed;
+        std::uint64_t rejected;
+        double meanLatencyUs;
+        double p99LatencyUs;         // upper bound of the power-of-two bucket
+        double maxLatencyUs;
+    };
+    Stats stats() const;
+
+private:
+    struct Job {
+        PinCredential credential;
+        std::string pin;   // clear PINs only
+        bool enciphered;
+        PinBlock block;
+        long long pan;
+        Callback done;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    static constexpr std::size_t kMaxBatch = 8;
+    static constexpr int kLatencyBuckets = 40;   // bucket b holds latencies below 2^b microseconds
+
+    PinVerifierOptions options;
+    mutable std::mutex mutex;
+    std::condition_variable queued;
+    std::deque<Job> jobs;
+    std::size_t maxDepth = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    std::atomic<std::uint64_t> completed{0};
+    std::atomic<std::uint64_t> rejected{0};
+    std::atomic<std::uint64_t> totalLatencyUs{0};
+    std::atomic<std::uint64_t> maxLatencyUs{0};
+    std::atomic<std::uint64_t> latencyHistogram[kLatencyBuckets] = {};
+
+    bool enqueue(Job job);
+    void workerLoop();
+    void recordLatency(std::uint64_t us);
+};
+
+} // namespace atm
+
+#endif // ATM_PIN_VERIFIER_H
@@ -0,0 +1,135 @@
+#include "reconcile.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "journal.h"
+
+namespace atm {
+
+namespace {
+
+bool isWithdrawal(const JournalRecord& record) {
+    return record.txnType() == TxnType::Withdrawal;
+}
+
+// Process id plus a per-process count, so two reconciliations sharing a
+// temp directory (in one process or several) never use the same files.
+std::string scratchPath(const std::string& dir, const char* what) {
+    static std::atomic<unsigned> calls{0};
+#ifdef _WIN32
+    long pid = _getpid();
+#else
+    long pid = getpid();
+#endif
+    return dir + "/reconcile-" + what + "-" + std::to_string(pid) + "-" + std::to_string(calls.fetch_add(1)) +
+           ".sorted.tmp";
+}
+
+// The sorted copies are scratch files; removed however the join ends.
+struct SortedCopy {
+    std::string path;
+
+    explicit SortedCopy(std::string p) : path(std::move(p)) {}
+    ~SortedCopy() { std::remove(path.c_str()); }
+};
+
+Mismatch mismatchOf(MismatchKind kind, const JournalRecord* dispense, const JournalRecord* debit) {
+    const JournalRecord& primary = debit ? *debit : *dispense;
+    Mismatch m;
+    m.kind = kind;
+    m.txnId = primary.txnId;
+    m.accountNumber = primary.accountNumber;
+    m.otherAccount = dispense ? dispense->accountNumber : primary.accountNumber;
+    m.dispensed = dispense ? dispense->amount : 0;
+    m.debited = debit ? debit->amount : 0;
+    m.timestampUs = primary.timestampUs;
+    return m;
+}
+
+} // namespace
+
+const char* mismatchKindName(MismatchKind kind) {
+    switch (kind) {
+        case MismatchKind::DispensedNotDebited: return "dispensed-not-debited";
+        case MismatchKind::DebitedNotDispensed: return "debited-not-dispensed";
+        case MismatchKind::AmountDiffers: return "amount-differs";
+        case MismatchKind::AccountDiffers: return "account-differs";
+    }
+    return "unknown";
+}
+
+ReconcileReport reconcileCash(const std::string& dispensePath, const std::string& debitPath, SortOptions options,
+                              const std::function<void(const Mismatch&)>& onMismatch) {
+    ReconcileReport report;
+    SortedCopy dispenseSorted(scratchPath(options.tempDir, "dispense"));
+    SortedCopy debitSorted(scratchPath(options.tempDir, "debit"));
+    report.dispenseSort = sortJournalByTxn(dispensePath, dispenseSorted.path, options, isWithdrawal);
+    report.debitSort = sortJournalByTxn(debitPath, debitSorted.path, options, isWithdrawal);
+
+    auto start = std::chrono::steady_clock::now();
+    // Debits below the first record still on disk were compacted away.
+    std::uint64_t firstDebitLsn = 0;
+    {
+        JournalReader debitJournal(debitPath);
+        JournalRecord first;
+        if (debitJournal.next(first)) firstDebitLsn = first.lsn;
+    }
+    auto emit = [&](MismatchKind kind, const JournalRecord* dispense, const JournalRecord* debit) {
+        switch (kind) {
+            case MismatchKind::DispensedNotDebited: report.dispensedNotDebited++; break;
+            case MismatchKind::DebitedNotDispensed: report.debitedNotDispensed++; break;
+            case MismatchKind::AmountDiffers: report.amountDiffers++; break;
+            case MismatchKind::AccountDiffers: report.accountDiffers++; break;
+        }
+        if (onMismatch) onMismatch(mismatchOf(kind, dispense, debit));
+    };
+
+    // Merge-join: both streams are in (txnId, LSN) order, so each step
+    // advances whichever side is behind, or both on a matching ID.
+    JournalReader dispenses(dispenseSorted.path);
+    JournalReader debits(debitSorted.path);
+    JournalRecord dispense, debit;
+    bool haveDispense = dispenses.next(dispense);
+    bool haveDebit = debits.next(debit);
+    while (haveDispense && dispense.txnId < firstDebitLsn) {
+        report.compacted++;
+        haveDispense = dispenses.next(dispense);
+    }
+    while (haveDispense || haveDebit) {
+        if (haveDispense && (!haveDebit || dispense.txnId < debit.txnId)) {
+            report.dispensedTotal += dispense.amount;
+            emit(MismatchKind::DispensedNotDebited, &dispense, nullptr);
+            haveDispense = dispenses.next(dispense);
+        } else if (haveDebit && (!haveDispense || debit.txnId < dispense.txnId)) {
+            report.debitedTotal += debit.amount;
+            emit(MismatchKind::DebitedNotDispensed, nullptr, &debit);
+            haveDebit = debits.next(debit);
+        } else {
+            report.dispensedTotal += dispense.amount;
+            report.debitedTotal += debit.amount;
+            if (dispense.accountNumber != debit.accountNumber) {
+                emit(MismatchKind::AccountDiffers, &dispense, &debit);
+            } else if (dispense.amount != debit.amount) {
+                emit(MismatchKind::AmountDiffers, &dispense, &debit);
+            } else {
+                report.matched++;
+            }
+            haveDispense = dispenses.next(dispense);
+            haveDebit = debits.next(debit);
+        }
+    }
+    report.joinSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+} // namespace atm
@@ -0,0 +1,87 @@
+#ifndef ATM_RECONCILE_H
+#define ATM_RECONCILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "journal_sort.h"
+#include "money.h"
+
+namespace atm {
+
+// Cash reconciliation
+//
+// The terminal writes two journals: the account journal, where every
+// withdrawal is debited before the cash is handed out, and a dispense
+// journal, where each dispense is recorded afterwards under the debit's
+// LSN as its transaction ID. Reconciliation sorts the withdrawals of both
+// by transaction ID (journal_sort.h, so either can be larger than memory)
+// and merge-joins the two sorted streams, reporting every transaction
+// that appears on one side only or with different amounts or accounts.
+//
+// Only Withdrawal records take part; deposits and book entries in the
+// account journal have no cash counterpart. Several records with the same
+// ID on one side are paired with the other side's in LSN order, and the
+// extras are reported as unmatched.
+//
+// Snapshots compact the account journal but never the dispense journal, so
+// dispenses keyed below the account journal's first remaining LSN have
+// lost their debit to compaction. They are counted apart (compacted), not
+// reported as mismatches.
+
+enum class MismatchKind {
+    DispensedNotDebited,
+    DebitedNotDispensed,
+    AmountDiffers,
+    AccountDiffers
+};
+
+// "dispensed-not-debited", ... as written in reports.
+const char* mismatchKindName(MismatchKind kind);
+
+struct Mismatch {
+    MismatchKind kind;
+    std::uint64_t txnId;
+    std::int32_t accountNumber;       // the debit's, or the dispense's if there is no debit
+    std::int32_t otherAccount;        // the dispense's for AccountDiffers, else the same
+    Money dispensed;                  // 0 if not dispensed
+    Money debited;                    // 0 if not debited
+    std::int64_t timestampUs;         // of whichever record exists, the debit if both
+};
+
+struct ReconcileReport {
+    SortStats dispenseSort;
+    SortStats debitSort;
+    std::size_t matched = 0;
+    std::size_t compacted = 0;   // dispenses whose debit was compacted away
+    std::size_t dispensedNotDebited = 0;
+    std::size_t debitedNotDispensed = 0;
+    std::size_t amountDiffers = 0;
+    std::size_t accountDiffers = 0;
+    Money dispensedTotal = 0;
+    Money debitedTotal = 0;
+    double joinSeconds = 0;
+
+    std::size_t mismatches() const {
+        return dispensedNotDebited + debitedNotDispensed + amountDiffers + accountDiffers;
+    }
+    double totalSeconds() const {
+        return dispenseSort.runSeconds + dispenseSort.mergeSeconds + debitSort.runSeconds + debitSort.mergeSeconds +
+               joinSeconds;
+    }
+};
+
+// Reconciles the two journals, calling onMismatch (if set) for each
+// mismatch in transaction ID order. options applies to each of the two
+// sorts in turn, so memory stays within options.memoryBytes plus the
+// join's two read buffers; the sorted copies go to options.tempDir.
+// Throws std::runtime_error if a file cannot be read or written.
+ReconcileReport reconcileCash(const std::string& dispensePath, const std::string& debitPath,
+                              SortOptions options = SortOptions(),
+                              const std::function<void(const Mismatch&)>& onMismatch = nullptr);
+
+} // namespace atm
+
+#endif // ATM_RECONCILE_H
@@ -0,0 +1,47 @@
+#include "session_arena.h"
+
+#include <algorithm>
+
+namespace atm {
+
+namespace {
+
+std::pmr::pool_options overflowPoolOptions() {
+    std::pmr::pool_options options;
+    // The arena asks for geometrically growing chunks; pool all of them
+    // rather than letting large ones go straight back to the heap.
+    options.largest_required_pool_block = 1 << 20;
+    return options;
+}
+
+} // namespace
+
+void* SessionArena::CountingResource::do_allocate(std::size_t size, std::size_t alignment) {
+    allocations++;
+    bytes += size;
+    return upstream->allocate(size, alignment);
+}
+
+void SessionArena::CountingResource::do_deallocate(void* p, std::size_t size, std::size_t alignment) {
+    upstream->deallocate(p, size, alignment);
+}
+
+SessionArena::SessionArena()
+    : heap(std::pmr::new_delete_resource()),
+      pool(overflowPoolOptions(), &heap),
+      arena(buffer, sizeof(buffer), &pool),
+      front(&arena) {}
+
+void SessionArena::release() {
+    peakBytes = std::max(peakBytes, front.bytes);
+    arena.release();
+    front.allocations = 0;
+    front.bytes = 0;
+    sessions++;
+}
+
+SessionArena::Stats SessionArena::stats() const {
+    return Stats{front.allocations, front.bytes, std::max(peakBytes, front.bytes), sessions, heap.allocations, heap.bytes};
+}
+
+} // namespace atm
@@ -0,0 +1,71 @@
+#ifndef ATM_SESSION_ARENA_H
+#define ATM_SESSION_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace atm {
+
+// Memory for one customer session, from card tap (or account entry) to
+// "Eject Card". Session temporaries -- the NFC request body, formatted
+// amounts, mini-statement rows, the UPI link -- are bump-allocated from
+// an inline buffer and dropped together by release() when the session
+// ends; nothing is freed one by one.
+//
+// A session that outgrows the inline buffer continues in chunks from a
+// pool that keeps them after release(), so once the pool has seen the
+// largest session, later sessions make no global heap allocation at
+// all. heapAllocations in the stats counts what did reach the heap.
+//
+// Not thread-safe: one arena per session thread.
+class SessionArena {
+public:
+    static constexpr std::size_t kInlineBytes = 16 * 1024;
+
+    SessionArena();
+    SessionArena(const SessionArena&) = delete;
+    SessionArena& operator=(const SessionArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &front; }
+
+    // Ends the session: everything allocated from resource() is gone.
+    void release();
+
+    struct Stats {
+        std::uint64_t allocations;       // this session, through resource()
+        std::uint64_t bytes;             // this session
+        std::uint64_t peakBytes;         // largest session so far
+        std::uint64_t sessions;          // release() calls
+        std::uint64_t heapAllocations;   // ever, from the global heap
+        std::uint64_t heapBytes;         // ever
+    };
+    Stats stats() const;
+
+private:
+    // Passes every call on to upstream and counts allocations.
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        explicit CountingResource(std::pmr::memory_resource* upstream) : upstream(upstream) {}
+        std::uint64_t allocations = 0;
+        std::uint64_t bytes = 0;
+
+    private:
+        std::pmr::memory_resource* upstream;
+        void* do_allocate(std::size_t size, std::size_t alignment) override;
+        void do_deallocate(void* p, std::size_t size, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    alignas(std::max_align_t) unsigned char buffer[kInlineBytes];
+    CountingResource heap;                           // global heap, counted
+    std::pmr::unsynchronized_pool_resource pool;     // overflow chunks, kept across sessions
+    std::pmr::monotonic_buffer_resource arena;       // inline buffer, then pool
+    CountingResource front;                          // what sessions see, counted
+    std::uint64_t peakBytes = 0;
+    std::uint64_t sessions = 0;
+};
+
+} // namespace atm
+
+#endif // ATM_SESSION_ARENA_H
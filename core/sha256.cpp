@@ -0,0 +1,164 @@
+#include "sha256.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace atm {
+
+namespace {
+
+constexpr std::uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline std::uint32_t rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline std::uint32_t loadBigEndian(const std::uint8_t* p) {
+    return (std::uint32_t{p[0]} << 24) | (std::uint32_t{p[1]} << 16) | (std::uint32_t{p[2]} << 8) | p[3];
+}
+
+inline void storeBigEndian(std::uint8_t* p, std::uint32_t v) {
+    p[0] = static_cast<std::uint8_t>(v >> 24);
+    p[1] = static_cast<std::uint8_t>(v >> 16);
+    p[2] = static_cast<std::uint8_t>(v >> 8);
+    p[3] = static_cast<std::uint8_t>(v);
+}
+
+void compress(std::uint32_t state[8], const std::uint8_t block[Sha256::kBlockSize]) {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; i++) w[i] = loadBigEndian(block + 4 * i);
+    for (int i = 16; i < 64; i++) {
+        std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        std::uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + kRoundConstants[i] + w[i];
+        std::uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+} // namespace
+
+Sha256::Sha256() { reset(); }
+
+void Sha256::reset() {
+    static constexpr std::uint32_t kInitial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                                  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    std::memcpy(state, kInitial, sizeof(state));
+    blockLength = 0;
+    totalLength = 0;
+}
+
+void Sha256::update(const void* data, std::size_t length) {
+    const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+    totalLength += length;
+    if (blockLength > 0) {
+        std::size_t take = std::min(length, kBlockSize - blockLength);
+        std::memcpy(block + blockLength, p, take);
+        blockLength += take;
+        p += take;
+        length -= take;
+        if (blockLength < kBlockSize) return;
+        compress(state, block);
+        blockLength = 0;
+    }
+    for (; length >= kBlockSize; p += kBlockSize, length -= kBlockSize) compress(state, p);
+    std::memcpy(block, p, length);
+    blockLength = length;
+}
+
+void Sha256::finish(std::uint8_t digest[kDigestSize]) {
+    std::uint64_t bits = totalLength * 8;
+    block[blockLength++] = 0x80;
+    if (blockLength > kBlockSize - 8) {
+        std::memset(block + blockLength, 0, kBlockSize - blockLength);
+        compress(state, block);
+        blockLength = 0;
+    }
+    std::memset(block + blockLength, 0, kBlockSize - 8 - blockLength);
+    storeBigEndian(block + 56, static_cast<std::uint32_t>(bits >> 32));
+    storeBigEndian(block + 60, static_cast<std::uint32_t>(bits));
+    compress(state, block);
+    for (int i = 0; i < 8; i++) storeBigEndian(digest + 4 * i, state[i]);
+}
+
+HmacSha256::HmacSha256(const void* key, std::size_t keyLength) {
+    std::uint8_t padded[Sha256::kBlockSize] = {};
+    if (keyLength > Sha256::kBlockSize) {
+        Sha256 h;
+        h.update(key, keyLength);
+        h.finish(padded);
+    } else {
+        std::memcpy(padded, key, keyLength);
+    }
+
+    std::uint8_t pad[Sha256::kBlockSize];
+    for (std::size_t i = 0; i < Sha256::kBlockSize; i++) pad[i] = padded[i] ^ 0x36;
+    inner.update(pad, sizeof(pad));
+    for (std::size_t i = 0; i < Sha256::kBlockSize; i++) pad[i] = padded[i] ^ 0x5c;
+    outer.update(pad, sizeof(pad));
+}
+
+void HmacSha256::mac(const void* data, std::size_t length, std::uint8_t out[Sha256::kDigestSize]) const {
+    Sha256 h = inner;
+    h.update(data, length);
+    std::uint8_t innerDigest[Sha256::kDigestSize];
+    h.finish(innerDigest);
+    h = outer;
+    h.update(innerDigest, sizeof(innerDigest));
+    h.finish(out);
+}
+
+void pbkdf2Sha256(const void* password, std::size_t passwordLength, const void* salt, std::size_t saltLength,
+                  std::uint32_t iterations, std::uint8_t* out, std::size_t outLength) {
+    HmacSha256 prf(password, passwordLength);
+    std::vector<std::uint8_t> first(saltLength + 4);
+    if (saltLength > 0) std::memcpy(first.data(), salt, saltLength);
+
+    for (std::uint32_t blockIndex = 1; outLength > 0; blockIndex++) {
+        std::uint8_t u[Sha256::kDigestSize];
+        storeBigEndian(first.data() + saltLength, blockIndex);
+        prf.mac(first.data(), first.size(), u);
+
+        std::uint8_t t[Sha256::kDigestSize];
+        std::memcpy(t, u, sizeof(t));
+        for (std::uint32_t i = 1; i < iterations; i++) {
+            prf.mac(u, sizeof(u), u);
+            for (std::size_t k = 0; k < sizeof(t); k++) t[k] ^= u[k];
+        }
+
+        std::size_t take = std::min(outLength, sizeof(t));
+        std::memcpy(out, t, take);
+        out += take;
+        outLength -= take;
+    }
+}
+
+} // namespace atm
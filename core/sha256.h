@@ -0,0 +1,49 @@
+#ifndef ATM_SHA256_H
+#define ATM_SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace atm {
+
+// FIPS 180-4 SHA-256, incremental.
+class Sha256 {
+public:
+    static constexpr std::size_t kDigestSize = 32;
+    static constexpr std::size_t kBlockSize = 64;
+
+    Sha256();
+
+    void update(const void* data, std::size_t length);
+    // Writes the digest; the object must be reset before reuse.
+    void finish(std::uint8_t digest[kDigestSize]);
+    void reset();
+
+private:
+    std::uint32_t state[8];
+    std::uint8_t block[kBlockSize];
+    std::size_t blockLength;
+    std::uint64_t totalLength;
+
+};
+
+// RFC 2104 HMAC-SHA256. The keyed inner and outer states are computed
+// once, so each mac() costs two compressions for short messages.
+class HmacSha256 {
+public:
+    HmacSha256(const void* key, std::size_t keyLength);
+
+    void mac(const void* data, std::size_t length, std::uint8_t out[Sha256::kDigestSize]) const;
+
+private:
+    Sha256 inner;
+    Sha256 outer;
+};
+
+// RFC 8018 PBKDF2 with HMAC-SHA256 as the PRF.
+void pbkdf2Sha256(const void* password, std::size_t passwordLength, const void* salt, std::size_t saltLength,
+                  std::uint32_t iterations, std::uint8_t* out, std::size_t outLength);
+
+} // namespace atm
+
+#endif // ATM_SHA256_H
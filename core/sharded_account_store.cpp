@@ -0,0 +1,334 @@
+#include "sharded_account_store.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <unordered_set>
+
+#include "hash_index.h"
+
+namespace atm {
+
+// One account set as served: its records and indexes. Rows are never
+// reused or moved between generations, so a row found in one is the same
+// account in every later one, and the history rings (addressed by row)
+// are shared by all of them.
+struct AccountGeneration {
+    AccountFile file;   // not open when the records are borrowed
+    AccountStore& accounts;
+    std::uint64_t number;
+    // Set while the set is served from its generation file because that
+    // could not be renamed into place; the file goes with the set.
+    std::string scratchPath;
+
+    AccountGeneration(AccountStore& borrowed, std::uint64_t number) : accounts(borrowed), number(number) {}
+    AccountGeneration(AccountFile opened, std::uint64_t number)
+        : file(std::move(opened)), accounts(file.accounts()), number(number) {}
+    ~AccountGeneration() {
+        file = AccountFile();   // unmapped first, or Windows keeps the file
+        if (!scratchPath.empty()) std::remove(scratchPath.c_str());
+    }
+};
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// rename() that replaces the target, atomically where the platform
+// allows. Windows will not replace (or remove) a file that is still
+// mapped, so this fails there while an older generation is alive.
+bool renameOver(const std::string& from, const std::string& to) {
+    if (std::rename(from.c_str(), to.c_str()) == 0) return true;
+    std::remove(to.c_str());
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+} // namespace
+
+Account* AccountHandle::live() const {
+    AccountGeneration* now = store->current.load(std::memory_order_acquire);
+    if (now == generation) return record;
+    return now->accounts.begin() + (record - generation->accounts.begin());
+}
+
+TxnStatus AccountHandle::deposit(Money amount, Money* balanceAfter) {
+    std::shared_lock<std::shared_mutex> guard(store->shards[shardIndex].lock);
+    // Under the shard lock a reload cannot be moving this account over, so
+    // the generation read here is the one the change belongs in.
+    AccountGeneration& now = *store->current.load(std::memory_order_acquire);
+    Account* target = live();
+    Money after;
+    TxnStatus status = target->deposit(amount, &after);
+    if (status == TxnStatus::Ok) {
+        store->recordHistory(now, target, TxnType::Deposit, amount, after);
+        if (balanceAfter) *balanceAfter = after;
+    }
+    return status;
+}
+
+TxnStatus AccountHandle::tryWithdraw(Money amount, Money* balanceAfter) {
+    std::shared_lock<std::shared_mutex> guard(store->shards[shardIndex].lock);
+    AccountGeneration& now = *store->current.load(std::memory_order_acquire);
+    Account* target = live();
+    Money after;
+    TxnStatus status = target->tryWithdraw(amount, &after);
+    if (status == TxnStatus::Ok) {
+        store->recordHistory(now, target, TxnType::Withdrawal, amount, after);
+        if (balanceAfter) *balanceAfter = after;
+    }
+    return status;
+}
+
+void AccountHandle::reverseDeposit(Money amount, Money* balanceAfter) {
+    std::shared_lock<std::shared_mutex> guard(store->shards[shardIndex].lock);
+    AccountGeneration& now = *store->current.load(std::memory_order_acquire);
+    Account* target = live();
+    Money after;
+    target->reverseDeposit(amount, &after);
+    store->recordHistory(now, target, TxnType::Debit, amount, after);
+    if (balanceAfter) *balanceAfter = after;
+}
+
+void AccountHandle::reverseWithdrawal(Money amount, Money* balanceAfter) {
+    std::shared_lock<std::shared_mutex> guard(store->shards[shardIndex].lock);
+    AccountGeneration& now = *store->current.load(std::memory_order_acquire);
+    Account* target = live();
+    Money after;
+    target->reverseWithdrawal(amount, &after);
+    store->recordHistory(now, target, TxnType::Credit, amount, after);
+    if (balanceAfter) *balanceAfter = after;
+}
+
+std::vector<HistoryEntry> AccountHandle::recentTransactions(std::size_t n) const {
+    return store->transactions.recent(static_cast<std::size_t>(record - generation->accounts.begin()), n);
+}
+
+std::pmr::vector<HistoryEntry> AccountHandle::recentTransactions(std::size_t n, std::pmr::memory_resource* memory) const {
+    return store->transactions.recent(static_cast<std::size_t>(record - generation->accounts.begin()), n, memory);
+}
+
+ShardedAccountStore::ShardedAccountStore(AccountStore& accounts, std::size_t shardCount)
+    : currentOwner(std::make_shared<AccountGeneration>(accounts, 1)), transactions(currentOwner->accounts) {
+    std::size_t n = 1;
+    while (n < shardCount) n <<= 1;
+    shards.reset(new Shard[n]);
+    shardMask = n - 1;
+    current.store(currentOwner.get(), std::memory_order_release);
+}
+
+ShardedAccountStore::ShardedAccountStore(AccountFile file, std::size_t shardCount)
+    : currentOwner(std::make_shared<AccountGeneration>(std::move(file), 1)), transactions(currentOwner->accounts) {
+    std::size_t n = 1;
+    while (n < shardCount) n <<= 1;
+    shards.reset(new Shard[n]);
+    shardMask = n - 1;
+    current.store(currentOwner.get(), std::memory_order_release);
+}
+
+ShardedAccountStore::~ShardedAccountStore() = default;
+
+std::uint32_t ShardedAccountStore::shardOf(int accountNumber) const {
+    std::uint64_t key = static_cast<std::uint32_t>(accountNumber);
+    // Use the high bits: the store's hash index already consumes the low
+    // ones, and neighbouring accounts should not share a shard.
+    return static_cast<std::uint32_t>((HashIndex::hash(key) >> 40) & shardMask);
+}
+
+void ShardedAccountStore::recordHistory(AccountGeneration& generation, const Account* record, TxnType type,
+                                        Money amount, Money balanceAfter) {
+    std::int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    transactions.record(static_cast<std::size_t>(record - generation.accounts.begin()),
+                        HistoryEntry{now, amount, balanceAfter, type, 0});
+}
+
+AccountHandle ShardedAccountStore::handleFor(EpochDomain::Guard pin, AccountGeneration* generation, Account* record) {
+    AccountHandle handle;
+    if (record) {
+        handle.store = this;
+        handle.generation = generation;
+        handle.record = record;
+        handle.shardIndex = shardOf(record->getAccountNumber());
+        handle.pin = std::move(pin);
+    }
+    return handle;
+}
+
+AccountHandle ShardedAccountStore::findByAccount(int accountNumber) {
+    // Pinned before the generation is loaded, so it cannot be freed under
+    // the lookup or the handle.
+    EpochDomain::Guard pin = epochs.pin();
+    AccountGeneration* generation = current.load(std::memory_order_acquire);
+    return handleFor(std::move(pin), generation, generation->accounts.findByAccount(accountNumber));
+}
+
+AccountHandle ShardedAccountStore::findByCard(long long cardNumber, bool* blocked) {
+    bool hot = blockedCards.contains(cardNumber);
+    if (blocked) *blocked = hot;
+    if (hot) return AccountHandle();
+    EpochDomain::Guard pin = epochs.pin();
+    AccountGeneration* generation = current.load(std::memory_order_acquire);
+    return handleFor(std::move(pin), generation, generation->accounts.findByCard(cardNumber));
+}
+
+TxnStatus ShardedAccountStore::transfer(AccountHandle& from, AccountHandle& to, Money amount) {
+    if (!from || !to || from.accountNumber() == to.accountNumber() || amount <= 0) return TxnStatus::InvalidAmount;
+
+    // Fixed lock order (lowest shard first) rules out deadlock between two
+    // transfers that touch the same pair of shards in opposite directions.
+    std::uint32_t first = from.shardIndex < to.shardIndex ? from.shardIndex : to.shardIndex;
+    std::uint32_t second = from.shardIndex < to.shardIndex ? to.shardIndex : from.shardIndex;
+    std::unique_lock<std::shared_mutex> firstGuard(shards[first].lock);
+    std::unique_lock<std::shared_mutex> secondGuard;
+    if (second != first) secondGuard = std::unique_lock<std::shared_mutex>(shards[second].lock);
+
+    AccountGeneration& now = *current.load(std::memory_order_acquire);
+    Account* debited = from.live();
+    Account* credited = to.live();
+    Money fromAfter, toAfter;
+    TxnStatus status = debited->debit(amount, &fromAfter);
+    if (status != TxnStatus::Ok) return status;
+    credited->credit(amount, &toAfter);
+    recordHistory(now, debited, TxnType::Debit, amount, fromAfter);
+    recordHistory(now, credited, TxnType::Credit, amount, toAfter);
+    return TxnStatus::Ok;
+}
+
+std::vector<std::shared_lock<std::shared_mutex>> ShardedAccountStore::holdTransfers() {
+    std::vector<std::shared_lock<std::shared_mutex>> held;
+    held.reserve(shardCount());
+    for (std::size_t i = 0; i < shardCount(); i++) held.emplace_back(shards[i].lock);
+    return held;
+}
+
+AccountStore& ShardedAccountStore::accountStore() {
+    return current.load(std::memory_order_acquire)->accounts;
+}
+
+std::size_t ShardedAccountStore::size() const {
+    return current.load(std::memory_order_acquire)->accounts.size();
+}
+
+std::uint64_t ShardedAccountStore::generation() const {
+    return current.load(std::memory_order_acquire)->number;
+}
+
+void ShardedAccountStore::sync(const AccountHandle& handle) {
+    if (!handle) return;
+    AccountGeneration& now = *current.load(std::memory_order_acquire);
+    if (!now.file.path().empty()) now.file.sync(*handle.live());
+}
+
+void ShardedAccountStore::closeCleanly(std::uint64_t journalLsn) {
+    std::lock_guard<std::mutex> reloading(reloadLock);
+    AccountGeneration& now = *current.load(std::memory_order_acquire);
+    // A set still served from its generation file is not the file the
+    // next start opens.
+    if (!now.file.path().empty() && now.scratchPath.empty()) now.file.closeCleanly(journalLsn);
+}
+
+ReloadReport ShardedAccountStore::reload(const AccountStore& incoming, const std::string& path,
+                                         const ReloadHook& beforePublish) {
+    std::lock_guard<std::mutex> reloading(reloadLock);
+    ReloadReport report;
+    auto start = std::chrono::steady_clock::now();
+    // Only reload() replaces the generation, so this one stays current
+    // (and alive) until the end.
+    AccountGeneration* live = current.load(std::memory_order_acquire);
+    const AccountStore& served = live->accounts;
+    const std::size_t kept = served.size();
+
+    std::vector<CardLink> cards = served.extraCards();
+    std::vector<Account> added;
+    std::vector<std::uint32_t> rowOf(incoming.size(), HashIndex::kNotFound);
+    std::unordered_set<long long> newCards;
+    auto cardFree = [&](long long card) {
+        return card == 0 || (!served.findByCard(card) && newCards.count(card) == 0);
+    };
+    const Account* incomingRows = incoming.begin();
+    for (std::size_t i = 0; i < incoming.size(); i++) {
+        const Account& account = incomingRows[i];
+        if (served.findByAccount(account.getAccountNumber())) continue;
+        if (!cardFree(account.getCardNumber())) {
+            report.skipped++;
+            continue;
+        }
+        if (account.getCardNumber() != 0) newCards.insert(account.getCardNumber());
+        rowOf[i] = static_cast<std::uint32_t>(kept + added.size());
+        added.push_back(account);
+    }
+    std::vector<CardLink> addedCards;   // rows within added
+    for (const CardLink& link : incoming.extraCards()) {
+        if (rowOf[link.row] == HashIndex::kNotFound || !cardFree(link.cardNumber)) continue;
+        newCards.insert(link.cardNumber);
+        cards.push_back(CardLink{link.cardNumber, rowOf[link.row]});
+        addedCards.push_back(CardLink{link.cardNumber, static_cast<std::uint32_t>(rowOf[link.row] - kept)});
+    }
+    if (added.empty()) {
+        // Nothing new (e.g. the first check after a start): the served set
+        // stays as it is.
+        report.generation = live->number;
+        report.accounts = kept;
+        report.buildSeconds = secondsSince(start);
+        return report;
+    }
+
+    // Served accounts first and in their rows, so handles, shards and
+    // history rows carry over unchanged. Their balances are copied again
+    // at the freeze; this copy only gives the new indexes their keys.
+    std::vector<Account> merged;
+    merged.reserve(kept + added.size());
+    merged.assign(served.begin(), served.end());
+    merged.insert(merged.end(), added.begin(), added.end());
+
+    // Written beside path, not over it: the generation being served may be
+    // mapped from path, and until the new one is published path must stay
+    // a complete account file.
+    AccountStore built;
+    built.bulkLoad(std::move(merged), cards, 0);
+    std::uint64_t number = live->number + 1;
+    std::string nextPath = path + ".gen" + std::to_string(number);
+    AccountFile::create(nextPath, built);
+    built = AccountStore();
+    auto next = std::make_shared<AccountGeneration>(AccountFile::open(nextPath), number);
+
+    if (beforePublish) beforePublish(added, addedCards);
+    transactions.grow(next->accounts);
+    // A first copy outside the freeze faults the new file's pages in, so
+    // the copy that counts only rewrites memory already mapped.
+    const Account* from = served.begin();
+    Account* to = next->accounts.begin();
+    for (std::size_t i = 0; i < kept; i++) to[i] = from[i];
+    report.buildSeconds = secondsSince(start);
+
+    // Freeze: with every shard held no balance can change, so the served
+    // records are final once copied. Lookups carry on against the old
+    // generation until the pointer moves.
+    start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::unique_lock<std::shared_mutex>> frozen;
+        frozen.reserve(shardCount());
+        for (std::size_t i = 0; i < shardCount(); i++) frozen.emplace_back(shards[i].lock);
+        for (std::size_t i = 0; i < kept; i++) to[i] = from[i];
+        current.store(next.get(), std::memory_order_seq_cst);
+    }
+    report.freezeSeconds = secondsSince(start);
+
+    // Published: the new file takes path's place, complete with the live
+    // balances. If it cannot (Windows, while the old set is mapped), the
+    // set is served from its own file and path keeps the previous set
+    // until the next reload; a restart rebuilds path from the snapshot.
+    next->file.sync();
+    if (!renameOver(nextPath, path)) next->scratchPath = nextPath;
+    epochs.retire(std::move(currentOwner));
+    currentOwner = std::move(next);
+    report.reclaimed = epochs.reclaim();
+    report.generation = currentOwner->number;
+    report.accounts = currentOwner->accounts.size();
+    report.added = added.size();
+    return report;
+}
+
+} // namespace atm
@@ -0,0 +1,212 @@
+#ifndef ATM_SHARDED_ACCOUNT_STORE_H
+#define ATM_SHARDED_ACCOUNT_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "account.h"
+#include "account_file.h"
+#include "account_store.h"
+#include "bin_table.h"
+#include "epoch.h"
+#include "hot_card_list.h"
+#include "money.h"
+#include "transaction_history.h"
+
+namespace atm {
+
+class ShardedAccountStore;
+struct AccountGeneration;
+
+// What a session holds instead of a raw Account*: the record plus the
+// shard that guards it. A default handle is empty.
+//
+// A handle pins the account set it was found in (see reload()), so it
+// stays valid for as long as it is held, across any number of reloads;
+// balances and operations always go to the account's record in the set
+// being served now. Copying one pins another epoch slot, so hold a handle
+// for a session rather than copying it per operation.
+class AccountHandle {
+public:
+    AccountHandle() = default;
+
+    explicit operator bool() const { return record != nullptr; }
+
+    // Fixed for the life of the account, so read from the pinned record.
+    int accountNumber() const { return record->getAccountNumber(); }
+    long long cardNumber() const { return record->getCardNumber(); }
+    std::string_view holderName() const { return record->getName(); }
+    const PinCredential& pinCredential() const { return record->pinCredential(); }
+    Money balance() const { return live()->getBalance(); }
+    AccountSnapshot snapshot() const { return live()->snapshot(); }
+
+    TxnStatus deposit(Money amount, Money* balanceAfter = nullptr);
+    TxnStatus tryWithdraw(Money amount, Money* balanceAfter = nullptr);
+    // Undo a deposit or withdrawal made through this handle that could not
+    // be journaled (see Account::reverseDeposit). The mini-statement shows
+    // the reversal as a debit or credit.
+    void reverseDeposit(Money amount, Money* balanceAfter = nullptr);
+    void reverseWithdrawal(Money amount, Money* balanceAfter = nullptr);
+
+    // Mini-statement: up to n most recent transactions, newest first.
+    std::vector<HistoryEntry> recentTransactions(std::size_t n) const;
+    std::pmr::vector<HistoryEntry> recentTransactions(std::size_t n, std::pmr::memory_resource* memory) const;
+
+    const Account& account() const { return *live(); }
+    std::uint32_t shard() const { return shardIndex; }
+
+private:
+    friend class ShardedAccountStore;
+
+    ShardedAccountStore* store = nullptr;
+    AccountGeneration* generation = nullptr;   // the set record belongs to
+    Account* record = nullptr;
+    std::uint32_t shardIndex = 0;
+    EpochDomain::Guard pin;
+
+    // The same row in the set being served now; rows never move.
+    Account* live() const;
+};
+
+struct ReloadReport {
+    std::uint64_t generation = 0;   // number of the set now served
+    std::size_t accounts = 0;       // in it
+    std::size_t added = 0;
+    std::size_t skipped = 0;        // new accounts whose card is already taken
+    std::size_t reclaimed = 0;      // earlier sets freed by this reload
+    double buildSeconds = 0;        // everything before the freeze; nothing waits
+    double freezeSeconds = 0;       // balance changes held while the live state moved over
+};
+
+// Many concurrent sessions over one account set.
+//
+// Accounts are spread over a power-of-two number of shards by account
+// number, each with its own reader/writer lock. Single-account operations
+// take their shard's lock shared and then rely on the per-account seqlock,
+// so sessions on the same shard only wait for each other on the same
+// account, and then only for a few stores.
+// Operations that must change several accounts as one unit take every
+// shard involved exclusively, always in ascending shard order, so two of
+// them can never deadlock.
+//
+// Lookups go through the store's read-only hash indexes and take no lock.
+//
+// The account set can be replaced while sessions run (reload()). Each set
+// is a generation: its records, indexes and history. The new one is built
+// off to the side and published with one atomic pointer store, so a
+// lookup sees either the old set or the new one, never a partly loaded
+// table. Lookups pin an epoch rather than taking a lock or a reference
+// count, and a replaced generation is freed by epoch-based reclamation
+// once the last handle that could have seen it is gone.
+//
+// Every successful operation is also added to the store's
+// TransactionHistory for mini-statements, and card lookups are refused
+// for cards on its HotCardList.
+class ShardedAccountStore {
+public:
+    static constexpr std::size_t kDefaultShards = 64;
+
+    // accounts must outlive the store; shardCount is rounded up to a power
+    // of two.
+    explicit ShardedAccountStore(AccountStore& accounts, std::size_t shardCount = kDefaultShards);
+    // Serves the accounts of file, which the store then owns.
+    explicit ShardedAccountStore(AccountFile file, std::size_t shardCount = kDefaultShards);
+    ~ShardedAccountStore();
+    ShardedAccountStore(const ShardedAccountStore&) = delete;
+    ShardedAccountStore& operator=(const ShardedAccountStore&) = delete;
+
+    AccountHandle findByAccount(int accountNumber);
+    // Returns an empty handle for a card on the hot-card list; blocked,
+    // when given, tells that apart from an unknown card.
+    AccountHandle findByCard(long long cardNumber, bool* blocked = nullptr);
+
+    // Moves amount between two accounts atomically with respect to every
+    // other operation on either shard.
+    TxnStatus transfer(AccountHandle& from, AccountHandle& to, Money amount);
+
+    // Takes every shard lock shared, in ascending order, and holds them
+    // until the returned locks go out of scope. Single-account operations
+    // carry on; transfers wait, so no money is in flight between two
+    // accounts while the caller reads across the whole store.
+    std::vector<std::shared_lock<std::shared_mutex>> holdTransfers();
+    // Keeps reload() from replacing the account set until the lock goes.
+    std::unique_lock<std::mutex> holdReloads() { return std::unique_lock<std::mutex>(reloadLock); }
+    // The records themselves, for batch jobs that walk every account;
+    // hold holdReloads() while using them.
+    AccountStore& accountStore();
+
+    // Serves the accounts already served, in the same rows and with their
+    // live balances and history, plus every account of incoming whose
+    // number is new. Accounts are never removed, and one already served
+    // keeps its live state whatever incoming says about it. If incoming
+    // adds nothing, the served set and path are left as they are.
+    //
+    // The merged set is written beside path (path.gen<N>), served from
+    // there, and renamed over path once it is published, so path is a
+    // complete account file at every point. Where a mapped file cannot be
+    // replaced (Windows) path keeps the previous set instead and the new
+    // one is served from its generation file, which is removed when the
+    // set is freed. beforePublish, if given, is called with the added
+    // accounts and their extra cards (rows within the added accounts) just
+    // before they become visible, e.g. to add them to the snapshot. Only
+    // the last step holds up balance changes, while the live records are
+    // copied over; lookups never wait. Throws std::runtime_error if the
+    // file cannot be written.
+    using ReloadHook = std::function<void(const std::vector<Account>&, const std::vector<CardLink>&)>;
+    ReloadReport reload(const AccountStore& incoming, const std::string& path, const ReloadHook& beforePublish = nullptr);
+    // Frees replaced account sets no handle can still see; reload() does
+    // this too. Returns how many were freed.
+    std::size_t reclaim() { return epochs.reclaim(); }
+    std::uint64_t generation() const;
+    std::size_t retiredGenerations() const { return epochs.retiredCount(); }
+
+    // Forces the handle's account to disk when the set is served from a
+    // file the store owns; does nothing otherwise.
+    void sync(const AccountHandle& handle);
+    // At shutdown, once nothing changes balances any more and every
+    // journal record up to journalLsn is applied: marks the owned file
+    // closed cleanly so the next start can open it in place.
+    void closeCleanly(std::uint64_t journalLsn);
+
+    std::size_t shardCount() const { return shardMask + 1; }
+    std::size_t size() const;
+
+    TransactionHistory& history() { return transactions; }
+    HotCardList& hotCards() { return blockedCards; }
+    // Frontends route a card by its issuer prefix before calling
+    // findByCard(); only on-us cards are looked up here.
+    BinRouter& binRoutes() { return cardRoutes; }
+
+private:
+    friend class AccountHandle;
+
+    struct alignas(64) Shard {
+        std::shared_mutex lock;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    std::size_t shardMask;
+    EpochDomain epochs;   // holds the replaced generations until reclaimed
+    std::atomic<AccountGeneration*> current{nullptr};
+    std::shared_ptr<AccountGeneration> currentOwner;
+    TransactionHistory transactions;   // rows never move, so every generation shares it
+    std::mutex reloadLock;
+    HotCardList blockedCards;
+    BinRouter cardRoutes;
+
+    AccountHandle handleFor(EpochDomain::Guard pin, AccountGeneration* generation, Account* record);
+    void recordHistory(AccountGeneration& generation, const Account* record, TxnType type, Money amount,
+                       Money balanceAfter);
+    std::uint32_t shardOf(int accountNumber) const;
+};
+
+} // namespace atm
+
+#endif // ATM_SHARDED_ACCOUNT_STORE_H
@@ -0,0 +1,257 @@
+#include "snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "account_file.h"
+#include "end_of_day.h"
+#include "parallel.h"
+
+namespace atm {
+
+namespace {
+
+// Below this many tail records a single thread replays faster than the
+// others can be started.
+constexpr std::size_t kParallelReplayThreshold = 4096;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool fileExists(const std::string& path) {
+    return std::ifstream(path, std::ios::binary).good();
+}
+
+unsigned partitionOf(int accountNumber, unsigned partitions) {
+    // Multiplicative hash so consecutive account numbers spread out.
+    std::uint32_t h = static_cast<std::uint32_t>(accountNumber) * 2654435761u;
+    return static_cast<unsigned>((static_cast<std::uint64_t>(h) * partitions) >> 32);
+}
+
+std::uint64_t lastJournalLsn(const std::string& journalPath) {
+    JournalReader reader(journalPath);
+    JournalRecord record;
+    std::uint64_t last = 0;
+    while (reader.next(record)) last = record.lsn;
+    return last;
+}
+
+bool journalHasAfter(const std::string& journalPath, std::uint64_t lsn) {
+    JournalReader reader(journalPath);
+    reader.seek(lsn + 1);
+    JournalRecord record;
+    return reader.next(record);
+}
+
+// A clean-closed accounts file the journal has not moved past since is
+// exactly what the copy and replay would rebuild, so it is served as it
+// is. Anything else (a crash, a damaged file) takes the full path.
+bool reopenInPlace(const std::string& accountsPath, const std::string& journalPath) {
+    try {
+        AccountFile live = AccountFile::open(accountsPath);
+        if (!live.closedCleanly() || journalHasAfter(journalPath, live.journalLsn())) return false;
+        live.markOpen();
+        return true;
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+}
+
+void renameOver(const std::string& from, const std::string& to) {
+    std::remove(to.c_str());   // rename() does not replace on Windows
+    if (std::rename(from.c_str(), to.c_str()) != 0) {
+        throw std::runtime_error("Cannot move " + from + " to " + to);
+    }
+}
+
+} // namespace
+
+RecoveryReport replayJournal(AccountStore& accounts, const std::string& journalPath, std::uint64_t afterLsn,
+                             std::uint64_t uptoLsn, unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
+    RecoveryReport report;
+    report.snapshotLsn = afterLsn;
+    report.lastLsn = afterLsn;
+
+    std::vector<JournalRecord> tail;
+    JournalReader reader(journalPath);
+    reader.seek(afterLsn + 1);
+    JournalRecord record;
+    while (reader.next(record) && record.lsn <= uptoLsn) {
+        if (record.lsn <= afterLsn) continue;
+        tail.push_back(record);
+        report.lastLsn = record.lsn;
+    }
+
+    threads = resolveThreads(threads);
+    if (tail.size() < kParallelReplayThreshold) threads = 1;
+    report.threads = threads;
+
+    // Every thread walks the whole tail but only applies its own accounts,
+    // so each balance has a single writer and no record is shared out.
+    std::vector<std::size_t> unknown(threads, 0);
+    auto replayPartition = [&](unsigned part) {
+        for (const JournalRecord& r : tail) {
+            if (threads > 1 && partitionOf(r.accountNumber, threads) != part) continue;
+            if (Account* account = accounts.findByAccount(r.accountNumber)) {
+                std::uint32_t day = static_cast<std::uint32_t>(r.timestampUs / 86400000000LL);
+                switch (r.txnType()) {
+                    case TxnType::Withdrawal:
+                        account->applyWithdrawal(r.amount, day);
+                        break;
+                    case TxnType::Deposit:
+                    case TxnType::Debit:
+                        account->applyDelta(r.delta(), day);
+                        break;
+                    default:
+                        account->applyDelta(r.delta());
+                        if (std::uint32_t paid = interestDayOf(r.txnId)) {
+                            if (account->interestPaidDay() < paid) account->setInterestPaidDay(paid);
+                        }
+                        break;
+                }
+            } else {
+                unknown[part]++;
+            }
+        }
+    };
+    runOnThreads(threads, replayPartition);
+
+    report.replayed = tail.size();
+    for (std::size_t n : unknown) report.unknownAccounts += n;
+    report.replaySeconds = secondsSince(start);
+    return report;
+}
+
+RecoveryReport recoverAccounts(const std::string& accountsPath, const std::string& snapshotPath,
+                               const std::string& journalPath, const std::vector<Account>& seed,
+                               unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
+    if (fileExists(snapshotPath) && fileExists(accountsPath) && reopenInPlace(accountsPath, journalPath)) {
+        RecoveryReport report;
+        report.openedInPlace = true;
+        report.loadSeconds = secondsSince(start);
+        return report;
+    }
+    if (!fileExists(snapshotPath)) {
+        if (fileExists(accountsPath)) {
+            AccountFile::copy(accountsPath, snapshotPath);
+            AccountFile::open(snapshotPath).setJournalLsn(lastJournalLsn(journalPath));
+        } else {
+            AccountFile::create(snapshotPath, seed, 0);
+        }
+    }
+
+    AccountFile::copy(snapshotPath, accountsPath);
+    AccountFile live = AccountFile::open(accountsPath);
+    double loadSeconds = secondsSince(start);
+
+    RecoveryReport report = replayJournal(live.accounts(), journalPath, live.journalLsn(), UINT64_MAX, threads);
+    report.loadSeconds = loadSeconds;
+    return report;
+}
+
+// --- Snapshotter ---
+
+Snapshotter::Snapshotter(const std::string& snapshotPath, Journal& journal, SnapshotOptions opts)
+    : path(snapshotPath), journal(journal), options(opts) {
+    currentLsn = AccountFile::open(path).journalLsn();
+    worker = std::thread(&Snapshotter::run, this);
+}
+
+Snapshotter::~Snapshotter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+std::uint64_t Snapshotter::snapshotLsn() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return currentLsn;
+}
+
+std::string Snapshotter::lastError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return error;
+}
+
+bool Snapshotter::takeSnapshot() {
+    std::lock_guard<std::mutex> building(snapshotMutex);
+    std::uint64_t from = snapshotLsn();
+    std::uint64_t target = journal.durableLsn();
+    if (target <= from) return false;
+
+    // Built beside the current snapshot and renamed over it, so a crash
+    // part way through leaves the previous snapshot in place.
+    std::string nextPath = path + ".next";
+    AccountFile::copy(path, nextPath);
+    {
+        AccountFile next = AccountFile::open(nextPath);
+        // One thread: this runs next to live sessions and is not urgent.
+        replayJournal(next.accounts(), journal.path(), from, target, 1);
+        next.sync();
+        next.setJournalLsn(target);
+    }
+    renameOver(nextPath, path);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentLsn = target;
+    }
+
+    if (options.compactJournal && target > options.keepJournalRecords) {
+        journal.compact(target - options.keepJournalRecords);
+    }
+    return true;
+}
+
+void Snapshotter::addAccounts(const std::vector<Account>& accounts, const std::vector<CardLink>& extraCards) {
+    if (accounts.empty()) return;
+    std::lock_guard<std::mutex> building(snapshotMutex);
+    std::string nextPath = path + ".next";
+    {
+        AccountFile snapshot = AccountFile::open(path);
+        const AccountStore& current = snapshot.accounts();
+        auto base = static_cast<std::uint32_t>(current.size());
+        std::vector<Account> merged(current.begin(), current.end());
+        merged.insert(merged.end(), accounts.begin(), accounts.end());
+        std::vector<CardLink> cards = current.extraCards();
+        for (const CardLink& link : extraCards) cards.push_back(CardLink{link.cardNumber, base + link.row});
+
+        AccountStore store;
+        store.bulkLoad(std::move(merged), cards, 0);
+        AccountFile::create(nextPath, store, snapshot.journalLsn());
+    }
+    renameOver(nextPath, path);
+}
+
+void Snapshotter::run() {
+    const auto poll = std::min<std::chrono::steady_clock::duration>(std::chrono::seconds(1), options.interval);
+    auto lastSnapshot = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, poll, [&] { return stopping; })) {
+        std::uint64_t tail = journal.durableLsn() - currentLsn;
+        bool due = tail >= options.maxTailRecords ||
+                   (tail > 0 && std::chrono::steady_clock::now() - lastSnapshot >= options.interval);
+        if (!due) continue;
+
+        lock.unlock();
+        std::string failure;
+        try {
+            takeSnapshot();
+        } catch (const std::exception& e) {
+            failure = e.what();
+        }
+        lock.lock();
+        error = failure;
+        lastSnapshot = std::chrono::steady_clock::now();
+    }
+}
+
+} // namespace atm
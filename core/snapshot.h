@@ -0,0 +1,128 @@
+#ifndef ATM_SNAPSHOT_H
+#define ATM_SNAPSHOT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "account.h"
+#include "account_store.h"
+#include "journal.h"
+
+namespace atm {
+
+// Snapshots and restart
+//
+// A snapshot is an account file whose header says which journal LSN its
+// balances include. The live account file is never copied while sessions
+// are running: a new snapshot is the previous snapshot with the journal
+// records after it replayed on top. Writers are not paused, and nothing
+// they touch is read, so there is nothing to copy-on-write; the journal
+// LSN plays the part of the epoch.
+//
+// At startup the live account file is rebuilt from the latest snapshot
+// plus the journal tail after it, which bounds restart time by the
+// snapshot interval instead of the age of the journal. The rebuild copies
+// the whole snapshot, so it is skipped when the live file was closed
+// cleanly: that file is opened in place. Taking a snapshot copies the
+// whole previous one too, in the background.
+//
+// Journal segments a snapshot covers are compacted away after it is
+// written, so from then on the snapshot is the only copy of their effect
+// on balances.
+
+struct RecoveryReport {
+    std::uint64_t snapshotLsn = 0;   // LSN the snapshot was current to
+    std::uint64_t lastLsn = 0;       // last journal record applied
+    std::size_t replayed = 0;        // tail records applied
+    std::size_t unknownAccounts = 0; // tail records for accounts not in the snapshot
+    unsigned threads = 0;
+    bool openedInPlace = false;      // clean-closed account file served as it was
+    double loadSeconds = 0;          // snapshot copied into place and mapped
+    double replaySeconds = 0;        // tail read and applied
+
+    double readySeconds() const { return loadSeconds + replaySeconds; }
+};
+
+// Applies the journal records in (afterLsn, uptoLsn] to accounts, with
+// records partitioned across threads by account number so each account is
+// only touched by one thread. threads == 0 uses the hardware concurrency.
+RecoveryReport replayJournal(AccountStore& accounts, const std::string& journalPath, std::uint64_t afterLsn,
+                             std::uint64_t uptoLsn = UINT64_MAX, unsigned threads = 0);
+
+// Brings accountsPath up to date with the journal before it is opened.
+//
+// - If accountsPath was closed cleanly (AccountFile::closeCleanly) and the
+//   journal holds nothing after it, it is only marked open again.
+// - Otherwise, if snapshotPath exists, it is copied over accountsPath and
+//   the journal tail after it is replayed.
+// - Otherwise a first snapshot is written: from accountsPath if it exists
+//   (it already includes the journal), else from seed with the whole
+//   journal replayed on top.
+//
+// The journal should already be open, so a torn tail has been cut off.
+// Throws std::runtime_error if a file cannot be read or written.
+RecoveryReport recoverAccounts(const std::string& accountsPath, const std::string& snapshotPath,
+                               const std::string& journalPath, const std::vector<Account>& seed,
+                               unsigned threads = 0);
+
+struct SnapshotOptions {
+    // A snapshot is taken once this many records are past the last one...
+    std::uint64_t maxTailRecords = 100000;
+    // ...or once this much time has passed and anything changed.
+    std::chrono::seconds interval{60};
+    // After each snapshot, delete the sealed journal segments it covers,
+    // except those holding the last keepJournalRecords records before it
+    // (for history replay at startup, say).
+    bool compactJournal = true;
+    std::uint64_t keepJournalRecords = 0;
+};
+
+// Background thread that keeps the snapshot close behind the journal.
+class Snapshotter {
+public:
+    Snapshotter(const std::string& snapshotPath, Journal& journal, SnapshotOptions options = SnapshotOptions());
+    ~Snapshotter();
+    Snapshotter(const Snapshotter&) = delete;
+    Snapshotter& operator=(const Snapshotter&) = delete;
+
+    // Rolls the snapshot forward to the journal's durable LSN now, then
+    // compacts the journal if the options say so. Returns false if it was
+    // already current.
+    bool takeSnapshot();
+
+    // Appends accounts to the snapshot, at its current LSN: they are new to
+    // the account set (see ShardedAccountStore::reload()), so no journal
+    // record before now concerns them. extraCards rows are positions in
+    // accounts. Throws std::runtime_error if the snapshot cannot be
+    // rewritten and std::invalid_argument on a duplicate account or card.
+    void addAccounts(const std::vector<Account>& accounts, const std::vector<CardLink>& extraCards = {});
+
+    std::uint64_t snapshotLsn() const;
+    // Message of the last failed background snapshot, empty if none.
+    std::string lastError() const;
+
+private:
+    std::string path;
+    Journal& journal;
+    SnapshotOptions options;
+
+    mutable std::mutex mutex;
+    std::mutex snapshotMutex;   // one snapshot build at a time
+    std::condition_variable wake;
+    bool stopping = false;
+    std::uint64_t currentLsn = 0;
+    std::string error;
+    std::thread worker;
+
+    void run();
+};
+
+} // namespace atm
+
+#endif // ATM_SNAPSHOT_H
@@ -0,0 +1,94 @@
+#include "transaction_history.h"
+
+#include <algorithm>
+
+#include "account_store.h"
+
+namespace atm {
+
+TransactionHistory::TransactionHistory(const AccountStore& accounts, std::size_t depth)
+    : accounts(&accounts), ringDepth(std::max<std::size_t>(depth, 1)), rings(accounts.size()),
+      stripes(new Stripe[kStripes]), slabs((accounts.size() + kRingsPerSlab - 1) / kRingsPerSlab) {
+}
+
+HistoryEntry* TransactionHistory::ringEntries(std::uint32_t slot) const {
+    return slabs[slot / kRingsPerSlab].get() + (slot % kRingsPerSlab) * ringDepth;
+}
+
+std::uint32_t TransactionHistory::allocateRing() {
+    std::lock_guard<std::mutex> guard(slabLock);
+    if (ringsUsed % kRingsPerSlab == 0) {
+        slabs[ringsUsed / kRingsPerSlab].reset(new HistoryEntry[kRingsPerSlab * ringDepth]);
+    }
+    return ringsUsed++;
+}
+
+void TransactionHistory::record(std::size_t row, const HistoryEntry& entry) {
+    std::lock_guard<std::mutex> guard(stripes[row % kStripes].lock);
+    if (row >= rings.size()) return;
+    Ring& ring = rings[row];
+    if (ring.slot == kNoRing) ring.slot = allocateRing();
+    ringEntries(ring.slot)[ring.written % ringDepth] = entry;
+    ring.written++;
+}
+
+template <typename Vector>
+void TransactionHistory::collectRecent(std::size_t row, std::size_t n, Vector& out) const {
+    std::lock_guard<std::mutex> guard(stripes[row % kStripes].lock);
+    if (row >= rings.size()) return;
+    const Ring& ring = rings[row];
+    if (ring.slot == kNoRing) return;
+
+    // The ring's slab was allocated before its slot was published under
+    // this stripe lock.
+    const HistoryEntry* entries = ringEntries(ring.slot);
+    n = std::min<std::size_t>({n, ringDepth, ring.written});
+    out.reserve(n);
+    for (std::size_t i = 1; i <= n; i++) out.push_back(entries[(ring.written - i) % ringDepth]);
+}
+
+std::vector<HistoryEntry> TransactionHistory::recent(std::size_t row, std::size_t n) const {
+    std::vector<HistoryEntry> out;
+    collectRecent(row, n, out);
+    return out;
+}
+
+std::pmr::vector<HistoryEntry> TransactionHistory::recent(std::size_t row, std::size_t n,
+                                                          std::pmr::memory_resource* memory) const {
+    std::pmr::vector<HistoryEntry> out(memory);
+    collectRecent(row, n, out);
+    return out;
+}
+
+void TransactionHistory::replay(const std::string& journalPath, std::uint64_t afterLsn) {
+    JournalReader reader(journalPath);
+    reader.seek(afterLsn + 1);
+    JournalRecord r;
+    while (reader.next(r)) {
+        if (r.lsn <= afterLsn) continue;
+        const Account* account = accounts->findByAccount(r.accountNumber);
+        if (!account) continue;
+        record(static_cast<std::size_t>(account - accounts->begin()),
+               HistoryEntry{r.timestampUs, r.amount, r.balanceAfter, r.txnType(), 0});
+    }
+}
+
+void TransactionHistory::grow(const AccountStore& grown) {
+    // Every stripe, then the slab lock: the order record() takes them in.
+    std::vector<std::unique_lock<std::mutex>> held;
+    held.reserve(kStripes);
+    for (std::size_t i = 0; i < kStripes; i++) held.emplace_back(stripes[i].lock);
+    std::lock_guard<std::mutex> guard(slabLock);
+    rings.resize(std::max(rings.size(), grown.size()));
+    slabs.resize((rings.size() + kRingsPerSlab - 1) / kRingsPerSlab);
+    accounts = &grown;
+}
+
+std::size_t TransactionHistory::memoryBytes() const {
+    std::lock_guard<std::mutex> guard(slabLock);
+    std::size_t slabsInUse = (ringsUsed + kRingsPerSlab - 1) / kRingsPerSlab;
+    return rings.capacity() * sizeof(Ring) + slabs.capacity() * sizeof(slabs[0]) +
+           slabsInUse * kRingsPerSlab * ringDepth * sizeof(HistoryEntry);
+}
+
+} // namespace atm
@@ -0,0 +1,100 @@
+#ifndef ATM_TRANSACTION_HISTORY_H
+#define ATM_TRANSACTION_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "journal.h"
+#include "money.h"
+
+namespace atm {
+
+class AccountStore;
+
+// One mini-statement line.
+struct HistoryEntry {
+    std::int64_t timestampUs;   // wall clock, microseconds since the Unix epoch
+    Money amount;               // always positive; type gives the direction
+    Money balanceAfter;
+    TxnType type;
+    std::uint32_t reserved;
+};
+
+// The last few transactions of every account, for mini-statements.
+//
+// Each account that has transacted owns a fixed ring of depth() entries.
+// Rings are carved out of large shared slabs on first use rather than
+// being a vector per account, so there is one allocation per few thousand
+// accounts and idle accounts cost only an 8-byte descriptor. Accounts are
+// addressed by their row in the AccountStore, so neither recording nor a
+// "last n" query involves a lookup or a scan of the journal.
+//
+// Recording and reading are guarded by striped locks, so sessions on
+// different accounts rarely contend.
+class TransactionHistory {
+public:
+    static constexpr std::size_t kDefaultDepth = 16;
+
+    explicit TransactionHistory(const AccountStore& accounts, std::size_t depth = kDefaultDepth);
+
+    // row is the account's position in the store (record - accounts.begin()).
+    void record(std::size_t row, const HistoryEntry& entry);
+
+    // Up to n most recent entries for row, newest first.
+    std::vector<HistoryEntry> recent(std::size_t row, std::size_t n) const;
+    std::pmr::vector<HistoryEntry> recent(std::size_t row, std::size_t n, std::pmr::memory_resource* memory) const;
+
+    // Records every journal entry after afterLsn, oldest first. Used at
+    // startup to fill the rings from the end of the journal.
+    void replay(const std::string& journalPath, std::uint64_t afterLsn);
+
+    // Makes room for the rows of grown, which the history stands for from
+    // now on: it must hold the current accounts in the same rows, and any
+    // new ones after them. Recording and reading wait while the row table
+    // is resized.
+    void grow(const AccountStore& grown);
+
+    std::size_t depth() const { return ringDepth; }
+    std::size_t memoryBytes() const;
+
+private:
+    static constexpr std::uint32_t kNoRing = 0xFFFFFFFFu;
+    static constexpr std::size_t kRingsPerSlab = 1024;
+    static constexpr std::size_t kStripes = 64;
+
+    template <typename Vector>
+    void collectRecent(std::size_t row, std::size_t n, Vector& out) const;
+
+    struct Ring {
+        std::uint32_t slot = kNoRing;   // ring number within the slabs
+        std::uint32_t written = 0;      // entries ever recorded; the next goes at written % depth
+    };
+
+    struct alignas(64) Stripe {
+        std::mutex lock;
+    };
+
+    const AccountStore* accounts;
+    std::size_t ringDepth;
+    std::vector<Ring> rings;   // one per account row
+
+    mutable std::unique_ptr<Stripe[]> stripes;
+    mutable std::mutex slabLock;
+    // Sized for every account up front and only resized by grow(), with
+    // every stripe held, so readers can index it while another ring is
+    // being allocated.
+    std::vector<std::unique_ptr<HistoryEntry[]>> slabs;
+    std::uint32_t ringsUsed = 0;
+
+    HistoryEntry* ringEntries(std::uint32_t slot) const;
+    std::uint32_t allocateRing();
+};
+
+} // namespace atm
+
+#endif // ATM_TRANSACTION_HISTORY_H
@@ -4,6 +4,14 @@
 #include <vector>
 #include <algorithm>
 #include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <charconv>
+#include <chrono>
+#include <memory_resource>
 
 // --- CROSS-PLATFORM NETWORKING SETUP ---
 #ifdef _WIN32
@@ -29,9 +37,37 @@
     #define IS_VALIDSOCKET(s) ((s) >= 0)
 #endif
 
+#include "account.h"
+#include "account_file.h"
+#include "account_import.h"
+#include "account_store.h"
+#include "bin_table.h"
+#include "card_number.h"
+#include "end_of_day.h"
+#include "journal.h"
+#include "name_index.h"
+#include "pin_block.h"
+#include "pin_verifier.h"
+#include "session_arena.h"
+#include "sharded_account_store.h"
+#include "snapshot.h"
+#include "nfc_request.h"
 #include "qrcodegen.hpp"
 
 using namespace std;
+using atm::Account;
+using atm::AccountFile;
+using atm::AccountHandle;
+using atm::Journal;
+using atm::PinResult;
+using atm::PinVerifier;
+using atm::ShardedAccountStore;
+using atm::Snapshotter;
+using atm::TxnStatus;
+using atm::kNoteDenomination;
+using atm::Money;
+using atm::formatMoney;
+using atm::rupees;
 using std::uint8_t;
 using qrcodegen::QrCode;
 using qrcodegen::QrSegment;
@@ -55,95 +91,230 @@ void cleanupNetworking() {
 #endif
 }
 
-class Account {
-    private:
-        int accountNumber;
-        string accountHolderName;
-        double balance;
-        int pin;
-        int cardNumber;
-
-    public:
-        Account(int accNum, string accHolder, double bal, int pinCode, int cardNum)
-            : accountNumber(accNum), accountHolderName(accHolder), balance(bal), pin(pinCode), cardNumber(cardNum) {
-            }
-
-        int getAccountNumber() const { return accountNumber; }
-        long long getCardNumber() const { return cardNumber; }
-        bool validatePin(int enteredPin) const { return pin == enteredPin; }
-        string getName() const { return accountHolderName; }
-
-        void checkBalance() const {
-             cout << "\n--- Account Status ---" << endl;
-             cout << "Holder: " << accountHolderName << endl;
-             cout << "Current Balance: " << balance << endl; // Removed currency symbol for console compatibility
-             cout << "----------------------" << endl;
-        }
+// --- ACCOUNT DATA ---
+// Balances persist in this file in the working directory.
+// It is created from the demo accounts below on first run.
+const char* const ACCOUNT_FILE = "accounts.dat";
+// If present on first run, accounts are imported from this CSV/TSV file
+// instead of the demo accounts below. Accounts added to it later are
+// served from the next menu on, without a restart.
+const char* const IMPORT_FILE = "accounts.csv";
+// Every deposit and withdrawal is appended here before it is confirmed.
+const char* const JOURNAL_FILE = "journal.log";
+// Every cash dispense is appended here once the notes are out, under the
+// account journal LSN of its debit; `atmtool reconcile` compares the two.
+const char* const DISPENSE_FILE = "dispense.log";
+// Balances as of a journal position; startup replays only the journal after it.
+const char* const SNAPSHOT_FILE = "accounts.snap";
+// Mini-statements are filled from this many journal records at startup.
+const uint64_t HISTORY_REPLAY_RECORDS = 100000;
+const size_t MINI_STATEMENT_LINES = 10;
+// Optional list of blocked card numbers, one per line.
+const char* const HOT_CARD_FILE = "hotcards.txt";
+// Optional BIN routing table, "<prefix> <route>" per line; without one
+// every card is on-us. Re-read whenever it changes.
+const char* const BIN_FILE = "bins.txt";
+const uint32_t TERMINAL_ID = 1;
+
+vector<Account> seedAccounts() {
+    return {
+        Account(1001, "Tanmay Padale", rupees(1800), atm::hashPin("1234"), 4000000000007866),
+        Account(1002, "Swayam Bagul", rupees(1500, 50), atm::hashPin("5678"), 4000000000008427),
+        Account(1004, "Yash Pratap Gautam", rupees(2000, 27), atm::hashPin("1111"), 4000000000005886)
+    };
+}
 
-        void deposit(int amount) {
-            if (amount > 0 && amount % 100 == 0) {
-                balance += amount;
-                cout << "\n[SUCCESS] Deposited " << amount << endl;
-                cout << "New Balance: " << balance << endl;
-            } else {
-                cout << "\n[ERROR] Deposit amount must be positive." << endl;
-            }
+// Re-imports IMPORT_FILE if it changed since it was last loaded and serves
+// the accounts it adds next to the existing ones, whose balances are kept.
+// The new accounts also go into the snapshot, so a restart keeps them.
+// Sessions in flight carry on undisturbed.
+void refreshAccounts(ShardedAccountStore& accounts, Snapshotter& snapshotter, unique_ptr<atm::NameIndex>& names,
+                     filesystem::file_time_type& loadedVersion) {
+    error_code ec;
+    filesystem::file_time_type modified = filesystem::last_write_time(IMPORT_FILE, ec);
+    if (ec || modified == loadedVersion) return;
+    loadedVersion = modified;   // a bad file is reported once, not on every menu
+    try {
+        atm::AccountStore imported;
+        atm::importAccounts(IMPORT_FILE, imported);
+        vector<Account> added;
+        atm::ReloadReport report = accounts.reload(imported, ACCOUNT_FILE,
+            [&](const vector<Account>& newAccounts, const vector<atm::CardLink>& cards) {
+                snapshotter.addAccounts(newAccounts, cards);
+                added = newAccounts;
+            });
+        if (names) {
+            for (const Account& account : added) names->add(account.getName(), account.getAccountNumber());
         }
+        cout << "[ACCOUNTS] " << IMPORT_FILE << " reloaded: " << report.added << " account(s) added";
+        if (report.skipped) cout << ", " << report.skipped << " skipped (card already in use)";
+        cout << ", " << report.accounts << " served. Built in " << report.buildSeconds * 1000
+             << " ms; balances held for " << report.freezeSeconds * 1000 << " ms." << endl;
+    } catch (const exception& e) {
+        cerr << "[ERROR] " << e.what() << endl;
+    }
+}
 
-        void withdraw(int amount) {
-            if (amount > 0 && amount <= balance && amount % 100 == 0) {
-                balance -= amount;
-                cout << "\n[SUCCESS] Please take your cash: " << amount << endl;
-                cout << "New Balance: " << balance << endl;
-                cout << "Transaction Complete." << endl;
-            } else {
-                cout << "\n[ERROR] Insufficient funds or invalid amount." << endl;
-            }
-        }
-};
+// Reloads BIN_FILE if it changed since it was last loaded. Taps in flight
+// keep routing on the table they started with.
+void refreshBinTable(atm::BinRouter& router, filesystem::file_time_type& loadedVersion) {
+    error_code ec;
+    filesystem::file_time_type modified = filesystem::last_write_time(BIN_FILE, ec);
+    if (ec || modified == loadedVersion) return;
+    loadedVersion = modified;   // a bad file is reported once, not on every tap
+    try {
+        router.reload(BIN_FILE);
+        cout << "[BIN] Routing table loaded: " << router.table()->prefixCount() << " prefixes." << endl;
+    } catch (const exception& e) {
+        cerr << "[ERROR] " << e.what() << endl;
+    }
+}
 
-Account* findAccount(Account accounts[], int size, int accNum) {
-    for (int i = 0; i < size; i++) {
-        if (accounts[i].getAccountNumber() == accNum) {
-            return &accounts[i];
-        }
+// --- SESSION OUTPUT (the core library does no I/O) ---
+// Session temporaries come from `session` (the session arena).
+void checkBalance(const AccountHandle& account, pmr::memory_resource* session) {
+    cout << "\n--- Account Status ---" << endl;
+    cout << "Holder: " << account.holderName() << endl;
+    // One snapshot, so the figures below always add up.
+    atm::AccountSnapshot money = account.snapshot();
+    cout << "Current Balance: " << formatMoney(money.balance, session) << endl; // Removed currency symbol for console compatibility
+    if (money.holds > 0) {
+        cout << "On Hold: " << formatMoney(money.holds, session) << endl;
+        cout << "Available Balance: " << formatMoney(money.available(), session) << endl;
     }
-    return nullptr;
+    cout << "Withdrawn Today: " << formatMoney(money.day >= atm::currentDay() ? money.withdrawnToday : 0, session) << endl;
+    cout << "----------------------" << endl;
 }
 
-Account* findCardNum(Account accounts[], int size, int cardNum) {
-    for (int i = 0; i < size; i++) {
-        if (accounts[i].getCardNumber() == cardNum) {
-            return &accounts[i];
-        }
+void miniStatement(const AccountHandle& account, pmr::memory_resource* session) {
+    cout << "\n--- Mini Statement ---" << endl;
+    pmr::vector<atm::HistoryEntry> entries = account.recentTransactions(MINI_STATEMENT_LINES, session);
+    if (entries.empty()) cout << "No recent transactions." << endl;
+    for (const atm::HistoryEntry& e : entries) {
+        time_t seconds = static_cast<time_t>(e.timestampUs / 1000000);
+        char when[32];
+        strftime(when, sizeof(when), "%d-%m-%Y %H:%M", localtime(&seconds));
+        bool credit = e.type == atm::TxnType::Deposit || e.type == atm::TxnType::Credit;
+        cout << when << "  " << atm::txnTypeName(e.type) << "  " << (credit ? "+" : "-") << formatMoney(e.amount, session)
+             << "  Bal " << formatMoney(e.balanceAfter, session) << endl;
     }
-    return nullptr;
+    cout << "Current Balance: " << formatMoney(account.balance(), session) << endl;
+    cout << "----------------------" << endl;
 }
 
-string parseJsonValue(string body, string key) {
-    string searchKey = "\"" + key + "\"";
-    size_t keyPos = body.find(searchKey);
-    
-    if (keyPos == string::npos) return "";
+// Returns the transaction's LSN, or 0 if it could not be journaled.
+uint64_t record(Journal& journal, atm::TxnType type, const AccountHandle& account, int amount, Money balanceAfter,
+                uint64_t txnId = 0) {
+    try {
+        return journal.append(atm::makeJournalRecord(type, account.accountNumber(), rupees(amount), balanceAfter,
+                                                     TERMINAL_ID, txnId));
+    } catch (const exception& e) {
+        cerr << "\n[ERROR] Journal write failed: " << e.what() << endl;
+        return 0;
+    }
+}
 
-    size_t colonPos = body.find(":", keyPos);
-    if (colonPos == string::npos) return "";
+void deposit(AccountHandle& account, Journal& journal, int amount, pmr::memory_resource* session) {
+    Money balanceAfter;
+    if (account.deposit(rupees(amount), &balanceAfter) == TxnStatus::Ok) {
+        if (!record(journal, atm::TxnType::Deposit, account, amount, balanceAfter)) {
+            // Not on the books, so it must not stay in the balance either.
+            account.reverseDeposit(rupees(amount));
+            cout << "[ERROR] Deposit cancelled; please take back your cash." << endl;
+            return;
+        }
+        cout << "\n[SUCCESS] Deposited " << amount << endl;
+        cout << "New Balance: " << formatMoney(balanceAfter, session) << endl;
+    } else {
+        cout << "\n[ERROR] Deposit amount must be a positive multiple of " << kNoteDenomination << "." << endl;
+    }
+}
 
-    size_t valueStart = colonPos + 1;
-    size_t valueEnd = body.find_first_of(",}", valueStart);
-    if (valueEnd == string::npos) valueEnd = body.length();
+void withdraw(AccountHandle& account, Journal& journal, Journal& dispenses, int amount, pmr::memory_resource* session) {
+    Money balanceAfter;
+    uint64_t lsn;
+    switch (account.tryWithdraw(rupees(amount), &balanceAfter)) {
+        case TxnStatus::Ok:
+            lsn = record(journal, atm::TxnType::Withdrawal, account, amount, balanceAfter);
+            if (!lsn) {
+                account.reverseWithdrawal(rupees(amount));
+                cout << "[ERROR] Withdrawal cancelled; no cash dispensed." << endl;
+                break;
+            }
+            cout << "\n[SUCCESS] Please take your cash: " << amount << endl;
+            record(dispenses, atm::TxnType::Withdrawal, account, amount, balanceAfter, lsn);
+            cout << "New Balance: " << formatMoney(balanceAfter, session) << endl;
+            cout << "Transaction Complete." << endl;
+            break;
+        case TxnStatus::InsufficientFunds:
+            cout << "\n[ERROR] Insufficient funds." << endl;
+            break;
+        default:
+            cout << "\n[ERROR] Amount must be a positive multiple of " << kNoteDenomination << "." << endl;
+    }
+}
 
-    string value = body.substr(valueStart, valueEnd - valueStart);
-    value.erase(remove(value.begin(), value.end(), '\"'), value.end());
-    value.erase(remove(value.begin(), value.end(), ' '), value.end());
-    value.erase(remove(value.begin(), value.end(), '\n'), value.end());
-    value.erase(remove(value.begin(), value.end(), '\r'), value.end());
+// Operator: closes today's business day once. The summary file doubles as
+// the record that the day is closed, so interest is never posted twice.
+void endOfDay(ShardedAccountStore& accounts, Journal& journal) {
+    atm::EndOfDayOptions options;
+    options.businessDay = atm::currentDay();
+    options.terminalId = TERMINAL_ID;
+    string summary = atm::endOfDaySummaryName(options.businessDay);
+    if (ifstream(summary).good()) {
+        cout << "\n[EOD] Today is already closed (" << summary << ")." << endl;
+        return;
+    }
+    try {
+        atm::EndOfDayReport report = atm::runEndOfDay(accounts, &journal, options);
+        writeEndOfDaySummary(summary, report);
+        cout << "\n[EOD] " << report.accounts << " accounts in " << report.wallSeconds() * 1000 << " ms on "
+             << report.threads << " thread(s): interest " << formatMoney(report.interestTotal) << " to "
+             << report.interestCredited << " accounts";
+        if (report.interestAlreadyPaid) cout << " (" << report.interestAlreadyPaid << " paid by an earlier run)";
+        cout << ", " << report.newlyDormant << " newly dormant, "
+             << report.countersReset << " counters reset. Summary in " << summary << "." << endl;
+    } catch (const exception& e) {
+        cerr << "\n[ERROR] End-of-day batch failed: " << e.what() << " Run it again to finish the day." << endl;
+    }
+}
 
-    return value;
+// Operator: finds customers by the start of any word of their name. The
+// index is built on the first search, so it adds nothing to start-up.
+void findByName(ShardedAccountStore& accounts, unique_ptr<atm::NameIndex>& names) {
+    const size_t kShown = 20;
+    string prefix;
+    cout << "Name starts with: ";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    getline(cin, prefix);
+
+    if (!names) {
+        auto start = chrono::steady_clock::now();
+        auto noReload = accounts.holdReloads();
+        names = make_unique<atm::NameIndex>(atm::NameIndex::fromStore(accounts.accountStore()));
+        cout << "\n[SEARCH] Indexed " << names->size() << " holder names in "
+             << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms." << endl;
+    }
+    vector<int> found;
+    auto start = chrono::steady_clock::now();
+    names->find(prefix, found, kShown + 1);
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    if (found.empty()) {
+        cout << "\n[SEARCH] No account holder matches \"" << prefix << "\"." << endl;
+        return;
+    }
+    cout << "\n[SEARCH] " << (found.size() > kShown ? "First " + to_string(kShown) : to_string(found.size()))
+         << " match(es) in " << micros << " us:" << endl;
+    for (size_t i = 0; i < found.size() && i < kShown; i++) {
+        AccountHandle account = accounts.findByAccount(found[i]);
+        if (account) cout << "  " << account.accountNumber() << "  " << account.holderName() << endl;
+    }
 }
 
 // --- UPDATED SERVER FUNCTION ---
-string startNFCServer() {
+// The card number is allocated from `session`; the caller waits for this
+// to return before touching the session arena again.
+pmr::string startNFCServer(pmr::memory_resource* session) {
     SOCK_TYPE server_fd, new_socket;
     struct sockaddr_in address;
     int opt = 1;
@@ -155,7 +326,7 @@ string startNFCServer() {
     // Use the abstraction for creating socket
     if (!IS_VALIDSOCKET(server_fd = socket(AF_INET, SOCK_STREAM, 0))) {
         perror("[NFC] Socket failed");
-        return "";
+        return pmr::string(session);
     }
 
     // Setsockopt is slightly different on Windows (char* vs int*)
@@ -165,7 +336,7 @@ string startNFCServer() {
     if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
 #endif
         perror("[NFC] Setsockopt failed");
-        return "";
+        return pmr::string(session);
     }
     
     address.sin_family = AF_INET;
@@ -174,41 +345,35 @@ string startNFCServer() {
 
     if (::bind(server_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
         perror("[NFC] Bind failed");
-        return "";
+        return pmr::string(session);
     }
     
     if (listen(server_fd, 3) < 0) {
         perror("[NFC] Listen failed");
-        return "";
+        return pmr::string(session);
     }
     
     cout << "[NFC] Waiting for Card Tap (Connection from Phone)..." << endl;
     
     if (!IS_VALIDSOCKET(new_socket = accept(server_fd, (struct sockaddr *)&address, (socklen_t*)&addrlen))) {
         perror("[NFC] Accept failed");
-        return "";
+        return pmr::string(session);
     }
 
     cout << "[NFC] Connection Established! Reading data..." << endl;
 
     // Use recv() instead of read() for compatibility
-    recv(new_socket, buffer, 2048, 0);
-    string rawRequest(buffer);
+    int received = recv(new_socket, buffer, sizeof(buffer) - 1, 0);
+    string_view rawRequest(buffer, received > 0 ? static_cast<size_t>(received) : 0);
     
-    string httpResponse = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\n\r\nOK";
-    send(new_socket, httpResponse.c_str(), httpResponse.length(), 0);
+    const char httpResponse[] = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\n\r\nOK";
+    send(new_socket, httpResponse, sizeof(httpResponse) - 1, 0);
 
-    string jsonBody = "";
-    size_t bodyPos = rawRequest.find("\r\n\r\n");
-    if (bodyPos != string::npos) {
-        jsonBody = rawRequest.substr(bodyPos + 4);
-    } else {
-        jsonBody = rawRequest; 
-    }
+    string_view jsonBody = atm::httpRequestBody(rawRequest);
 
     cout << "[DEBUG] Raw Body: " << jsonBody << endl;
 
-    string cardNum = parseJsonValue(jsonBody, "cardNum");
+    pmr::string cardNum = atm::parseJsonValue(jsonBody, "cardNum", session);
 
     cout << "[NFC] Parsed Card Number: " << cardNum << endl;
     
@@ -219,6 +384,14 @@ string startNFCServer() {
     return cardNum;
 }
 
+// Drops everything the customer's session allocated in one step.
+void endSession(atm::SessionArena& arena) {
+    atm::SessionArena::Stats s = arena.stats();
+    arena.release();
+    cout << "[SESSION] " << s.allocations << " allocations (" << s.bytes << " bytes) from the session arena; "
+         << s.heapAllocations << " heap allocations by the arena since startup." << endl;
+}
+
 static void printQr(const QrCode &qr) {
     int border = 1;
     for (int y = -border; y < qr.getSize() + border; y++) {
@@ -236,15 +409,73 @@ int main() {
     // 1. Initialize Networking (Required for Windows)
     if (!initNetworking()) return 1;
 
-    const int NUM_ACCOUNTS = 3;
-    Account bankAccounts[NUM_ACCOUNTS] = {
-        Account(1001, "Tanmay Padale", 1800.00, 1234, 7864), 
-        Account(1002, "Swayam Bagul", 1500.50, 5678, 8420),
-        Account(1004, "Yash Pratap Gautam", 2000.27, 1111, 5887)
-    };
+    // 2. Open the transaction journal, rebuild the account file from the
+    //    latest snapshot plus the journal after it, and map it
+    AccountFile accountFile;
+    unique_ptr<Journal> journal;
+    unique_ptr<Journal> dispenseLog;
+    unique_ptr<Snapshotter> snapshotter;
+    // Unset, so the first menu reconciles IMPORT_FILE with what is served:
+    // rows added while the terminal was stopped are loaded then.
+    filesystem::file_time_type accountsVersion = filesystem::file_time_type::min();
+    try {
+        journal = make_unique<Journal>(JOURNAL_FILE);
+        dispenseLog = make_unique<Journal>(DISPENSE_FILE);
+        if (!ifstream(SNAPSHOT_FILE).good() && !ifstream(ACCOUNT_FILE).good() && ifstream(IMPORT_FILE).good()) {
+            error_code ec;
+            filesystem::file_time_type importing = filesystem::last_write_time(IMPORT_FILE, ec);
+            atm::AccountStore imported;
+            atm::ImportStats s = atm::importAccounts(IMPORT_FILE, imported);
+            AccountFile::create(ACCOUNT_FILE, imported);
+            if (!ec) accountsVersion = importing;   // all of it is served already
+            cout << "[IMPORT] " << s.records << " accounts from " << IMPORT_FILE << " in " << s.totalSeconds() * 1000
+                 << " ms (count " << s.countSeconds * 1000 << ", allocate " << s.allocateSeconds * 1000
+                 << ", parse " << s.parseSeconds * 1000 << ", index " << s.indexSeconds * 1000 << ") on "
+                 << s.threads << " thread(s)." << endl;
+        }
+        atm::RecoveryReport recovery = atm::recoverAccounts(ACCOUNT_FILE, SNAPSHOT_FILE, JOURNAL_FILE, seedAccounts());
+        accountFile = AccountFile::open(ACCOUNT_FILE);
+        // Compaction leaves the journal records history replay reads below.
+        atm::SnapshotOptions snapshotOptions;
+        snapshotOptions.keepJournalRecords = HISTORY_REPLAY_RECORDS;
+        snapshotter = make_unique<Snapshotter>(SNAPSHOT_FILE, *journal, snapshotOptions);
+        if (recovery.openedInPlace) {
+            cout << "[RECOVERY] Ready in " << recovery.readySeconds() * 1000
+                 << " ms: account file was closed cleanly, opened in place." << endl;
+        } else {
+            cout << "[RECOVERY] Ready in " << recovery.readySeconds() * 1000 << " ms: snapshot at LSN "
+                 << recovery.snapshotLsn << ", " << recovery.replayed << " journal records replayed on "
+                 << recovery.threads << " thread(s)." << endl;
+        }
+    } catch (const exception& e) {
+        cerr << "[ERROR] " << e.what() << endl;
+        cleanupNetworking();
+        return 1;
+    }
+    ShardedAccountStore bankAccounts(std::move(accountFile));
+    unique_ptr<atm::NameIndex> holderNames;
+    try {
+        if (ifstream(HOT_CARD_FILE).good()) bankAccounts.hotCards().replace(atm::HotCardList::readFile(HOT_CARD_FILE));
+    } catch (const exception& e) {
+        cerr << "[ERROR] " << e.what() << endl;
+    }
+    filesystem::file_time_type binVersion;
+    refreshBinTable(bankAccounts.binRoutes(), binVersion);
+    uint64_t lastLsn = journal->lastLsn();
+    bankAccounts.history().replay(JOURNAL_FILE, lastLsn > HISTORY_REPLAY_RECORDS ? lastLsn - HISTORY_REPLAY_RECORDS : 0);
+    // The PIN pad enciphers each PIN into an ISO 9564 format-4 block under
+    // this key; only the verifier's workers ever see the clear PIN. PIN
+    // hashes are deliberately slow, so they run on those workers too.
+    const atm::Aes128 pinPadKey = atm::Aes128::generate();
+    atm::PinVerifierOptions pinOptions;
+    pinOptions.pinKey = &pinPadKey;
+    PinVerifier pinVerifier(pinOptions);
+    // Released after each customer by endSession().
+    atm::SessionArena sessionArena;
 
     while (true) {
         int mainChoice;
+        refreshAccounts(bankAccounts, *snapshotter, holderNames, accountsVersion);
 
         cout << "\n=================================" << endl;
         cout << "           NEXT GEN ATM           " << endl;
@@ -253,39 +484,64 @@ int main() {
         cout << "1. Enter Account Number" << endl;
         cout << "2. UPI Withdrawal" << endl;
         cout << "3. Tap & Withdraw (NFC)" << endl; 
+        cout << "8. Find Account by Name (operator)" << endl;
+        cout << "9. End-of-Day Batch (operator)" << endl;
+        cout << "0. Shut Down (operator)" << endl;
         cout << "Select option: ";
-        cin >> mainChoice;
+        if (!(cin >> mainChoice) || mainChoice == 0) break;
 
         if (mainChoice == 1 || mainChoice == 3) {
-            Account* currentSession = nullptr;
+            AccountHandle currentSession;
+            bool cardBlocked = false;
+            atm::BinTable::RouteId cardRoute = atm::BinTable::kOnUs;
+            string cardNetwork;
+            string enteredPin;
 
             if (mainChoice == 1) {
                 int enteredAccount;
-                int enteredPin;
                 
                 cout << "Please enter Account Number (or <=0 to back): ";
                 cin >> enteredAccount;
     
                 if (enteredAccount <= 0) continue;
     
-                currentSession = findAccount(bankAccounts, NUM_ACCOUNTS, enteredAccount);
+                currentSession = bankAccounts.findByAccount(enteredAccount);
             } else {
-                future<string> nfcData = async(launch::async, &startNFCServer);
-                string cardNumStr = nfcData.get();
-                try{
-                    int cardNum = stoi(cardNumStr);
-                    currentSession = findCardNum(bankAccounts, NUM_ACCOUNTS, cardNum);
-                } catch (...) {
-                    cout << "[ERROR] Invalid data received from NFC tag." << endl;
+                future<pmr::string> nfcData = async(launch::async, &startNFCServer, sessionArena.resource());
+                pmr::string cardNumStr = nfcData.get();
+                long long cardNum = 0;
+                // Length and check digit first: a garbled tap never reaches the store.
+                atm::CardCheck check = atm::checkCardNumber(cardNumStr, &cardNum);
+                if (check == atm::CardCheck::Ok) {
+                    // Then the issuer prefix: only on-us cards are looked up here.
+                    refreshBinTable(bankAccounts.binRoutes(), binVersion);
+                    atm::BinRouter::Pinned bins = bankAccounts.binRoutes().table();
+                    cardRoute = bins->route(cardNum);
+                    cardNetwork = bins->routeName(cardRoute);
+                    if (cardRoute == atm::BinTable::kOnUs) currentSession = bankAccounts.findByCard(cardNum, &cardBlocked);
+                } else {
+                    cout << "[ERROR] Invalid card number from NFC tag (" << atm::cardCheckName(check) << ")." << endl;
                 }
             }
 
-            if (currentSession != nullptr) {
+            if (currentSession) {
                 cout << "Enter PIN: ";
                 cin >> enteredPin;
 
-                if (currentSession->validatePin(enteredPin)) {
-                    cout << "\nLogin Successful! Welcome, " << currentSession->getName() << "." << endl;
+                // PIN blocks are bound to the card number (the account number without a card).
+                long long pan = currentSession.cardNumber() ? currentSession.cardNumber() : currentSession.accountNumber();
+                PinResult pinResult = PinResult::Mismatch;
+                try {
+                    atm::PinBlock block = atm::encryptPinBlock(pinPadKey, atm::PinBlockFormat::Iso4, enteredPin, pan);
+                    future<PinResult> pinCheck = pinVerifier.verify(currentSession.pinCredential(), block, pan);
+                    cout << "Verifying PIN..." << endl;
+                    pinResult = pinCheck.get();
+                } catch (const invalid_argument&) {
+                    // Not 4 to 12 digits: treated as a wrong PIN.
+                }
+
+                if (pinResult == PinResult::Match) {
+                    cout << "\nLogin Successful! Welcome, " << currentSession.holderName() << "." << endl;
                     
                     bool sessionActive = true;
                     while (sessionActive) {
@@ -294,30 +550,44 @@ int main() {
                         cout << "1. Check Balance" << endl;
                         cout << "2. Deposit Cash" << endl;
                         cout << "3. Withdraw Cash" << endl;
-                        cout << "4. Eject Card" << endl;
+                        cout << "4. Mini Statement" << endl;
+                        cout << "5. Eject Card" << endl;
                         cout << "Select option: ";
                         cin >> choice;
 
                         switch (choice) {
-                            case 1: currentSession->checkBalance(); break;
+                            case 1: checkBalance(currentSession, sessionArena.resource()); break;
                             case 2: {
-                                double amt; cout << "Enter deposit amount: "; cin >> amt;
-                                currentSession->deposit(amt); break;
+                                int amt; cout << "Enter deposit amount: "; cin >> amt;
+                                deposit(currentSession, *journal, amt, sessionArena.resource());
+                                bankAccounts.sync(currentSession); break;
                             }
                             case 3: {
-                                double amt; cout << "Enter withdrawal amount: "; cin >> amt;
-                                currentSession->withdraw(amt); break;
+                                int amt; cout << "Enter withdrawal amount: "; cin >> amt;
+                                withdraw(currentSession, *journal, *dispenseLog, amt, sessionArena.resource());
+                                bankAccounts.sync(currentSession); break;
                             }
-                            case 4: cout << "Ejecting card... Goodbye!" << endl; sessionActive = false; break;
+                            case 4: miniStatement(currentSession, sessionArena.resource()); break;
+                            case 5: cout << "Ejecting card... Goodbye!" << endl; sessionActive = false; break;
                             default: cout << "Invalid option." << endl;
                         }
                     }
+                } else if (pinResult == PinResult::Busy) {
+                    cout << "\n[ERROR] The ATM is busy. Please try again." << endl;
                 } else {
                     cout << "\n[ERROR] Invalid PIN." << endl;
                 }
+            } else if (cardBlocked) {
+                cout << "\n[ERROR] This card has been blocked. Please contact your bank." << endl;
+            } else if (cardRoute == atm::BinTable::kUnrouted) {
+                cout << "\n[ERROR] No route for this card's issuer." << endl;
+            } else if (cardRoute != atm::BinTable::kOnUs) {
+                cout << "\n[ROUTE] Card issued by another bank: forwarding to the " << cardNetwork
+                     << " network is not available on this ATM." << endl;
             } else {
                 cout << "\n[ERROR] Account not recognized." << endl;
             }
+            endSession(sessionArena);
         }
 
         else if (mainChoice == 2) {
@@ -328,7 +598,10 @@ int main() {
             if (upiAmt <= 0) continue;
 
             cout << "Scan the QR code to pay " << upiAmt << endl;
-            std::string upiLink = "upi://pay?pa=atm@bank&pn=ATM&am="+ std::to_string(upiAmt) +"&cu=INR";
+            pmr::string upiLink("upi://pay?pa=atm@bank&pn=ATM&am=", sessionArena.resource());
+            char amountText[16];
+            upiLink.append(amountText, to_chars(amountText, amountText + sizeof(amountText), upiAmt).ptr);
+            upiLink += "&cu=INR";
             const QrCode qr0 = QrCode::encodeText(upiLink.c_str(), QrCode::Ecc::LOW);
             printQr(qr0);
 
@@ -337,13 +610,34 @@ int main() {
             cin >> simInput;
             if (simInput == 1) cout << "[SUCCESS] Payment received! Dispensing cash..." << endl;
             else cout << "[CANCELLED]" << endl;
+            endSession(sessionArena);
+        }
+
+        else if (mainChoice == 8) {
+            findByName(bankAccounts, holderNames);
+        }
+
+        else if (mainChoice == 9) {
+            endOfDay(bankAccounts, *journal);
         }
 
         else {
             cout << "\n[ERROR] Invalid option." << endl;
         }
     }
-    
+
+    // Nothing changes balances any more: once the journal is on disk the
+    // account file is marked clean, and the next start opens it in place.
+    snapshotter.reset();
+    try {
+        journal->flush();
+        dispenseLog->flush();
+        bankAccounts.closeCleanly(journal->durableLsn());
+        cout << "[SHUTDOWN] Account file closed cleanly at LSN " << journal->durableLsn() << "." << endl;
+    } catch (const exception& e) {
+        cerr << "[ERROR] Account file not closed cleanly: " << e.what() << endl;
+    }
+
     // Cleanup Windows Networking before exiting
     cleanupNetworking();
     return 0;
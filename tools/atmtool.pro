@@ -0,0 +1,18 @@
+# Operator tools for the journals the frontends write: ./app/atmtool <command> [args]
+CONFIG -= qt
+CONFIG += c++17 console ltcg
+
+TARGET = atmtool
+TEMPLATE = app
+
+DESTDIR = ./app
+
+SOURCES += \
+    main.cpp
+
+INCLUDEPATH += ../core
+DEPENDPATH += ../core
+LIBS += -L$$OUT_PWD/../core/lib -latm_core
+
+win32-msvc*: PRE_TARGETDEPS += $$OUT_PWD/../core/lib/atm_core.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/../core/lib/libatm_core.a
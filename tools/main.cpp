@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "journal_columns.h"
+#include "journal_index.h"
+#include "journal_segments.h"
+#include "journal_sort.h"
+#include "money.h"
+#include "reconcile.h"
+
+namespace {
+
+struct Command {
+    const char* name;
+    const char* usage;
+    int (*run)(int argc, char** argv);
+};
+
+long argOr(int argc, char** argv, int index, long fallback) {
+    return index < argc ? std::strtol(argv[index], nullptr, 10) : fallback;
+}
+
+// Microseconds since the Unix epoch at midnight UTC of a "YYYY-MM-DD"
+// date; false if text is not one.
+bool parseDate(const char* text, std::int64_t* micros) {
+    int y, m, d;
+    if (std::sscanf(text, "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31) return false;
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    *micros = (era * 146097 + doe - 719468) * 86400000000LL;
+    return true;
+}
+
+void printSort(const char* label, const char* path, const atm::SortStats& s) {
+    std::printf("%-9s %zu withdrawals in %zu run(s), %u merge pass(es), %.2f s sort + %.2f s merge on %u thread(s)\n",
+                label, s.records, s.runs, s.mergePasses, s.runSeconds, s.mergeSeconds, s.threads);
+    if (s.truncated()) {
+        std::printf("          warning: %s has a bad record at byte %llu of %llu; the rest was not read\n", path,
+                    static_cast<unsigned long long>(s.validBytes), static_cast<unsigned long long>(s.inputBytes));
+    }
+}
+
+// Exit status: 0 when the journals agree, 2 when there are mismatches.
+int runReconcile(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: atmtool reconcile <dispense.log> <journal.log> [memory MB] [threads] [mismatches.csv]\n");
+        return 1;
+    }
+    atm::SortOptions options;
+    options.memoryBytes = static_cast<std::size_t>(argOr(argc, argv, 3, 256)) << 20;
+    options.threads = static_cast<unsigned>(argOr(argc, argv, 4, 0));
+
+    // Mismatches go to the CSV file when one is given, else the first
+    // few are printed.
+    const std::size_t kPrinted = 20;
+    std::ofstream csv;
+    if (argc > 5) {
+        csv.open(argv[5]);
+        if (!csv) {
+            std::fprintf(stderr, "Cannot write %s\n", argv[5]);
+            return 1;
+        }
+        csv << "kind,txn_id,account,dispense_account,dispensed,debited,timestamp_us\n";
+    }
+    std::size_t seen = 0;
+    auto onMismatch = [&](const atm::Mismatch& m) {
+        if (csv.is_open()) {
+            csv << atm::mismatchKindName(m.kind) << ',' << m.txnId << ',' << m.accountNumber << ',' << m.otherAccount
+                << ',' << atm::formatMoney(m.dispensed) << ',' << atm::formatMoney(m.debited) << ',' << m.timestampUs
+                << '\n';
+        } else if (seen < kPrinted) {
+            std::printf("  %-22s txn %-10llu account %-8d dispensed %12s debited %12s\n", atm::mismatchKindName(m.kind),
+                        static_cast<unsigned long long>(m.txnId), m.accountNumber, atm::formatMoney(m.dispensed).c_str(),
+                        atm::formatMoney(m.debited).c_str());
+        }
+        seen++;
+    };
+
+    atm::ReconcileReport r = atm::reconcileCash(argv[1], argv[2], options, onMismatch);
+    if (!csv.is_open() && seen > kPrinted) std::printf("  ... %zu more\n", seen - kPrinted);
+    printSort("dispense", argv[1], r.dispenseSort);
+    printSort("debit", argv[2], r.debitSort);
+    std::printf("matched               %zu\n", r.matched);
+    if (r.compacted) std::printf("debit compacted away  %zu (not compared)\n", r.compacted);
+    std::printf("dispensed-not-debited %zu\n", r.dispensedNotDebited);
+    std::printf("debited-not-dispensed %zu\n", r.debitedNotDispensed);
+    std::printf("amount-differs        %zu\n", r.amountDiffers);
+    std::printf("account-differs       %zu\n", r.accountDiffers);
+    std::printf("dispensed %s, debited %s, difference %s\n", atm::formatMoney(r.dispensedTotal).c_str(),
+                atm::formatMoney(r.debitedTotal).c_str(), atm::formatMoney(r.dispensedTotal - r.debitedTotal).c_str());
+    std::printf("%.2f s in total (join %.2f s)\n", r.totalSeconds(), r.joinSeconds);
+    if (csv.is_open()) {
+        csv.close();
+        if (!csv) {
+            std::fprintf(stderr, "Cannot write %s\n", argv[5]);
+            return 1;
+        }
+    }
+    return r.mismatches() ? 2 : 0;
+}
+
+int runExport(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: atmtool export <journal.log> <out.col> [YYYY-MM-DD] [threads]\n");
+        return 1;
+    }
+    atm::ColumnExportOptions options;
+    if (argc > 3) {
+        if (!parseDate(argv[3], &options.fromUs)) {
+            std::fprintf(stderr, "not a date: %s\n", argv[3]);
+            return 1;
+        }
+        options.toUs = options.fromUs + 86400000000LL;
+    }
+    options.threads = static_cast<unsigned>(argOr(argc, argv, 4, 0));
+
+    atm::ColumnExportStats s = atm::exportJournalColumns(argv[1], argv[2], options);
+    std::printf("%zu records in %zu row group(s): %llu bytes as journal entries, %llu exported (%.1fx) in %.2f s on %u thread(s)\n",
+                s.rows, s.rowGroups, static_cast<unsigned long long>(s.journalBytes),
+                static_cast<unsigned long long>(s.fileBytes),
+                s.fileBytes ? static_cast<double>(s.journalBytes) / s.fileBytes : 0.0, s.seconds, s.threads);
+    atm::ColumnFile file = atm::ColumnFile::open(argv[2]);
+    for (std::size_t c = 0; c < atm::kJournalColumns; c++) {
+        atm::JournalColumn column = static_cast<atm::JournalColumn>(c);
+        std::printf("  %-10s %12llu bytes", atm::journalColumnName(column), static_cast<unsigned long long>(s.columnBytes[c]));
+        if (file.rowGroupCount()) {
+            const atm::ColumnFile::ChunkInfo& chunk = file.rowGroup(0).chunk(column);
+            std::printf("  %-18s %2u bits/value in the first group", atm::columnEncodingName(chunk.encoding), chunk.bitWidth);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
+
+// Builds the index of every sealed segment that has none, as the journal's
+// background thread would: for segments sealed by an older build, or by a
+// journal opened with indexSegments off.
+int runIndex(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: atmtool index <journal.log>\n");
+        return 1;
+    }
+    std::size_t built = 0, present = 0;
+    for (const atm::JournalSegment& s : atm::listJournalSegments(argv[1])) {
+        std::string index = atm::segmentIndexPath(argv[1], s.firstLsn);
+        if (std::ifstream(index).good()) {
+            present++;
+            continue;
+        }
+        atm::SegmentIndexStats stats = atm::indexJournalSegment(s, index + ".tmp");
+        std::remove(index.c_str());
+        if (std::rename((index + ".tmp").c_str(), index.c_str()) != 0) {
+            std::fprintf(stderr, "cannot move %s.tmp to %s\n", index.c_str(), index.c_str());
+            return 1;
+        }
+        std::printf("%s: %llu records, %llu accounts, %llu bytes in %.2f s\n", index.c_str(),
+                    static_cast<unsigned long long>(stats.records), static_cast<unsigned long long>(stats.accounts),
+                    static_cast<unsigned long long>(stats.bytes), stats.seconds);
+        built++;
+    }
+    std::printf("%zu index(es) built, %zu already there\n", built, present);
+    return 0;
+}
+
+// One account's entries, or every account's, between two UTC dates, both
+// included. Sealed segments are searched through their indexes.
+int runQuery(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: atmtool query <journal.log> <account|all> [from YYYY-MM-DD] [to YYYY-MM-DD]\n");
+        return 1;
+    }
+    atm::JournalQuery query;
+    if (std::strcmp(argv[2], "all") != 0) {
+        query.accountNumber = static_cast<int>(std::strtol(argv[2], nullptr, 10));
+        if (query.accountNumber <= 0) {
+            std::fprintf(stderr, "not an account number: %s\n", argv[2]);
+            return 1;
+        }
+    }
+    if (argc > 3 && !parseDate(argv[3], &query.fromUs)) {
+        std::fprintf(stderr, "not a date: %s\n", argv[3]);
+        return 1;
+    }
+    if (argc > 4) {
+        if (!parseDate(argv[4], &query.toUs)) {
+            std::fprintf(stderr, "not a date: %s\n", argv[4]);
+            return 1;
+        }
+        query.toUs += 86400000000LL;
+    }
+
+    atm::JournalQueryStats s;
+    std::vector<atm::JournalRecord> records = atm::queryJournal(argv[1], query, &s);
+    for (const atm::JournalRecord& r : records) {
+        std::time_t seconds = static_cast<std::time_t>(r.timestampUs / 1000000);
+        char when[32];
+        std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", std::gmtime(&seconds));
+        std::printf("%s  %-10s %9d %14s %16s  terminal %-4u txn %-10llu lsn %llu\n", when, atm::txnTypeName(r.txnType()),
+                    r.accountNumber, atm::formatMoney(r.delta()).c_str(), atm::formatMoney(r.balanceAfter).c_str(),
+                    r.terminalId, static_cast<unsigned long long>(r.txnId), static_cast<unsigned long long>(r.lsn));
+    }
+    std::printf("%zu entries in %.2f ms: %zu segment(s) searched by index, %zu skipped by time, %zu scanned; "
+                "%llu postings, %llu blocks, %llu records read\n",
+                records.size(), s.seconds * 1e3, s.segmentsSearched, s.segmentsSkipped, s.segmentsScanned,
+                static_cast<unsigned long long>(s.postingsRead), static_cast<unsigned long long>(s.blocksRead),
+                static_cast<unsigned long long>(s.recordsRead));
+    return 0;
+}
+
+// Reads one column only. Row groups whose min/max cannot overlap
+// [low, high] are skipped without being read.
+int runScan(int argc, char** argv) {
+    atm::JournalColumn column;
+    if (argc < 3 || !atm::parseJournalColumn(argv[2], &column)) {
+        std::fprintf(stderr, "usage: atmtool scan <file.col> <column> [min] [max]\ncolumns:");
+        for (std::size_t c = 0; c < atm::kJournalColumns; c++) {
+            std::fprintf(stderr, " %s", atm::journalColumnName(static_cast<atm::JournalColumn>(c)));
+        }
+        std::fprintf(stderr, "\n");
+        return 1;
+    }
+    std::int64_t low = argc > 3 ? std::strtoll(argv[3], nullptr, 10) : std::numeric_limits<std::int64_t>::min();
+    std::int64_t high = argc > 4 ? std::strtoll(argv[4], nullptr, 10) : std::numeric_limits<std::int64_t>::max();
+
+    atm::ColumnFile file = atm::ColumnFile::open(argv[1]);
+    std::vector<std::int64_t> values;
+    std::size_t matched = 0, skipped = 0;
+    std::int64_t min = std::numeric_limits<std::int64_t>::max(), max = std::numeric_limits<std::int64_t>::min();
+    long double sum = 0;
+    for (std::size_t g = 0; g < file.rowGroupCount(); g++) {
+        const atm::ColumnFile::ChunkInfo& chunk = file.rowGroup(g).chunk(column);
+        if (chunk.max < low || chunk.min > high) {
+            skipped++;
+            continue;
+        }
+        file.readColumn(g, column, values);
+        for (std::int64_t v : values) {
+            if (v < low || v > high) continue;
+            matched++;
+            sum += v;
+            min = std::min(min, v);
+            max = std::max(max, v);
+        }
+    }
+    std::printf("%s: %zu of %llu rows matched, %zu of %zu row groups skipped by their statistics\n",
+                atm::journalColumnName(column), matched, static_cast<unsigned long long>(file.rows()), skipped,
+                file.rowGroupCount());
+    if (matched) std::printf("min %lld, max %lld, sum %.0Lf\n", static_cast<long long>(min), static_cast<long long>(max), sum);
+    std::printf("%llu column bytes read\n", static_cast<unsigned long long>(file.bytesRead()));
+    return 0;
+}
+
+// Sealed segments oldest first, then the active file.
+int runSegments(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: atmtool segments <journal.log>\n");
+        return 1;
+    }
+    const std::uint64_t kRecord = sizeof(atm::JournalRecord);
+    std::printf("%-20s %-20s %12s %14s  %s\n", "first LSN", "last LSN", "records", "bytes", "file");
+    std::uint64_t records = 0, fileBytes = 0;
+    for (const atm::JournalSegment& s : atm::listJournalSegments(argv[1])) {
+        std::printf("%-20llu %-20llu %12llu %14llu  %s", static_cast<unsigned long long>(s.firstLsn),
+                    static_cast<unsigned long long>(s.lastLsn), static_cast<unsigned long long>(s.records()),
+                    static_cast<unsigned long long>(s.fileBytes), s.path.c_str());
+        if (s.compressed && s.fileBytes) std::printf(" (%.1fx)", static_cast<double>(s.records() * kRecord) / s.fileBytes);
+        if (s.lastLsn == 0) std::printf(" (unreadable)");
+        std::printf("\n");
+        records += s.records();
+        fileBytes += s.fileBytes;
+    }
+    std::ifstream active(argv[1], std::ios::binary | std::ios::ate);
+    std::uint64_t activeBytes = active ? static_cast<std::uint64_t>(active.tellg()) : 0;
+    std::printf("%-20s %-20s %12llu %14llu  %s (active)\n", "-", "-",
+                static_cast<unsigned long long>(activeBytes / kRecord), static_cast<unsigned long long>(activeBytes), argv[1]);
+    records += activeBytes / kRecord;
+    fileBytes += activeBytes;
+    std::printf("%llu records in %llu bytes on disk (%llu as journal entries)\n", static_cast<unsigned long long>(records),
+                static_cast<unsigned long long>(fileBytes), static_cast<unsigned long long>(records * kRecord));
+    return 0;
+}
+
+const Command kCommands[] = {
+    {"export", "export <journal.log> <out.col> [YYYY-MM-DD] [threads]  Columnar copy of the journal (one UTC day if given)", runExport},
+    {"index", "index <journal.log>  Builds the account and time index of sealed segments that have none", runIndex},
+    {"query", "query <journal.log> <account|all> [from YYYY-MM-DD] [to YYYY-MM-DD]  Entries of one account or all, dates inclusive, through the segment indexes", runQuery},
+    {"reconcile", "reconcile <dispense.log> <journal.log> [memory MB] [threads] [mismatches.csv]  Cash dispensed vs debited, by transaction ID", runReconcile},
+    {"scan", "scan <file.col> <column> [min] [max]  Reads one exported column: matching rows, min, max, sum", runScan},
+    {"segments", "segments <journal.log>  Sealed journal segments with their LSN ranges and compression, and the active file", runSegments},
+};
+
+void printUsage() {
+    std::printf("usage: atmtool <command> [args]\n\n");
+    for (const Command& c : kCommands) std::printf("  %s\n", c.usage);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    for (const Command& c : kCommands) {
+        if (std::strcmp(argv[1], c.name) != 0) continue;
+        try {
+            return c.run(argc - 1, argv + 1);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "error: %s\n", e.what());
+            return 1;
+        }
+    }
+    std::printf("unknown command '%s'\n\n", argv[1]);
+    printUsage();
+    return 1;
+}